@@ -0,0 +1,312 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "allocator.h"
+#include "heap_profiler_allocator.h"
+#include "pool_allocator.h"
+#include "thread_cache_allocator.h"
+
+#define BENCH_LIVE_SLOTS 1024
+#define BENCH_MAX_THREADS 16
+#define BENCH_PROFILER_SAMPLE_INTERVAL ((size_t)512 * 1024)
+#define BENCH_RUNS 3
+#define BENCH_ALLOCATORS 4
+
+typedef enum BenchWorkload
+{
+    BENCH_WORKLOAD_DICT_NODES = 0,
+    BENCH_WORKLOAD_ARRAY_GROWTH = 1,
+    BENCH_WORKLOAD_MIXED = 2
+} BenchWorkload;
+
+typedef struct BenchWorker
+{
+    OafAllocator* allocator;
+    BenchWorkload workload;
+    size_t operations;
+    uint64_t seed;
+    size_t checksum;
+} BenchWorker;
+
+static const char* const g_workload_names[] = {"dict_nodes", "array_growth", "mixed"};
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static uint64_t next_random(uint64_t* state)
+{
+    uint64_t value = *state;
+
+    value ^= value << 13;
+    value ^= value >> 7;
+    value ^= value << 17;
+    *state = value;
+    return value;
+}
+
+static void* malloc_alloc(void* state, size_t size, size_t alignment)
+{
+    (void)state;
+    (void)alignment;
+    return malloc(size == 0 ? 1 : size);
+}
+
+static void* malloc_realloc(void* state, void* ptr, size_t old_size, size_t new_size, size_t alignment)
+{
+    (void)state;
+    (void)old_size;
+    (void)alignment;
+    return realloc(ptr, new_size == 0 ? 1 : new_size);
+}
+
+static void malloc_free(void* state, void* ptr)
+{
+    (void)state;
+    free(ptr);
+}
+
+static void run_dict_nodes(BenchWorker* worker)
+{
+    void* nodes[BENCH_LIVE_SLOTS];
+    size_t done = 0;
+    size_t index;
+
+    while (done < worker->operations)
+    {
+        for (index = 0; index < BENCH_LIVE_SLOTS; index++)
+        {
+            nodes[index] = oaf_allocator_alloc(worker->allocator, 48u + (index & 1u) * 16u, 8);
+            ((unsigned char*)nodes[index])[0] = (unsigned char)index;
+        }
+
+        for (index = 0; index < BENCH_LIVE_SLOTS; index++)
+        {
+            size_t victim = (size_t)(next_random(&worker->seed) % BENCH_LIVE_SLOTS);
+            void* swap = nodes[victim];
+
+            nodes[victim] = nodes[index];
+            nodes[index] = swap;
+        }
+
+        for (index = 0; index < BENCH_LIVE_SLOTS; index++)
+        {
+            worker->checksum += ((unsigned char*)nodes[index])[0];
+            oaf_allocator_free(worker->allocator, nodes[index]);
+        }
+
+        done += BENCH_LIVE_SLOTS * 2u;
+    }
+}
+
+static void run_array_growth(BenchWorker* worker)
+{
+    size_t done = 0;
+
+    while (done < worker->operations)
+    {
+        size_t capacity = 16;
+        unsigned char* data = (unsigned char*)oaf_allocator_alloc(worker->allocator, capacity, 16);
+
+        done++;
+        while (capacity < 65536u && data != NULL)
+        {
+            data[capacity - 1u] = (unsigned char)capacity;
+            data = (unsigned char*)oaf_allocator_realloc(worker->allocator, data, capacity, capacity * 2u, 16);
+            capacity *= 2u;
+            done++;
+        }
+
+        worker->checksum += data != NULL ? data[capacity / 2u - 1u] : 0u;
+        oaf_allocator_free(worker->allocator, data);
+        done++;
+    }
+}
+
+static void run_mixed(BenchWorker* worker)
+{
+    void* slots[BENCH_LIVE_SLOTS] = {0};
+    size_t done = 0;
+    size_t index;
+
+    while (done < worker->operations)
+    {
+        size_t slot = (size_t)(next_random(&worker->seed) % BENCH_LIVE_SLOTS);
+        size_t size = 16u + (size_t)(next_random(&worker->seed) % 1009u);
+
+        oaf_allocator_free(worker->allocator, slots[slot]);
+        slots[slot] = oaf_allocator_alloc(worker->allocator, size, 8);
+        ((unsigned char*)slots[slot])[size - 1u] = (unsigned char)size;
+        done += 2;
+    }
+
+    for (index = 0; index < BENCH_LIVE_SLOTS; index++)
+    {
+        worker->checksum += slots[index] != NULL;
+        oaf_allocator_free(worker->allocator, slots[index]);
+    }
+}
+
+static void* worker_main(void* args)
+{
+    BenchWorker* worker = (BenchWorker*)args;
+
+    switch (worker->workload)
+    {
+    case BENCH_WORKLOAD_DICT_NODES:
+        run_dict_nodes(worker);
+        break;
+    case BENCH_WORKLOAD_ARRAY_GROWTH:
+        run_array_growth(worker);
+        break;
+    default:
+        run_mixed(worker);
+        break;
+    }
+
+    return NULL;
+}
+
+static double time_case(OafAllocator* allocator, BenchWorkload workload, size_t threads, size_t operations)
+{
+    BenchWorker workers[BENCH_MAX_THREADS];
+    pthread_t handles[BENCH_MAX_THREADS];
+    double started;
+    size_t index;
+
+    for (index = 0; index < threads; index++)
+    {
+        workers[index].allocator = allocator;
+        workers[index].workload = workload;
+        workers[index].operations = operations / threads;
+        workers[index].seed = 0x9E3779B97F4A7C15ull + index;
+        workers[index].checksum = 0;
+    }
+
+    started = now_ms();
+    for (index = 0; index < threads; index++)
+    {
+        pthread_create(&handles[index], NULL, worker_main, &workers[index]);
+    }
+
+    for (index = 0; index < threads; index++)
+    {
+        pthread_join(handles[index], NULL);
+    }
+
+    return now_ms() - started;
+}
+
+static void print_case(const char* name, BenchWorkload workload, size_t threads, size_t operations, double elapsed)
+{
+    printf(
+        "%s,%s,%zu,%zu,%.3f,%.0f\n",
+        name,
+        g_workload_names[workload],
+        threads,
+        operations,
+        elapsed,
+        elapsed > 0.0 ? (double)operations / (elapsed / 1000.0) : 0.0);
+}
+
+int main(int argc, char** argv)
+{
+    static const size_t thread_counts[] = {1, 4};
+    OafThreadCacheAllocatorState cache_state;
+    OafMultiPoolAllocatorState pool_state;
+    OafHeapProfilerState profiler_state;
+    OafAllocator cached;
+    OafAllocator profiled;
+    OafAllocator pooled;
+    OafAllocator system;
+    const char* names[BENCH_ALLOCATORS] = {"glibc_malloc", "thread_cache", "profiled_thread_cache", "multi_pool"};
+    OafAllocator* allocators[BENCH_ALLOCATORS];
+    size_t operations = 4000000u;
+    size_t threads;
+    int workload;
+
+    if (argc > 2 && strcmp(argv[1], "--ops") == 0)
+    {
+        operations = (size_t)strtoull(argv[2], NULL, 10);
+    }
+
+    if (operations == 0)
+    {
+        fprintf(stderr, "--ops must be positive\n");
+        return 1;
+    }
+
+    if (!oaf_thread_cache_allocator_init(&cache_state))
+    {
+        fprintf(stderr, "thread cache allocator init failed\n");
+        return 1;
+    }
+
+    if (!oaf_multi_pool_allocator_init(&pool_state, NULL, 0))
+    {
+        fprintf(stderr, "multi pool allocator init failed\n");
+        oaf_thread_cache_allocator_destroy(&cache_state);
+        return 1;
+    }
+
+    oaf_thread_cache_allocator_as_allocator(&cache_state, &cached);
+    if (!oaf_heap_profiler_init(&profiler_state, &cached, BENCH_PROFILER_SAMPLE_INTERVAL))
+    {
+        fprintf(stderr, "heap profiler init failed\n");
+        oaf_multi_pool_allocator_destroy(&pool_state);
+        oaf_thread_cache_allocator_destroy(&cache_state);
+        return 1;
+    }
+
+    oaf_heap_profiler_as_allocator(&profiler_state, &profiled);
+    oaf_multi_pool_allocator_as_allocator(&pool_state, &pooled);
+    system.state = NULL;
+    system.ops.alloc = malloc_alloc;
+    system.ops.realloc = malloc_realloc;
+    system.ops.free = malloc_free;
+    allocators[0] = &system;
+    allocators[1] = &cached;
+    allocators[2] = &profiled;
+    allocators[3] = &pooled;
+
+    printf("allocator,workload,threads,ops,total_ms,ops_per_sec\n");
+    for (workload = BENCH_WORKLOAD_DICT_NODES; workload <= BENCH_WORKLOAD_MIXED; workload++)
+    {
+        for (threads = 0; threads < sizeof(thread_counts) / sizeof(thread_counts[0]); threads++)
+        {
+            double best[BENCH_ALLOCATORS];
+            size_t index;
+            int run;
+
+            /* Best of BENCH_RUNS rounds; each round runs every allocator, so machine noise hits all rows alike. */
+            for (run = 0; run < BENCH_RUNS; run++)
+            {
+                for (index = 0; index < BENCH_ALLOCATORS; index++)
+                {
+                    double elapsed = time_case(allocators[index], (BenchWorkload)workload, thread_counts[threads], operations);
+
+                    best[index] = run == 0 || elapsed < best[index] ? elapsed : best[index];
+                }
+            }
+
+            for (index = 0; index < BENCH_ALLOCATORS; index++)
+            {
+                print_case(names[index], (BenchWorkload)workload, thread_counts[threads], operations, best[index]);
+            }
+        }
+    }
+
+    oaf_heap_profiler_destroy(&profiler_state);
+    oaf_multi_pool_allocator_destroy(&pool_state);
+    oaf_thread_cache_allocator_destroy(&cache_state);
+    return 0;
+}
@@ -0,0 +1,265 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "channel.h"
+#include "ring_channel.h"
+
+#define BENCH_CHANNEL_CAPACITY 1024
+#define BENCH_BATCH_SIZE 32
+#define BENCH_MAX_THREADS 32
+
+typedef enum BenchVariant
+{
+    BENCH_VARIANT_MUTEX = 0,
+    BENCH_VARIANT_MUTEX_BATCH = 1,
+    BENCH_VARIANT_RING = 2,
+    BENCH_VARIANT_RING_BATCH = 3
+} BenchVariant;
+
+typedef struct BenchShared
+{
+    BenchVariant variant;
+    OafChannel channel;
+    OafRingChannel ring;
+} BenchShared;
+
+typedef struct BenchWorker
+{
+    BenchShared* shared;
+    size_t first;
+    size_t count;
+    uint64_t checksum;
+} BenchWorker;
+
+static const char* const g_variant_names[] = {"mutex", "mutex_batch", "ring", "ring_batch"};
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static void* producer_main(void* args)
+{
+    BenchWorker* worker = (BenchWorker*)args;
+    BenchShared* shared = worker->shared;
+    void* batch[BENCH_BATCH_SIZE];
+    size_t sent = 0;
+
+    while (sent < worker->count)
+    {
+        size_t chunk = worker->count - sent;
+        size_t index;
+
+        if (shared->variant == BENCH_VARIANT_MUTEX)
+        {
+            oaf_channel_send(&shared->channel, (void*)(uintptr_t)(worker->first + sent + 1u));
+            sent++;
+            continue;
+        }
+
+        if (shared->variant == BENCH_VARIANT_RING)
+        {
+            oaf_ring_channel_send(&shared->ring, (void*)(uintptr_t)(worker->first + sent + 1u));
+            sent++;
+            continue;
+        }
+
+        if (chunk > BENCH_BATCH_SIZE)
+        {
+            chunk = BENCH_BATCH_SIZE;
+        }
+
+        for (index = 0; index < chunk; index++)
+        {
+            batch[index] = (void*)(uintptr_t)(worker->first + sent + index + 1u);
+        }
+
+        if (shared->variant == BENCH_VARIANT_MUTEX_BATCH)
+        {
+            sent += oaf_channel_send_batch(&shared->channel, batch, chunk);
+        }
+        else
+        {
+            sent += oaf_ring_channel_send_batch(&shared->ring, batch, chunk);
+        }
+    }
+
+    return NULL;
+}
+
+static void* consumer_main(void* args)
+{
+    BenchWorker* worker = (BenchWorker*)args;
+    BenchShared* shared = worker->shared;
+    void* batch[BENCH_BATCH_SIZE];
+    size_t received = 0;
+
+    while (received < worker->count)
+    {
+        size_t limit = worker->count - received;
+        size_t moved = 0;
+        size_t index;
+
+        if (limit > BENCH_BATCH_SIZE)
+        {
+            limit = BENCH_BATCH_SIZE;
+        }
+
+        switch (shared->variant)
+        {
+        case BENCH_VARIANT_MUTEX:
+            moved = (size_t)oaf_channel_recv(&shared->channel, &batch[0]);
+            break;
+        case BENCH_VARIANT_MUTEX_BATCH:
+            moved = oaf_channel_recv_batch(&shared->channel, batch, limit);
+            break;
+        case BENCH_VARIANT_RING:
+            moved = (size_t)oaf_ring_channel_recv(&shared->ring, &batch[0]);
+            break;
+        default:
+            moved = oaf_ring_channel_recv_batch(&shared->ring, batch, limit);
+            break;
+        }
+
+        if (moved == 0)
+        {
+            break;
+        }
+
+        for (index = 0; index < moved; index++)
+        {
+            worker->checksum += (uint64_t)(uintptr_t)batch[index];
+        }
+
+        received += moved;
+    }
+
+    return NULL;
+}
+
+static int run_case(BenchVariant variant, size_t producers, size_t consumers, size_t messages)
+{
+    BenchShared shared;
+    BenchWorker producer_state[BENCH_MAX_THREADS];
+    BenchWorker consumer_state[BENCH_MAX_THREADS];
+    pthread_t producer_threads[BENCH_MAX_THREADS];
+    pthread_t consumer_threads[BENCH_MAX_THREADS];
+    uint64_t checksum = 0;
+    uint64_t expected = (uint64_t)messages * (uint64_t)(messages + 1u) / 2u;
+    double started;
+    double elapsed;
+    size_t index;
+
+    shared.variant = variant;
+    if (!oaf_channel_init(&shared.channel, BENCH_CHANNEL_CAPACITY))
+    {
+        return 0;
+    }
+
+    if (!oaf_ring_channel_init(&shared.ring, BENCH_CHANNEL_CAPACITY))
+    {
+        oaf_channel_destroy(&shared.channel);
+        return 0;
+    }
+
+    for (index = 0; index < producers; index++)
+    {
+        producer_state[index].shared = &shared;
+        producer_state[index].first = messages / producers * index;
+        producer_state[index].count = index + 1u == producers
+            ? messages - producer_state[index].first
+            : messages / producers;
+        producer_state[index].checksum = 0;
+    }
+
+    for (index = 0; index < consumers; index++)
+    {
+        consumer_state[index].shared = &shared;
+        consumer_state[index].first = 0;
+        consumer_state[index].count = index + 1u == consumers
+            ? messages - messages / consumers * index
+            : messages / consumers;
+        consumer_state[index].checksum = 0;
+    }
+
+    started = now_ms();
+    for (index = 0; index < consumers; index++)
+    {
+        pthread_create(&consumer_threads[index], NULL, consumer_main, &consumer_state[index]);
+    }
+
+    for (index = 0; index < producers; index++)
+    {
+        pthread_create(&producer_threads[index], NULL, producer_main, &producer_state[index]);
+    }
+
+    for (index = 0; index < producers; index++)
+    {
+        pthread_join(producer_threads[index], NULL);
+    }
+
+    for (index = 0; index < consumers; index++)
+    {
+        pthread_join(consumer_threads[index], NULL);
+        checksum += consumer_state[index].checksum;
+    }
+    elapsed = now_ms() - started;
+
+    printf(
+        "%s,%zu,%zu,%zu,%.3f,%.0f\n",
+        g_variant_names[variant],
+        producers,
+        consumers,
+        messages,
+        elapsed,
+        elapsed > 0.0 ? (double)messages / (elapsed / 1000.0) : 0.0);
+
+    oaf_ring_channel_destroy(&shared.ring);
+    oaf_channel_destroy(&shared.channel);
+    return checksum == expected;
+}
+
+int main(int argc, char** argv)
+{
+    static const size_t shapes[3][2] = {{1, 1}, {4, 4}, {16, 1}};
+    size_t messages = 2000000u;
+    size_t shape;
+    int variant;
+    int ok = 1;
+
+    if (argc > 2 && strcmp(argv[1], "--messages") == 0)
+    {
+        messages = (size_t)strtoull(argv[2], NULL, 10);
+    }
+
+    if (messages == 0)
+    {
+        fprintf(stderr, "--messages must be positive\n");
+        return 1;
+    }
+
+    printf("variant,producers,consumers,messages,total_ms,msgs_per_sec\n");
+    for (shape = 0; shape < 3; shape++)
+    {
+        for (variant = BENCH_VARIANT_MUTEX; variant <= BENCH_VARIANT_RING_BATCH; variant++)
+        {
+            ok = ok && run_case((BenchVariant)variant, shapes[shape][0], shapes[shape][1], messages);
+        }
+    }
+
+    if (!ok)
+    {
+        fprintf(stderr, "channel throughput benchmark produced a bad checksum\n");
+        return 1;
+    }
+
+    return 0;
+}
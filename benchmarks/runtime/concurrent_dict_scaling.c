@@ -0,0 +1,299 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "concurrent_dict.h"
+#include "dict.h"
+#include "sync_primitives.h"
+#include "thread_cache_allocator.h"
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_KEY_SPACE 65536u
+
+typedef enum BenchWorkload
+{
+    BENCH_WORKLOAD_READ_MOSTLY = 0,
+    BENCH_WORKLOAD_MIXED = 1,
+    BENCH_WORKLOAD_GROWTH = 2
+} BenchWorkload;
+
+typedef enum BenchMap
+{
+    BENCH_MAP_LOCKED_DICT = 0,
+    BENCH_MAP_CONCURRENT_DICT = 1
+} BenchMap;
+
+typedef struct BenchShared
+{
+    BenchMap map;
+    BenchWorkload workload;
+    OafDict dict;
+    OafMutex dict_lock;
+    OafConcurrentDict concurrent;
+} BenchShared;
+
+typedef struct BenchWorker
+{
+    BenchShared* shared;
+    size_t operations;
+    int64_t first_fresh_key;
+    uint64_t seed;
+    int64_t checksum;
+} BenchWorker;
+
+static const char* const g_workload_names[] = {"read_90_write_10", "read_50_set_25_remove_25", "get_or_insert_growth"};
+static const char* const g_map_names[] = {"mutex_dict", "concurrent_dict"};
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static uint64_t next_random(uint64_t* state)
+{
+    uint64_t value = *state;
+
+    value ^= value << 13;
+    value ^= value >> 7;
+    value ^= value << 17;
+    *state = value;
+    return value;
+}
+
+static int map_get(BenchShared* shared, const int64_t* key, int64_t* value)
+{
+    int found;
+
+    if (shared->map == BENCH_MAP_CONCURRENT_DICT)
+    {
+        return oaf_concurrent_dict_try_get(&shared->concurrent, key, value);
+    }
+
+    oaf_mutex_lock(&shared->dict_lock);
+    found = oaf_dict_try_get(&shared->dict, key, value);
+    oaf_mutex_unlock(&shared->dict_lock);
+    return found;
+}
+
+static void map_set(BenchShared* shared, const int64_t* key, const int64_t* value)
+{
+    if (shared->map == BENCH_MAP_CONCURRENT_DICT)
+    {
+        oaf_concurrent_dict_set(&shared->concurrent, key, value);
+        return;
+    }
+
+    oaf_mutex_lock(&shared->dict_lock);
+    oaf_dict_set(&shared->dict, key, value);
+    oaf_mutex_unlock(&shared->dict_lock);
+}
+
+static void map_remove(BenchShared* shared, const int64_t* key)
+{
+    if (shared->map == BENCH_MAP_CONCURRENT_DICT)
+    {
+        oaf_concurrent_dict_remove(&shared->concurrent, key, NULL);
+        return;
+    }
+
+    oaf_mutex_lock(&shared->dict_lock);
+    oaf_dict_remove(&shared->dict, key, NULL);
+    oaf_mutex_unlock(&shared->dict_lock);
+}
+
+static void map_get_or_insert(BenchShared* shared, const int64_t* key, const int64_t* value, int64_t* out_value)
+{
+    if (shared->map == BENCH_MAP_CONCURRENT_DICT)
+    {
+        oaf_concurrent_dict_get_or_insert(&shared->concurrent, key, value, out_value, NULL);
+        return;
+    }
+
+    oaf_mutex_lock(&shared->dict_lock);
+    if (!oaf_dict_try_get(&shared->dict, key, out_value) && oaf_dict_set(&shared->dict, key, value))
+    {
+        *out_value = *value;
+    }
+    oaf_mutex_unlock(&shared->dict_lock);
+}
+
+static void* worker_main(void* argument)
+{
+    BenchWorker* worker = (BenchWorker*)argument;
+    BenchShared* shared = worker->shared;
+    size_t index;
+
+    for (index = 0; index < worker->operations; index++)
+    {
+        uint64_t random = next_random(&worker->seed);
+        int64_t key = (int64_t)(random % BENCH_KEY_SPACE);
+        int64_t value = key;
+        unsigned int choice = (unsigned int)((random >> 32) % 100u);
+
+        switch (shared->workload)
+        {
+        case BENCH_WORKLOAD_READ_MOSTLY:
+            if (choice < 90u)
+            {
+                worker->checksum += map_get(shared, &key, &value) ? value : 0;
+            }
+            else
+            {
+                map_set(shared, &key, &value);
+            }
+            break;
+        case BENCH_WORKLOAD_MIXED:
+            if (choice < 50u)
+            {
+                worker->checksum += map_get(shared, &key, &value) ? value : 0;
+            }
+            else if (choice < 75u)
+            {
+                map_set(shared, &key, &value);
+            }
+            else
+            {
+                map_remove(shared, &key);
+            }
+            break;
+        default:
+            key = worker->first_fresh_key + (int64_t)(index / 2u);
+            map_get_or_insert(shared, &key, &key, &value);
+            worker->checksum += value;
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static int run_case(BenchMap map, BenchWorkload workload, size_t threads, size_t operations, OafAllocator* allocator)
+{
+    BenchShared shared;
+    BenchWorker workers[BENCH_MAX_THREADS];
+    pthread_t handles[BENCH_MAX_THREADS];
+    double started;
+    double elapsed;
+    int64_t key;
+    size_t index;
+    int ok;
+
+    shared.map = map;
+    shared.workload = workload;
+    if (map == BENCH_MAP_CONCURRENT_DICT)
+    {
+        ok = oaf_concurrent_dict_init(&shared.concurrent, sizeof(int64_t), sizeof(int64_t), 0, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, allocator);
+    }
+    else
+    {
+        ok = oaf_mutex_init(&shared.dict_lock)
+            && oaf_dict_init(&shared.dict, sizeof(int64_t), sizeof(int64_t), 0, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, allocator);
+    }
+
+    for (key = 0; ok && workload != BENCH_WORKLOAD_GROWTH && key < (int64_t)BENCH_KEY_SPACE; key += 2)
+    {
+        map_set(&shared, &key, &key);
+    }
+
+    for (index = 0; ok && index < threads; index++)
+    {
+        workers[index].shared = &shared;
+        workers[index].operations = operations / threads;
+        workers[index].first_fresh_key = (int64_t)(index * operations);
+        workers[index].seed = 0x9E3779B97F4A7C15ull + index;
+        workers[index].checksum = 0;
+    }
+
+    started = now_ms();
+    for (index = 0; ok && index < threads; index++)
+    {
+        ok = pthread_create(&handles[index], NULL, worker_main, &workers[index]) == 0;
+        threads = ok ? threads : index;
+    }
+
+    for (index = 0; index < threads; index++)
+    {
+        pthread_join(handles[index], NULL);
+    }
+    elapsed = now_ms() - started;
+
+    if (ok)
+    {
+        printf(
+            "%s,%s,%zu,%zu,%.3f,%.0f\n",
+            g_map_names[map],
+            g_workload_names[workload],
+            threads,
+            operations,
+            elapsed,
+            elapsed > 0.0 ? (double)operations / (elapsed / 1000.0) : 0.0);
+    }
+
+    if (map == BENCH_MAP_CONCURRENT_DICT)
+    {
+        oaf_concurrent_dict_destroy(&shared.concurrent);
+    }
+    else
+    {
+        oaf_dict_destroy(&shared.dict);
+        oaf_mutex_destroy(&shared.dict_lock);
+    }
+
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    static const size_t thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+    OafThreadCacheAllocatorState cache_state;
+    OafAllocator allocator;
+    size_t operations = 2000000u;
+    size_t threads;
+    int workload;
+    int map;
+
+    if (argc > 2 && strcmp(argv[1], "--ops") == 0)
+    {
+        operations = (size_t)strtoull(argv[2], NULL, 10);
+    }
+
+    if (operations < BENCH_MAX_THREADS)
+    {
+        fprintf(stderr, "--ops must be at least %d\n", BENCH_MAX_THREADS);
+        return 1;
+    }
+
+    if (!oaf_thread_cache_allocator_init(&cache_state))
+    {
+        fprintf(stderr, "thread cache allocator init failed\n");
+        return 1;
+    }
+
+    oaf_thread_cache_allocator_as_allocator(&cache_state, &allocator);
+    printf("map,workload,threads,ops,total_ms,ops_per_sec\n");
+    for (workload = BENCH_WORKLOAD_READ_MOSTLY; workload <= BENCH_WORKLOAD_GROWTH; workload++)
+    {
+        for (threads = 0; threads < sizeof(thread_counts) / sizeof(thread_counts[0]); threads++)
+        {
+            for (map = BENCH_MAP_LOCKED_DICT; map <= BENCH_MAP_CONCURRENT_DICT; map++)
+            {
+                if (!run_case((BenchMap)map, (BenchWorkload)workload, thread_counts[threads], operations, &allocator))
+                {
+                    fprintf(stderr, "%s with %zu threads failed\n", g_map_names[map], thread_counts[threads]);
+                    oaf_thread_cache_allocator_destroy(&cache_state);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    oaf_thread_cache_allocator_destroy(&cache_state);
+    return 0;
+}
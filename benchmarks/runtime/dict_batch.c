@@ -0,0 +1,165 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "default_allocator.h"
+#include "dict.h"
+
+#define BENCH_CHUNK 4096u
+
+static const size_t g_table_sizes[] = {1u << 12, 1u << 16, 1u << 20, 1u << 22};
+
+static volatile int64_t g_sink;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static uint64_t next_random(uint64_t* state)
+{
+    uint64_t value = *state;
+
+    value ^= value << 13;
+    value ^= value >> 7;
+    value ^= value << 17;
+    *state = value;
+    return value;
+}
+
+static void print_row(const char* operation, const char* mode, size_t keys, size_t operations, double elapsed)
+{
+    printf(
+        "%s,%s,%zu,%zu,%.3f,%.1f\n",
+        operation,
+        mode,
+        keys,
+        operations,
+        elapsed,
+        operations > 0 ? elapsed * 1000000.0 / (double)operations : 0.0);
+}
+
+static int run_size(size_t keys, size_t lookups, OafAllocator* allocator)
+{
+    int64_t* inserted = (int64_t*)malloc(keys * sizeof(int64_t));
+    int64_t* probes = (int64_t*)malloc(lookups * sizeof(int64_t));
+    int64_t* values = (int64_t*)malloc(BENCH_CHUNK * sizeof(int64_t));
+    unsigned char* found = (unsigned char*)malloc(BENCH_CHUNK);
+    uint64_t seed = 0x9E3779B97F4A7C15ull ^ keys;
+    OafDict dict;
+    double started;
+    int64_t checksum;
+    size_t index;
+    int batched;
+    int ok = inserted != NULL && probes != NULL && values != NULL && found != NULL;
+
+    for (index = 0; ok && index < keys; index++)
+    {
+        inserted[index] = (int64_t)next_random(&seed);
+    }
+
+    /* Every other probe misses so both the hit and the miss paths are measured. */
+    for (index = 0; ok && index < lookups; index++)
+    {
+        uint64_t random = next_random(&seed);
+        probes[index] = (random & 1u) != 0 ? inserted[(random >> 1) % keys] : (int64_t)random;
+    }
+
+    for (batched = 0; ok && batched <= 1; batched++)
+    {
+        const char* mode = batched ? "batched" : "single";
+
+        ok = oaf_dict_init(&dict, sizeof(int64_t), sizeof(int64_t), 0, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, allocator);
+        if (!ok)
+        {
+            break;
+        }
+
+        started = now_ms();
+        if (batched)
+        {
+            ok = oaf_dict_set_many(&dict, inserted, inserted, keys);
+        }
+        else
+        {
+            for (index = 0; ok && index < keys; index++)
+            {
+                ok = oaf_dict_set(&dict, &inserted[index], &inserted[index]);
+            }
+        }
+        print_row("insert", mode, keys, keys, now_ms() - started);
+
+        checksum = 0;
+        started = now_ms();
+        if (batched)
+        {
+            for (index = 0; index < lookups; index += BENCH_CHUNK)
+            {
+                size_t chunk = lookups - index < BENCH_CHUNK ? lookups - index : BENCH_CHUNK;
+                size_t item;
+
+                oaf_dict_try_get_many(&dict, probes + index, chunk, values, found);
+                for (item = 0; item < chunk; item++)
+                {
+                    checksum += found[item] ? values[item] : 0;
+                }
+            }
+        }
+        else
+        {
+            for (index = 0; index < lookups; index++)
+            {
+                int64_t value;
+                checksum += oaf_dict_try_get(&dict, &probes[index], &value) ? value : 0;
+            }
+        }
+        print_row("lookup", mode, keys, lookups, now_ms() - started);
+
+        g_sink += checksum;
+        oaf_dict_destroy(&dict);
+    }
+
+    free(found);
+    free(values);
+    free(probes);
+    free(inserted);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    size_t lookups = 4000000u;
+    size_t size;
+
+    if (argc > 2 && strcmp(argv[1], "--lookups") == 0)
+    {
+        lookups = (size_t)strtoull(argv[2], NULL, 10);
+    }
+
+    if (lookups == 0)
+    {
+        fprintf(stderr, "--lookups must be positive\n");
+        return 1;
+    }
+
+    oaf_default_allocator_init(&state, &allocator);
+    printf("operation,mode,keys,ops,total_ms,ns_per_op\n");
+    for (size = 0; size < sizeof(g_table_sizes) / sizeof(g_table_sizes[0]); size++)
+    {
+        if (!run_size(g_table_sizes[size], lookups, &allocator))
+        {
+            fprintf(stderr, "%zu keys failed\n", g_table_sizes[size]);
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "default_allocator.h"
+#include "gc.h"
+
+#define BENCH_REPEATS 3
+#define BENCH_WIDE_HUBS 1024
+
+typedef enum BenchGraph
+{
+    BENCH_GRAPH_TREE = 0,
+    BENCH_GRAPH_WIDE = 1,
+    BENCH_GRAPH_CHAIN = 2
+} BenchGraph;
+
+static const char* const g_graph_names[] = {"binary_tree", "wide_fanout", "long_chain"};
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static int build_graph(OafGarbageCollector* collector, BenchGraph graph, void** nodes, size_t objects)
+{
+    size_t index;
+
+    for (index = 0; index < objects; index++)
+    {
+        size_t parent;
+
+        nodes[index] = oaf_gc_alloc(collector, 32, 8);
+        if (nodes[index] == NULL)
+        {
+            return 0;
+        }
+
+        if (index == 0)
+        {
+            continue;
+        }
+
+        switch (graph)
+        {
+        case BENCH_GRAPH_TREE:
+            parent = (index - 1u) / 2u;
+            break;
+        case BENCH_GRAPH_WIDE:
+            parent = index <= BENCH_WIDE_HUBS ? 0 : 1u + index % BENCH_WIDE_HUBS;
+            break;
+        default:
+            parent = index - 1u;
+            break;
+        }
+
+        if (!oaf_gc_add_reference(collector, nodes[parent], nodes[index]))
+        {
+            return 0;
+        }
+    }
+
+    return oaf_gc_retain(collector, nodes[0]);
+}
+
+static int run_case(BenchGraph graph, size_t workers, size_t objects, void** nodes, double* baseline_ms)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafGarbageCollector collector;
+    double best = 0.0;
+    size_t repeat;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_gc_init(&collector, &allocator, 1))
+    {
+        return 0;
+    }
+
+    if (!oaf_gc_set_mark_workers(&collector, workers) || !build_graph(&collector, graph, nodes, objects))
+    {
+        oaf_gc_destroy(&collector);
+        return 0;
+    }
+
+    for (repeat = 0; repeat < BENCH_REPEATS; repeat++)
+    {
+        double started = now_ms();
+        double elapsed;
+
+        if (oaf_gc_collect(&collector) != 0 || oaf_gc_object_count(&collector) != objects)
+        {
+            oaf_gc_destroy(&collector);
+            return 0;
+        }
+
+        elapsed = now_ms() - started;
+        best = repeat == 0 || elapsed < best ? elapsed : best;
+    }
+
+    if (workers == 1)
+    {
+        *baseline_ms = best;
+    }
+
+    printf(
+        "%s,%zu,%zu,%.3f,%.2f\n",
+        g_graph_names[graph],
+        workers,
+        objects,
+        best,
+        best > 0.0 ? *baseline_ms / best : 0.0);
+    oaf_gc_destroy(&collector);
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    static const size_t worker_counts[] = {1, 2, 4, 8};
+    size_t objects = 1000000u;
+    double baseline_ms = 0.0;
+    void** nodes;
+    size_t workers;
+    int graph;
+
+    if (argc > 2 && strcmp(argv[1], "--objects") == 0)
+    {
+        objects = (size_t)strtoull(argv[2], NULL, 10);
+    }
+
+    if (objects < 2)
+    {
+        fprintf(stderr, "--objects must be at least 2\n");
+        return 1;
+    }
+
+    nodes = (void**)malloc(objects * sizeof(void*));
+    if (nodes == NULL)
+    {
+        fprintf(stderr, "node table allocation failed\n");
+        return 1;
+    }
+
+    printf("graph,workers,objects,collect_ms,speedup\n");
+    for (graph = BENCH_GRAPH_TREE; graph <= BENCH_GRAPH_CHAIN; graph++)
+    {
+        for (workers = 0; workers < sizeof(worker_counts) / sizeof(worker_counts[0]); workers++)
+        {
+            if (!run_case((BenchGraph)graph, worker_counts[workers], objects, nodes, &baseline_ms))
+            {
+                fprintf(stderr, "%s with %zu workers failed\n", g_graph_names[graph], worker_counts[workers]);
+                free(nodes);
+                return 1;
+            }
+        }
+    }
+
+    free(nodes);
+    return 0;
+}
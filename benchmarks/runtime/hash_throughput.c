@@ -0,0 +1,121 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dict.h"
+
+#define BENCH_BUFFER_SIZE ((size_t)64 * 1024)
+#define BENCH_REPEATS 3
+
+typedef size_t (*BenchHashProc)(const void* data, size_t length);
+
+static volatile size_t g_sink;
+static const size_t g_lengths[] = {8, 16, 32, 64, 128, 256, 512, 1024, 4096};
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static size_t hash_fnv1a(const void* data, size_t length)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 1469598103934665603ull;
+    size_t index;
+
+    for (index = 0; index < length; index++)
+    {
+        hash ^= bytes[index];
+        hash *= 1099511628211ull;
+    }
+
+    return (size_t)hash;
+}
+
+static size_t hash_portable(const void* data, size_t length)
+{
+    return oaf_dict_hash_bytes_seeded(data, length, 0x9e3779b97f4a7c15ull);
+}
+
+static size_t hash_runtime(const void* data, size_t length)
+{
+    return oaf_dict_hash_bytes(data, length);
+}
+
+static void run_case(const char* name, BenchHashProc hash, const unsigned char* buffer, size_t length, size_t total_bytes)
+{
+    size_t iterations = total_bytes / length;
+    double best = 0.0;
+    size_t sink = 0;
+    size_t repeat;
+
+    for (repeat = 0; repeat < BENCH_REPEATS; repeat++)
+    {
+        double started = now_ms();
+        double elapsed;
+        size_t index;
+
+        for (index = 0; index < iterations; index++)
+        {
+            sink += hash(buffer + ((index * 64u) & (BENCH_BUFFER_SIZE / 2u - 1u)), length);
+        }
+
+        elapsed = now_ms() - started;
+        best = repeat == 0 || elapsed < best ? elapsed : best;
+    }
+
+    printf(
+        "%s,%zu,%.2f,%.2f\n",
+        name,
+        length,
+        best * 1000000.0 / (double)iterations,
+        best > 0.0 ? (double)(iterations * length) / (best * 1000000.0) : 0.0);
+    g_sink = sink;
+}
+
+int main(int argc, char** argv)
+{
+    size_t total_bytes = (size_t)256 * 1024 * 1024;
+    unsigned char* buffer;
+    size_t index;
+
+    if (argc > 2 && strcmp(argv[1], "--bytes") == 0)
+    {
+        total_bytes = (size_t)strtoull(argv[2], NULL, 10);
+    }
+
+    if (total_bytes < 4096)
+    {
+        fprintf(stderr, "--bytes must be at least 4096\n");
+        return 1;
+    }
+
+    buffer = (unsigned char*)malloc(BENCH_BUFFER_SIZE);
+    if (buffer == NULL)
+    {
+        fprintf(stderr, "buffer allocation failed\n");
+        return 1;
+    }
+
+    for (index = 0; index < BENCH_BUFFER_SIZE; index++)
+    {
+        buffer[index] = (unsigned char)((index * 2654435761u) >> 13);
+    }
+
+    printf("hash,length,ns_per_hash,gb_per_sec\n");
+    for (index = 0; index < sizeof(g_lengths) / sizeof(g_lengths[0]); index++)
+    {
+        run_case("fnv1a", hash_fnv1a, buffer, g_lengths[index], total_bytes);
+        run_case("wyhash_portable", hash_portable, buffer, g_lengths[index], total_bytes);
+        run_case(oaf_dict_hash_uses_aes() ? "oaf_dict_hash_bytes_aes" : "oaf_dict_hash_bytes", hash_runtime, buffer, g_lengths[index], total_bytes);
+    }
+
+    free(buffer);
+    return 0;
+}
@@ -0,0 +1,311 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "array.h"
+#include "array_template.h"
+#include "default_allocator.h"
+#include "dict.h"
+#include "dict_template.h"
+
+typedef struct BenchPoint
+{
+    int32_t x;
+    int32_t y;
+} BenchPoint;
+
+typedef struct BenchParticle
+{
+    float position[2];
+    float velocity[2];
+} BenchParticle;
+
+static size_t hash_point(const BenchPoint* point, uint64_t seed)
+{
+    return oaf_dict_hash_u64(((uint64_t)(uint32_t)point->x << 32) | (uint32_t)point->y, seed);
+}
+
+static int equals_point(const BenchPoint* left, const BenchPoint* right)
+{
+    return left->x == right->x && left->y == right->y;
+}
+
+static size_t hash_point_erased(const void* key, void* state)
+{
+    (void)state;
+    return hash_point((const BenchPoint*)key, oaf_dict_hash_seed());
+}
+
+static int equals_point_erased(const void* left, const void* right, void* state)
+{
+    (void)state;
+    return equals_point((const BenchPoint*)left, (const BenchPoint*)right);
+}
+
+OAF_ARRAY_DEFINE(BenchI64Array, bench_i64_array, int64_t)
+OAF_DICT_DEFINE(BenchI64Dict, bench_i64_dict, int64_t, int64_t, oaf_dict_key_hash_i64, oaf_dict_key_equals_i64)
+OAF_DICT_DEFINE(BenchPointDict, bench_point_dict, BenchPoint, BenchParticle, hash_point, equals_point)
+
+static volatile int64_t g_sink;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static uint64_t next_random(uint64_t* state)
+{
+    uint64_t value = *state;
+
+    value ^= value << 13;
+    value ^= value >> 7;
+    value ^= value << 17;
+    *state = value;
+    return value;
+}
+
+static void print_row(const char* workload, const char* variant, size_t size, size_t operations, double elapsed)
+{
+    printf(
+        "%s,%s,%zu,%zu,%.3f,%.2f\n",
+        workload,
+        variant,
+        size,
+        operations,
+        elapsed,
+        operations > 0 ? elapsed * 1000000.0 / (double)operations : 0.0);
+}
+
+static int bench_array(size_t size, OafAllocator* allocator)
+{
+    OafArray erased;
+    BenchI64Array typed;
+    double started;
+    int64_t sum = 0;
+    int64_t value;
+    size_t index;
+    int ok = 1;
+
+    if (!oaf_array_init(&erased, sizeof(int64_t), 0, allocator))
+    {
+        return 0;
+    }
+
+    if (!bench_i64_array_init(&typed, 0, allocator))
+    {
+        oaf_array_destroy(&erased);
+        return 0;
+    }
+
+    started = now_ms();
+    for (index = 0; ok && index < size; index++)
+    {
+        value = (int64_t)index;
+        ok = oaf_array_push(&erased, &value);
+    }
+    for (index = 0; ok && index < size; index++)
+    {
+        ok = oaf_array_get(&erased, index, &value);
+        sum += value;
+    }
+    print_row("array_i64_push_get", "erased", size, size * 2u, now_ms() - started);
+
+    started = now_ms();
+    for (index = 0; ok && index < size; index++)
+    {
+        ok = bench_i64_array_push(&typed, (int64_t)index);
+    }
+    for (index = 0; ok && index < size; index++)
+    {
+        ok = bench_i64_array_get(&typed, index, &value);
+        sum += value;
+    }
+    print_row("array_i64_push_get", "typed", size, size * 2u, now_ms() - started);
+
+    g_sink += sum;
+    oaf_array_destroy(&erased);
+    bench_i64_array_destroy(&typed);
+    return ok;
+}
+
+static int bench_i64_dict(const int64_t* keys, size_t size, size_t lookups, OafAllocator* allocator)
+{
+    OafDict erased;
+    BenchI64Dict typed;
+    uint64_t seed = 0x2545F4914F6CDD1Dull;
+    double started;
+    int64_t sum = 0;
+    int64_t value;
+    size_t index;
+    int ok = 1;
+
+    if (!oaf_dict_init(&erased, sizeof(int64_t), sizeof(int64_t), 0, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, allocator))
+    {
+        return 0;
+    }
+
+    if (!bench_i64_dict_init(&typed, 0, allocator))
+    {
+        oaf_dict_destroy(&erased);
+        return 0;
+    }
+
+    started = now_ms();
+    for (index = 0; ok && index < size; index++)
+    {
+        ok = oaf_dict_set(&erased, &keys[index], &keys[index]);
+    }
+    print_row("dict_i64_insert", "erased", size, size, now_ms() - started);
+
+    started = now_ms();
+    for (index = 0; ok && index < size; index++)
+    {
+        ok = bench_i64_dict_set(&typed, keys[index], keys[index]);
+    }
+    print_row("dict_i64_insert", "typed", size, size, now_ms() - started);
+
+    started = now_ms();
+    for (index = 0; index < lookups; index++)
+    {
+        int64_t key = keys[next_random(&seed) % size];
+        sum += oaf_dict_try_get(&erased, &key, &value) ? value : 0;
+    }
+    print_row("dict_i64_lookup", "erased", size, lookups, now_ms() - started);
+
+    seed = 0x2545F4914F6CDD1Dull;
+    started = now_ms();
+    for (index = 0; index < lookups; index++)
+    {
+        sum += bench_i64_dict_try_get(&typed, keys[next_random(&seed) % size], &value) ? value : 0;
+    }
+    print_row("dict_i64_lookup", "typed", size, lookups, now_ms() - started);
+
+    g_sink += sum;
+    oaf_dict_destroy(&erased);
+    bench_i64_dict_destroy(&typed);
+    return ok;
+}
+
+static int bench_point_dict(size_t size, size_t lookups, OafAllocator* allocator)
+{
+    OafDict erased;
+    BenchPointDict typed;
+    BenchParticle particle = {{1.0f, 2.0f}, {0.5f, -0.5f}};
+    BenchParticle found;
+    BenchPoint point;
+    uint64_t seed = 0x2545F4914F6CDD1Dull;
+    size_t side = 1;
+    double started;
+    double sum = 0.0;
+    size_t index;
+    int ok = 1;
+
+    while (side * side < size)
+    {
+        side++;
+    }
+
+    if (!oaf_dict_init(&erased, sizeof(BenchPoint), sizeof(BenchParticle), 0, hash_point_erased, equals_point_erased, NULL, allocator))
+    {
+        return 0;
+    }
+
+    if (!bench_point_dict_init(&typed, 0, allocator))
+    {
+        oaf_dict_destroy(&erased);
+        return 0;
+    }
+
+    started = now_ms();
+    for (index = 0; ok && index < size; index++)
+    {
+        point.x = (int32_t)(index % side);
+        point.y = (int32_t)(index / side);
+        ok = oaf_dict_set(&erased, &point, &particle);
+    }
+    print_row("dict_point_insert", "erased", size, size, now_ms() - started);
+
+    started = now_ms();
+    for (index = 0; ok && index < size; index++)
+    {
+        point.x = (int32_t)(index % side);
+        point.y = (int32_t)(index / side);
+        ok = bench_point_dict_set(&typed, point, particle);
+    }
+    print_row("dict_point_insert", "typed", size, size, now_ms() - started);
+
+    started = now_ms();
+    for (index = 0; index < lookups; index++)
+    {
+        uint64_t random = next_random(&seed) % size;
+        point.x = (int32_t)(random % side);
+        point.y = (int32_t)(random / side);
+        sum += oaf_dict_try_get(&erased, &point, &found) ? found.position[0] : 0.0f;
+    }
+    print_row("dict_point_lookup", "erased", size, lookups, now_ms() - started);
+
+    seed = 0x2545F4914F6CDD1Dull;
+    started = now_ms();
+    for (index = 0; index < lookups; index++)
+    {
+        uint64_t random = next_random(&seed) % size;
+        point.x = (int32_t)(random % side);
+        point.y = (int32_t)(random / side);
+        sum += bench_point_dict_try_get(&typed, point, &found) ? found.position[0] : 0.0f;
+    }
+    print_row("dict_point_lookup", "typed", size, lookups, now_ms() - started);
+
+    g_sink += (int64_t)sum;
+    oaf_dict_destroy(&erased);
+    bench_point_dict_destroy(&typed);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    static const size_t sizes[] = {1u << 10, 1u << 16, 1u << 20};
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    size_t lookups = 4000000u;
+    size_t size;
+    int ok = 1;
+
+    if (argc > 2 && strcmp(argv[1], "--lookups") == 0)
+    {
+        lookups = (size_t)strtoull(argv[2], NULL, 10);
+    }
+
+    oaf_default_allocator_init(&state, &allocator);
+    printf("workload,variant,size,ops,total_ms,ns_per_op\n");
+    for (size = 0; ok && size < sizeof(sizes) / sizeof(sizes[0]); size++)
+    {
+        uint64_t seed = 0x9E3779B97F4A7C15ull;
+        int64_t* keys = (int64_t*)malloc(sizes[size] * sizeof(int64_t));
+        size_t index;
+
+        ok = keys != NULL;
+        for (index = 0; ok && index < sizes[size]; index++)
+        {
+            keys[index] = (int64_t)next_random(&seed);
+        }
+
+        ok = ok && bench_array(sizes[size] * 16u, &allocator);
+        ok = ok && bench_i64_dict(keys, sizes[size], lookups, &allocator);
+        ok = ok && bench_point_dict(sizes[size], lookups, &allocator);
+        free(keys);
+    }
+
+    if (!ok)
+    {
+        fprintf(stderr, "typed collections benchmark failed\n");
+        return 1;
+    }
+
+    return 0;
+}
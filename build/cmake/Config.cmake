@@ -9,9 +9,13 @@ set(OAF_RUNTIME_SOURCES
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/types/src/reflection.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/types/src/interface_dispatch.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/concurrency/src/thread.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/concurrency/src/fiber_context.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/concurrency/src/stack_pool.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/concurrency/src/scheduler.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/concurrency/src/sync_primitives.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/concurrency/src/channel.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/concurrency/src/ring_channel.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/concurrency/src/spsc_channel.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/concurrency/src/atomic_ops.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/ffi/src/foreign_types.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/ffi/src/marshalling.c
@@ -22,6 +26,8 @@ set(OAF_RUNTIME_SOURCES
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/memory/src/allocators/arena_allocator.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/memory/src/allocators/pool_allocator.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/memory/src/allocators/temp_allocator.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/memory/src/allocators/thread_cache_allocator.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/memory/src/allocators/heap_profiler_allocator.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/memory/src/ownership.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/memory/src/lifetime.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/Runtime/memory/src/bounds.c
@@ -36,6 +42,7 @@ set(OAF_RUNTIME_SOURCES
     ${CMAKE_CURRENT_LIST_DIR}/../../src/stdlib/collections/list.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/stdlib/collections/dict.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/stdlib/collections/set.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/stdlib/collections/concurrent_dict.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/stdlib/io/file.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/stdlib/io/stream.c
     ${CMAKE_CURRENT_LIST_DIR}/../../src/stdlib/text/string.c
@@ -154,3 +161,52 @@ add_executable(
 )
 
 target_link_libraries(oaf_example_task_parallel PRIVATE oaf_runtime)
+
+add_executable(
+    oaf_bench_channel_throughput
+    ${CMAKE_CURRENT_LIST_DIR}/../../benchmarks/runtime/channel_throughput.c
+)
+
+target_link_libraries(oaf_bench_channel_throughput PRIVATE oaf_runtime)
+
+add_executable(
+    oaf_bench_allocator_throughput
+    ${CMAKE_CURRENT_LIST_DIR}/../../benchmarks/runtime/allocator_throughput.c
+)
+
+target_link_libraries(oaf_bench_allocator_throughput PRIVATE oaf_runtime)
+
+add_executable(
+    oaf_bench_gc_mark
+    ${CMAKE_CURRENT_LIST_DIR}/../../benchmarks/runtime/gc_mark.c
+)
+
+target_link_libraries(oaf_bench_gc_mark PRIVATE oaf_runtime)
+
+add_executable(
+    oaf_bench_hash_throughput
+    ${CMAKE_CURRENT_LIST_DIR}/../../benchmarks/runtime/hash_throughput.c
+)
+
+target_link_libraries(oaf_bench_hash_throughput PRIVATE oaf_runtime)
+
+add_executable(
+    oaf_bench_concurrent_dict_scaling
+    ${CMAKE_CURRENT_LIST_DIR}/../../benchmarks/runtime/concurrent_dict_scaling.c
+)
+
+target_link_libraries(oaf_bench_concurrent_dict_scaling PRIVATE oaf_runtime)
+
+add_executable(
+    oaf_bench_dict_batch
+    ${CMAKE_CURRENT_LIST_DIR}/../../benchmarks/runtime/dict_batch.c
+)
+
+target_link_libraries(oaf_bench_dict_batch PRIVATE oaf_runtime)
+
+add_executable(
+    oaf_bench_typed_collections
+    ${CMAKE_CURRENT_LIST_DIR}/../../benchmarks/runtime/typed_collections.c
+)
+
+target_link_libraries(oaf_bench_typed_collections PRIVATE oaf_runtime)
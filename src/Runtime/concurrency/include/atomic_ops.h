@@ -8,6 +8,16 @@
 extern "C" {
 #endif
 
+#define OAF_CACHE_LINE_SIZE 64
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OAF_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define OAF_CPU_RELAX() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define OAF_CPU_RELAX() ((void)0)
+#endif
+
 typedef struct OafAtomicI64
 {
     atomic_llong value;
@@ -2,15 +2,43 @@
 #define OAF_CHANNEL_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include "atomic_ops.h"
 #include "sync_primitives.h"
+#include "thread.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define OAF_CHANNEL_SELECT_MAX_CASES 64
+#define OAF_CHANNEL_SELECT_TIMEOUT (-1)
+#define OAF_CHANNEL_SELECT_CLOSED (-2)
+#define OAF_CHANNEL_SELECT_ERROR (-3)
+
+struct OafChannelSelector;
+
+typedef struct OafChannelWaiter
+{
+    OafLightweightThread* thread;
+    struct OafChannelSelector* selector;
+    size_t case_index;
+    struct OafChannelWaiter* next;
+    int queued;
+} OafChannelWaiter;
+
+typedef struct OafChannelWaitQueue
+{
+    OafChannelWaiter* head;
+    OafChannelWaiter* tail;
+} OafChannelWaitQueue;
+
+/* Elements are copied into the ring by value; slot_stride keeps every slot within one cache line. */
 typedef struct OafChannel
 {
-    void** buffer;
+    unsigned char* slots;
+    size_t element_size;
+    size_t slot_stride;
     size_t capacity;
     size_t count;
     size_t send_index;
@@ -19,16 +47,43 @@ typedef struct OafChannel
     OafMutex mutex;
     OafCondVar not_empty;
     OafCondVar not_full;
+    OafChannelWaitQueue recv_waiters;
+    OafChannelWaitQueue send_waiters;
 } OafChannel;
 
+typedef enum OafChannelSelectOp
+{
+    OAF_CHANNEL_SELECT_RECV = 0,
+    OAF_CHANNEL_SELECT_SEND = 1
+} OafChannelSelectOp;
+
+typedef struct OafChannelSelectCase
+{
+    OafChannel* channel;
+    OafChannelSelectOp op;
+    const void* send_element;
+    void* recv_element;
+} OafChannelSelectCase;
+
 int oaf_channel_init(OafChannel* channel, size_t capacity);
+int oaf_channel_init_typed(OafChannel* channel, size_t element_size, size_t capacity);
 void oaf_channel_destroy(OafChannel* channel);
 int oaf_channel_send(OafChannel* channel, void* value);
 int oaf_channel_try_send(OafChannel* channel, void* value);
 int oaf_channel_recv(OafChannel* channel, void** out_value);
 int oaf_channel_try_recv(OafChannel* channel, void** out_value);
+size_t oaf_channel_send_batch(OafChannel* channel, void* const* values, size_t count);
+size_t oaf_channel_recv_batch(OafChannel* channel, void** out_values, size_t max_count);
+int oaf_channel_send_value(OafChannel* channel, const void* element);
+int oaf_channel_try_send_value(OafChannel* channel, const void* element);
+int oaf_channel_recv_value(OafChannel* channel, void* out_element);
+int oaf_channel_try_recv_value(OafChannel* channel, void* out_element);
 void oaf_channel_close(OafChannel* channel);
 size_t oaf_channel_count(const OafChannel* channel);
+size_t oaf_channel_element_size(const OafChannel* channel);
+
+/* Completes the first ready case and returns its index; a negative timeout waits forever, zero only polls. */
+int oaf_channel_select(OafChannelSelectCase* cases, size_t case_count, int64_t timeout_ms);
 
 #ifdef __cplusplus
 }
@@ -1,10 +1,14 @@
 #ifndef OAF_CONCURRENCY_RUNTIME_H
 #define OAF_CONCURRENCY_RUNTIME_H
 
+#include "fiber_context.h"
+#include "stack_pool.h"
 #include "thread.h"
 #include "scheduler.h"
 #include "sync_primitives.h"
 #include "channel.h"
+#include "ring_channel.h"
+#include "spsc_channel.h"
 #include "atomic_ops.h"
 
 #endif
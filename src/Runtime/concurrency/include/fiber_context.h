@@ -0,0 +1,40 @@
+#ifndef OAF_FIBER_CONTEXT_H
+#define OAF_FIBER_CONTEXT_H
+
+#include <stddef.h>
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define OAF_FIBER_CONTEXT_ASM 1
+#else
+#define OAF_FIBER_CONTEXT_ASM 0
+#include <ucontext.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*OafFiberEntryProc)(void* argument);
+
+typedef struct OafFiberContext
+{
+#if OAF_FIBER_CONTEXT_ASM
+    void* stack_pointer;
+#else
+    ucontext_t handle;
+#endif
+} OafFiberContext;
+
+int oaf_fiber_context_make(
+    OafFiberContext* context,
+    void* stack,
+    size_t stack_size,
+    OafFiberEntryProc entry,
+    void* argument);
+void oaf_fiber_context_switch(OafFiberContext* from, OafFiberContext* to);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
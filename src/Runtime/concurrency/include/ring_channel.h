@@ -0,0 +1,52 @@
+#ifndef OAF_RING_CHANNEL_H
+#define OAF_RING_CHANNEL_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "atomic_ops.h"
+#include "sync_primitives.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OAF_RING_CHANNEL_SPIN_ROUNDS 128
+#define OAF_RING_CHANNEL_YIELD_ROUNDS 16
+
+typedef struct OafRingChannelCell
+{
+    atomic_size_t sequence;
+    void* value;
+} OafRingChannelCell;
+
+/* Vyukov bounded MPMC ring: each cell's sequence tells producers and consumers whose turn it is. */
+typedef struct OafRingChannel
+{
+    _Alignas(OAF_CACHE_LINE_SIZE) atomic_size_t enqueue_pos;
+    _Alignas(OAF_CACHE_LINE_SIZE) atomic_size_t dequeue_pos;
+    _Alignas(OAF_CACHE_LINE_SIZE) OafRingChannelCell* cells;
+    size_t mask;
+    atomic_int closed;
+    _Alignas(OAF_CACHE_LINE_SIZE) OafEventCount not_empty;
+    _Alignas(OAF_CACHE_LINE_SIZE) OafEventCount not_full;
+} OafRingChannel;
+
+int oaf_ring_channel_init(OafRingChannel* channel, size_t capacity);
+void oaf_ring_channel_destroy(OafRingChannel* channel);
+int oaf_ring_channel_send(OafRingChannel* channel, void* value);
+int oaf_ring_channel_try_send(OafRingChannel* channel, void* value);
+int oaf_ring_channel_recv(OafRingChannel* channel, void** out_value);
+int oaf_ring_channel_try_recv(OafRingChannel* channel, void** out_value);
+size_t oaf_ring_channel_send_batch(OafRingChannel* channel, void* const* values, size_t count);
+size_t oaf_ring_channel_try_send_batch(OafRingChannel* channel, void* const* values, size_t count);
+size_t oaf_ring_channel_recv_batch(OafRingChannel* channel, void** out_values, size_t max_count);
+size_t oaf_ring_channel_try_recv_batch(OafRingChannel* channel, void** out_values, size_t max_count);
+void oaf_ring_channel_close(OafRingChannel* channel);
+size_t oaf_ring_channel_count(const OafRingChannel* channel);
+size_t oaf_ring_channel_capacity(const OafRingChannel* channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,49 +3,120 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
 #include "thread.h"
+#include "atomic_ops.h"
+#include "stack_pool.h"
+#include "sync_primitives.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define OAF_SCHEDULER_MAX_WORKERS 8
-#define OAF_SCHEDULER_QUEUE_CAPACITY 256
-#define OAF_SCHEDULER_MAX_THREADS 512
+#define OAF_SCHEDULER_QUEUE_INITIAL_CAPACITY 256
+#define OAF_SCHEDULER_SLAB_SIZE 256
+#define OAF_SCHEDULER_SPIN_ROUNDS 64
 
+/* Retired buffers stay reachable from the live one until shutdown, since thieves may still read them. */
+typedef struct OafWorkStealingBuffer
+{
+    size_t capacity;
+    struct OafWorkStealingBuffer* retired;
+    _Atomic(OafLightweightThread*) entries[];
+} OafWorkStealingBuffer;
+
+/* Chase-Lev deque: the owning worker pushes and pops at the bottom, thieves CAS the top. */
 typedef struct OafWorkStealingQueue
 {
-    OafLightweightThread* entries[OAF_SCHEDULER_QUEUE_CAPACITY];
-    size_t head;
-    size_t tail;
-    size_t count;
+    _Alignas(OAF_CACHE_LINE_SIZE) atomic_ptrdiff_t top;
+    _Alignas(OAF_CACHE_LINE_SIZE) atomic_ptrdiff_t bottom;
+    _Alignas(OAF_CACHE_LINE_SIZE) _Atomic(OafWorkStealingBuffer*) buffer;
 } OafWorkStealingQueue;
 
 typedef struct OafSchedulerStats
 {
-    size_t enqueued;
-    size_t executed;
-    size_t stolen;
-    size_t failed_spawns;
+    atomic_size_t enqueued;
+    atomic_size_t executed;
+    atomic_size_t stolen;
+    atomic_size_t failed_spawns;
+    atomic_size_t parks;
+    atomic_size_t yielded;
+    atomic_size_t parked;
+    atomic_size_t recycled;
 } OafSchedulerStats;
 
+struct OafThreadScheduler;
+
+/* Deadline for a parked stackful thread; lives on that thread's stack and is linked in deadline order. */
+typedef struct OafSchedulerTimer
+{
+    uint64_t deadline_ns;
+    OafLightweightThread* thread;
+    struct OafSchedulerTimer* next;
+    int armed;
+} OafSchedulerTimer;
+
+typedef struct OafSchedulerWorker
+{
+    struct OafThreadScheduler* scheduler;
+    size_t index;
+    pthread_t handle;
+} OafSchedulerWorker;
+
 typedef struct OafThreadScheduler
 {
     OafWorkStealingQueue worker_queues[OAF_SCHEDULER_MAX_WORKERS];
-    OafLightweightThread thread_pool[OAF_SCHEDULER_MAX_THREADS];
-    size_t thread_count;
     size_t worker_count;
-    size_t rr_worker;
-    uint64_t next_thread_id;
+    atomic_size_t rr_worker;
+    atomic_ullong next_thread_id;
     OafSchedulerStats stats;
+
+    OafSchedulerWorker workers[OAF_SCHEDULER_MAX_WORKERS];
+    size_t started_workers;
+    atomic_int running;
+
+    OafMutex inject_mutex;
+    OafLightweightThread* inject_head;
+    OafLightweightThread* inject_tail;
+    atomic_size_t inject_count;
+
+    OafMutex park_mutex;
+    OafCondVar work_available;
+    OafCondVar idle;
+    atomic_uint wake_epoch;
+    atomic_size_t sleeping_workers;
+    atomic_size_t in_flight;
+
+    OafMutex timer_mutex;
+    OafSchedulerTimer* timers;
+    atomic_ullong next_timer_ns;
+
+    OafMutex slab_mutex;
+    OafLightweightThread** slabs;
+    size_t slab_count;
+    size_t slab_capacity;
+    OafLightweightThread* free_threads;
+    size_t live_threads;
+
+    OafStackPool stack_pool;
 } OafThreadScheduler;
 
 int oaf_scheduler_init(OafThreadScheduler* scheduler, size_t worker_count);
 void oaf_scheduler_shutdown(OafThreadScheduler* scheduler);
+int oaf_scheduler_start(OafThreadScheduler* scheduler);
+void oaf_scheduler_stop(OafThreadScheduler* scheduler);
+int oaf_scheduler_is_running(const OafThreadScheduler* scheduler);
+int oaf_scheduler_wait_idle(OafThreadScheduler* scheduler);
 OafLightweightThread* oaf_scheduler_spawn(
     OafThreadScheduler* scheduler,
     OafLightweightThreadProc proc,
     void* proc_args);
+OafLightweightThread* oaf_scheduler_spawn_stackful(
+    OafThreadScheduler* scheduler,
+    OafLightweightThreadProc proc,
+    void* proc_args);
 int oaf_scheduler_run_next(OafThreadScheduler* scheduler, size_t worker_index);
 size_t oaf_scheduler_run_all(OafThreadScheduler* scheduler);
 int oaf_scheduler_steal(
@@ -54,6 +125,23 @@ int oaf_scheduler_steal(
     OafLightweightThread** thread_out);
 size_t oaf_scheduler_pending_count(const OafThreadScheduler* scheduler);
 const OafSchedulerStats* oaf_scheduler_stats(const OafThreadScheduler* scheduler);
+size_t oaf_scheduler_live_threads(OafThreadScheduler* scheduler);
+size_t oaf_scheduler_thread_capacity(OafThreadScheduler* scheduler);
+
+/* Descriptors are recycled once a thread finishes; handles go stale instead of aliasing the next occupant. */
+OafThreadHandle oaf_scheduler_thread_handle(const OafLightweightThread* thread);
+OafLightweightThread* oaf_scheduler_thread_lookup(OafThreadScheduler* scheduler, OafThreadHandle handle);
+int oaf_scheduler_thread_is_done(OafThreadScheduler* scheduler, OafThreadHandle handle);
+
+OafLightweightThread* oaf_thread_current(void);
+int oaf_thread_yield(void);
+int oaf_thread_park(void);
+int oaf_thread_park_unlock(OafMutex* mutex);
+/* Parks until unparked or until the monotonic clock reaches deadline_ns; wakeups may be spurious. */
+int oaf_thread_park_until(uint64_t deadline_ns);
+/* Finishes a prepared event-count wait by parking the green thread; returns 0 outside one, with the wait untouched. */
+int oaf_thread_wait_event(OafEventCount* event_count, unsigned int key);
+void oaf_thread_unpark(OafLightweightThread* thread);
 
 #ifdef __cplusplus
 }
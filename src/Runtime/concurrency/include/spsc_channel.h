@@ -0,0 +1,47 @@
+#ifndef OAF_SPSC_CHANNEL_H
+#define OAF_SPSC_CHANNEL_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "atomic_ops.h"
+#include "sync_primitives.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OAF_SPSC_CHANNEL_MAX_ELEMENT_SIZE OAF_CACHE_LINE_SIZE
+#define OAF_SPSC_CHANNEL_SPIN_ROUNDS 128
+#define OAF_SPSC_CHANNEL_YIELD_ROUNDS 16
+
+/* One producer, one consumer: each side owns its index and only caches the other's. */
+typedef struct OafSpscChannel
+{
+    _Alignas(OAF_CACHE_LINE_SIZE) atomic_size_t tail;
+    size_t cached_head;
+    _Alignas(OAF_CACHE_LINE_SIZE) atomic_size_t head;
+    size_t cached_tail;
+    _Alignas(OAF_CACHE_LINE_SIZE) unsigned char* slots;
+    size_t element_size;
+    size_t slot_stride;
+    size_t mask;
+    atomic_int closed;
+    OafEventCount not_empty;
+    OafEventCount not_full;
+} OafSpscChannel;
+
+int oaf_spsc_channel_init(OafSpscChannel* channel, size_t element_size, size_t capacity);
+void oaf_spsc_channel_destroy(OafSpscChannel* channel);
+int oaf_spsc_channel_send(OafSpscChannel* channel, const void* element);
+int oaf_spsc_channel_try_send(OafSpscChannel* channel, const void* element);
+int oaf_spsc_channel_recv(OafSpscChannel* channel, void* out_element);
+int oaf_spsc_channel_try_recv(OafSpscChannel* channel, void* out_element);
+void oaf_spsc_channel_close(OafSpscChannel* channel);
+size_t oaf_spsc_channel_count(const OafSpscChannel* channel);
+size_t oaf_spsc_channel_capacity(const OafSpscChannel* channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef OAF_STACK_POOL_H
+#define OAF_STACK_POOL_H
+
+#include <stddef.h>
+#include "sync_primitives.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OAF_STACK_POOL_DEFAULT_STACK_SIZE (64u * 1024u)
+#define OAF_STACK_POOL_DEFAULT_MAX_CACHED 256u
+
+typedef struct OafStackPoolEntry OafStackPoolEntry;
+
+typedef struct OafStackPool
+{
+    OafMutex mutex;
+    OafStackPoolEntry* free_list;
+    size_t stack_size;
+    size_t guard_size;
+    size_t cached_count;
+    size_t max_cached;
+    size_t active_count;
+} OafStackPool;
+
+int oaf_stack_pool_init(OafStackPool* pool, size_t stack_size, size_t max_cached);
+void oaf_stack_pool_destroy(OafStackPool* pool);
+void* oaf_stack_pool_acquire(OafStackPool* pool);
+void oaf_stack_pool_release(OafStackPool* pool, void* stack);
+size_t oaf_stack_pool_stack_size(const OafStackPool* pool);
+size_t oaf_stack_pool_active_count(const OafStackPool* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,6 +2,8 @@
 #define OAF_SYNC_PRIMITIVES_H
 
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,9 +29,44 @@ int oaf_mutex_unlock(OafMutex* mutex);
 int oaf_cond_var_init(OafCondVar* cond_var);
 void oaf_cond_var_destroy(OafCondVar* cond_var);
 int oaf_cond_var_wait(OafCondVar* cond_var, OafMutex* mutex);
+int oaf_cond_var_timed_wait(OafCondVar* cond_var, OafMutex* mutex, uint64_t timeout_ns);
 int oaf_cond_var_signal(OafCondVar* cond_var);
 int oaf_cond_var_broadcast(OafCondVar* cond_var);
 
+/* Sleeps while *word == expected; uses futex(2) on Linux and a yield loop elsewhere. */
+void oaf_futex_wait(atomic_uint* word, unsigned int expected);
+void oaf_futex_wake(atomic_uint* word, int waiter_count);
+
+/* Waiter that cannot block its OS thread (a green thread); notify calls wake(context) instead of a futex wake. */
+typedef struct OafEventWaiter
+{
+    void (*wake)(void* context);
+    void* context;
+    struct OafEventWaiter* next;
+    int queued;
+} OafEventWaiter;
+
+/* Futex event count: register, re-check the condition, then wait; notifiers skip the syscall when nobody waits. */
+typedef struct OafEventCount
+{
+    atomic_uint epoch;
+    atomic_uint waiters;
+    atomic_flag parked_lock;
+    OafEventWaiter* parked;
+} OafEventCount;
+
+void oaf_event_count_init(OafEventCount* event_count);
+unsigned int oaf_event_count_prepare_wait(OafEventCount* event_count);
+void oaf_event_count_cancel_wait(OafEventCount* event_count);
+void oaf_event_count_wait(OafEventCount* event_count, unsigned int key);
+void oaf_event_count_notify(OafEventCount* event_count, int waiter_count);
+/* Callback form of wait: queues waiter unless the epoch already moved past key (returns 0); the waiter must
+   then suspend itself and call oaf_event_count_remove_waiter once resumed, woken or not. */
+int oaf_event_count_add_waiter(OafEventCount* event_count, unsigned int key, OafEventWaiter* waiter);
+void oaf_event_count_remove_waiter(OafEventCount* event_count, OafEventWaiter* waiter);
+
+uint64_t oaf_monotonic_time_ns(void);
+
 #ifdef __cplusplus
 }
 #endif
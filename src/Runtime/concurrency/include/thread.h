@@ -1,7 +1,11 @@
 #ifndef OAF_THREAD_H
 #define OAF_THREAD_H
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdatomic.h>
+#include "fiber_context.h"
+#include "sync_primitives.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,19 +18,51 @@ typedef enum OafThreadState
     OAF_THREAD_STATE_RUNNING = 2,
     OAF_THREAD_STATE_COMPLETED = 3,
     OAF_THREAD_STATE_FAILED = 4,
-    OAF_THREAD_STATE_CANCELLED = 5
+    OAF_THREAD_STATE_CANCELLED = 5,
+    OAF_THREAD_STATE_PARKED = 6
 } OafThreadState;
 
+typedef enum OafThreadSwitchReason
+{
+    OAF_THREAD_SWITCH_NONE = 0,
+    OAF_THREAD_SWITCH_YIELD = 1,
+    OAF_THREAD_SWITCH_PARK = 2,
+    OAF_THREAD_SWITCH_COMPLETE = 3
+} OafThreadSwitchReason;
+
+typedef enum OafThreadParkState
+{
+    OAF_THREAD_PARK_IDLE = 0,
+    OAF_THREAD_PARK_PERMIT = 1,
+    OAF_THREAD_PARK_PARKED = 2
+} OafThreadParkState;
+
 typedef void* (*OafLightweightThreadProc)(void* args);
 
+struct OafThreadScheduler;
+
+typedef uint64_t OafThreadHandle;
+
+#define OAF_THREAD_HANDLE_INVALID ((OafThreadHandle)0)
+
 typedef struct OafLightweightThread
 {
     uint64_t id;
+    uint32_t slot;
+    atomic_uint generation;
     OafThreadState state;
     OafLightweightThreadProc proc;
     void* proc_args;
     void* result;
     struct OafLightweightThread* next;
+    struct OafThreadScheduler* scheduler;
+    void* stack;
+    size_t stack_size;
+    OafFiberContext context;
+    OafFiberContext* return_context;
+    OafThreadSwitchReason switch_reason;
+    OafMutex* park_unlock;
+    atomic_int park_state;
 } OafLightweightThread;
 
 void oaf_lightweight_thread_init(
@@ -36,6 +72,7 @@ void oaf_lightweight_thread_init(
     void* proc_args);
 int oaf_lightweight_thread_run(OafLightweightThread* thread);
 int oaf_lightweight_thread_is_done(const OafLightweightThread* thread);
+int oaf_lightweight_thread_is_stackful(const OafLightweightThread* thread);
 
 #ifdef __cplusplus
 }
@@ -1,37 +1,348 @@
+#include <stdatomic.h>
 #include <stdlib.h>
+#include <string.h>
 #include "channel.h"
+#include "scheduler.h"
+
+typedef struct OafChannelSelector
+{
+    OafLightweightThread* thread;
+    OafMutex mutex;
+    OafCondVar cond_var;
+    atomic_int fired;
+    size_t fired_case;
+} OafChannelSelector;
+
+static int selector_fire(OafChannelSelector* selector, size_t case_index)
+{
+    int expected = 0;
+
+    if (!atomic_compare_exchange_strong(&selector->fired, &expected, 1))
+    {
+        return 0;
+    }
+
+    selector->fired_case = case_index;
+    if (selector->thread != NULL)
+    {
+        oaf_thread_unpark(selector->thread);
+        return 1;
+    }
+
+    oaf_mutex_lock(&selector->mutex);
+    oaf_cond_var_signal(&selector->cond_var);
+    oaf_mutex_unlock(&selector->mutex);
+    return 1;
+}
+
+static void wait_queue_init(OafChannelWaitQueue* queue)
+{
+    queue->head = NULL;
+    queue->tail = NULL;
+}
+
+static void wait_queue_push(OafChannelWaitQueue* queue, OafChannelWaiter* waiter)
+{
+    waiter->next = NULL;
+    waiter->queued = 1;
+    if (queue->tail == NULL)
+    {
+        queue->head = waiter;
+    }
+    else
+    {
+        queue->tail->next = waiter;
+    }
+    queue->tail = waiter;
+}
+
+static void wait_queue_remove(OafChannelWaitQueue* queue, OafChannelWaiter* waiter)
+{
+    OafChannelWaiter* previous = NULL;
+    OafChannelWaiter* current = queue->head;
+
+    while (current != NULL && current != waiter)
+    {
+        previous = current;
+        current = current->next;
+    }
+
+    if (current == NULL)
+    {
+        return;
+    }
+
+    if (previous == NULL)
+    {
+        queue->head = current->next;
+    }
+    else
+    {
+        previous->next = current->next;
+    }
+
+    if (queue->tail == current)
+    {
+        queue->tail = previous;
+    }
+
+    current->next = NULL;
+    current->queued = 0;
+}
+
+static void wait_queue_wake_one(OafChannelWaitQueue* queue)
+{
+    OafChannelWaiter* waiter;
+
+    while ((waiter = queue->head) != NULL)
+    {
+        OafLightweightThread* thread = waiter->thread;
+        OafChannelSelector* selector = waiter->selector;
+        size_t case_index = waiter->case_index;
+
+        queue->head = waiter->next;
+        if (queue->head == NULL)
+        {
+            queue->tail = NULL;
+        }
+
+        waiter->next = NULL;
+        waiter->queued = 0;
+
+        if (selector == NULL)
+        {
+            oaf_thread_unpark(thread);
+            return;
+        }
+
+        if (selector_fire(selector, case_index))
+        {
+            return;
+        }
+    }
+}
+
+static void wait_queue_wake_all(OafChannelWaitQueue* queue)
+{
+    while (queue->head != NULL)
+    {
+        wait_queue_wake_one(queue);
+    }
+}
+
+static int channel_wait(OafChannel* channel, OafCondVar* cond_var, OafChannelWaitQueue* queue)
+{
+    OafLightweightThread* current = oaf_thread_current();
+    OafChannelWaiter waiter;
+
+    if (current == NULL)
+    {
+        return oaf_cond_var_wait(cond_var, &channel->mutex);
+    }
+
+    waiter.thread = current;
+    waiter.selector = NULL;
+    waiter.case_index = 0;
+    wait_queue_push(queue, &waiter);
+    oaf_thread_park_unlock(&channel->mutex);
+
+    if (!oaf_mutex_lock(&channel->mutex))
+    {
+        return 0;
+    }
+
+    if (waiter.queued)
+    {
+        wait_queue_remove(queue, &waiter);
+    }
+
+    return 1;
+}
+
+static size_t slot_stride_for(size_t element_size)
+{
+    size_t stride = 1;
+
+    if (element_size > OAF_CACHE_LINE_SIZE)
+    {
+        return (element_size + OAF_CACHE_LINE_SIZE - 1u) / OAF_CACHE_LINE_SIZE * OAF_CACHE_LINE_SIZE;
+    }
+
+    while (stride < element_size)
+    {
+        stride <<= 1;
+    }
+
+    return stride;
+}
+
+static unsigned char* channel_slot(const OafChannel* channel, size_t index)
+{
+    return channel->slots + index * channel->slot_stride;
+}
+
+static void channel_push(OafChannel* channel, const void* element)
+{
+    memcpy(channel_slot(channel, channel->send_index), element, channel->element_size);
+    channel->send_index = (channel->send_index + 1) % channel->capacity;
+    channel->count++;
+}
+
+static void channel_pop(OafChannel* channel, void* out_element)
+{
+    memcpy(out_element, channel_slot(channel, channel->recv_index), channel->element_size);
+    channel->recv_index = (channel->recv_index + 1) % channel->capacity;
+    channel->count--;
+}
+
+static void wake_waiters(OafCondVar* cond_var, OafChannelWaitQueue* queue, size_t moved)
+{
+    size_t index;
+
+    if (moved == 1)
+    {
+        oaf_cond_var_signal(cond_var);
+    }
+    else
+    {
+        oaf_cond_var_broadcast(cond_var);
+    }
+
+    for (index = 0; index < moved && queue->head != NULL; index++)
+    {
+        wait_queue_wake_one(queue);
+    }
+}
+
+static size_t channel_send_many(OafChannel* channel, const unsigned char* elements, size_t count, int blocking)
+{
+    size_t sent = 0;
+
+    if (!oaf_mutex_lock(&channel->mutex))
+    {
+        return 0;
+    }
+
+    while (sent < count)
+    {
+        size_t moved = 0;
+
+        while (blocking && !channel->closed && channel->count == channel->capacity)
+        {
+            if (!channel_wait(channel, &channel->not_full, &channel->send_waiters))
+            {
+                oaf_mutex_unlock(&channel->mutex);
+                return sent;
+            }
+        }
+
+        if (channel->closed || channel->count == channel->capacity)
+        {
+            break;
+        }
+
+        while (sent < count && channel->count < channel->capacity)
+        {
+            channel_push(channel, elements + sent * channel->element_size);
+            sent++;
+            moved++;
+        }
+
+        wake_waiters(&channel->not_empty, &channel->recv_waiters, moved);
+    }
+
+    oaf_mutex_unlock(&channel->mutex);
+    return sent;
+}
+
+static size_t channel_recv_many(OafChannel* channel, unsigned char* out_elements, size_t max_count, int blocking)
+{
+    size_t received = 0;
+
+    if (!oaf_mutex_lock(&channel->mutex))
+    {
+        return 0;
+    }
+
+    while (blocking && channel->count == 0 && !channel->closed)
+    {
+        if (!channel_wait(channel, &channel->not_empty, &channel->recv_waiters))
+        {
+            oaf_mutex_unlock(&channel->mutex);
+            return 0;
+        }
+    }
+
+    while (received < max_count && channel->count > 0)
+    {
+        channel_pop(channel, out_elements + received * channel->element_size);
+        received++;
+    }
+
+    if (received > 0)
+    {
+        wake_waiters(&channel->not_full, &channel->send_waiters, received);
+    }
+
+    oaf_mutex_unlock(&channel->mutex);
+    return received;
+}
+
+static int is_pointer_channel(const OafChannel* channel)
+{
+    return channel != NULL && channel->slots != NULL && channel->element_size == sizeof(void*);
+}
 
 int oaf_channel_init(OafChannel* channel, size_t capacity)
 {
-    if (channel == NULL || capacity == 0)
+    return oaf_channel_init_typed(channel, sizeof(void*), capacity);
+}
+
+int oaf_channel_init_typed(OafChannel* channel, size_t element_size, size_t capacity)
+{
+    size_t stride;
+    size_t bytes;
+
+    if (channel == NULL || capacity == 0 || element_size == 0)
     {
         return 0;
     }
 
-    channel->buffer = (void**)malloc(sizeof(void*) * capacity);
-    if (channel->buffer == NULL)
+    stride = slot_stride_for(element_size);
+    if (capacity > ((size_t)-1 - OAF_CACHE_LINE_SIZE) / stride)
     {
         return 0;
     }
 
+    bytes = (stride * capacity + OAF_CACHE_LINE_SIZE - 1u) / OAF_CACHE_LINE_SIZE * OAF_CACHE_LINE_SIZE;
+    channel->slots = (unsigned char*)aligned_alloc(OAF_CACHE_LINE_SIZE, bytes);
+    if (channel->slots == NULL)
+    {
+        return 0;
+    }
+
+    channel->element_size = element_size;
+    channel->slot_stride = stride;
     channel->capacity = capacity;
     channel->count = 0;
     channel->send_index = 0;
     channel->recv_index = 0;
     channel->closed = 0;
+    wait_queue_init(&channel->recv_waiters);
+    wait_queue_init(&channel->send_waiters);
 
     if (!oaf_mutex_init(&channel->mutex))
     {
-        free(channel->buffer);
-        channel->buffer = NULL;
+        free(channel->slots);
+        channel->slots = NULL;
         return 0;
     }
 
     if (!oaf_cond_var_init(&channel->not_empty))
     {
         oaf_mutex_destroy(&channel->mutex);
-        free(channel->buffer);
-        channel->buffer = NULL;
+        free(channel->slots);
+        channel->slots = NULL;
         return 0;
     }
 
@@ -39,8 +350,8 @@ int oaf_channel_init(OafChannel* channel, size_t capacity)
     {
         oaf_cond_var_destroy(&channel->not_empty);
         oaf_mutex_destroy(&channel->mutex);
-        free(channel->buffer);
-        channel->buffer = NULL;
+        free(channel->slots);
+        channel->slots = NULL;
         return 0;
     }
 
@@ -54,10 +365,10 @@ void oaf_channel_destroy(OafChannel* channel)
         return;
     }
 
-    if (channel->buffer != NULL)
+    if (channel->slots != NULL)
     {
-        free(channel->buffer);
-        channel->buffer = NULL;
+        free(channel->slots);
+        channel->slots = NULL;
     }
 
     oaf_cond_var_destroy(&channel->not_full);
@@ -68,156 +379,394 @@ void oaf_channel_destroy(OafChannel* channel)
     channel->send_index = 0;
     channel->recv_index = 0;
     channel->closed = 1;
+    wait_queue_init(&channel->recv_waiters);
+    wait_queue_init(&channel->send_waiters);
 }
 
 int oaf_channel_try_send(OafChannel* channel, void* value)
 {
-    int result = 0;
-
-    if (channel == NULL || channel->buffer == NULL)
+    if (!is_pointer_channel(channel))
     {
         return 0;
     }
 
-    if (!oaf_mutex_lock(&channel->mutex))
+    return channel_send_many(channel, (const unsigned char*)&value, 1, 0) == 1;
+}
+
+int oaf_channel_send(OafChannel* channel, void* value)
+{
+    if (!is_pointer_channel(channel))
     {
         return 0;
     }
 
-    if (!channel->closed && channel->count < channel->capacity)
+    return channel_send_many(channel, (const unsigned char*)&value, 1, 1) == 1;
+}
+
+int oaf_channel_try_recv(OafChannel* channel, void** out_value)
+{
+    if (!is_pointer_channel(channel) || out_value == NULL)
     {
-        channel->buffer[channel->send_index] = value;
-        channel->send_index = (channel->send_index + 1) % channel->capacity;
-        channel->count++;
-        result = 1;
-        oaf_cond_var_signal(&channel->not_empty);
+        return 0;
     }
 
-    oaf_mutex_unlock(&channel->mutex);
-    return result;
+    return channel_recv_many(channel, (unsigned char*)out_value, 1, 0) == 1;
 }
 
-int oaf_channel_send(OafChannel* channel, void* value)
+int oaf_channel_recv(OafChannel* channel, void** out_value)
 {
-    if (channel == NULL || channel->buffer == NULL)
+    if (!is_pointer_channel(channel) || out_value == NULL)
     {
         return 0;
     }
 
-    if (!oaf_mutex_lock(&channel->mutex))
+    return channel_recv_many(channel, (unsigned char*)out_value, 1, 1) == 1;
+}
+
+size_t oaf_channel_send_batch(OafChannel* channel, void* const* values, size_t count)
+{
+    if (!is_pointer_channel(channel) || values == NULL)
     {
         return 0;
     }
 
-    while (!channel->closed && channel->count == channel->capacity)
+    return channel_send_many(channel, (const unsigned char*)values, count, 1);
+}
+
+size_t oaf_channel_recv_batch(OafChannel* channel, void** out_values, size_t max_count)
+{
+    if (!is_pointer_channel(channel) || out_values == NULL || max_count == 0)
     {
-        if (!oaf_cond_var_wait(&channel->not_full, &channel->mutex))
-        {
-            oaf_mutex_unlock(&channel->mutex);
-            return 0;
-        }
+        return 0;
     }
 
-    if (channel->closed)
+    return channel_recv_many(channel, (unsigned char*)out_values, max_count, 1);
+}
+
+int oaf_channel_send_value(OafChannel* channel, const void* element)
+{
+    if (channel == NULL || channel->slots == NULL || element == NULL)
     {
-        oaf_mutex_unlock(&channel->mutex);
         return 0;
     }
 
-    channel->buffer[channel->send_index] = value;
-    channel->send_index = (channel->send_index + 1) % channel->capacity;
-    channel->count++;
-    oaf_cond_var_signal(&channel->not_empty);
-    oaf_mutex_unlock(&channel->mutex);
-    return 1;
+    return channel_send_many(channel, (const unsigned char*)element, 1, 1) == 1;
 }
 
-int oaf_channel_try_recv(OafChannel* channel, void** out_value)
+int oaf_channel_try_send_value(OafChannel* channel, const void* element)
 {
-    int result = 0;
+    if (channel == NULL || channel->slots == NULL || element == NULL)
+    {
+        return 0;
+    }
+
+    return channel_send_many(channel, (const unsigned char*)element, 1, 0) == 1;
+}
 
-    if (channel == NULL || channel->buffer == NULL || out_value == NULL)
+int oaf_channel_recv_value(OafChannel* channel, void* out_element)
+{
+    if (channel == NULL || channel->slots == NULL || out_element == NULL)
     {
         return 0;
     }
 
-    if (!oaf_mutex_lock(&channel->mutex))
+    return channel_recv_many(channel, (unsigned char*)out_element, 1, 1) == 1;
+}
+
+int oaf_channel_try_recv_value(OafChannel* channel, void* out_element)
+{
+    if (channel == NULL || channel->slots == NULL || out_element == NULL)
     {
         return 0;
     }
 
-    if (channel->count > 0)
+    return channel_recv_many(channel, (unsigned char*)out_element, 1, 0) == 1;
+}
+
+void oaf_channel_close(OafChannel* channel)
+{
+    if (channel == NULL || channel->slots == NULL)
     {
-        *out_value = channel->buffer[channel->recv_index];
-        channel->recv_index = (channel->recv_index + 1) % channel->capacity;
-        channel->count--;
-        result = 1;
-        oaf_cond_var_signal(&channel->not_full);
+        return;
+    }
+
+    if (!oaf_mutex_lock(&channel->mutex))
+    {
+        return;
     }
 
+    channel->closed = 1;
+    oaf_cond_var_broadcast(&channel->not_empty);
+    oaf_cond_var_broadcast(&channel->not_full);
+    wait_queue_wake_all(&channel->recv_waiters);
+    wait_queue_wake_all(&channel->send_waiters);
     oaf_mutex_unlock(&channel->mutex);
-    return result;
 }
 
-int oaf_channel_recv(OafChannel* channel, void** out_value)
+size_t oaf_channel_count(const OafChannel* channel)
 {
-    if (channel == NULL || channel->buffer == NULL || out_value == NULL)
+    if (channel == NULL)
     {
         return 0;
     }
 
-    if (!oaf_mutex_lock(&channel->mutex))
+    return channel->count;
+}
+
+size_t oaf_channel_element_size(const OafChannel* channel)
+{
+    if (channel == NULL)
     {
         return 0;
     }
 
-    while (channel->count == 0 && !channel->closed)
+    return channel->element_size;
+}
+
+typedef enum SelectCaseStatus
+{
+    SELECT_CASE_BLOCKED = 0,
+    SELECT_CASE_DONE = 1,
+    SELECT_CASE_CLOSED = 2
+} SelectCaseStatus;
+
+static OafChannelWaitQueue* select_case_queue(const OafChannelSelectCase* select_case)
+{
+    return select_case->op == OAF_CHANNEL_SELECT_SEND
+        ? &select_case->channel->send_waiters
+        : &select_case->channel->recv_waiters;
+}
+
+static SelectCaseStatus select_try_case(OafChannelSelectCase* select_case)
+{
+    OafChannel* channel = select_case->channel;
+
+    if (select_case->op == OAF_CHANNEL_SELECT_SEND)
     {
-        if (!oaf_cond_var_wait(&channel->not_empty, &channel->mutex))
+        if (channel->closed)
         {
-            oaf_mutex_unlock(&channel->mutex);
-            return 0;
+            return SELECT_CASE_CLOSED;
+        }
+
+        if (channel->count == channel->capacity)
+        {
+            return SELECT_CASE_BLOCKED;
         }
+
+        channel_push(channel, select_case->send_element);
+        wake_waiters(&channel->not_empty, &channel->recv_waiters, 1);
+        return SELECT_CASE_DONE;
     }
 
-    if (channel->count == 0 && channel->closed)
+    if (channel->count == 0)
     {
-        oaf_mutex_unlock(&channel->mutex);
-        return 0;
+        return channel->closed ? SELECT_CASE_CLOSED : SELECT_CASE_BLOCKED;
     }
 
-    *out_value = channel->buffer[channel->recv_index];
-    channel->recv_index = (channel->recv_index + 1) % channel->capacity;
-    channel->count--;
-    oaf_cond_var_signal(&channel->not_full);
-    oaf_mutex_unlock(&channel->mutex);
-    return 1;
+    channel_pop(channel, select_case->recv_element);
+    wake_waiters(&channel->not_full, &channel->send_waiters, 1);
+    return SELECT_CASE_DONE;
 }
 
-void oaf_channel_close(OafChannel* channel)
+static void select_unregister(OafChannelSelectCase* cases, OafChannelWaiter* waiters, size_t case_count)
 {
-    if (channel == NULL || channel->buffer == NULL)
+    size_t index;
+
+    for (index = 0; index < case_count; index++)
     {
-        return;
+        if (waiters[index].selector == NULL)
+        {
+            continue;
+        }
+
+        oaf_mutex_lock(&cases[index].channel->mutex);
+        if (waiters[index].queued)
+        {
+            wait_queue_remove(select_case_queue(&cases[index]), &waiters[index]);
+        }
+        oaf_mutex_unlock(&cases[index].channel->mutex);
+        waiters[index].selector = NULL;
     }
+}
 
-    if (!oaf_mutex_lock(&channel->mutex))
+static void select_pass_wakeup(OafChannelSelectCase* select_case)
+{
+    OafChannel* channel = select_case->channel;
+
+    oaf_mutex_lock(&channel->mutex);
+    if (select_case->op == OAF_CHANNEL_SELECT_SEND)
+    {
+        wake_waiters(&channel->not_full, &channel->send_waiters, 1);
+    }
+    else
     {
+        wake_waiters(&channel->not_empty, &channel->recv_waiters, 1);
+    }
+    oaf_mutex_unlock(&channel->mutex);
+}
+
+static void select_block(OafChannelSelector* selector, int64_t timeout_ms, uint64_t deadline)
+{
+    if (selector->thread != NULL)
+    {
+        while (!atomic_load(&selector->fired))
+        {
+            if (timeout_ms < 0)
+            {
+                oaf_thread_park();
+            }
+            else if (oaf_monotonic_time_ns() < deadline)
+            {
+                oaf_thread_park_until(deadline);
+            }
+            else
+            {
+                return;
+            }
+        }
         return;
     }
 
-    channel->closed = 1;
-    oaf_cond_var_broadcast(&channel->not_empty);
-    oaf_cond_var_broadcast(&channel->not_full);
-    oaf_mutex_unlock(&channel->mutex);
+    oaf_mutex_lock(&selector->mutex);
+    while (!atomic_load(&selector->fired))
+    {
+        uint64_t now;
+
+        if (timeout_ms < 0)
+        {
+            oaf_cond_var_wait(&selector->cond_var, &selector->mutex);
+            continue;
+        }
+
+        now = oaf_monotonic_time_ns();
+        if (now >= deadline)
+        {
+            break;
+        }
+
+        oaf_cond_var_timed_wait(&selector->cond_var, &selector->mutex, deadline - now);
+    }
+    oaf_mutex_unlock(&selector->mutex);
 }
 
-size_t oaf_channel_count(const OafChannel* channel)
+int oaf_channel_select(OafChannelSelectCase* cases, size_t case_count, int64_t timeout_ms)
 {
-    if (channel == NULL)
+    OafChannelWaiter waiters[OAF_CHANNEL_SELECT_MAX_CASES];
+    OafChannelSelector selector;
+    uint64_t deadline = 0;
+    int result = OAF_CHANNEL_SELECT_TIMEOUT;
+    int woken_by = -1;
+    size_t index;
+
+    if (cases == NULL || case_count == 0 || case_count > OAF_CHANNEL_SELECT_MAX_CASES)
     {
-        return 0;
+        return OAF_CHANNEL_SELECT_ERROR;
     }
 
-    return channel->count;
+    for (index = 0; index < case_count; index++)
+    {
+        OafChannelSelectCase* select_case = &cases[index];
+
+        if (select_case->channel == NULL
+            || select_case->channel->slots == NULL
+            || (select_case->op == OAF_CHANNEL_SELECT_SEND && select_case->send_element == NULL)
+            || (select_case->op == OAF_CHANNEL_SELECT_RECV && select_case->recv_element == NULL))
+        {
+            return OAF_CHANNEL_SELECT_ERROR;
+        }
+
+        waiters[index].selector = NULL;
+        waiters[index].queued = 0;
+    }
+
+    selector.thread = oaf_thread_current();
+    if (selector.thread == NULL)
+    {
+        if (!oaf_mutex_init(&selector.mutex))
+        {
+            return OAF_CHANNEL_SELECT_ERROR;
+        }
+
+        if (!oaf_cond_var_init(&selector.cond_var))
+        {
+            oaf_mutex_destroy(&selector.mutex);
+            return OAF_CHANNEL_SELECT_ERROR;
+        }
+    }
+
+    if (timeout_ms > 0)
+    {
+        deadline = oaf_monotonic_time_ns() + (uint64_t)timeout_ms * 1000000u;
+    }
+
+    while (1)
+    {
+        size_t closed_cases = 0;
+
+        atomic_init(&selector.fired, 0);
+        selector.fired_case = 0;
+        result = OAF_CHANNEL_SELECT_TIMEOUT;
+
+        for (index = 0; index < case_count && result == OAF_CHANNEL_SELECT_TIMEOUT; index++)
+        {
+            OafChannelSelectCase* select_case = &cases[index];
+            SelectCaseStatus status;
+
+            oaf_mutex_lock(&select_case->channel->mutex);
+            status = select_try_case(select_case);
+            if (status == SELECT_CASE_DONE)
+            {
+                result = (int)index;
+            }
+            else if (status == SELECT_CASE_CLOSED)
+            {
+                closed_cases++;
+            }
+            else if (timeout_ms != 0)
+            {
+                waiters[index].thread = selector.thread;
+                waiters[index].selector = &selector;
+                waiters[index].case_index = index;
+                wait_queue_push(select_case_queue(select_case), &waiters[index]);
+            }
+            oaf_mutex_unlock(&select_case->channel->mutex);
+        }
+
+        if (result == OAF_CHANNEL_SELECT_TIMEOUT && closed_cases == case_count)
+        {
+            result = OAF_CHANNEL_SELECT_CLOSED;
+        }
+
+        if (result == OAF_CHANNEL_SELECT_TIMEOUT && timeout_ms != 0)
+        {
+            select_block(&selector, timeout_ms, deadline);
+        }
+
+        select_unregister(cases, waiters, case_count);
+
+        if (atomic_load(&selector.fired))
+        {
+            woken_by = (int)selector.fired_case;
+        }
+
+        if (result != OAF_CHANNEL_SELECT_TIMEOUT
+            || timeout_ms == 0
+            || (timeout_ms > 0 && oaf_monotonic_time_ns() >= deadline && !atomic_load(&selector.fired)))
+        {
+            break;
+        }
+    }
+
+    if (woken_by >= 0 && woken_by != result)
+    {
+        select_pass_wakeup(&cases[woken_by]);
+    }
+
+    if (selector.thread == NULL)
+    {
+        oaf_cond_var_destroy(&selector.cond_var);
+        oaf_mutex_destroy(&selector.mutex);
+    }
+
+    return result;
 }
@@ -0,0 +1,191 @@
+#include <stdint.h>
+#include "fiber_context.h"
+
+#if OAF_FIBER_CONTEXT_ASM
+
+void oaf_fiber_context_jump(void** from_stack_pointer, void* to_stack_pointer);
+void oaf_fiber_context_trampoline(void);
+
+#if defined(__x86_64__)
+
+__asm__(
+    ".text\n"
+    ".globl oaf_fiber_context_jump\n"
+    ".type oaf_fiber_context_jump,@function\n"
+    "oaf_fiber_context_jump:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size oaf_fiber_context_jump,.-oaf_fiber_context_jump\n"
+    ".globl oaf_fiber_context_trampoline\n"
+    ".type oaf_fiber_context_trampoline,@function\n"
+    "oaf_fiber_context_trampoline:\n"
+    "    movq %r13, %rdi\n"
+    "    andq $-16, %rsp\n"
+    "    callq *%r12\n"
+    "    ud2\n"
+    ".size oaf_fiber_context_trampoline,.-oaf_fiber_context_trampoline\n");
+
+#define OAF_FIBER_FRAME_WORDS 8u
+#define OAF_FIBER_FRAME_ENTRY 3u
+#define OAF_FIBER_FRAME_ARGUMENT 2u
+#define OAF_FIBER_FRAME_RETURN 6u
+
+#elif defined(__aarch64__)
+
+__asm__(
+    ".text\n"
+    ".globl oaf_fiber_context_jump\n"
+    ".type oaf_fiber_context_jump,%function\n"
+    "oaf_fiber_context_jump:\n"
+    "    sub sp, sp, #160\n"
+    "    stp x19, x20, [sp, #0]\n"
+    "    stp x21, x22, [sp, #16]\n"
+    "    stp x23, x24, [sp, #32]\n"
+    "    stp x25, x26, [sp, #48]\n"
+    "    stp x27, x28, [sp, #64]\n"
+    "    stp x29, x30, [sp, #80]\n"
+    "    stp d8, d9, [sp, #96]\n"
+    "    stp d10, d11, [sp, #112]\n"
+    "    stp d12, d13, [sp, #128]\n"
+    "    stp d14, d15, [sp, #144]\n"
+    "    mov x9, sp\n"
+    "    str x9, [x0]\n"
+    "    mov sp, x1\n"
+    "    ldp x19, x20, [sp, #0]\n"
+    "    ldp x21, x22, [sp, #16]\n"
+    "    ldp x23, x24, [sp, #32]\n"
+    "    ldp x25, x26, [sp, #48]\n"
+    "    ldp x27, x28, [sp, #64]\n"
+    "    ldp x29, x30, [sp, #80]\n"
+    "    ldp d8, d9, [sp, #96]\n"
+    "    ldp d10, d11, [sp, #112]\n"
+    "    ldp d12, d13, [sp, #128]\n"
+    "    ldp d14, d15, [sp, #144]\n"
+    "    add sp, sp, #160\n"
+    "    ret\n"
+    ".size oaf_fiber_context_jump,.-oaf_fiber_context_jump\n"
+    ".globl oaf_fiber_context_trampoline\n"
+    ".type oaf_fiber_context_trampoline,%function\n"
+    "oaf_fiber_context_trampoline:\n"
+    "    mov x0, x20\n"
+    "    blr x19\n"
+    "    brk #0\n"
+    ".size oaf_fiber_context_trampoline,.-oaf_fiber_context_trampoline\n");
+
+#define OAF_FIBER_FRAME_WORDS 20u
+#define OAF_FIBER_FRAME_ENTRY 0u
+#define OAF_FIBER_FRAME_ARGUMENT 1u
+#define OAF_FIBER_FRAME_RETURN 11u
+
+#endif
+
+int oaf_fiber_context_make(
+    OafFiberContext* context,
+    void* stack,
+    size_t stack_size,
+    OafFiberEntryProc entry,
+    void* argument)
+{
+    uintptr_t top;
+    void** frame;
+    size_t index;
+
+    if (context == NULL || stack == NULL || entry == NULL || stack_size < (OAF_FIBER_FRAME_WORDS * sizeof(void*) * 2u))
+    {
+        return 0;
+    }
+
+    top = ((uintptr_t)stack + stack_size) & ~(uintptr_t)15u;
+    frame = (void**)(top - (OAF_FIBER_FRAME_WORDS * sizeof(void*)));
+
+    for (index = 0; index < OAF_FIBER_FRAME_WORDS; index++)
+    {
+        frame[index] = NULL;
+    }
+
+    frame[OAF_FIBER_FRAME_ENTRY] = (void*)entry;
+    frame[OAF_FIBER_FRAME_ARGUMENT] = argument;
+    frame[OAF_FIBER_FRAME_RETURN] = (void*)oaf_fiber_context_trampoline;
+    context->stack_pointer = frame;
+    return 1;
+}
+
+void oaf_fiber_context_switch(OafFiberContext* from, OafFiberContext* to)
+{
+    if (from == NULL || to == NULL)
+    {
+        return;
+    }
+
+    oaf_fiber_context_jump(&from->stack_pointer, to->stack_pointer);
+}
+
+#else
+
+static void fiber_context_start(unsigned int entry_high, unsigned int entry_low, unsigned int argument_high, unsigned int argument_low)
+{
+    uintptr_t entry_bits = ((uintptr_t)entry_high << 16 << 16) | (uintptr_t)entry_low;
+    uintptr_t argument_bits = ((uintptr_t)argument_high << 16 << 16) | (uintptr_t)argument_low;
+    OafFiberEntryProc entry = (OafFiberEntryProc)entry_bits;
+
+    entry((void*)argument_bits);
+}
+
+int oaf_fiber_context_make(
+    OafFiberContext* context,
+    void* stack,
+    size_t stack_size,
+    OafFiberEntryProc entry,
+    void* argument)
+{
+    uintptr_t entry_bits = (uintptr_t)entry;
+    uintptr_t argument_bits = (uintptr_t)argument;
+
+    if (context == NULL || stack == NULL || entry == NULL || stack_size == 0)
+    {
+        return 0;
+    }
+
+    if (getcontext(&context->handle) != 0)
+    {
+        return 0;
+    }
+
+    context->handle.uc_stack.ss_sp = stack;
+    context->handle.uc_stack.ss_size = stack_size;
+    context->handle.uc_link = NULL;
+    makecontext(
+        &context->handle,
+        (void (*)(void))fiber_context_start,
+        4,
+        (unsigned int)(entry_bits >> 16 >> 16),
+        (unsigned int)(entry_bits & 0xffffffffu),
+        (unsigned int)(argument_bits >> 16 >> 16),
+        (unsigned int)(argument_bits & 0xffffffffu));
+    return 1;
+}
+
+void oaf_fiber_context_switch(OafFiberContext* from, OafFiberContext* to)
+{
+    if (from == NULL || to == NULL)
+    {
+        return;
+    }
+
+    swapcontext(&from->handle, &to->handle);
+}
+
+#endif
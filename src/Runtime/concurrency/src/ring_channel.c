@@ -0,0 +1,356 @@
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "ring_channel.h"
+#include "scheduler.h"
+#include "sync_primitives.h"
+
+static OafRingChannelCell* ring_cell(const OafRingChannel* channel, size_t position)
+{
+    return &channel->cells[position & channel->mask];
+}
+
+static int ring_is_full(OafRingChannel* channel)
+{
+    size_t position = atomic_load(&channel->enqueue_pos);
+    size_t sequence = atomic_load(&ring_cell(channel, position)->sequence);
+
+    return (intptr_t)(sequence - position) < 0;
+}
+
+static int ring_is_empty(OafRingChannel* channel)
+{
+    size_t position = atomic_load(&channel->dequeue_pos);
+    size_t sequence = atomic_load(&ring_cell(channel, position)->sequence);
+
+    return (intptr_t)(sequence - (position + 1u)) < 0;
+}
+
+static void ring_backoff(OafRingChannel* channel, OafEventCount* event_count, int for_space, size_t* spins)
+{
+    unsigned int key;
+
+    if (*spins < OAF_RING_CHANNEL_SPIN_ROUNDS)
+    {
+        (*spins)++;
+        OAF_CPU_RELAX();
+        return;
+    }
+
+    /* Yielding the OS thread frees nothing for a green thread's peers on the same worker; it parks instead. */
+    if (oaf_thread_current() == NULL && *spins < OAF_RING_CHANNEL_SPIN_ROUNDS + OAF_RING_CHANNEL_YIELD_ROUNDS)
+    {
+        (*spins)++;
+        sched_yield();
+        return;
+    }
+
+    key = oaf_event_count_prepare_wait(event_count);
+    if (atomic_load(&channel->closed)
+        || !(for_space ? ring_is_full(channel) : ring_is_empty(channel)))
+    {
+        oaf_event_count_cancel_wait(event_count);
+        return;
+    }
+
+    if (!oaf_thread_wait_event(event_count, key))
+    {
+        oaf_event_count_wait(event_count, key);
+    }
+}
+
+int oaf_ring_channel_init(OafRingChannel* channel, size_t capacity)
+{
+    size_t rounded = 2;
+    size_t index;
+
+    if (channel == NULL || capacity == 0 || capacity > ((size_t)1 << (sizeof(size_t) * 8u - 2u)))
+    {
+        return 0;
+    }
+
+    while (rounded < capacity)
+    {
+        rounded <<= 1;
+    }
+
+    channel->cells = (OafRingChannelCell*)malloc(sizeof(OafRingChannelCell) * rounded);
+    if (channel->cells == NULL)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < rounded; index++)
+    {
+        atomic_init(&channel->cells[index].sequence, index);
+        channel->cells[index].value = NULL;
+    }
+
+    channel->mask = rounded - 1u;
+    atomic_init(&channel->enqueue_pos, 0u);
+    atomic_init(&channel->dequeue_pos, 0u);
+    atomic_init(&channel->closed, 0);
+    oaf_event_count_init(&channel->not_empty);
+    oaf_event_count_init(&channel->not_full);
+    return 1;
+}
+
+void oaf_ring_channel_destroy(OafRingChannel* channel)
+{
+    if (channel == NULL)
+    {
+        return;
+    }
+
+    free(channel->cells);
+    channel->cells = NULL;
+    channel->mask = 0;
+    atomic_store(&channel->enqueue_pos, 0u);
+    atomic_store(&channel->dequeue_pos, 0u);
+    atomic_store(&channel->closed, 1);
+}
+
+size_t oaf_ring_channel_try_send_batch(OafRingChannel* channel, void* const* values, size_t count)
+{
+    size_t position;
+    size_t claimed;
+    size_t index;
+
+    if (channel == NULL || channel->cells == NULL || values == NULL || count == 0
+        || atomic_load_explicit(&channel->closed, memory_order_acquire))
+    {
+        return 0;
+    }
+
+    position = atomic_load_explicit(&channel->enqueue_pos, memory_order_relaxed);
+    while (1)
+    {
+        claimed = 0;
+        while (claimed < count && claimed <= channel->mask)
+        {
+            size_t sequence = atomic_load_explicit(
+                &ring_cell(channel, position + claimed)->sequence,
+                memory_order_acquire);
+
+            if (sequence != position + claimed)
+            {
+                break;
+            }
+            claimed++;
+        }
+
+        if (claimed == 0)
+        {
+            size_t sequence = atomic_load_explicit(&ring_cell(channel, position)->sequence, memory_order_acquire);
+
+            if ((intptr_t)(sequence - position) < 0)
+            {
+                return 0;
+            }
+
+            position = atomic_load_explicit(&channel->enqueue_pos, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(
+                &channel->enqueue_pos,
+                &position,
+                position + claimed,
+                memory_order_relaxed,
+                memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    for (index = 0; index < claimed; index++)
+    {
+        OafRingChannelCell* cell = ring_cell(channel, position + index);
+
+        cell->value = values[index];
+        atomic_store_explicit(&cell->sequence, position + index + 1u, memory_order_release);
+    }
+
+    oaf_event_count_notify(&channel->not_empty, (int)(claimed > 64u ? 64u : claimed));
+    return claimed;
+}
+
+size_t oaf_ring_channel_try_recv_batch(OafRingChannel* channel, void** out_values, size_t max_count)
+{
+    size_t position;
+    size_t claimed;
+    size_t index;
+
+    if (channel == NULL || channel->cells == NULL || out_values == NULL || max_count == 0)
+    {
+        return 0;
+    }
+
+    position = atomic_load_explicit(&channel->dequeue_pos, memory_order_relaxed);
+    while (1)
+    {
+        claimed = 0;
+        while (claimed < max_count && claimed <= channel->mask)
+        {
+            size_t sequence = atomic_load_explicit(
+                &ring_cell(channel, position + claimed)->sequence,
+                memory_order_acquire);
+
+            if (sequence != position + claimed + 1u)
+            {
+                break;
+            }
+            claimed++;
+        }
+
+        if (claimed == 0)
+        {
+            size_t sequence = atomic_load_explicit(&ring_cell(channel, position)->sequence, memory_order_acquire);
+
+            if ((intptr_t)(sequence - (position + 1u)) < 0)
+            {
+                return 0;
+            }
+
+            position = atomic_load_explicit(&channel->dequeue_pos, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(
+                &channel->dequeue_pos,
+                &position,
+                position + claimed,
+                memory_order_relaxed,
+                memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    for (index = 0; index < claimed; index++)
+    {
+        OafRingChannelCell* cell = ring_cell(channel, position + index);
+
+        out_values[index] = cell->value;
+        atomic_store_explicit(&cell->sequence, position + index + channel->mask + 1u, memory_order_release);
+    }
+
+    oaf_event_count_notify(&channel->not_full, (int)(claimed > 64u ? 64u : claimed));
+    return claimed;
+}
+
+size_t oaf_ring_channel_send_batch(OafRingChannel* channel, void* const* values, size_t count)
+{
+    size_t sent = 0;
+    size_t spins = 0;
+
+    if (channel == NULL || channel->cells == NULL || values == NULL)
+    {
+        return 0;
+    }
+
+    while (sent < count && !atomic_load_explicit(&channel->closed, memory_order_acquire))
+    {
+        size_t moved = oaf_ring_channel_try_send_batch(channel, values + sent, count - sent);
+
+        if (moved > 0)
+        {
+            sent += moved;
+            spins = 0;
+            continue;
+        }
+
+        ring_backoff(channel, &channel->not_full, 1, &spins);
+    }
+
+    return sent;
+}
+
+size_t oaf_ring_channel_recv_batch(OafRingChannel* channel, void** out_values, size_t max_count)
+{
+    size_t spins = 0;
+
+    if (channel == NULL || channel->cells == NULL || out_values == NULL || max_count == 0)
+    {
+        return 0;
+    }
+
+    while (1)
+    {
+        size_t moved = oaf_ring_channel_try_recv_batch(channel, out_values, max_count);
+
+        if (moved > 0)
+        {
+            return moved;
+        }
+
+        if (atomic_load_explicit(&channel->closed, memory_order_acquire))
+        {
+            return oaf_ring_channel_try_recv_batch(channel, out_values, max_count);
+        }
+
+        ring_backoff(channel, &channel->not_empty, 0, &spins);
+    }
+}
+
+int oaf_ring_channel_send(OafRingChannel* channel, void* value)
+{
+    return oaf_ring_channel_send_batch(channel, &value, 1) == 1;
+}
+
+int oaf_ring_channel_try_send(OafRingChannel* channel, void* value)
+{
+    return oaf_ring_channel_try_send_batch(channel, &value, 1) == 1;
+}
+
+int oaf_ring_channel_recv(OafRingChannel* channel, void** out_value)
+{
+    return oaf_ring_channel_recv_batch(channel, out_value, 1) == 1;
+}
+
+int oaf_ring_channel_try_recv(OafRingChannel* channel, void** out_value)
+{
+    return oaf_ring_channel_try_recv_batch(channel, out_value, 1) == 1;
+}
+
+void oaf_ring_channel_close(OafRingChannel* channel)
+{
+    if (channel == NULL || channel->cells == NULL)
+    {
+        return;
+    }
+
+    atomic_store(&channel->closed, 1);
+    oaf_event_count_notify(&channel->not_empty, 0);
+    oaf_event_count_notify(&channel->not_full, 0);
+}
+
+size_t oaf_ring_channel_count(const OafRingChannel* channel)
+{
+    size_t enqueued;
+    size_t dequeued;
+
+    if (channel == NULL || channel->cells == NULL)
+    {
+        return 0;
+    }
+
+    dequeued = atomic_load(&((OafRingChannel*)channel)->dequeue_pos);
+    enqueued = atomic_load(&((OafRingChannel*)channel)->enqueue_pos);
+    if ((intptr_t)(enqueued - dequeued) <= 0)
+    {
+        return 0;
+    }
+
+    return enqueued - dequeued > channel->mask + 1u ? channel->mask + 1u : enqueued - dequeued;
+}
+
+size_t oaf_ring_channel_capacity(const OafRingChannel* channel)
+{
+    if (channel == NULL || channel->cells == NULL)
+    {
+        return 0;
+    }
+
+    return channel->mask + 1u;
+}
@@ -1,155 +1,1026 @@
 #include <stddef.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
 #include "scheduler.h"
 
-static void queue_init(OafWorkStealingQueue* queue)
+static _Thread_local OafSchedulerWorker* g_current_worker = NULL;
+static _Thread_local OafLightweightThread* g_current_thread = NULL;
+static _Thread_local OafFiberContext g_scheduler_context;
+
+static OafWorkStealingBuffer* buffer_create(size_t capacity)
+{
+    OafWorkStealingBuffer* buffer = (OafWorkStealingBuffer*)malloc(
+        sizeof(OafWorkStealingBuffer) + capacity * sizeof(_Atomic(OafLightweightThread*)));
+    size_t index;
+
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+
+    buffer->capacity = capacity;
+    buffer->retired = NULL;
+    for (index = 0; index < capacity; index++)
+    {
+        atomic_init(&buffer->entries[index], NULL);
+    }
+
+    return buffer;
+}
+
+static int queue_init(OafWorkStealingQueue* queue)
+{
+    OafWorkStealingBuffer* buffer = buffer_create(OAF_SCHEDULER_QUEUE_INITIAL_CAPACITY);
+
+    if (buffer == NULL)
+    {
+        return 0;
+    }
+
+    atomic_init(&queue->top, 0);
+    atomic_init(&queue->bottom, 0);
+    atomic_init(&queue->buffer, buffer);
+    return 1;
+}
+
+static void queue_destroy(OafWorkStealingQueue* queue)
+{
+    OafWorkStealingBuffer* buffer = atomic_load_explicit(&queue->buffer, memory_order_relaxed);
+
+    while (buffer != NULL)
+    {
+        OafWorkStealingBuffer* retired = buffer->retired;
+        free(buffer);
+        buffer = retired;
+    }
+
+    atomic_store_explicit(&queue->buffer, NULL, memory_order_relaxed);
+    atomic_store_explicit(&queue->top, 0, memory_order_relaxed);
+    atomic_store_explicit(&queue->bottom, 0, memory_order_relaxed);
+}
+
+static size_t queue_size(const OafWorkStealingQueue* queue)
+{
+    ptrdiff_t top = atomic_load_explicit(&((OafWorkStealingQueue*)queue)->top, memory_order_acquire);
+    ptrdiff_t bottom = atomic_load_explicit(&((OafWorkStealingQueue*)queue)->bottom, memory_order_acquire);
+
+    return bottom > top ? (size_t)(bottom - top) : 0u;
+}
+
+static OafWorkStealingBuffer* queue_grow(
+    OafWorkStealingQueue* queue,
+    OafWorkStealingBuffer* buffer,
+    ptrdiff_t top,
+    ptrdiff_t bottom)
 {
+    OafWorkStealingBuffer* grown = buffer_create(buffer->capacity * 2u);
+    ptrdiff_t index;
+
+    if (grown == NULL)
+    {
+        return NULL;
+    }
+
+    for (index = top; index < bottom; index++)
+    {
+        atomic_store_explicit(
+            &grown->entries[(size_t)index & (grown->capacity - 1u)],
+            atomic_load_explicit(&buffer->entries[(size_t)index & (buffer->capacity - 1u)], memory_order_relaxed),
+            memory_order_relaxed);
+    }
+
+    grown->retired = buffer;
+    atomic_store_explicit(&queue->buffer, grown, memory_order_release);
+    return grown;
+}
+
+static int queue_push(OafWorkStealingQueue* queue, OafLightweightThread* thread)
+{
+    ptrdiff_t bottom;
+    ptrdiff_t top;
+    OafWorkStealingBuffer* buffer;
+
+    if (queue == NULL || thread == NULL)
+    {
+        return 0;
+    }
+
+    bottom = atomic_load_explicit(&queue->bottom, memory_order_relaxed);
+    top = atomic_load_explicit(&queue->top, memory_order_acquire);
+    buffer = atomic_load_explicit(&queue->buffer, memory_order_relaxed);
+    if (bottom - top >= (ptrdiff_t)buffer->capacity)
+    {
+        buffer = queue_grow(queue, buffer, top, bottom);
+        if (buffer == NULL)
+        {
+            return 0;
+        }
+    }
+
+    atomic_store_explicit(
+        &buffer->entries[(size_t)bottom & (buffer->capacity - 1u)],
+        thread,
+        memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&queue->bottom, bottom + 1, memory_order_relaxed);
+    return 1;
+}
+
+static OafLightweightThread* queue_pop(OafWorkStealingQueue* queue)
+{
+    ptrdiff_t bottom;
+    ptrdiff_t top;
+    OafWorkStealingBuffer* buffer;
+    OafLightweightThread* thread = NULL;
+
     if (queue == NULL)
     {
-        return;
+        return NULL;
+    }
+
+    bottom = atomic_load_explicit(&queue->bottom, memory_order_relaxed) - 1;
+    buffer = atomic_load_explicit(&queue->buffer, memory_order_relaxed);
+    atomic_store_explicit(&queue->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    top = atomic_load_explicit(&queue->top, memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        atomic_store_explicit(&queue->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    thread = atomic_load_explicit(
+        &buffer->entries[(size_t)bottom & (buffer->capacity - 1u)],
+        memory_order_relaxed);
+
+    if (top == bottom)
+    {
+        if (!atomic_compare_exchange_strong_explicit(
+                &queue->top,
+                &top,
+                top + 1,
+                memory_order_seq_cst,
+                memory_order_relaxed))
+        {
+            thread = NULL;
+        }
+
+        atomic_store_explicit(&queue->bottom, bottom + 1, memory_order_relaxed);
+    }
+
+    return thread;
+}
+
+static OafLightweightThread* queue_steal(OafWorkStealingQueue* queue)
+{
+    ptrdiff_t top;
+    ptrdiff_t bottom;
+    OafWorkStealingBuffer* buffer;
+    OafLightweightThread* thread;
+
+    if (queue == NULL)
+    {
+        return NULL;
+    }
+
+    top = atomic_load_explicit(&queue->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    bottom = atomic_load_explicit(&queue->bottom, memory_order_acquire);
+
+    if (top >= bottom)
+    {
+        return NULL;
+    }
+
+    buffer = atomic_load_explicit(&queue->buffer, memory_order_acquire);
+    thread = atomic_load_explicit(
+        &buffer->entries[(size_t)top & (buffer->capacity - 1u)],
+        memory_order_relaxed);
+
+    if (!atomic_compare_exchange_strong_explicit(
+            &queue->top,
+            &top,
+            top + 1,
+            memory_order_seq_cst,
+            memory_order_relaxed))
+    {
+        return NULL;
+    }
+
+    return thread;
+}
+
+static void inject_push(OafThreadScheduler* scheduler, OafLightweightThread* thread)
+{
+    oaf_mutex_lock(&scheduler->inject_mutex);
+    thread->next = NULL;
+    if (scheduler->inject_tail == NULL)
+    {
+        scheduler->inject_head = thread;
+    }
+    else
+    {
+        scheduler->inject_tail->next = thread;
+    }
+    scheduler->inject_tail = thread;
+    atomic_fetch_add_explicit(&scheduler->inject_count, 1, memory_order_release);
+    oaf_mutex_unlock(&scheduler->inject_mutex);
+}
+
+static OafLightweightThread* inject_pop(OafThreadScheduler* scheduler)
+{
+    OafLightweightThread* thread;
+
+    if (atomic_load_explicit(&scheduler->inject_count, memory_order_acquire) == 0)
+    {
+        return NULL;
+    }
+
+    oaf_mutex_lock(&scheduler->inject_mutex);
+    thread = scheduler->inject_head;
+    if (thread != NULL)
+    {
+        scheduler->inject_head = thread->next;
+        if (scheduler->inject_head == NULL)
+        {
+            scheduler->inject_tail = NULL;
+        }
+        thread->next = NULL;
+        atomic_fetch_sub_explicit(&scheduler->inject_count, 1, memory_order_relaxed);
+    }
+    oaf_mutex_unlock(&scheduler->inject_mutex);
+    return thread;
+}
+
+static void wake_worker(OafThreadScheduler* scheduler)
+{
+    atomic_fetch_add(&scheduler->wake_epoch, 1u);
+    if (atomic_load(&scheduler->sleeping_workers) == 0)
+    {
+        return;
+    }
+
+    oaf_mutex_lock(&scheduler->park_mutex);
+    oaf_cond_var_signal(&scheduler->work_available);
+    oaf_mutex_unlock(&scheduler->park_mutex);
+}
+
+static void timer_arm(OafThreadScheduler* scheduler, OafSchedulerTimer* timer)
+{
+    OafSchedulerTimer** link = &scheduler->timers;
+    int earliest;
+
+    oaf_mutex_lock(&scheduler->timer_mutex);
+    while (*link != NULL && (*link)->deadline_ns <= timer->deadline_ns)
+    {
+        link = &(*link)->next;
+    }
+
+    timer->next = *link;
+    timer->armed = 1;
+    *link = timer;
+    earliest = scheduler->timers == timer;
+    if (earliest)
+    {
+        atomic_store(&scheduler->next_timer_ns, timer->deadline_ns);
+    }
+    oaf_mutex_unlock(&scheduler->timer_mutex);
+
+    /* A sleeping worker may be waiting on a later deadline, or on none. */
+    if (earliest)
+    {
+        wake_worker(scheduler);
+    }
+}
+
+static void timer_disarm(OafThreadScheduler* scheduler, OafSchedulerTimer* timer)
+{
+    OafSchedulerTimer** link = &scheduler->timers;
+
+    oaf_mutex_lock(&scheduler->timer_mutex);
+    if (timer->armed)
+    {
+        while (*link != timer)
+        {
+            link = &(*link)->next;
+        }
+
+        *link = timer->next;
+        timer->armed = 0;
+        atomic_store(&scheduler->next_timer_ns, scheduler->timers != NULL ? scheduler->timers->deadline_ns : UINT64_MAX);
+    }
+    oaf_mutex_unlock(&scheduler->timer_mutex);
+}
+
+/* Unparks under timer_mutex so a woken thread cannot disarm and drop its stack node while this walks the list. */
+static void fire_timers(OafThreadScheduler* scheduler)
+{
+    uint64_t now;
+
+    if (atomic_load_explicit(&scheduler->next_timer_ns, memory_order_relaxed) == UINT64_MAX)
+    {
+        return;
+    }
+
+    now = oaf_monotonic_time_ns();
+    if (now < atomic_load(&scheduler->next_timer_ns))
+    {
+        return;
+    }
+
+    oaf_mutex_lock(&scheduler->timer_mutex);
+    while (scheduler->timers != NULL && scheduler->timers->deadline_ns <= now)
+    {
+        OafSchedulerTimer* timer = scheduler->timers;
+
+        scheduler->timers = timer->next;
+        timer->armed = 0;
+        oaf_thread_unpark(timer->thread);
+    }
+
+    atomic_store(&scheduler->next_timer_ns, scheduler->timers != NULL ? scheduler->timers->deadline_ns : UINT64_MAX);
+    oaf_mutex_unlock(&scheduler->timer_mutex);
+}
+
+static void park_worker(OafThreadScheduler* scheduler, unsigned int observed_epoch)
+{
+    oaf_mutex_lock(&scheduler->park_mutex);
+    atomic_fetch_add(&scheduler->sleeping_workers, 1u);
+
+    while (atomic_load(&scheduler->running) && atomic_load(&scheduler->wake_epoch) == observed_epoch)
+    {
+        uint64_t deadline = atomic_load(&scheduler->next_timer_ns);
+        uint64_t now;
+
+        if (deadline == UINT64_MAX)
+        {
+            if (!oaf_cond_var_wait(&scheduler->work_available, &scheduler->park_mutex))
+            {
+                break;
+            }
+            continue;
+        }
+
+        /* Sleep no later than the earliest timer; the worker loop fires it. */
+        now = oaf_monotonic_time_ns();
+        if (now >= deadline
+            || !oaf_cond_var_timed_wait(&scheduler->work_available, &scheduler->park_mutex, deadline - now))
+        {
+            break;
+        }
+    }
+
+    atomic_fetch_sub(&scheduler->sleeping_workers, 1u);
+    oaf_mutex_unlock(&scheduler->park_mutex);
+    atomic_fetch_add_explicit(&scheduler->stats.parks, 1u, memory_order_relaxed);
+}
+
+static void enqueue_thread(OafThreadScheduler* scheduler, OafLightweightThread* thread)
+{
+    OafSchedulerWorker* worker = g_current_worker;
+
+    if (worker == NULL
+        || worker->scheduler != scheduler
+        || !queue_push(&scheduler->worker_queues[worker->index], thread))
+    {
+        inject_push(scheduler, thread);
+    }
+
+    wake_worker(scheduler);
+}
+
+static void thread_finished(OafThreadScheduler* scheduler)
+{
+    if (atomic_fetch_sub(&scheduler->in_flight, 1u) != 1u)
+    {
+        return;
+    }
+
+    oaf_mutex_lock(&scheduler->park_mutex);
+    oaf_cond_var_broadcast(&scheduler->idle);
+    oaf_mutex_unlock(&scheduler->park_mutex);
+}
+
+static int grow_thread_slabs(OafThreadScheduler* scheduler)
+{
+    OafLightweightThread* slab;
+    size_t base;
+    size_t index;
+
+    base = scheduler->slab_count * OAF_SCHEDULER_SLAB_SIZE;
+    if (base + OAF_SCHEDULER_SLAB_SIZE > (size_t)UINT32_MAX)
+    {
+        return 0;
+    }
+
+    if (scheduler->slab_count == scheduler->slab_capacity)
+    {
+        size_t capacity = scheduler->slab_capacity == 0 ? 8u : scheduler->slab_capacity * 2u;
+        OafLightweightThread** slabs = (OafLightweightThread**)realloc(
+            scheduler->slabs,
+            capacity * sizeof(OafLightweightThread*));
+
+        if (slabs == NULL)
+        {
+            return 0;
+        }
+
+        scheduler->slabs = slabs;
+        scheduler->slab_capacity = capacity;
+    }
+
+    slab = (OafLightweightThread*)calloc(OAF_SCHEDULER_SLAB_SIZE, sizeof(OafLightweightThread));
+    if (slab == NULL)
+    {
+        return 0;
+    }
+
+    for (index = OAF_SCHEDULER_SLAB_SIZE; index > 0; index--)
+    {
+        OafLightweightThread* thread = &slab[index - 1u];
+
+        thread->slot = (uint32_t)(base + index - 1u);
+        atomic_init(&thread->generation, 1u);
+        thread->next = scheduler->free_threads;
+        scheduler->free_threads = thread;
+    }
+
+    scheduler->slabs[scheduler->slab_count++] = slab;
+    return 1;
+}
+
+static OafLightweightThread* acquire_thread(OafThreadScheduler* scheduler)
+{
+    OafLightweightThread* thread = NULL;
+
+    if (!oaf_mutex_lock(&scheduler->slab_mutex))
+    {
+        return NULL;
+    }
+
+    if (scheduler->free_threads != NULL || grow_thread_slabs(scheduler))
+    {
+        thread = scheduler->free_threads;
+        scheduler->free_threads = thread->next;
+        thread->next = NULL;
+        scheduler->live_threads++;
+    }
+
+    oaf_mutex_unlock(&scheduler->slab_mutex);
+    return thread;
+}
+
+static void recycle_thread(OafThreadScheduler* scheduler, OafLightweightThread* thread)
+{
+    unsigned int generation;
+
+    oaf_mutex_lock(&scheduler->slab_mutex);
+    generation = atomic_load(&thread->generation) + 1u;
+    atomic_store(&thread->generation, generation == 0u ? 1u : generation);
+    thread->next = scheduler->free_threads;
+    scheduler->free_threads = thread;
+    scheduler->live_threads--;
+    oaf_mutex_unlock(&scheduler->slab_mutex);
+    atomic_fetch_add_explicit(&scheduler->stats.recycled, 1u, memory_order_relaxed);
+}
+
+static OafLightweightThread* slot_thread(OafThreadScheduler* scheduler, size_t slot)
+{
+    OafLightweightThread* thread = NULL;
+
+    oaf_mutex_lock(&scheduler->slab_mutex);
+    if (slot / OAF_SCHEDULER_SLAB_SIZE < scheduler->slab_count)
+    {
+        thread = &scheduler->slabs[slot / OAF_SCHEDULER_SLAB_SIZE][slot % OAF_SCHEDULER_SLAB_SIZE];
+    }
+    oaf_mutex_unlock(&scheduler->slab_mutex);
+    return thread;
+}
+
+static void stackful_entry(void* argument)
+{
+    OafLightweightThread* thread = (OafLightweightThread*)argument;
+
+    thread->result = thread->proc(thread->proc_args);
+    thread->switch_reason = OAF_THREAD_SWITCH_COMPLETE;
+    oaf_fiber_context_switch(&thread->context, thread->return_context);
+}
+
+static int resume_stackful(OafThreadScheduler* scheduler, OafLightweightThread* thread)
+{
+    OafMutex* park_unlock;
+    int expected = OAF_THREAD_PARK_IDLE;
+
+    if (thread->state != OAF_THREAD_STATE_READY)
+    {
+        thread->state = OAF_THREAD_STATE_FAILED;
+        oaf_stack_pool_release(&scheduler->stack_pool, thread->stack);
+        thread->stack = NULL;
+        recycle_thread(scheduler, thread);
+        thread_finished(scheduler);
+        return 0;
+    }
+
+    thread->state = OAF_THREAD_STATE_RUNNING;
+    thread->switch_reason = OAF_THREAD_SWITCH_NONE;
+    thread->return_context = &g_scheduler_context;
+    g_current_thread = thread;
+    oaf_fiber_context_switch(&g_scheduler_context, &thread->context);
+    g_current_thread = NULL;
+
+    switch (thread->switch_reason)
+    {
+    case OAF_THREAD_SWITCH_YIELD:
+        thread->state = OAF_THREAD_STATE_READY;
+        atomic_fetch_add_explicit(&scheduler->stats.yielded, 1u, memory_order_relaxed);
+        inject_push(scheduler, thread);
+        wake_worker(scheduler);
+        return 1;
+
+    case OAF_THREAD_SWITCH_PARK:
+        thread->state = OAF_THREAD_STATE_PARKED;
+        park_unlock = thread->park_unlock;
+        thread->park_unlock = NULL;
+        atomic_fetch_add_explicit(&scheduler->stats.parked, 1u, memory_order_relaxed);
+        if (park_unlock != NULL)
+        {
+            oaf_mutex_unlock(park_unlock);
+        }
+
+        if (atomic_compare_exchange_strong(&thread->park_state, &expected, OAF_THREAD_PARK_PARKED))
+        {
+            return 1;
+        }
+
+        atomic_store(&thread->park_state, OAF_THREAD_PARK_IDLE);
+        thread->state = OAF_THREAD_STATE_READY;
+        enqueue_thread(scheduler, thread);
+        return 1;
+
+    default:
+        thread->state = OAF_THREAD_STATE_COMPLETED;
+        oaf_stack_pool_release(&scheduler->stack_pool, thread->stack);
+        thread->stack = NULL;
+        atomic_fetch_add_explicit(&scheduler->stats.executed, 1u, memory_order_relaxed);
+        recycle_thread(scheduler, thread);
+        thread_finished(scheduler);
+        return 1;
+    }
+}
+
+static int execute_thread(OafThreadScheduler* scheduler, OafLightweightThread* thread)
+{
+    if (thread->stack != NULL)
+    {
+        return resume_stackful(scheduler, thread);
+    }
+
+    if (!oaf_lightweight_thread_run(thread))
+    {
+        thread->state = OAF_THREAD_STATE_FAILED;
+        recycle_thread(scheduler, thread);
+        thread_finished(scheduler);
+        return 0;
+    }
+
+    atomic_fetch_add_explicit(&scheduler->stats.executed, 1u, memory_order_relaxed);
+    recycle_thread(scheduler, thread);
+    thread_finished(scheduler);
+    return 1;
+}
+
+static OafLightweightThread* find_work(OafThreadScheduler* scheduler, size_t worker_index)
+{
+    OafLightweightThread* thread;
+
+    fire_timers(scheduler);
+    thread = queue_pop(&scheduler->worker_queues[worker_index]);
+
+    if (thread != NULL)
+    {
+        return thread;
+    }
+
+    thread = inject_pop(scheduler);
+    if (thread != NULL)
+    {
+        return thread;
+    }
+
+    if (oaf_scheduler_steal(scheduler, worker_index, &thread))
+    {
+        return thread;
+    }
+
+    return NULL;
+}
+
+static void* worker_main(void* state)
+{
+    OafSchedulerWorker* worker = (OafSchedulerWorker*)state;
+    OafThreadScheduler* scheduler = worker->scheduler;
+    size_t idle_rounds = 0;
+
+    g_current_worker = worker;
+
+    while (atomic_load(&scheduler->running))
+    {
+        unsigned int observed_epoch = atomic_load(&scheduler->wake_epoch);
+        OafLightweightThread* thread = find_work(scheduler, worker->index);
+
+        if (thread != NULL)
+        {
+            execute_thread(scheduler, thread);
+            idle_rounds = 0;
+            continue;
+        }
+
+        if (idle_rounds < OAF_SCHEDULER_SPIN_ROUNDS)
+        {
+            idle_rounds++;
+            sched_yield();
+            continue;
+        }
+
+        park_worker(scheduler, observed_epoch);
+        idle_rounds = 0;
+    }
+
+    g_current_worker = NULL;
+    return NULL;
+}
+
+static void release_thread_slabs(OafThreadScheduler* scheduler)
+{
+    size_t slab_index;
+
+    for (slab_index = 0; slab_index < scheduler->slab_count; slab_index++)
+    {
+        OafLightweightThread* slab = scheduler->slabs[slab_index];
+        size_t index;
+
+        for (index = 0; index < OAF_SCHEDULER_SLAB_SIZE; index++)
+        {
+            if (slab[index].stack != NULL)
+            {
+                oaf_stack_pool_release(&scheduler->stack_pool, slab[index].stack);
+                slab[index].stack = NULL;
+            }
+        }
+
+        free(slab);
+    }
+
+    free(scheduler->slabs);
+    scheduler->slabs = NULL;
+    scheduler->slab_count = 0;
+    scheduler->slab_capacity = 0;
+    scheduler->free_threads = NULL;
+    scheduler->live_threads = 0;
+}
+
+static void destroy_queues(OafThreadScheduler* scheduler, size_t queue_count)
+{
+    size_t worker_index;
+
+    for (worker_index = 0; worker_index < queue_count; worker_index++)
+    {
+        queue_destroy(&scheduler->worker_queues[worker_index]);
+    }
+}
+
+int oaf_scheduler_init(OafThreadScheduler* scheduler, size_t worker_count)
+{
+    size_t worker_index;
+
+    if (scheduler == NULL)
+    {
+        return 0;
+    }
+
+    if (worker_count == 0)
+    {
+        worker_count = 1;
+    }
+
+    if (worker_count > OAF_SCHEDULER_MAX_WORKERS)
+    {
+        worker_count = OAF_SCHEDULER_MAX_WORKERS;
+    }
+
+    scheduler->worker_count = worker_count;
+    atomic_init(&scheduler->rr_worker, 0u);
+    atomic_init(&scheduler->next_thread_id, 1u);
+    atomic_init(&scheduler->stats.enqueued, 0u);
+    atomic_init(&scheduler->stats.executed, 0u);
+    atomic_init(&scheduler->stats.stolen, 0u);
+    atomic_init(&scheduler->stats.failed_spawns, 0u);
+    atomic_init(&scheduler->stats.parks, 0u);
+    atomic_init(&scheduler->stats.yielded, 0u);
+    atomic_init(&scheduler->stats.parked, 0u);
+    atomic_init(&scheduler->stats.recycled, 0u);
+
+    scheduler->started_workers = 0;
+    atomic_init(&scheduler->running, 0);
+    atomic_init(&scheduler->inject_count, 0u);
+    atomic_init(&scheduler->wake_epoch, 0u);
+    atomic_init(&scheduler->sleeping_workers, 0u);
+    atomic_init(&scheduler->in_flight, 0u);
+    atomic_init(&scheduler->next_timer_ns, UINT64_MAX);
+    scheduler->timers = NULL;
+    scheduler->inject_head = NULL;
+    scheduler->inject_tail = NULL;
+    scheduler->slabs = NULL;
+    scheduler->slab_count = 0;
+    scheduler->slab_capacity = 0;
+    scheduler->free_threads = NULL;
+    scheduler->live_threads = 0;
+
+    for (worker_index = 0; worker_index < worker_count; worker_index++)
+    {
+        if (!queue_init(&scheduler->worker_queues[worker_index]))
+        {
+            destroy_queues(scheduler, worker_index);
+            return 0;
+        }
+    }
+
+    if (!oaf_mutex_init(&scheduler->slab_mutex))
+    {
+        destroy_queues(scheduler, worker_count);
+        return 0;
+    }
+
+    if (!oaf_mutex_init(&scheduler->inject_mutex))
+    {
+        oaf_mutex_destroy(&scheduler->slab_mutex);
+        destroy_queues(scheduler, worker_count);
+        return 0;
     }
 
-    queue->head = 0;
-    queue->tail = 0;
-    queue->count = 0;
-}
+    if (!oaf_mutex_init(&scheduler->park_mutex))
+    {
+        oaf_mutex_destroy(&scheduler->inject_mutex);
+        oaf_mutex_destroy(&scheduler->slab_mutex);
+        destroy_queues(scheduler, worker_count);
+        return 0;
+    }
 
-static int queue_push_back(OafWorkStealingQueue* queue, OafLightweightThread* thread)
-{
-    if (queue == NULL || thread == NULL || queue->count >= OAF_SCHEDULER_QUEUE_CAPACITY)
+    if (!oaf_mutex_init(&scheduler->timer_mutex))
     {
+        oaf_mutex_destroy(&scheduler->park_mutex);
+        oaf_mutex_destroy(&scheduler->inject_mutex);
+        oaf_mutex_destroy(&scheduler->slab_mutex);
+        destroy_queues(scheduler, worker_count);
         return 0;
     }
 
-    queue->entries[queue->tail] = thread;
-    queue->tail = (queue->tail + 1) % OAF_SCHEDULER_QUEUE_CAPACITY;
-    queue->count++;
-    return 1;
-}
+    if (!oaf_cond_var_init(&scheduler->work_available))
+    {
+        oaf_mutex_destroy(&scheduler->timer_mutex);
+        oaf_mutex_destroy(&scheduler->park_mutex);
+        oaf_mutex_destroy(&scheduler->inject_mutex);
+        oaf_mutex_destroy(&scheduler->slab_mutex);
+        destroy_queues(scheduler, worker_count);
+        return 0;
+    }
 
-static OafLightweightThread* queue_pop_front(OafWorkStealingQueue* queue)
-{
-    OafLightweightThread* thread;
+    if (!oaf_cond_var_init(&scheduler->idle))
+    {
+        oaf_cond_var_destroy(&scheduler->work_available);
+        oaf_mutex_destroy(&scheduler->timer_mutex);
+        oaf_mutex_destroy(&scheduler->park_mutex);
+        oaf_mutex_destroy(&scheduler->inject_mutex);
+        oaf_mutex_destroy(&scheduler->slab_mutex);
+        destroy_queues(scheduler, worker_count);
+        return 0;
+    }
 
-    if (queue == NULL || queue->count == 0)
+    if (!oaf_stack_pool_init(&scheduler->stack_pool, OAF_STACK_POOL_DEFAULT_STACK_SIZE, OAF_STACK_POOL_DEFAULT_MAX_CACHED))
     {
-        return NULL;
+        oaf_cond_var_destroy(&scheduler->idle);
+        oaf_cond_var_destroy(&scheduler->work_available);
+        oaf_mutex_destroy(&scheduler->timer_mutex);
+        oaf_mutex_destroy(&scheduler->park_mutex);
+        oaf_mutex_destroy(&scheduler->inject_mutex);
+        oaf_mutex_destroy(&scheduler->slab_mutex);
+        destroy_queues(scheduler, worker_count);
+        return 0;
     }
 
-    thread = queue->entries[queue->head];
-    queue->entries[queue->head] = NULL;
-    queue->head = (queue->head + 1) % OAF_SCHEDULER_QUEUE_CAPACITY;
-    queue->count--;
-    return thread;
+    return 1;
 }
 
-static OafLightweightThread* queue_pop_back(OafWorkStealingQueue* queue)
+void oaf_scheduler_shutdown(OafThreadScheduler* scheduler)
 {
-    OafLightweightThread* thread;
-
-    if (queue == NULL || queue->count == 0)
+    if (scheduler == NULL)
     {
-        return NULL;
+        return;
     }
 
-    queue->tail = (queue->tail + OAF_SCHEDULER_QUEUE_CAPACITY - 1) % OAF_SCHEDULER_QUEUE_CAPACITY;
-    thread = queue->entries[queue->tail];
-    queue->entries[queue->tail] = NULL;
-    queue->count--;
-    return thread;
+    oaf_scheduler_stop(scheduler);
+
+    release_thread_slabs(scheduler);
+    destroy_queues(scheduler, scheduler->worker_count);
+    scheduler->inject_head = NULL;
+    scheduler->inject_tail = NULL;
+    atomic_store(&scheduler->inject_count, 0u);
+    atomic_store(&scheduler->in_flight, 0u);
+    atomic_store(&scheduler->rr_worker, 0u);
+
+    oaf_stack_pool_destroy(&scheduler->stack_pool);
+    oaf_cond_var_destroy(&scheduler->idle);
+    oaf_cond_var_destroy(&scheduler->work_available);
+    oaf_mutex_destroy(&scheduler->timer_mutex);
+    oaf_mutex_destroy(&scheduler->park_mutex);
+    oaf_mutex_destroy(&scheduler->inject_mutex);
+    oaf_mutex_destroy(&scheduler->slab_mutex);
 }
 
-int oaf_scheduler_init(OafThreadScheduler* scheduler, size_t worker_count)
+int oaf_scheduler_start(OafThreadScheduler* scheduler)
 {
     size_t worker_index;
+    int expected = 0;
 
     if (scheduler == NULL)
     {
         return 0;
     }
 
-    if (worker_count == 0)
+    if (!atomic_compare_exchange_strong(&scheduler->running, &expected, 1))
     {
-        worker_count = 1;
+        return 1;
     }
 
-    if (worker_count > OAF_SCHEDULER_MAX_WORKERS)
+    scheduler->started_workers = 0;
+    for (worker_index = 0; worker_index < scheduler->worker_count; worker_index++)
     {
-        worker_count = OAF_SCHEDULER_MAX_WORKERS;
-    }
+        OafSchedulerWorker* worker = &scheduler->workers[worker_index];
 
-    scheduler->thread_count = 0;
-    scheduler->worker_count = worker_count;
-    scheduler->rr_worker = 0;
-    scheduler->next_thread_id = 1;
-    scheduler->stats.enqueued = 0;
-    scheduler->stats.executed = 0;
-    scheduler->stats.stolen = 0;
-    scheduler->stats.failed_spawns = 0;
+        worker->scheduler = scheduler;
+        worker->index = worker_index;
+        if (pthread_create(&worker->handle, NULL, worker_main, worker) != 0)
+        {
+            oaf_scheduler_stop(scheduler);
+            return 0;
+        }
 
-    for (worker_index = 0; worker_index < OAF_SCHEDULER_MAX_WORKERS; worker_index++)
-    {
-        queue_init(&scheduler->worker_queues[worker_index]);
+        scheduler->started_workers++;
     }
 
     return 1;
 }
 
-void oaf_scheduler_shutdown(OafThreadScheduler* scheduler)
+void oaf_scheduler_stop(OafThreadScheduler* scheduler)
 {
     size_t worker_index;
 
-    if (scheduler == NULL)
+    if (scheduler == NULL || !atomic_exchange(&scheduler->running, 0))
     {
         return;
     }
 
-    scheduler->thread_count = 0;
-    scheduler->rr_worker = 0;
+    atomic_fetch_add(&scheduler->wake_epoch, 1u);
+    oaf_mutex_lock(&scheduler->park_mutex);
+    oaf_cond_var_broadcast(&scheduler->work_available);
+    oaf_mutex_unlock(&scheduler->park_mutex);
 
-    for (worker_index = 0; worker_index < OAF_SCHEDULER_MAX_WORKERS; worker_index++)
+    for (worker_index = 0; worker_index < scheduler->started_workers; worker_index++)
     {
-        queue_init(&scheduler->worker_queues[worker_index]);
+        pthread_join(scheduler->workers[worker_index].handle, NULL);
     }
+
+    scheduler->started_workers = 0;
 }
 
-OafLightweightThread* oaf_scheduler_spawn(
+int oaf_scheduler_is_running(const OafThreadScheduler* scheduler)
+{
+    if (scheduler == NULL)
+    {
+        return 0;
+    }
+
+    return atomic_load(&((OafThreadScheduler*)scheduler)->running) != 0;
+}
+
+int oaf_scheduler_wait_idle(OafThreadScheduler* scheduler)
+{
+    if (scheduler == NULL)
+    {
+        return 0;
+    }
+
+    if (!oaf_scheduler_is_running(scheduler))
+    {
+        oaf_scheduler_run_all(scheduler);
+        return oaf_scheduler_pending_count(scheduler) == 0;
+    }
+
+    if (!oaf_mutex_lock(&scheduler->park_mutex))
+    {
+        return 0;
+    }
+
+    while (atomic_load(&scheduler->in_flight) > 0)
+    {
+        if (!oaf_cond_var_wait(&scheduler->idle, &scheduler->park_mutex))
+        {
+            oaf_mutex_unlock(&scheduler->park_mutex);
+            return 0;
+        }
+    }
+
+    oaf_mutex_unlock(&scheduler->park_mutex);
+    return 1;
+}
+
+static OafLightweightThread* spawn_thread(
     OafThreadScheduler* scheduler,
     OafLightweightThreadProc proc,
-    void* proc_args)
+    void* proc_args,
+    int stackful)
 {
     OafLightweightThread* thread;
-    size_t target_worker;
+    void* stack = NULL;
+    size_t worker_index;
 
     if (scheduler == NULL || proc == NULL)
     {
         return NULL;
     }
 
-    if (scheduler->thread_count >= OAF_SCHEDULER_MAX_THREADS)
+    thread = acquire_thread(scheduler);
+    if (thread == NULL)
     {
-        scheduler->stats.failed_spawns++;
+        atomic_fetch_add_explicit(&scheduler->stats.failed_spawns, 1u, memory_order_relaxed);
         return NULL;
     }
 
-    thread = &scheduler->thread_pool[scheduler->thread_count];
-    scheduler->thread_count++;
-    oaf_lightweight_thread_init(thread, scheduler->next_thread_id, proc, proc_args);
-    scheduler->next_thread_id++;
+    oaf_lightweight_thread_init(
+        thread,
+        (uint64_t)atomic_fetch_add_explicit(&scheduler->next_thread_id, 1u, memory_order_relaxed),
+        proc,
+        proc_args);
+    thread->scheduler = scheduler;
 
-    target_worker = scheduler->rr_worker % scheduler->worker_count;
-    scheduler->rr_worker++;
+    if (stackful)
+    {
+        stack = oaf_stack_pool_acquire(&scheduler->stack_pool);
+        if (stack == NULL
+            || !oaf_fiber_context_make(
+                &thread->context,
+                stack,
+                oaf_stack_pool_stack_size(&scheduler->stack_pool),
+                stackful_entry,
+                thread))
+        {
+            oaf_stack_pool_release(&scheduler->stack_pool, stack);
+            atomic_fetch_add_explicit(&scheduler->stats.failed_spawns, 1u, memory_order_relaxed);
+            thread->state = OAF_THREAD_STATE_FAILED;
+            recycle_thread(scheduler, thread);
+            return NULL;
+        }
+
+        thread->stack = stack;
+        thread->stack_size = oaf_stack_pool_stack_size(&scheduler->stack_pool);
+    }
+
+    atomic_fetch_add(&scheduler->in_flight, 1u);
+    atomic_fetch_add_explicit(&scheduler->stats.enqueued, 1u, memory_order_relaxed);
 
-    if (!queue_push_back(&scheduler->worker_queues[target_worker], thread))
+    if (oaf_scheduler_is_running(scheduler))
     {
-        scheduler->stats.failed_spawns++;
-        thread->state = OAF_THREAD_STATE_FAILED;
-        return NULL;
+        enqueue_thread(scheduler, thread);
+        return thread;
+    }
+
+    worker_index = atomic_fetch_add_explicit(&scheduler->rr_worker, 1u, memory_order_relaxed) % scheduler->worker_count;
+    if (!queue_push(&scheduler->worker_queues[worker_index], thread))
+    {
+        inject_push(scheduler, thread);
     }
 
-    scheduler->stats.enqueued++;
     return thread;
 }
 
+OafLightweightThread* oaf_scheduler_spawn(
+    OafThreadScheduler* scheduler,
+    OafLightweightThreadProc proc,
+    void* proc_args)
+{
+    return spawn_thread(scheduler, proc, proc_args, 0);
+}
+
+OafLightweightThread* oaf_scheduler_spawn_stackful(
+    OafThreadScheduler* scheduler,
+    OafLightweightThreadProc proc,
+    void* proc_args)
+{
+    return spawn_thread(scheduler, proc, proc_args, 1);
+}
+
 int oaf_scheduler_steal(
     OafThreadScheduler* scheduler,
     size_t thief_worker_index,
@@ -168,15 +1039,15 @@ int oaf_scheduler_steal(
         OafWorkStealingQueue* victim_queue = &scheduler->worker_queues[victim_index];
         OafLightweightThread* stolen;
 
-        if (victim_queue->count == 0)
+        if (queue_size(victim_queue) == 0)
         {
             continue;
         }
 
-        stolen = queue_pop_back(victim_queue);
+        stolen = queue_steal(victim_queue);
         if (stolen != NULL)
         {
-            scheduler->stats.stolen++;
+            atomic_fetch_add_explicit(&scheduler->stats.stolen, 1u, memory_order_relaxed);
             *thread_out = stolen;
             return 1;
         }
@@ -189,66 +1060,82 @@ int oaf_scheduler_run_next(OafThreadScheduler* scheduler, size_t worker_index)
 {
     OafLightweightThread* thread;
 
-    if (scheduler == NULL || worker_index >= scheduler->worker_count)
+    if (scheduler == NULL
+        || worker_index >= scheduler->worker_count
+        || oaf_scheduler_is_running(scheduler)
+        || g_current_thread != NULL)
     {
         return 0;
     }
 
-    thread = queue_pop_front(&scheduler->worker_queues[worker_index]);
+    thread = find_work(scheduler, worker_index);
     if (thread == NULL)
     {
-        OafLightweightThread* stolen = NULL;
-        if (!oaf_scheduler_steal(scheduler, worker_index, &stolen))
-        {
-            return 0;
-        }
-
-        thread = stolen;
-    }
-
-    if (!oaf_lightweight_thread_run(thread))
-    {
-        thread->state = OAF_THREAD_STATE_FAILED;
         return 0;
     }
 
-    scheduler->stats.executed++;
-    return 1;
+    return execute_thread(scheduler, thread);
 }
 
 size_t oaf_scheduler_run_all(OafThreadScheduler* scheduler)
 {
-    size_t total_executed = 0;
-    size_t guard = OAF_SCHEDULER_MAX_THREADS * 2;
+    size_t executed_before;
 
     if (scheduler == NULL)
     {
         return 0;
     }
 
-    while (oaf_scheduler_pending_count(scheduler) > 0 && guard > 0)
+    if (oaf_scheduler_is_running(scheduler))
+    {
+        executed_before = atomic_load(&scheduler->stats.executed);
+
+        if (!oaf_scheduler_wait_idle(scheduler))
+        {
+            return 0;
+        }
+
+        return atomic_load(&scheduler->stats.executed) - executed_before;
+    }
+
+    executed_before = atomic_load(&scheduler->stats.executed);
+    while (oaf_scheduler_pending_count(scheduler) > 0
+        || atomic_load(&scheduler->next_timer_ns) != UINT64_MAX)
     {
         size_t worker_index;
-        size_t executed_this_round = 0;
+        size_t progressed_this_round = 0;
+        uint64_t deadline = atomic_load(&scheduler->next_timer_ns);
+
+        /* Nothing runnable but a timed park outstanding: sleep to its deadline instead of returning early. */
+        if (oaf_scheduler_pending_count(scheduler) == 0)
+        {
+            uint64_t now = oaf_monotonic_time_ns();
+
+            if (deadline > now)
+            {
+                struct timespec pause;
+
+                pause.tv_sec = (time_t)((deadline - now) / 1000000000u);
+                pause.tv_nsec = (long)((deadline - now) % 1000000000u);
+                nanosleep(&pause, NULL);
+            }
+        }
 
         for (worker_index = 0; worker_index < scheduler->worker_count; worker_index++)
         {
             if (oaf_scheduler_run_next(scheduler, worker_index))
             {
-                executed_this_round++;
-                total_executed++;
+                progressed_this_round++;
             }
         }
 
-        if (executed_this_round == 0)
+        if (progressed_this_round == 0)
         {
             break;
         }
-
-        guard--;
     }
 
-    return total_executed;
+    return atomic_load(&scheduler->stats.executed) - executed_before;
 }
 
 size_t oaf_scheduler_pending_count(const OafThreadScheduler* scheduler)
@@ -263,10 +1150,10 @@ size_t oaf_scheduler_pending_count(const OafThreadScheduler* scheduler)
 
     for (worker_index = 0; worker_index < scheduler->worker_count; worker_index++)
     {
-        pending += scheduler->worker_queues[worker_index].count;
+        pending += queue_size(&scheduler->worker_queues[worker_index]);
     }
 
-    return pending;
+    return pending + atomic_load(&((OafThreadScheduler*)scheduler)->inject_count);
 }
 
 const OafSchedulerStats* oaf_scheduler_stats(const OafThreadScheduler* scheduler)
@@ -278,3 +1165,212 @@ const OafSchedulerStats* oaf_scheduler_stats(const OafThreadScheduler* scheduler
 
     return &scheduler->stats;
 }
+
+size_t oaf_scheduler_live_threads(OafThreadScheduler* scheduler)
+{
+    size_t live_threads;
+
+    if (scheduler == NULL || !oaf_mutex_lock(&scheduler->slab_mutex))
+    {
+        return 0;
+    }
+
+    live_threads = scheduler->live_threads;
+    oaf_mutex_unlock(&scheduler->slab_mutex);
+    return live_threads;
+}
+
+size_t oaf_scheduler_thread_capacity(OafThreadScheduler* scheduler)
+{
+    size_t capacity;
+
+    if (scheduler == NULL || !oaf_mutex_lock(&scheduler->slab_mutex))
+    {
+        return 0;
+    }
+
+    capacity = scheduler->slab_count * OAF_SCHEDULER_SLAB_SIZE;
+    oaf_mutex_unlock(&scheduler->slab_mutex);
+    return capacity;
+}
+
+OafThreadHandle oaf_scheduler_thread_handle(const OafLightweightThread* thread)
+{
+    if (thread == NULL || thread->scheduler == NULL)
+    {
+        return OAF_THREAD_HANDLE_INVALID;
+    }
+
+    return ((OafThreadHandle)atomic_load(&((OafLightweightThread*)thread)->generation) << 32)
+        | (OafThreadHandle)thread->slot;
+}
+
+OafLightweightThread* oaf_scheduler_thread_lookup(OafThreadScheduler* scheduler, OafThreadHandle handle)
+{
+    OafLightweightThread* thread;
+
+    if (scheduler == NULL || handle == OAF_THREAD_HANDLE_INVALID)
+    {
+        return NULL;
+    }
+
+    thread = slot_thread(scheduler, (size_t)(handle & 0xFFFFFFFFu));
+    if (thread == NULL || atomic_load(&thread->generation) != (unsigned int)(handle >> 32))
+    {
+        return NULL;
+    }
+
+    return thread;
+}
+
+int oaf_scheduler_thread_is_done(OafThreadScheduler* scheduler, OafThreadHandle handle)
+{
+    OafLightweightThread* thread;
+
+    if (scheduler == NULL
+        || handle == OAF_THREAD_HANDLE_INVALID
+        || slot_thread(scheduler, (size_t)(handle & 0xFFFFFFFFu)) == NULL)
+    {
+        return 0;
+    }
+
+    thread = oaf_scheduler_thread_lookup(scheduler, handle);
+    return thread == NULL || oaf_lightweight_thread_is_done(thread);
+}
+
+OafLightweightThread* oaf_thread_current(void)
+{
+    return g_current_thread;
+}
+
+int oaf_thread_yield(void)
+{
+    OafLightweightThread* thread = g_current_thread;
+
+    if (thread == NULL)
+    {
+        sched_yield();
+        return 0;
+    }
+
+    thread->switch_reason = OAF_THREAD_SWITCH_YIELD;
+    oaf_fiber_context_switch(&thread->context, thread->return_context);
+    return 1;
+}
+
+int oaf_thread_park(void)
+{
+    return oaf_thread_park_unlock(NULL);
+}
+
+int oaf_thread_park_unlock(OafMutex* mutex)
+{
+    OafLightweightThread* thread = g_current_thread;
+    int expected = OAF_THREAD_PARK_PERMIT;
+
+    if (thread == NULL)
+    {
+        return 0;
+    }
+
+    if (atomic_compare_exchange_strong(&thread->park_state, &expected, OAF_THREAD_PARK_IDLE))
+    {
+        if (mutex != NULL)
+        {
+            oaf_mutex_unlock(mutex);
+        }
+        return 1;
+    }
+
+    thread->park_unlock = mutex;
+    thread->switch_reason = OAF_THREAD_SWITCH_PARK;
+    oaf_fiber_context_switch(&thread->context, thread->return_context);
+    return 1;
+}
+
+int oaf_thread_park_until(uint64_t deadline_ns)
+{
+    OafLightweightThread* thread = g_current_thread;
+    OafSchedulerTimer timer;
+
+    if (thread == NULL)
+    {
+        return 0;
+    }
+
+    if (oaf_monotonic_time_ns() >= deadline_ns)
+    {
+        return 1;
+    }
+
+    timer.deadline_ns = deadline_ns;
+    timer.thread = thread;
+    timer.next = NULL;
+    timer.armed = 0;
+    timer_arm(thread->scheduler, &timer);
+    oaf_thread_park();
+    timer_disarm(thread->scheduler, &timer);
+    return 1;
+}
+
+static void wake_event_waiter(void* context)
+{
+    oaf_thread_unpark((OafLightweightThread*)context);
+}
+
+int oaf_thread_wait_event(OafEventCount* event_count, unsigned int key)
+{
+    OafLightweightThread* thread = g_current_thread;
+    OafEventWaiter waiter;
+
+    if (thread == NULL)
+    {
+        return 0;
+    }
+
+    waiter.wake = wake_event_waiter;
+    waiter.context = thread;
+    waiter.next = NULL;
+    if (oaf_event_count_add_waiter(event_count, key, &waiter))
+    {
+        oaf_thread_park();
+    }
+
+    oaf_event_count_remove_waiter(event_count, &waiter);
+    return 1;
+}
+
+void oaf_thread_unpark(OafLightweightThread* thread)
+{
+    int state;
+
+    if (thread == NULL || thread->scheduler == NULL)
+    {
+        return;
+    }
+
+    state = atomic_load(&thread->park_state);
+    while (1)
+    {
+        if (state == OAF_THREAD_PARK_PERMIT)
+        {
+            return;
+        }
+
+        if (state == OAF_THREAD_PARK_IDLE)
+        {
+            if (atomic_compare_exchange_weak(&thread->park_state, &state, OAF_THREAD_PARK_PERMIT))
+            {
+                return;
+            }
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak(&thread->park_state, &state, OAF_THREAD_PARK_IDLE))
+        {
+            thread->state = OAF_THREAD_STATE_READY;
+            enqueue_thread(thread->scheduler, thread);
+            return;
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spsc_channel.h"
+#include "scheduler.h"
+
+static unsigned char* spsc_slot(const OafSpscChannel* channel, size_t position)
+{
+    return channel->slots + (position & channel->mask) * channel->slot_stride;
+}
+
+static int spsc_is_full(OafSpscChannel* channel)
+{
+    return atomic_load(&channel->tail) - atomic_load(&channel->head) > channel->mask;
+}
+
+static int spsc_is_empty(OafSpscChannel* channel)
+{
+    return atomic_load(&channel->tail) == atomic_load(&channel->head);
+}
+
+static void spsc_backoff(OafSpscChannel* channel, OafEventCount* event_count, int for_space, size_t* spins)
+{
+    unsigned int key;
+
+    if (*spins < OAF_SPSC_CHANNEL_SPIN_ROUNDS)
+    {
+        (*spins)++;
+        OAF_CPU_RELAX();
+        return;
+    }
+
+    /* Yielding the OS thread frees nothing for a green thread's peers on the same worker; it parks instead. */
+    if (oaf_thread_current() == NULL && *spins < OAF_SPSC_CHANNEL_SPIN_ROUNDS + OAF_SPSC_CHANNEL_YIELD_ROUNDS)
+    {
+        (*spins)++;
+        sched_yield();
+        return;
+    }
+
+    key = oaf_event_count_prepare_wait(event_count);
+    if (atomic_load(&channel->closed)
+        || !(for_space ? spsc_is_full(channel) : spsc_is_empty(channel)))
+    {
+        oaf_event_count_cancel_wait(event_count);
+        return;
+    }
+
+    if (!oaf_thread_wait_event(event_count, key))
+    {
+        oaf_event_count_wait(event_count, key);
+    }
+}
+
+int oaf_spsc_channel_init(OafSpscChannel* channel, size_t element_size, size_t capacity)
+{
+    size_t rounded = 2;
+    size_t stride = 1;
+
+    if (channel == NULL
+        || element_size == 0
+        || element_size > OAF_SPSC_CHANNEL_MAX_ELEMENT_SIZE
+        || capacity == 0
+        || capacity > ((size_t)-1 >> 8))
+    {
+        return 0;
+    }
+
+    while (rounded < capacity)
+    {
+        rounded <<= 1;
+    }
+
+    while (stride < element_size)
+    {
+        stride <<= 1;
+    }
+
+    channel->slots = (unsigned char*)aligned_alloc(
+        OAF_CACHE_LINE_SIZE,
+        (rounded * stride + OAF_CACHE_LINE_SIZE - 1u) / OAF_CACHE_LINE_SIZE * OAF_CACHE_LINE_SIZE);
+    if (channel->slots == NULL)
+    {
+        return 0;
+    }
+
+    channel->element_size = element_size;
+    channel->slot_stride = stride;
+    channel->mask = rounded - 1u;
+    channel->cached_head = 0;
+    channel->cached_tail = 0;
+    atomic_init(&channel->tail, 0u);
+    atomic_init(&channel->head, 0u);
+    atomic_init(&channel->closed, 0);
+    oaf_event_count_init(&channel->not_empty);
+    oaf_event_count_init(&channel->not_full);
+    return 1;
+}
+
+void oaf_spsc_channel_destroy(OafSpscChannel* channel)
+{
+    if (channel == NULL)
+    {
+        return;
+    }
+
+    free(channel->slots);
+    channel->slots = NULL;
+    channel->mask = 0;
+    atomic_store(&channel->tail, 0u);
+    atomic_store(&channel->head, 0u);
+    atomic_store(&channel->closed, 1);
+}
+
+int oaf_spsc_channel_try_send(OafSpscChannel* channel, const void* element)
+{
+    size_t tail;
+
+    if (channel == NULL || channel->slots == NULL || element == NULL
+        || atomic_load_explicit(&channel->closed, memory_order_acquire))
+    {
+        return 0;
+    }
+
+    tail = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+    if (tail - channel->cached_head > channel->mask)
+    {
+        channel->cached_head = atomic_load_explicit(&channel->head, memory_order_acquire);
+        if (tail - channel->cached_head > channel->mask)
+        {
+            return 0;
+        }
+    }
+
+    memcpy(spsc_slot(channel, tail), element, channel->element_size);
+    atomic_store_explicit(&channel->tail, tail + 1u, memory_order_release);
+    oaf_event_count_notify(&channel->not_empty, 1);
+    return 1;
+}
+
+int oaf_spsc_channel_try_recv(OafSpscChannel* channel, void* out_element)
+{
+    size_t head;
+
+    if (channel == NULL || channel->slots == NULL || out_element == NULL)
+    {
+        return 0;
+    }
+
+    head = atomic_load_explicit(&channel->head, memory_order_relaxed);
+    if (head == channel->cached_tail)
+    {
+        channel->cached_tail = atomic_load_explicit(&channel->tail, memory_order_acquire);
+        if (head == channel->cached_tail)
+        {
+            return 0;
+        }
+    }
+
+    memcpy(out_element, spsc_slot(channel, head), channel->element_size);
+    atomic_store_explicit(&channel->head, head + 1u, memory_order_release);
+    oaf_event_count_notify(&channel->not_full, 1);
+    return 1;
+}
+
+int oaf_spsc_channel_send(OafSpscChannel* channel, const void* element)
+{
+    size_t spins = 0;
+
+    if (channel == NULL || channel->slots == NULL || element == NULL)
+    {
+        return 0;
+    }
+
+    while (!atomic_load_explicit(&channel->closed, memory_order_acquire))
+    {
+        if (oaf_spsc_channel_try_send(channel, element))
+        {
+            return 1;
+        }
+
+        spsc_backoff(channel, &channel->not_full, 1, &spins);
+    }
+
+    return 0;
+}
+
+int oaf_spsc_channel_recv(OafSpscChannel* channel, void* out_element)
+{
+    size_t spins = 0;
+
+    if (channel == NULL || channel->slots == NULL || out_element == NULL)
+    {
+        return 0;
+    }
+
+    while (1)
+    {
+        if (oaf_spsc_channel_try_recv(channel, out_element))
+        {
+            return 1;
+        }
+
+        if (atomic_load_explicit(&channel->closed, memory_order_acquire))
+        {
+            return oaf_spsc_channel_try_recv(channel, out_element);
+        }
+
+        spsc_backoff(channel, &channel->not_empty, 0, &spins);
+    }
+}
+
+void oaf_spsc_channel_close(OafSpscChannel* channel)
+{
+    if (channel == NULL || channel->slots == NULL)
+    {
+        return;
+    }
+
+    atomic_store(&channel->closed, 1);
+    oaf_event_count_notify(&channel->not_empty, 0);
+    oaf_event_count_notify(&channel->not_full, 0);
+}
+
+size_t oaf_spsc_channel_count(const OafSpscChannel* channel)
+{
+    size_t head;
+    size_t tail;
+
+    if (channel == NULL || channel->slots == NULL)
+    {
+        return 0;
+    }
+
+    head = atomic_load(&((OafSpscChannel*)channel)->head);
+    tail = atomic_load(&((OafSpscChannel*)channel)->tail);
+    return tail - head;
+}
+
+size_t oaf_spsc_channel_capacity(const OafSpscChannel* channel)
+{
+    if (channel == NULL || channel->slots == NULL)
+    {
+        return 0;
+    }
+
+    return channel->mask + 1u;
+}
@@ -0,0 +1,185 @@
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "stack_pool.h"
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifndef MAP_STACK
+#define MAP_STACK 0
+#endif
+
+struct OafStackPoolEntry
+{
+    OafStackPoolEntry* next;
+};
+
+static size_t page_size(void)
+{
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (size_t)size : 4096u;
+}
+
+static void* map_stack(const OafStackPool* pool)
+{
+    unsigned char* mapping;
+
+    mapping = (unsigned char*)mmap(
+        NULL,
+        pool->guard_size + pool->stack_size,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+        -1,
+        0);
+    if (mapping == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    if (mprotect(mapping, pool->guard_size, PROT_NONE) != 0)
+    {
+        munmap(mapping, pool->guard_size + pool->stack_size);
+        return NULL;
+    }
+
+    return mapping + pool->guard_size;
+}
+
+static void unmap_stack(const OafStackPool* pool, void* stack)
+{
+    munmap((unsigned char*)stack - pool->guard_size, pool->guard_size + pool->stack_size);
+}
+
+int oaf_stack_pool_init(OafStackPool* pool, size_t stack_size, size_t max_cached)
+{
+    size_t page;
+
+    if (pool == NULL)
+    {
+        return 0;
+    }
+
+    page = page_size();
+    if (stack_size == 0)
+    {
+        stack_size = OAF_STACK_POOL_DEFAULT_STACK_SIZE;
+    }
+
+    pool->free_list = NULL;
+    pool->stack_size = (stack_size + page - 1u) & ~(page - 1u);
+    pool->guard_size = page;
+    pool->cached_count = 0;
+    pool->max_cached = max_cached;
+    pool->active_count = 0;
+
+    return oaf_mutex_init(&pool->mutex);
+}
+
+void oaf_stack_pool_destroy(OafStackPool* pool)
+{
+    OafStackPoolEntry* entry;
+
+    if (pool == NULL || !pool->mutex.initialized)
+    {
+        return;
+    }
+
+    entry = pool->free_list;
+    while (entry != NULL)
+    {
+        OafStackPoolEntry* next = entry->next;
+        unmap_stack(pool, entry);
+        entry = next;
+    }
+
+    pool->free_list = NULL;
+    pool->cached_count = 0;
+    pool->active_count = 0;
+    oaf_mutex_destroy(&pool->mutex);
+}
+
+void* oaf_stack_pool_acquire(OafStackPool* pool)
+{
+    OafStackPoolEntry* entry;
+
+    if (pool == NULL || !oaf_mutex_lock(&pool->mutex))
+    {
+        return NULL;
+    }
+
+    entry = pool->free_list;
+    if (entry != NULL)
+    {
+        pool->free_list = entry->next;
+        pool->cached_count--;
+    }
+    pool->active_count++;
+    oaf_mutex_unlock(&pool->mutex);
+
+    if (entry != NULL)
+    {
+        return entry;
+    }
+
+    entry = (OafStackPoolEntry*)map_stack(pool);
+    if (entry == NULL)
+    {
+        oaf_mutex_lock(&pool->mutex);
+        pool->active_count--;
+        oaf_mutex_unlock(&pool->mutex);
+    }
+
+    return entry;
+}
+
+void oaf_stack_pool_release(OafStackPool* pool, void* stack)
+{
+    OafStackPoolEntry* entry = (OafStackPoolEntry*)stack;
+
+    if (pool == NULL || stack == NULL || !oaf_mutex_lock(&pool->mutex))
+    {
+        return;
+    }
+
+    if (pool->active_count > 0)
+    {
+        pool->active_count--;
+    }
+
+    if (pool->cached_count < pool->max_cached)
+    {
+        entry->next = pool->free_list;
+        pool->free_list = entry;
+        pool->cached_count++;
+        entry = NULL;
+    }
+
+    oaf_mutex_unlock(&pool->mutex);
+
+    if (entry != NULL)
+    {
+        unmap_stack(pool, entry);
+    }
+}
+
+size_t oaf_stack_pool_stack_size(const OafStackPool* pool)
+{
+    if (pool == NULL)
+    {
+        return 0;
+    }
+
+    return pool->stack_size;
+}
+
+size_t oaf_stack_pool_active_count(const OafStackPool* pool)
+{
+    if (pool == NULL)
+    {
+        return 0;
+    }
+
+    return pool->active_count;
+}
@@ -1,5 +1,15 @@
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <time.h>
 #include "sync_primitives.h"
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 int oaf_mutex_init(OafMutex* mutex)
 {
     if (mutex == NULL)
@@ -48,6 +58,22 @@ int oaf_mutex_unlock(OafMutex* mutex)
     return pthread_mutex_unlock(&mutex->handle) == 0;
 }
 
+/* Timed waits measure against CLOCK_MONOTONIC so a wall-clock step neither cuts them short nor stretches them. */
+static int init_monotonic_cond(pthread_cond_t* cond)
+{
+    pthread_condattr_t attributes;
+    int ok;
+
+    if (pthread_condattr_init(&attributes) != 0)
+    {
+        return 0;
+    }
+
+    ok = pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC) == 0 && pthread_cond_init(cond, &attributes) == 0;
+    pthread_condattr_destroy(&attributes);
+    return ok;
+}
+
 int oaf_cond_var_init(OafCondVar* cond_var)
 {
     if (cond_var == NULL)
@@ -55,7 +81,7 @@ int oaf_cond_var_init(OafCondVar* cond_var)
         return 0;
     }
 
-    if (pthread_cond_init(&cond_var->handle, NULL) != 0)
+    if (!init_monotonic_cond(&cond_var->handle))
     {
         cond_var->initialized = 0;
         return 0;
@@ -86,6 +112,24 @@ int oaf_cond_var_wait(OafCondVar* cond_var, OafMutex* mutex)
     return pthread_cond_wait(&cond_var->handle, &mutex->handle) == 0;
 }
 
+int oaf_cond_var_timed_wait(OafCondVar* cond_var, OafMutex* mutex, uint64_t timeout_ns)
+{
+    struct timespec deadline;
+    uint64_t nanoseconds;
+
+    if (cond_var == NULL || mutex == NULL || !cond_var->initialized || !mutex->initialized)
+    {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    nanoseconds = (uint64_t)deadline.tv_nsec + timeout_ns % 1000000000u;
+    deadline.tv_sec += (time_t)(timeout_ns / 1000000000u + nanoseconds / 1000000000u);
+    deadline.tv_nsec = (long)(nanoseconds % 1000000000u);
+
+    return pthread_cond_timedwait(&cond_var->handle, &mutex->handle, &deadline) != ETIMEDOUT;
+}
+
 int oaf_cond_var_signal(OafCondVar* cond_var)
 {
     if (cond_var == NULL || !cond_var->initialized)
@@ -105,3 +149,153 @@ int oaf_cond_var_broadcast(OafCondVar* cond_var)
 
     return pthread_cond_broadcast(&cond_var->handle) == 0;
 }
+
+void oaf_futex_wait(atomic_uint* word, unsigned int expected)
+{
+    if (word == NULL)
+    {
+        return;
+    }
+
+#if defined(__linux__)
+    syscall(SYS_futex, (unsigned int*)word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#else
+    while (atomic_load(word) == expected)
+    {
+        sched_yield();
+    }
+#endif
+}
+
+void oaf_futex_wake(atomic_uint* word, int waiter_count)
+{
+    if (word == NULL)
+    {
+        return;
+    }
+
+#if defined(__linux__)
+    syscall(SYS_futex, (unsigned int*)word, FUTEX_WAKE_PRIVATE, waiter_count <= 0 ? INT_MAX : waiter_count, NULL, NULL, 0);
+#else
+    (void)waiter_count;
+#endif
+}
+
+void oaf_event_count_init(OafEventCount* event_count)
+{
+    if (event_count == NULL)
+    {
+        return;
+    }
+
+    atomic_init(&event_count->epoch, 0u);
+    atomic_init(&event_count->waiters, 0u);
+    atomic_flag_clear(&event_count->parked_lock);
+    event_count->parked = NULL;
+}
+
+static void event_count_lock(OafEventCount* event_count)
+{
+    while (atomic_flag_test_and_set_explicit(&event_count->parked_lock, memory_order_acquire))
+    {
+        sched_yield();
+    }
+}
+
+static void event_count_unlock(OafEventCount* event_count)
+{
+    atomic_flag_clear_explicit(&event_count->parked_lock, memory_order_release);
+}
+
+unsigned int oaf_event_count_prepare_wait(OafEventCount* event_count)
+{
+    atomic_fetch_add(&event_count->waiters, 1u);
+    return atomic_load(&event_count->epoch);
+}
+
+void oaf_event_count_cancel_wait(OafEventCount* event_count)
+{
+    atomic_fetch_sub(&event_count->waiters, 1u);
+}
+
+void oaf_event_count_wait(OafEventCount* event_count, unsigned int key)
+{
+    oaf_futex_wait(&event_count->epoch, key);
+    atomic_fetch_sub(&event_count->waiters, 1u);
+}
+
+void oaf_event_count_notify(OafEventCount* event_count, int waiter_count)
+{
+    int remaining;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&event_count->waiters, memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+    atomic_fetch_add(&event_count->epoch, 1u);
+    oaf_futex_wake(&event_count->epoch, waiter_count);
+
+    /* Wake under the lock: a resumed waiter removes itself under it too, so its node outlives the call. */
+    remaining = waiter_count <= 0 ? INT_MAX : waiter_count;
+    event_count_lock(event_count);
+    while (event_count->parked != NULL && remaining > 0)
+    {
+        OafEventWaiter* waiter = event_count->parked;
+
+        event_count->parked = waiter->next;
+        waiter->queued = 0;
+        waiter->wake(waiter->context);
+        remaining--;
+    }
+    event_count_unlock(event_count);
+}
+
+int oaf_event_count_add_waiter(OafEventCount* event_count, unsigned int key, OafEventWaiter* waiter)
+{
+    int queued = 0;
+
+    /* Notifiers bump the epoch before taking the lock, so checking it under the lock cannot miss a wake. */
+    event_count_lock(event_count);
+    if (atomic_load(&event_count->epoch) == key)
+    {
+        waiter->next = event_count->parked;
+        waiter->queued = 1;
+        event_count->parked = waiter;
+        queued = 1;
+    }
+    else
+    {
+        waiter->queued = 0;
+    }
+    event_count_unlock(event_count);
+    return queued;
+}
+
+void oaf_event_count_remove_waiter(OafEventCount* event_count, OafEventWaiter* waiter)
+{
+    OafEventWaiter** link = &event_count->parked;
+
+    event_count_lock(event_count);
+    if (waiter->queued)
+    {
+        while (*link != waiter)
+        {
+            link = &(*link)->next;
+        }
+
+        *link = waiter->next;
+        waiter->queued = 0;
+    }
+    event_count_unlock(event_count);
+    atomic_fetch_sub(&event_count->waiters, 1u);
+}
+
+uint64_t oaf_monotonic_time_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
@@ -18,6 +18,13 @@ void oaf_lightweight_thread_init(
     thread->proc_args = proc_args;
     thread->result = NULL;
     thread->next = NULL;
+    thread->scheduler = NULL;
+    thread->stack = NULL;
+    thread->stack_size = 0;
+    thread->return_context = NULL;
+    thread->switch_reason = OAF_THREAD_SWITCH_NONE;
+    thread->park_unlock = NULL;
+    atomic_init(&thread->park_state, OAF_THREAD_PARK_IDLE);
 }
 
 int oaf_lightweight_thread_run(OafLightweightThread* thread)
@@ -49,3 +56,13 @@ int oaf_lightweight_thread_is_done(const OafLightweightThread* thread)
         || thread->state == OAF_THREAD_STATE_FAILED
         || thread->state == OAF_THREAD_STATE_CANCELLED;
 }
+
+int oaf_lightweight_thread_is_stackful(const OafLightweightThread* thread)
+{
+    if (thread == NULL)
+    {
+        return 0;
+    }
+
+    return thread->stack != NULL;
+}
@@ -3,6 +3,8 @@
 #include <unistd.h>
 #include "scheduler.h"
 #include "channel.h"
+#include "ring_channel.h"
+#include "spsc_channel.h"
 #include "atomic_ops.h"
 #include "sync_primitives.h"
 
@@ -82,6 +84,312 @@ static int test_scheduler_and_work_stealing(void)
     return 1;
 }
 
+typedef struct FanOutState
+{
+    OafThreadScheduler* scheduler;
+    OafAtomicI64* total;
+    int64_t value;
+    int children;
+} FanOutState;
+
+static void* fan_out_task(void* args)
+{
+    FanOutState* state = (FanOutState*)args;
+    int child;
+
+    oaf_atomic_i64_fetch_add(state->total, state->value);
+    for (child = 0; child < state->children; child++)
+    {
+        if (oaf_scheduler_spawn(state->scheduler, accumulate_task, &state->children) == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+static int test_threaded_scheduler(void)
+{
+    OafThreadScheduler scheduler;
+    FanOutState states[64];
+    OafAtomicI64 total;
+    size_t index;
+    const OafSchedulerStats* stats;
+    int ok = 1;
+
+    if (!oaf_scheduler_init(&scheduler, 4))
+    {
+        return 0;
+    }
+
+    if (!oaf_scheduler_start(&scheduler) || !oaf_scheduler_is_running(&scheduler))
+    {
+        oaf_scheduler_shutdown(&scheduler);
+        return 0;
+    }
+
+    oaf_atomic_i64_init(&total, 0);
+    oaf_atomic_i64_init(&g_scheduler_counter, 0);
+
+    for (index = 0; index < 64; index++)
+    {
+        states[index].scheduler = &scheduler;
+        states[index].total = &total;
+        states[index].value = (int64_t)(index + 1u);
+        states[index].children = 4;
+        if (oaf_scheduler_spawn(&scheduler, fan_out_task, &states[index]) == NULL)
+        {
+            ok = 0;
+            break;
+        }
+    }
+
+    ok = ok && oaf_scheduler_wait_idle(&scheduler);
+    ok = ok && oaf_atomic_i64_load(&total) == 2080;
+    ok = ok && oaf_atomic_i64_load(&g_scheduler_counter) == 64 * 4 * 4;
+    ok = ok && oaf_scheduler_pending_count(&scheduler) == 0;
+    ok = ok && !oaf_scheduler_run_next(&scheduler, 0);
+
+    stats = oaf_scheduler_stats(&scheduler);
+    ok = ok && stats != NULL && stats->executed == 64 + (64 * 4) && stats->failed_spawns == 0;
+
+    oaf_scheduler_stop(&scheduler);
+    ok = ok && !oaf_scheduler_is_running(&scheduler);
+    oaf_scheduler_shutdown(&scheduler);
+    return ok;
+}
+
+static int test_thread_recycling(void)
+{
+    OafThreadScheduler scheduler;
+    OafLightweightThread* thread;
+    OafThreadHandle handle;
+    int value = 1;
+    size_t index;
+    size_t round;
+    size_t capacity;
+    int ok = 1;
+
+    if (!oaf_scheduler_init(&scheduler, 2))
+    {
+        return 0;
+    }
+
+    oaf_atomic_i64_init(&g_scheduler_counter, 0);
+
+    for (index = 0; ok && index < 1000; index++)
+    {
+        ok = oaf_scheduler_spawn(&scheduler, accumulate_task, &value) != NULL;
+    }
+
+    ok = ok && oaf_scheduler_pending_count(&scheduler) == 1000;
+    ok = ok && oaf_scheduler_run_all(&scheduler) == 1000;
+    ok = ok && oaf_scheduler_live_threads(&scheduler) == 0;
+    capacity = oaf_scheduler_thread_capacity(&scheduler);
+    ok = ok && capacity >= 1000;
+
+    for (round = 0; ok && round < 20; round++)
+    {
+        for (index = 0; ok && index < 100; index++)
+        {
+            ok = oaf_scheduler_spawn(&scheduler, accumulate_task, &value) != NULL;
+        }
+
+        ok = ok && oaf_scheduler_run_all(&scheduler) == 100;
+    }
+
+    ok = ok && oaf_atomic_i64_load(&g_scheduler_counter) == 3000;
+    ok = ok && oaf_scheduler_thread_capacity(&scheduler) == capacity;
+    ok = ok && oaf_scheduler_stats(&scheduler)->recycled == 3000;
+    ok = ok && oaf_scheduler_stats(&scheduler)->failed_spawns == 0;
+
+    thread = ok ? oaf_scheduler_spawn(&scheduler, accumulate_task, &value) : NULL;
+    handle = oaf_scheduler_thread_handle(thread);
+    ok = ok && handle != OAF_THREAD_HANDLE_INVALID;
+    ok = ok && oaf_scheduler_thread_lookup(&scheduler, handle) == thread;
+    ok = ok && !oaf_scheduler_thread_is_done(&scheduler, handle);
+    ok = ok && oaf_scheduler_run_all(&scheduler) == 1;
+    ok = ok && oaf_scheduler_thread_is_done(&scheduler, handle);
+    ok = ok && oaf_scheduler_thread_lookup(&scheduler, handle) == NULL;
+
+    thread = ok ? oaf_scheduler_spawn(&scheduler, accumulate_task, &value) : NULL;
+    ok = ok && thread != NULL && oaf_scheduler_thread_handle(thread) != handle;
+    ok = ok && oaf_scheduler_thread_lookup(&scheduler, handle) == NULL;
+    ok = ok && oaf_scheduler_run_all(&scheduler) == 1;
+
+    oaf_scheduler_shutdown(&scheduler);
+    return ok;
+}
+
+typedef struct YieldState
+{
+    int* log;
+    size_t* log_length;
+    int tag;
+} YieldState;
+
+static void* yielding_task(void* args)
+{
+    YieldState* state = (YieldState*)args;
+    int step;
+
+    for (step = 0; step < 3; step++)
+    {
+        state->log[*state->log_length] = state->tag;
+        (*state->log_length)++;
+        if (!oaf_thread_yield())
+        {
+            return NULL;
+        }
+    }
+
+    return state;
+}
+
+static int test_stackful_yield(void)
+{
+    OafThreadScheduler scheduler;
+    OafLightweightThread* first;
+    OafLightweightThread* second;
+    YieldState states[2];
+    int log[6] = {0};
+    size_t log_length = 0;
+    size_t index;
+    int ok = 1;
+
+    if (!oaf_scheduler_init(&scheduler, 1))
+    {
+        return 0;
+    }
+
+    for (index = 0; index < 2; index++)
+    {
+        states[index].log = log;
+        states[index].log_length = &log_length;
+        states[index].tag = (int)index + 1;
+    }
+
+    first = oaf_scheduler_spawn_stackful(&scheduler, yielding_task, &states[0]);
+    second = oaf_scheduler_spawn_stackful(&scheduler, yielding_task, &states[1]);
+    ok = first != NULL && second != NULL && oaf_lightweight_thread_is_stackful(first);
+    ok = ok && oaf_scheduler_run_all(&scheduler) == 2;
+    ok = ok && log_length == 6;
+
+    for (index = 1; ok && index < 6; index++)
+    {
+        ok = log[index] != log[index - 1];
+    }
+
+    ok = ok && oaf_lightweight_thread_is_done(first) && first->result == &states[0];
+    ok = ok && oaf_lightweight_thread_is_done(second) && second->result == &states[1];
+    ok = ok && oaf_scheduler_stats(&scheduler)->yielded == 6;
+    ok = ok && oaf_stack_pool_active_count(&scheduler.stack_pool) == 0;
+    ok = ok && oaf_thread_current() == NULL && !oaf_thread_yield();
+
+    oaf_scheduler_shutdown(&scheduler);
+    return ok;
+}
+
+typedef struct GreenChannelState
+{
+    OafChannel* channel;
+    OafAtomicI64* total;
+    int64_t* values;
+    size_t value_count;
+} GreenChannelState;
+
+static void* green_consumer(void* args)
+{
+    GreenChannelState* state = (GreenChannelState*)args;
+    void* received = NULL;
+
+    if (oaf_channel_recv(state->channel, &received))
+    {
+        oaf_atomic_i64_fetch_add(state->total, *(int64_t*)received);
+    }
+
+    return NULL;
+}
+
+static void* green_producer(void* args)
+{
+    GreenChannelState* state = (GreenChannelState*)args;
+    size_t index;
+
+    for (index = 0; index < state->value_count; index++)
+    {
+        if (!oaf_channel_send(state->channel, &state->values[index]))
+        {
+            return NULL;
+        }
+    }
+
+    return state;
+}
+
+static int run_green_channel_round(size_t worker_count, int threaded)
+{
+    OafThreadScheduler scheduler;
+    OafChannel channel;
+    OafAtomicI64 total;
+    GreenChannelState state;
+    int64_t values[300];
+    size_t index;
+    int ok = 1;
+
+    if (!oaf_scheduler_init(&scheduler, worker_count))
+    {
+        return 0;
+    }
+
+    if (!oaf_channel_init(&channel, 4))
+    {
+        oaf_scheduler_shutdown(&scheduler);
+        return 0;
+    }
+
+    for (index = 0; index < 300; index++)
+    {
+        values[index] = (int64_t)(index + 1u);
+    }
+
+    oaf_atomic_i64_init(&total, 0);
+    state.channel = &channel;
+    state.total = &total;
+    state.values = values;
+    state.value_count = 300;
+
+    if (threaded && !oaf_scheduler_start(&scheduler))
+    {
+        oaf_channel_destroy(&channel);
+        oaf_scheduler_shutdown(&scheduler);
+        return 0;
+    }
+
+    for (index = 0; ok && index < 300; index++)
+    {
+        ok = oaf_scheduler_spawn_stackful(&scheduler, green_consumer, &state) != NULL;
+    }
+
+    ok = ok && oaf_scheduler_spawn_stackful(&scheduler, green_producer, &state) != NULL;
+    ok = ok && oaf_scheduler_wait_idle(&scheduler);
+    ok = ok && oaf_atomic_i64_load(&total) == (300 * 301) / 2;
+    ok = ok && oaf_scheduler_stats(&scheduler)->executed == 301;
+    ok = ok && (threaded || oaf_scheduler_stats(&scheduler)->parked > 0);
+
+    oaf_scheduler_shutdown(&scheduler);
+    oaf_channel_destroy(&channel);
+    return ok;
+}
+
+static int test_green_thread_channels(void)
+{
+    return run_green_channel_round(1, 0)
+        && run_green_channel_round(3, 0)
+        && run_green_channel_round(4, 1);
+}
+
 static int test_channel_operations(void)
 {
     OafChannel channel;
@@ -137,6 +445,630 @@ static int test_channel_operations(void)
     return 1;
 }
 
+static int test_channel_batches(void)
+{
+    OafChannel channel;
+    int values[5] = {1, 2, 3, 4, 5};
+    void* outgoing[5];
+    void* incoming[5] = {0};
+    size_t index;
+    int ok;
+
+    if (!oaf_channel_init(&channel, 8))
+    {
+        return 0;
+    }
+
+    for (index = 0; index < 5; index++)
+    {
+        outgoing[index] = &values[index];
+    }
+
+    ok = oaf_channel_send_batch(&channel, outgoing, 5) == 5;
+    ok = ok && oaf_channel_count(&channel) == 5;
+    ok = ok && oaf_channel_recv_batch(&channel, incoming, 3) == 3;
+    ok = ok && oaf_channel_recv_batch(&channel, incoming + 3, 5) == 2;
+
+    for (index = 0; ok && index < 5; index++)
+    {
+        ok = incoming[index] == &values[index];
+    }
+
+    oaf_channel_close(&channel);
+    ok = ok && oaf_channel_send_batch(&channel, outgoing, 5) == 0;
+    ok = ok && oaf_channel_recv_batch(&channel, incoming, 5) == 0;
+
+    oaf_channel_destroy(&channel);
+    return ok;
+}
+
+typedef struct SampleMessage
+{
+    int64_t sequence;
+    double weight;
+    int tag;
+} SampleMessage;
+
+static int test_typed_channel(void)
+{
+    OafChannel channel;
+    SampleMessage message;
+    SampleMessage received;
+    void* pointer = NULL;
+    int index;
+    int ok;
+
+    if (!oaf_channel_init_typed(&channel, sizeof(SampleMessage), 2))
+    {
+        return 0;
+    }
+
+    ok = oaf_channel_element_size(&channel) == sizeof(SampleMessage);
+    ok = ok && ((uintptr_t)channel.slots % OAF_CACHE_LINE_SIZE) == 0;
+    ok = ok && channel.slot_stride >= sizeof(SampleMessage)
+        && OAF_CACHE_LINE_SIZE % channel.slot_stride == 0;
+
+    for (index = 0; ok && index < 2; index++)
+    {
+        message.sequence = index;
+        message.weight = index * 0.5;
+        message.tag = 100 + index;
+        ok = oaf_channel_send_value(&channel, &message);
+    }
+
+    message.sequence = 99;
+    ok = ok && !oaf_channel_try_send_value(&channel, &message);
+    ok = ok && !oaf_channel_try_send(&channel, &message);
+    ok = ok && !oaf_channel_try_recv(&channel, &pointer);
+
+    for (index = 0; ok && index < 2; index++)
+    {
+        ok = oaf_channel_recv_value(&channel, &received)
+            && received.sequence == index
+            && received.weight == index * 0.5
+            && received.tag == 100 + index;
+    }
+
+    ok = ok && !oaf_channel_try_recv_value(&channel, &received);
+    oaf_channel_close(&channel);
+    ok = ok && !oaf_channel_send_value(&channel, &message);
+    ok = ok && !oaf_channel_recv_value(&channel, &received);
+
+    oaf_channel_destroy(&channel);
+    return ok;
+}
+
+static void* spsc_producer(void* args)
+{
+    OafSpscChannel* channel = (OafSpscChannel*)args;
+    SampleMessage message;
+    int64_t index;
+
+    for (index = 0; index < 10000; index++)
+    {
+        message.sequence = index;
+        message.weight = (double)index;
+        message.tag = (int)(index & 0xFF);
+        if (!oaf_spsc_channel_send(channel, &message))
+        {
+            break;
+        }
+    }
+
+    oaf_spsc_channel_close(channel);
+    return NULL;
+}
+
+static int test_spsc_channel(void)
+{
+    OafSpscChannel channel;
+    SampleMessage received;
+    pthread_t producer;
+    int64_t expected = 0;
+    unsigned char oversized[OAF_SPSC_CHANNEL_MAX_ELEMENT_SIZE + 1];
+    int ok = 1;
+
+    if (oaf_spsc_channel_init(&channel, sizeof(oversized), 4))
+    {
+        oaf_spsc_channel_destroy(&channel);
+        return 0;
+    }
+
+    if (!oaf_spsc_channel_init(&channel, sizeof(SampleMessage), 16))
+    {
+        return 0;
+    }
+
+    if (pthread_create(&producer, NULL, spsc_producer, &channel) != 0)
+    {
+        oaf_spsc_channel_destroy(&channel);
+        return 0;
+    }
+
+    while (oaf_spsc_channel_recv(&channel, &received))
+    {
+        ok = ok
+            && received.sequence == expected
+            && received.weight == (double)expected
+            && received.tag == (int)(expected & 0xFF);
+        expected++;
+    }
+
+    pthread_join(producer, NULL);
+    ok = ok && expected == 10000;
+    ok = ok && oaf_spsc_channel_count(&channel) == 0;
+    ok = ok && !oaf_spsc_channel_try_send(&channel, &received);
+
+    oaf_spsc_channel_destroy(&channel);
+    return ok;
+}
+
+typedef struct GreenSpscState
+{
+    OafSpscChannel* channel;
+    int64_t received;
+    int in_order;
+} GreenSpscState;
+
+static void* green_spsc_consumer(void* args)
+{
+    GreenSpscState* state = (GreenSpscState*)args;
+    SampleMessage message;
+
+    while (oaf_spsc_channel_recv(state->channel, &message))
+    {
+        state->in_order = state->in_order && message.sequence == state->received;
+        state->received++;
+    }
+
+    return NULL;
+}
+
+/* Both ends as green threads on one worker: each side parks on the other's event count rather than yielding. */
+static int test_green_spsc_channel(void)
+{
+    OafThreadScheduler scheduler;
+    OafSpscChannel channel;
+    GreenSpscState state;
+    int ok;
+
+    if (!oaf_scheduler_init(&scheduler, 1))
+    {
+        return 0;
+    }
+
+    ok = oaf_spsc_channel_init(&channel, sizeof(SampleMessage), 16);
+    state.channel = &channel;
+    state.received = 0;
+    state.in_order = 1;
+    ok = ok && oaf_scheduler_spawn_stackful(&scheduler, green_spsc_consumer, &state) != NULL;
+    ok = ok && oaf_scheduler_spawn_stackful(&scheduler, spsc_producer, &channel) != NULL;
+    ok = ok && oaf_scheduler_run_all(&scheduler) == 2;
+    ok = ok && state.received == 10000 && state.in_order;
+    ok = ok && oaf_scheduler_stats(&scheduler)->yielded == 0;
+    ok = ok && oaf_scheduler_stats(&scheduler)->parked > 0;
+
+    oaf_scheduler_shutdown(&scheduler);
+    oaf_spsc_channel_destroy(&channel);
+    return ok;
+}
+
+typedef struct DelayedChannelOp
+{
+    OafChannel* channel;
+    int value;
+    int send;
+} DelayedChannelOp;
+
+static void* delayed_channel_op(void* args)
+{
+    DelayedChannelOp* op = (DelayedChannelOp*)args;
+    int received = 0;
+
+    usleep(20000);
+    if (op->send)
+    {
+        oaf_channel_send_value(op->channel, &op->value);
+    }
+    else
+    {
+        oaf_channel_recv_value(op->channel, &received);
+        op->value = received;
+    }
+
+    return NULL;
+}
+
+static int test_channel_select(void)
+{
+    OafChannel first;
+    OafChannel second;
+    OafChannelSelectCase cases[2];
+    DelayedChannelOp op;
+    pthread_t helper;
+    int first_value = 0;
+    int second_value = 0;
+    int outgoing = 77;
+    uint64_t started;
+    int ok;
+
+    if (!oaf_channel_init_typed(&first, sizeof(int), 1))
+    {
+        return 0;
+    }
+
+    if (!oaf_channel_init_typed(&second, sizeof(int), 1))
+    {
+        oaf_channel_destroy(&first);
+        return 0;
+    }
+
+    cases[0].channel = &first;
+    cases[0].op = OAF_CHANNEL_SELECT_RECV;
+    cases[0].send_element = NULL;
+    cases[0].recv_element = &first_value;
+    cases[1].channel = &second;
+    cases[1].op = OAF_CHANNEL_SELECT_RECV;
+    cases[1].send_element = NULL;
+    cases[1].recv_element = &second_value;
+
+    ok = oaf_channel_select(cases, 2, 0) == OAF_CHANNEL_SELECT_TIMEOUT;
+    started = oaf_monotonic_time_ns();
+    ok = ok && oaf_channel_select(cases, 2, 30) == OAF_CHANNEL_SELECT_TIMEOUT;
+    ok = ok && oaf_monotonic_time_ns() - started >= 25000000u;
+    ok = ok && oaf_channel_select(cases, 0, 0) == OAF_CHANNEL_SELECT_ERROR;
+
+    outgoing = 5;
+    ok = ok && oaf_channel_send_value(&second, &outgoing);
+    ok = ok && oaf_channel_select(cases, 2, -1) == 1 && second_value == 5;
+
+    op.channel = &first;
+    op.value = 11;
+    op.send = 1;
+    ok = ok && pthread_create(&helper, NULL, delayed_channel_op, &op) == 0;
+    ok = ok && oaf_channel_select(cases, 2, -1) == 0 && first_value == 11;
+    pthread_join(helper, NULL);
+
+    outgoing = 21;
+    ok = ok && oaf_channel_send_value(&second, &outgoing);
+    cases[1].op = OAF_CHANNEL_SELECT_SEND;
+    cases[1].send_element = &outgoing;
+    op.channel = &second;
+    op.value = 0;
+    op.send = 0;
+    ok = ok && pthread_create(&helper, NULL, delayed_channel_op, &op) == 0;
+    outgoing = 22;
+    ok = ok && oaf_channel_select(cases, 2, 1000) == 1;
+    pthread_join(helper, NULL);
+    ok = ok && op.value == 21;
+    ok = ok && oaf_channel_recv_value(&second, &second_value) && second_value == 22;
+
+    oaf_channel_close(&first);
+    oaf_channel_close(&second);
+    ok = ok && oaf_channel_select(cases, 2, -1) == OAF_CHANNEL_SELECT_CLOSED;
+
+    oaf_channel_destroy(&second);
+    oaf_channel_destroy(&first);
+    return ok;
+}
+
+typedef struct GreenSelectState
+{
+    OafChannel* channels[2];
+    int received[2];
+    int selected[2];
+} GreenSelectState;
+
+static void* green_selector(void* args)
+{
+    GreenSelectState* state = (GreenSelectState*)args;
+    OafChannelSelectCase cases[2];
+    int value = 0;
+    int round;
+
+    for (round = 0; round < 2; round++)
+    {
+        cases[0].channel = state->channels[0];
+        cases[0].op = OAF_CHANNEL_SELECT_RECV;
+        cases[0].send_element = NULL;
+        cases[0].recv_element = &value;
+        cases[1] = cases[0];
+        cases[1].channel = state->channels[1];
+        state->selected[round] = oaf_channel_select(cases, 2, -1);
+        state->received[round] = value;
+    }
+
+    return NULL;
+}
+
+static void* green_select_feeder(void* args)
+{
+    GreenSelectState* state = (GreenSelectState*)args;
+    int second = 2;
+    int first = 1;
+
+    oaf_channel_send_value(state->channels[1], &second);
+    oaf_thread_yield();
+    oaf_channel_send_value(state->channels[0], &first);
+    return NULL;
+}
+
+static int test_green_channel_select(void)
+{
+    OafThreadScheduler scheduler;
+    OafChannel channels[2];
+    GreenSelectState state;
+    int ok;
+
+    if (!oaf_scheduler_init(&scheduler, 1))
+    {
+        return 0;
+    }
+
+    ok = oaf_channel_init_typed(&channels[0], sizeof(int), 1);
+    ok = ok && oaf_channel_init_typed(&channels[1], sizeof(int), 1);
+    state.channels[0] = &channels[0];
+    state.channels[1] = &channels[1];
+
+    ok = ok && oaf_scheduler_spawn_stackful(&scheduler, green_selector, &state) != NULL;
+    ok = ok && oaf_scheduler_run_all(&scheduler) == 0;
+    ok = ok && oaf_scheduler_stats(&scheduler)->parked == 1;
+    ok = ok && oaf_scheduler_spawn_stackful(&scheduler, green_select_feeder, &state) != NULL;
+    ok = ok && oaf_scheduler_run_all(&scheduler) == 2;
+    ok = ok && state.selected[0] == 1 && state.received[0] == 2;
+    ok = ok && state.selected[1] == 0 && state.received[1] == 1;
+
+    oaf_scheduler_shutdown(&scheduler);
+    oaf_channel_destroy(&channels[1]);
+    oaf_channel_destroy(&channels[0]);
+    return ok;
+}
+
+static void* green_timed_selector(void* args)
+{
+    GreenSelectState* state = (GreenSelectState*)args;
+    OafChannelSelectCase select_case;
+    int value = 0;
+
+    select_case.channel = state->channels[0];
+    select_case.op = OAF_CHANNEL_SELECT_RECV;
+    select_case.send_element = NULL;
+    select_case.recv_element = &value;
+    state->selected[0] = oaf_channel_select(&select_case, 1, 20);
+    return NULL;
+}
+
+/* A timed select parks on a scheduler timer, both when driven by run_all and by started workers. */
+static int test_green_select_timeout(void)
+{
+    OafThreadScheduler scheduler;
+    OafChannel channel;
+    GreenSelectState state;
+    uint64_t started;
+    int ok;
+
+    if (!oaf_scheduler_init(&scheduler, 1))
+    {
+        return 0;
+    }
+
+    ok = oaf_channel_init_typed(&channel, sizeof(int), 1);
+    state.channels[0] = &channel;
+    state.selected[0] = 0;
+
+    started = oaf_monotonic_time_ns();
+    ok = ok && oaf_scheduler_spawn_stackful(&scheduler, green_timed_selector, &state) != NULL;
+    ok = ok && oaf_scheduler_run_all(&scheduler) == 1;
+    ok = ok && state.selected[0] == OAF_CHANNEL_SELECT_TIMEOUT;
+    ok = ok && oaf_monotonic_time_ns() - started >= 20000000u;
+    ok = ok && oaf_scheduler_stats(&scheduler)->yielded == 0;
+
+    state.selected[0] = 0;
+    ok = ok && oaf_scheduler_start(&scheduler);
+    ok = ok && oaf_scheduler_spawn_stackful(&scheduler, green_timed_selector, &state) != NULL;
+    ok = ok && oaf_scheduler_wait_idle(&scheduler);
+    ok = ok && state.selected[0] == OAF_CHANNEL_SELECT_TIMEOUT;
+    ok = ok && oaf_scheduler_stats(&scheduler)->yielded == 0;
+    ok = ok && oaf_scheduler_stats(&scheduler)->parked == 2;
+
+    oaf_scheduler_shutdown(&scheduler);
+    oaf_channel_destroy(&channel);
+    return ok;
+}
+
+typedef struct RingWorkerState
+{
+    OafRingChannel* channel;
+    size_t first;
+    size_t count;
+    int64_t sum;
+} RingWorkerState;
+
+static void* ring_producer(void* args)
+{
+    RingWorkerState* state = (RingWorkerState*)args;
+    void* batch[16];
+    size_t sent = 0;
+
+    while (sent < state->count)
+    {
+        size_t chunk = state->count - sent < 16 ? state->count - sent : 16;
+        size_t index;
+
+        for (index = 0; index < chunk; index++)
+        {
+            batch[index] = (void*)(uintptr_t)(state->first + sent + index + 1u);
+        }
+
+        if (oaf_ring_channel_send_batch(state->channel, batch, chunk) != chunk)
+        {
+            return NULL;
+        }
+
+        sent += chunk;
+    }
+
+    return NULL;
+}
+
+static void* ring_consumer(void* args)
+{
+    RingWorkerState* state = (RingWorkerState*)args;
+    void* batch[8];
+    size_t moved;
+
+    while ((moved = oaf_ring_channel_recv_batch(state->channel, batch, 8)) > 0)
+    {
+        size_t index;
+
+        for (index = 0; index < moved; index++)
+        {
+            state->sum += (int64_t)(uintptr_t)batch[index];
+        }
+    }
+
+    return NULL;
+}
+
+static void* green_ring_consumer(void* args)
+{
+    RingWorkerState* state = (RingWorkerState*)args;
+    void* received = NULL;
+    size_t index;
+
+    for (index = 0; index < state->count && oaf_ring_channel_recv(state->channel, &received); index++)
+    {
+        state->sum += (int64_t)(uintptr_t)received;
+    }
+
+    return NULL;
+}
+
+/* Green threads blocked on a full or empty ring park on its event counts instead of yielding. */
+static int test_green_ring_channel(void)
+{
+    OafThreadScheduler scheduler;
+    OafRingChannel channel;
+    RingWorkerState producers[2];
+    RingWorkerState consumer;
+    int started;
+    int ok = 1;
+
+    for (started = 0; ok && started <= 1; started++)
+    {
+        size_t index;
+
+        if (!oaf_scheduler_init(&scheduler, started ? 2 : 1))
+        {
+            return 0;
+        }
+
+        ok = oaf_ring_channel_init(&channel, 8);
+        consumer.channel = &channel;
+        consumer.count = 4000u;
+        consumer.sum = 0;
+        ok = ok && oaf_scheduler_spawn_stackful(&scheduler, green_ring_consumer, &consumer) != NULL;
+        for (index = 0; index < 2; index++)
+        {
+            producers[index].channel = &channel;
+            producers[index].first = index * 2000u;
+            producers[index].count = 2000u;
+            ok = ok && oaf_scheduler_spawn_stackful(&scheduler, ring_producer, &producers[index]) != NULL;
+        }
+
+        if (started)
+        {
+            ok = ok && oaf_scheduler_start(&scheduler) && oaf_scheduler_wait_idle(&scheduler);
+        }
+        else
+        {
+            ok = ok && oaf_scheduler_run_all(&scheduler) == 3;
+        }
+
+        ok = ok && consumer.sum == (int64_t)4000 * 4001 / 2;
+        ok = ok && oaf_scheduler_stats(&scheduler)->yielded == 0;
+        ok = ok && oaf_scheduler_stats(&scheduler)->parked > 0;
+        oaf_scheduler_shutdown(&scheduler);
+        oaf_ring_channel_destroy(&channel);
+    }
+
+    return ok;
+}
+
+static int test_ring_channel(void)
+{
+    OafRingChannel channel;
+    RingWorkerState producers[4];
+    RingWorkerState consumers[2];
+    pthread_t producer_threads[4];
+    pthread_t consumer_threads[2];
+    int values[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    void* batch[8];
+    void* received = NULL;
+    size_t index;
+    int ok;
+
+    if (!oaf_ring_channel_init(&channel, 5))
+    {
+        return 0;
+    }
+
+    ok = oaf_ring_channel_capacity(&channel) == 8;
+    for (index = 0; ok && index < 8; index++)
+    {
+        ok = oaf_ring_channel_try_send(&channel, &values[index]);
+    }
+
+    ok = ok && !oaf_ring_channel_try_send(&channel, &values[0]);
+    ok = ok && oaf_ring_channel_count(&channel) == 8;
+    ok = ok && oaf_ring_channel_try_recv_batch(&channel, batch, 3) == 3;
+    ok = ok && batch[0] == &values[0] && batch[2] == &values[2];
+    ok = ok && oaf_ring_channel_try_send_batch(&channel, batch, 8) == 3;
+    ok = ok && oaf_ring_channel_recv(&channel, &received) && received == &values[3];
+
+    oaf_ring_channel_close(&channel);
+    ok = ok && !oaf_ring_channel_send(&channel, &values[0]);
+    ok = ok && oaf_ring_channel_recv_batch(&channel, batch, 8) == 7;
+    ok = ok && batch[4] == &values[0] && batch[6] == &values[2];
+    ok = ok && !oaf_ring_channel_recv(&channel, &received);
+    oaf_ring_channel_destroy(&channel);
+
+    if (!ok || !oaf_ring_channel_init(&channel, 64))
+    {
+        return 0;
+    }
+
+    for (index = 0; index < 2; index++)
+    {
+        consumers[index].channel = &channel;
+        consumers[index].sum = 0;
+        pthread_create(&consumer_threads[index], NULL, ring_consumer, &consumers[index]);
+    }
+
+    for (index = 0; index < 4; index++)
+    {
+        producers[index].channel = &channel;
+        producers[index].first = index * 5000u;
+        producers[index].count = 5000u;
+        pthread_create(&producer_threads[index], NULL, ring_producer, &producers[index]);
+    }
+
+    for (index = 0; index < 4; index++)
+    {
+        pthread_join(producer_threads[index], NULL);
+    }
+
+    oaf_ring_channel_close(&channel);
+    for (index = 0; index < 2; index++)
+    {
+        pthread_join(consumer_threads[index], NULL);
+    }
+
+    ok = consumers[0].sum + consumers[1].sum == (int64_t)20000 * 20001 / 2;
+    oaf_ring_channel_destroy(&channel);
+    return ok;
+}
+
 typedef struct WaitSignalState
 {
     OafMutex mutex;
@@ -229,7 +1161,20 @@ int main(void)
 {
     int ok = 1;
     ok = ok && test_scheduler_and_work_stealing();
+    ok = ok && test_threaded_scheduler();
+    ok = ok && test_thread_recycling();
+    ok = ok && test_stackful_yield();
+    ok = ok && test_green_thread_channels();
     ok = ok && test_channel_operations();
+    ok = ok && test_channel_batches();
+    ok = ok && test_ring_channel();
+    ok = ok && test_green_ring_channel();
+    ok = ok && test_typed_channel();
+    ok = ok && test_spsc_channel();
+    ok = ok && test_green_spsc_channel();
+    ok = ok && test_channel_select();
+    ok = ok && test_green_channel_select();
+    ok = ok && test_green_select_timeout();
     ok = ok && test_sync_primitives();
     ok = ok && test_atomic_operations();
 
@@ -43,6 +43,8 @@ int oaf_context_report_error(OafContext* context, OafRuntimeError* error);
 int oaf_context_has_error(const OafContext* context);
 void oaf_context_clear_error(OafContext* context);
 void oaf_context_set_gc_enabled(OafContext* context, int enabled);
+/* Matches OafLeakSiteProc so a leak detector can attribute allocations to the context's caller location. */
+OafSourceLocation oaf_context_caller_location(void* context);
 
 #ifdef __cplusplus
 }
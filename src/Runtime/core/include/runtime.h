@@ -2,6 +2,7 @@
 #define OAF_RUNTIME_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include "context.h"
 #include "error.h"
 #include "stack_trace.h"
@@ -21,7 +22,11 @@ typedef struct OafRuntimeOptions
 {
     size_t temp_allocator_capacity;
     size_t scheduler_worker_count;
+    int scheduler_threaded;
     int gc_enabled;
+    uint64_t gc_pause_budget_ns;
+    int gc_background_marking;
+    size_t gc_mark_workers;
 } OafRuntimeOptions;
 
 typedef enum OafRuntimeStatus
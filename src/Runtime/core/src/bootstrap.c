@@ -18,7 +18,11 @@ void oaf_runtime_options_default(OafRuntimeOptions* options)
 
     options->temp_allocator_capacity = OAF_RUNTIME_DEFAULT_TEMP_CAPACITY;
     options->scheduler_worker_count = 4;
+    options->scheduler_threaded = 0;
     options->gc_enabled = 0;
+    options->gc_pause_budget_ns = 0;
+    options->gc_background_marking = 0;
+    options->gc_mark_workers = 0;
 }
 
 OafRuntimeStatus oaf_runtime_init(OafRuntime* runtime, const OafRuntimeOptions* options)
@@ -85,6 +89,24 @@ OafRuntimeStatus oaf_runtime_init(OafRuntime* runtime, const OafRuntimeOptions*
         return OAF_RUNTIME_STATUS_INIT_FAILED;
     }
 
+    oaf_gc_set_pause_budget(&runtime->gc, effective_options.gc_pause_budget_ns);
+    if (effective_options.gc_enabled
+        && ((effective_options.gc_background_marking && !oaf_gc_start_background(&runtime->gc, 0))
+            || (effective_options.gc_mark_workers > 1 && !oaf_gc_set_mark_workers(&runtime->gc, effective_options.gc_mark_workers))))
+    {
+        oaf_runtime_error_init(
+            &runtime->startup_error,
+            "RuntimeInitializationError",
+            "Failed to start garbage collection worker threads.",
+            runtime_bootstrap_location(),
+            NULL);
+        runtime->context.last_error = &runtime->startup_error;
+        oaf_gc_destroy(&runtime->gc);
+        oaf_scheduler_shutdown(&runtime->scheduler);
+        runtime->initialized = 0;
+        return OAF_RUNTIME_STATUS_INIT_FAILED;
+    }
+
     if (!oaf_temp_allocator_init(&runtime->temp_allocator_state, effective_options.temp_allocator_capacity))
     {
         oaf_runtime_error_init(
@@ -101,8 +123,26 @@ OafRuntimeStatus oaf_runtime_init(OafRuntime* runtime, const OafRuntimeOptions*
     }
 
     runtime->context.temp_allocator = &runtime->temp_allocator_state;
+    oaf_temp_allocator_bind_thread(&runtime->temp_allocator_state);
     oaf_context_set_gc_enabled(&runtime->context, effective_options.gc_enabled);
 
+    if (effective_options.scheduler_threaded && !oaf_scheduler_start(&runtime->scheduler))
+    {
+        oaf_runtime_error_init(
+            &runtime->startup_error,
+            "RuntimeInitializationError",
+            "Failed to start scheduler worker threads.",
+            runtime_bootstrap_location(),
+            NULL);
+        runtime->context.last_error = &runtime->startup_error;
+        oaf_temp_allocator_bind_thread(NULL);
+        oaf_temp_allocator_destroy(&runtime->temp_allocator_state);
+        oaf_gc_destroy(&runtime->gc);
+        oaf_scheduler_shutdown(&runtime->scheduler);
+        runtime->initialized = 0;
+        return OAF_RUNTIME_STATUS_INIT_FAILED;
+    }
+
     if (!oaf_type_registry_register_builtins(&runtime->type_registry))
     {
         oaf_runtime_error_init(
@@ -112,6 +152,7 @@ OafRuntimeStatus oaf_runtime_init(OafRuntime* runtime, const OafRuntimeOptions*
             runtime_bootstrap_location(),
             NULL);
         runtime->context.last_error = &runtime->startup_error;
+        oaf_temp_allocator_bind_thread(NULL);
         oaf_temp_allocator_destroy(&runtime->temp_allocator_state);
         oaf_gc_destroy(&runtime->gc);
         oaf_scheduler_shutdown(&runtime->scheduler);
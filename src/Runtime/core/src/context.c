@@ -129,3 +129,15 @@ void oaf_context_set_gc_enabled(OafContext* context, int enabled)
 
     context->gc_enabled = enabled != 0;
 }
+
+OafSourceLocation oaf_context_caller_location(void* context)
+{
+    OafSourceLocation location = {NULL, 0, 0};
+
+    if (context == NULL)
+    {
+        return location;
+    }
+
+    return ((const OafContext*)context)->caller_location;
+}
@@ -9,6 +9,10 @@ void oaf_runtime_shutdown(OafRuntime* runtime)
 
     if (runtime->initialized != 0)
     {
+        if (oaf_temp_allocator_bound_thread() == &runtime->temp_allocator_state)
+        {
+            oaf_temp_allocator_bind_thread(NULL);
+        }
         oaf_temp_allocator_destroy(&runtime->temp_allocator_state);
         oaf_gc_destroy(&runtime->gc);
         oaf_scheduler_shutdown(&runtime->scheduler);
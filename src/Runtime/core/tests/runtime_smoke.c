@@ -30,6 +30,9 @@ static int test_runtime_initialization(void)
     oaf_runtime_options_default(&options);
     options.temp_allocator_capacity = 512;
     options.gc_enabled = 1;
+    options.gc_pause_budget_ns = 500000;
+    options.gc_background_marking = 1;
+    options.gc_mark_workers = 2;
 
     if (oaf_runtime_init(&runtime, &options) != OAF_RUNTIME_STATUS_OK)
     {
@@ -63,7 +66,7 @@ static int test_runtime_initialization(void)
     }
 
     gc = oaf_runtime_gc(&runtime);
-    if (gc == NULL || !gc->enabled)
+    if (gc == NULL || !gc->enabled || gc->pause_budget_ns != 500000 || !gc->background_running || oaf_gc_mark_workers(gc) != 2)
     {
         oaf_runtime_shutdown(&runtime);
         return 0;
@@ -94,6 +97,12 @@ static int test_runtime_initialization(void)
     }
     oaf_allocator_free(context->allocator, ptr);
 
+    if (oaf_temp_allocator_thread_local() != context->temp_allocator)
+    {
+        oaf_runtime_shutdown(&runtime);
+        return 0;
+    }
+
     oaf_temp_allocator_as_allocator(context->temp_allocator, &temp_allocator);
     size_t mark = oaf_temp_allocator_mark(context->temp_allocator);
     if (mark == (size_t)-1)
@@ -116,7 +125,7 @@ static int test_runtime_initialization(void)
     }
 
     oaf_runtime_shutdown(&runtime);
-    return runtime.initialized == 0;
+    return runtime.initialized == 0 && oaf_temp_allocator_bound_thread() == NULL;
 }
 
 static int test_runtime_error_handling(void)
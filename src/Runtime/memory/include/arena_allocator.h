@@ -8,16 +8,43 @@
 extern "C" {
 #endif
 
+#define OAF_ARENA_MAX_CHUNK_SIZE ((size_t)64 * 1024 * 1024)
+#define OAF_ARENA_COMMIT_GRANULE ((size_t)64 * 1024)
+
+typedef struct OafArenaChunk
+{
+    struct OafArenaChunk* prev;
+    size_t capacity;
+    size_t committed;
+    size_t reserved_size;
+} OafArenaChunk;
+
+/* Bump allocator over a chain of chunks; `buffer`, `capacity` and `offset` describe the newest chunk. */
 typedef struct OafArenaAllocatorState
 {
+    OafArenaChunk* current;
+    OafArenaChunk* spare;
     unsigned char* buffer;
     size_t capacity;
+    size_t committed;
     size_t offset;
+    size_t next_chunk_size;
+    size_t chunk_count;
+    size_t total_capacity;
 } OafArenaAllocatorState;
 
+typedef struct OafArenaCheckpoint
+{
+    OafArenaChunk* chunk;
+    size_t offset;
+} OafArenaCheckpoint;
+
 int oaf_arena_allocator_init(OafArenaAllocatorState* state, size_t capacity);
+int oaf_arena_allocator_init_reserved(OafArenaAllocatorState* state, size_t reserve_size);
 void oaf_arena_allocator_destroy(OafArenaAllocatorState* state);
 void oaf_arena_allocator_reset(OafArenaAllocatorState* state);
+OafArenaCheckpoint oaf_arena_allocator_save(const OafArenaAllocatorState* state);
+void oaf_arena_allocator_restore(OafArenaAllocatorState* state, OafArenaCheckpoint checkpoint);
 void oaf_arena_allocator_as_allocator(OafArenaAllocatorState* state, OafAllocator* allocator);
 
 #ifdef __cplusplus
@@ -2,28 +2,150 @@
 #define OAF_GC_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
 #include "allocator.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define OAF_GC_MAX_OBJECTS 512
+#define OAF_GC_INITIAL_CAPACITY 64
+#define OAF_GC_INITIAL_TRIGGER 4096
+#define OAF_GC_PAUSE_BUCKETS 32
+#define OAF_GC_BACKGROUND_INTERVAL_NS 1000000ull
+#define OAF_GC_NURSERY_CHUNK_SIZE ((size_t)256 * 1024)
+#define OAF_GC_NURSERY_MAX_ALIGNMENT 64
+#define OAF_GC_NURSERY_LINE_SIZE 256
+#define OAF_GC_NURSERY_LINES (OAF_GC_NURSERY_CHUNK_SIZE / OAF_GC_NURSERY_LINE_SIZE)
+#define OAF_GC_FLAG_YOUNG 1u
+#define OAF_GC_MAX_MARK_WORKERS 64
+#define OAF_GC_PARALLEL_MARK_MIN_OBJECTS 8192
 
+typedef enum OafGcPhase
+{
+    OAF_GC_PHASE_IDLE = 0,
+    OAF_GC_PHASE_MARKING = 1,
+    OAF_GC_PHASE_SWEEPING = 2
+} OafGcPhase;
+
+/* Bucket 0 counts pauses under 1 us; bucket i counts pauses in [2^(i-1), 2^i) us. */
+typedef struct OafGcPauseHistogram
+{
+    uint64_t buckets[OAF_GC_PAUSE_BUCKETS];
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} OafGcPauseHistogram;
+
+/* Header allocated in front of every managed object; `pointer` is the address handed to callers. */
 typedef struct OafGcObject
 {
     void* pointer;
     size_t size;
     size_t external_refs;
-    int marked;
-    int active;
+    size_t index;
+    size_t root_index;
+    size_t young_index;
+    size_t remembered_index;
+    struct OafGcNurseryChunk* chunk;
+    struct OafGcObject** children;
+    size_t child_count;
+    size_t child_capacity;
+    size_t* child_index;
+    size_t child_index_capacity;
+    atomic_uint mark_epoch;
+    uint32_t flags;
 } OafGcObject;
 
+/* Bump-pointer block young objects are carved from. line_live counts the objects overlapping each line, and
+   allocation bumps from offset to limit through a run of free lines, so lines freed around promoted objects are
+   reused. A chunk is queued for recycling when one of its lines frees up, and reset or freed once it is empty. */
+typedef struct OafGcNurseryChunk
+{
+    struct OafGcNurseryChunk* recycle_prev;
+    struct OafGcNurseryChunk* recycle_next;
+    size_t capacity;
+    size_t offset;
+    size_t limit;
+    size_t live_objects;
+    int recyclable;
+    unsigned char line_live[OAF_GC_NURSERY_LINES];
+} OafGcNurseryChunk;
+
+typedef struct OafGcGenerationStats
+{
+    size_t young_objects;
+    size_t young_bytes;
+    size_t old_objects;
+    size_t old_bytes;
+    size_t remembered_objects;
+    size_t minor_collections;
+    size_t promoted_objects;
+    size_t promoted_bytes;
+    size_t nursery_chunk_bytes;
+} OafGcGenerationStats;
+
+typedef struct OafGcMapEntry
+{
+    const void* pointer;
+    OafGcObject* object;
+} OafGcMapEntry;
+
+/* Tracing collector: roots are objects with external references, marking walks per-object child lists.
+   With a nursery, new objects are bump-allocated young; minor collections trace them from young roots and the
+   remembered set of old objects that point at them, and promote survivors in place. Callers hold object addresses, so
+   survivors are never evacuated; instead the free lines around them are reused by later nursery allocation.
+   Minor collections only run when the caller asks: poll oaf_gc_nursery_full and call oaf_gc_collect_minor at a point
+   where every young object it still needs is retained or referenced.
+   Incremental cycles mark and sweep in slices bounded by pause_budget_ns; reference changes shade their target while marking.
+   With a mark team, stop-the-world marks of large heaps are split across work-stealing workers. */
 typedef struct OafGarbageCollector
 {
     OafAllocator* allocator;
-    OafGcObject objects[OAF_GC_MAX_OBJECTS];
-    unsigned char edges[OAF_GC_MAX_OBJECTS][OAF_GC_MAX_OBJECTS];
+    OafGcObject** objects;
+    size_t object_capacity;
+    OafGcObject** roots;
+    size_t root_count;
+    size_t root_capacity;
+    OafGcMapEntry* map;
+    size_t map_capacity;
+    OafGcObject** mark_stack;
+    size_t mark_stack_capacity;
+    size_t mark_depth;
+    OafGcObject** fresh;
+    size_t fresh_count;
+    size_t fresh_capacity;
+    OafGcObject** young;
+    size_t young_count;
+    size_t young_capacity;
+    OafGcObject** remembered;
+    size_t remembered_count;
+    size_t remembered_capacity;
+    OafGcNurseryChunk* nursery_chunk;
+    OafGcNurseryChunk* nursery_spare;
+    OafGcNurseryChunk* nursery_recycle;
+    size_t nursery_chunks;
+    size_t nursery_limit;
+    size_t young_bytes;
+    size_t minor_collections;
+    size_t promoted_objects;
+    size_t promoted_bytes;
+    uint32_t mark_epoch;
+    OafGcPhase phase;
+    size_t sweep_cursor;
+    size_t next_trigger;
+    size_t cycles;
+    uint64_t pause_budget_ns;
+    OafGcPauseHistogram pauses;
+    struct OafGcMarkTeam* mark_team;
+    pthread_mutex_t mutex;
+    pthread_cond_t background_wake;
+    pthread_t background_thread;
+    uint64_t background_interval_ns;
+    int background_running;
+    int background_stop;
     size_t active_count;
     size_t managed_bytes;
     int enabled;
@@ -38,6 +160,20 @@ int oaf_gc_release(OafGarbageCollector* collector, void* pointer);
 int oaf_gc_add_reference(OafGarbageCollector* collector, void* from, void* to);
 int oaf_gc_remove_reference(OafGarbageCollector* collector, void* from, void* to);
 size_t oaf_gc_collect(OafGarbageCollector* collector);
+void oaf_gc_set_pause_budget(OafGarbageCollector* collector, uint64_t budget_ns);
+size_t oaf_gc_step(OafGarbageCollector* collector);
+int oaf_gc_is_collecting(const OafGarbageCollector* collector);
+int oaf_gc_start_background(OafGarbageCollector* collector, uint64_t interval_ns);
+void oaf_gc_stop_background(OafGarbageCollector* collector);
+void oaf_gc_pause_histogram(const OafGarbageCollector* collector, OafGcPauseHistogram* out_histogram);
+uint64_t oaf_gc_pause_percentile_ns(const OafGarbageCollector* collector, double percentile);
+void oaf_gc_set_nursery_size(OafGarbageCollector* collector, size_t bytes);
+/* The nursery size is advisory: allocation never collects on its own, so callers poll this and run oaf_gc_collect_minor. */
+int oaf_gc_nursery_full(const OafGarbageCollector* collector);
+size_t oaf_gc_collect_minor(OafGarbageCollector* collector);
+void oaf_gc_generation_stats(const OafGarbageCollector* collector, OafGcGenerationStats* out_stats);
+int oaf_gc_set_mark_workers(OafGarbageCollector* collector, size_t worker_count);
+size_t oaf_gc_mark_workers(const OafGarbageCollector* collector);
 int oaf_gc_detect_cycles(const OafGarbageCollector* collector);
 size_t oaf_gc_object_count(const OafGarbageCollector* collector);
 size_t oaf_gc_managed_bytes(const OafGarbageCollector* collector);
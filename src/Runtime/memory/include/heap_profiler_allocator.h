@@ -0,0 +1,109 @@
+#ifndef OAF_HEAP_PROFILER_ALLOCATOR_H
+#define OAF_HEAP_PROFILER_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "allocator.h"
+#include "source_location.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OAF_HEAP_PROFILER_SIZE_CLASSES 48
+#define OAF_HEAP_PROFILER_FILTER_BITS 12
+#define OAF_HEAP_PROFILER_INITIAL_SITES 64
+#define OAF_HEAP_PROFILER_PATH_CAPACITY 512
+
+typedef OafSourceLocation (*OafHeapProfilerSiteProc)(void* state);
+
+/* Size class i counts blocks whose size has its highest set bit at position i - 1 (class 0 holds empty blocks); estimates when sampling. */
+typedef struct OafHeapSizeClassStats
+{
+    atomic_size_t live_bytes;
+    atomic_size_t live_count;
+    atomic_size_t total_bytes;
+    atomic_size_t total_count;
+} OafHeapSizeClassStats;
+
+/* Byte and count totals are estimates scaled by the sampling interval. */
+typedef struct OafHeapSiteStats
+{
+    OafSourceLocation location;
+    size_t live_bytes;
+    size_t live_count;
+    size_t total_bytes;
+    size_t total_count;
+} OafHeapSiteStats;
+
+typedef struct OafHeapProfileSnapshot
+{
+    size_t live_bytes[OAF_HEAP_PROFILER_SIZE_CLASSES];
+    size_t live_count[OAF_HEAP_PROFILER_SIZE_CLASSES];
+    size_t total_bytes[OAF_HEAP_PROFILER_SIZE_CLASSES];
+    size_t total_count[OAF_HEAP_PROFILER_SIZE_CLASSES];
+    OafHeapSiteStats* sites;
+    size_t site_count;
+    size_t sample_interval;
+    uint64_t sequence;
+} OafHeapProfileSnapshot;
+
+typedef struct OafHeapSampledBlock
+{
+    void* ptr;
+    size_t size;
+    uint32_t site;
+} OafHeapSampledBlock;
+
+/* Decorator over any allocator: about one byte in sample_interval (every block when the interval is 0) is
+   recorded by size class and call site with a scaled weight. Blocks pass through unchanged; sampled ones are
+   kept in a side table, and a counting filter over their addresses lets most frees skip the table lock. */
+typedef struct OafHeapProfilerState
+{
+    OafAllocator* inner;
+    OafAllocatorOps inner_ops;
+    void* inner_state;
+    size_t sample_interval;
+    OafHeapProfilerSiteProc site_proc;
+    void* site_state;
+    OafHeapSizeClassStats classes[OAF_HEAP_PROFILER_SIZE_CLASSES];
+    pthread_mutex_t site_mutex;
+    OafHeapSiteStats* sites;
+    size_t site_count;
+    size_t site_capacity;
+    uint32_t* site_slots;
+    size_t site_slot_capacity;
+    OafHeapSampledBlock* sampled;
+    size_t sampled_count;
+    size_t sampled_capacity;
+    atomic_uchar sampled_filter[1u << OAF_HEAP_PROFILER_FILTER_BITS];
+    pthread_mutex_t dumper_mutex;
+    pthread_cond_t dumper_wake;
+    pthread_t dumper_thread;
+    char dump_prefix[OAF_HEAP_PROFILER_PATH_CAPACITY];
+    uint64_t dump_interval_ns;
+    uint64_t dump_sequence;
+    int dump_signal;
+    int dumper_running;
+    int dumper_stop;
+} OafHeapProfilerState;
+
+int oaf_heap_profiler_init(OafHeapProfilerState* state, OafAllocator* inner, size_t sample_interval);
+void oaf_heap_profiler_destroy(OafHeapProfilerState* state);
+void oaf_heap_profiler_set_site_provider(OafHeapProfilerState* state, OafHeapProfilerSiteProc proc, void* site_state);
+void oaf_heap_profiler_as_allocator(OafHeapProfilerState* state, OafAllocator* allocator);
+size_t oaf_heap_profiler_size_class(size_t size);
+int oaf_heap_profiler_snapshot(OafHeapProfilerState* state, OafHeapProfileSnapshot* out_snapshot);
+void oaf_heap_profile_snapshot_release(OafHeapProfileSnapshot* snapshot);
+int oaf_heap_profiler_write_folded(OafHeapProfilerState* state, const char* path);
+/* At most one profiler at a time may dump on a signal; a second signal dumper is refused until the first stops. */
+int oaf_heap_profiler_start_dumper(OafHeapProfilerState* state, const char* path_prefix, uint64_t interval_ns, int signal_number);
+void oaf_heap_profiler_stop_dumper(OafHeapProfilerState* state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
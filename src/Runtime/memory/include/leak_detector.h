@@ -2,23 +2,50 @@
 #define OAF_LEAK_DETECTOR_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include "source_location.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define OAF_LEAK_DETECTOR_MAX_RECORDS 2048
+#define OAF_LEAK_DETECTOR_INITIAL_CAPACITY 1024
+#define OAF_LEAK_DETECTOR_INITIAL_SITES 64
 
+typedef OafSourceLocation (*OafLeakSiteProc)(void* state);
+
+/* Slot in the pointer table; a NULL pointer marks an empty slot. */
 typedef struct OafLeakRecord
 {
     void* pointer;
     size_t size;
-    int active;
+    uint32_t site;
 } OafLeakRecord;
 
+typedef struct OafLeakSite
+{
+    OafSourceLocation location;
+    size_t active_allocations;
+    size_t active_bytes;
+    size_t total_allocations;
+} OafLeakSite;
+
+/* Open-addressing pointer table grouped by allocation site; with sample_rate > 1 about one allocation in sample_rate is recorded. */
 typedef struct OafLeakDetector
 {
-    OafLeakRecord records[OAF_LEAK_DETECTOR_MAX_RECORDS];
+    OafLeakRecord* records;
+    size_t record_capacity;
+    size_t record_count;
+    OafLeakSite* sites;
+    size_t site_count;
+    size_t site_capacity;
+    uint32_t* site_slots;
+    size_t site_slot_capacity;
+    OafLeakSiteProc site_proc;
+    void* site_state;
+    size_t sample_rate;
+    size_t sample_countdown;
+    uint64_t sample_seed;
     size_t active_allocations;
     size_t active_bytes;
     size_t peak_bytes;
@@ -26,12 +53,19 @@ typedef struct OafLeakDetector
 } OafLeakDetector;
 
 void oaf_leak_detector_init(OafLeakDetector* detector);
+void oaf_leak_detector_destroy(OafLeakDetector* detector);
+void oaf_leak_detector_set_sample_rate(OafLeakDetector* detector, size_t sample_rate);
+void oaf_leak_detector_set_site_provider(OafLeakDetector* detector, OafLeakSiteProc proc, void* state);
 int oaf_leak_detector_track_alloc(OafLeakDetector* detector, void* pointer, size_t size);
+int oaf_leak_detector_track_alloc_at(OafLeakDetector* detector, void* pointer, size_t size, OafSourceLocation location);
+int oaf_leak_detector_track_realloc(OafLeakDetector* detector, void* old_pointer, void* new_pointer, size_t size);
 int oaf_leak_detector_track_free(OafLeakDetector* detector, void* pointer);
 size_t oaf_leak_detector_active_allocations(const OafLeakDetector* detector);
 size_t oaf_leak_detector_active_bytes(const OafLeakDetector* detector);
 size_t oaf_leak_detector_peak_bytes(const OafLeakDetector* detector);
 int oaf_leak_detector_has_leaks(const OafLeakDetector* detector);
+size_t oaf_leak_detector_report(const OafLeakDetector* detector, OafLeakSite* out_sites, size_t capacity);
+int oaf_leak_detector_format_report(const OafLeakDetector* detector, char* buffer, size_t capacity);
 
 #ifdef __cplusplus
 }
@@ -6,6 +6,8 @@
 #include "arena_allocator.h"
 #include "pool_allocator.h"
 #include "temp_allocator.h"
+#include "thread_cache_allocator.h"
+#include "heap_profiler_allocator.h"
 #include "ownership.h"
 #include "lifetime.h"
 #include "bounds.h"
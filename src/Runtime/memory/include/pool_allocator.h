@@ -2,6 +2,9 @@
 #define OAF_POOL_ALLOCATOR_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
 #include "allocator.h"
 
 #ifdef __cplusplus
@@ -21,6 +24,38 @@ int oaf_pool_allocator_init(OafPoolAllocatorState* state, size_t block_size, siz
 void oaf_pool_allocator_destroy(OafPoolAllocatorState* state);
 void oaf_pool_allocator_as_allocator(OafPoolAllocatorState* state, OafAllocator* allocator);
 
+#define OAF_MULTI_POOL_SLAB_SIZE ((size_t)64 * 1024)
+#define OAF_MULTI_POOL_SLAB_HEADER_SIZE 64
+#define OAF_MULTI_POOL_MAX_CLASSES 16
+#define OAF_MULTI_POOL_MAX_SLABS 4096
+#define OAF_MULTI_POOL_MAX_ALIGNMENT ((size_t)32 * 1024)
+
+/* Free list head packs a 32-bit ABA tag above a 32-bit block index (index 0 is empty). */
+typedef struct OafMultiPoolClass
+{
+    _Alignas(64) _Atomic uint64_t head;
+    size_t block_size;
+    size_t blocks_per_slab;
+    unsigned char* _Atomic* slabs;
+    atomic_size_t slab_count;
+    atomic_size_t active_blocks;
+    pthread_mutex_t grow_mutex;
+} OafMultiPoolClass;
+
+/* Size-routed pool family; slabs are added on demand and blocks may be freed from any thread. */
+typedef struct OafMultiPoolAllocatorState
+{
+    OafMultiPoolClass classes[OAF_MULTI_POOL_MAX_CLASSES];
+    size_t class_count;
+    atomic_size_t large_allocations;
+    atomic_size_t large_active;
+} OafMultiPoolAllocatorState;
+
+int oaf_multi_pool_allocator_init(OafMultiPoolAllocatorState* state, const size_t* class_sizes, size_t class_count);
+void oaf_multi_pool_allocator_destroy(OafMultiPoolAllocatorState* state);
+void oaf_multi_pool_allocator_as_allocator(OafMultiPoolAllocatorState* state, OafAllocator* allocator);
+size_t oaf_multi_pool_allocator_active_blocks(OafMultiPoolAllocatorState* state);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,19 +3,21 @@
 
 #include <stddef.h>
 #include "allocator.h"
+#include "arena_allocator.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define OAF_TEMP_MAX_MARKS 128
+#define OAF_TEMP_THREAD_DEFAULT_CAPACITY ((size_t)64 * 1024)
 
+struct OafTempMark;
+
+/* Growable scratch arena; each mark is a record allocated in the arena itself, so nesting depth is unbounded. */
 typedef struct OafTempAllocatorState
 {
-    unsigned char* buffer;
-    size_t capacity;
-    size_t offset;
-    size_t marks[OAF_TEMP_MAX_MARKS];
+    OafArenaAllocatorState arena;
+    struct OafTempMark* top_mark;
     size_t mark_count;
 } OafTempAllocatorState;
 
@@ -26,6 +28,12 @@ int oaf_temp_allocator_reset_to_mark(OafTempAllocatorState* state, size_t mark_i
 void oaf_temp_allocator_clear(OafTempAllocatorState* state);
 void oaf_temp_allocator_as_allocator(OafTempAllocatorState* state, OafAllocator* allocator);
 
+/* Calling thread's temp allocator: the one bound with oaf_temp_allocator_bind_thread, else one created on first use and destroyed at thread exit. */
+OafTempAllocatorState* oaf_temp_allocator_thread_local(void);
+void oaf_temp_allocator_bind_thread(OafTempAllocatorState* state);
+OafTempAllocatorState* oaf_temp_allocator_bound_thread(void);
+void oaf_temp_allocator_thread_release(void);
+
 #ifdef __cplusplus
 }
 #endif
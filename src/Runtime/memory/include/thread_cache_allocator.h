@@ -0,0 +1,96 @@
+#ifndef OAF_THREAD_CACHE_ALLOCATOR_H
+#define OAF_THREAD_CACHE_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "allocator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OAF_TC_SPAN_SIZE ((size_t)256 * 1024)
+#define OAF_TC_SPAN_HEADER_SIZE 64
+#define OAF_TC_MAX_SMALL_SIZE ((size_t)32 * 1024)
+#define OAF_TC_MAX_SMALL_ALIGNMENT ((size_t)4096)
+#define OAF_TC_MIN_ALIGNMENT 16
+#define OAF_TC_SIZE_CLASS_COUNT 40
+#define OAF_TC_MAX_BATCH 32
+#define OAF_TC_HUGE_CACHE_ENTRIES 16
+#define OAF_TC_HUGE_CACHE_MAX_BYTES ((size_t)64 * 1024 * 1024)
+
+typedef struct OafThreadCacheClass
+{
+    void* head;
+    size_t count;
+} OafThreadCacheClass;
+
+/* One per thread per allocator; blocks move between it and the central lists a batch at a time. */
+typedef struct OafThreadCache
+{
+    struct OafThreadCacheAllocatorState* owner;
+    struct OafThreadCache* next;
+    int attached;
+    OafThreadCacheClass classes[OAF_TC_SIZE_CLASS_COUNT];
+    atomic_size_t allocations;
+    atomic_size_t frees;
+    atomic_size_t bytes_allocated;
+} OafThreadCache;
+
+typedef struct OafCentralFreeList
+{
+    pthread_mutex_t mutex;
+    void* head;
+    size_t count;
+    unsigned char* carve_next;
+    unsigned char* carve_end;
+} OafCentralFreeList;
+
+typedef struct OafThreadCacheAllocatorStats
+{
+    size_t allocations;
+    size_t frees;
+    size_t active_allocations;
+    size_t bytes_allocated;
+    size_t huge_allocations;
+    size_t huge_active_bytes;
+    size_t spans;
+    size_t central_transfers;
+    size_t thread_caches;
+    size_t failed_allocations;
+} OafThreadCacheAllocatorStats;
+
+/* Size-class allocator: per-thread caches over mutex-guarded central lists; blocks above 32 KiB map their own pages. */
+typedef struct OafThreadCacheAllocatorState
+{
+    pthread_key_t cache_key;
+    int key_created;
+    pthread_mutex_t registry_mutex;
+    OafThreadCache* caches;
+    void* spans;
+    void* huge_blocks;
+    void* huge_cache;
+    size_t huge_cache_count;
+    size_t huge_cache_bytes;
+    OafCentralFreeList central[OAF_TC_SIZE_CLASS_COUNT];
+    atomic_size_t span_count;
+    atomic_size_t central_transfers;
+    atomic_size_t huge_allocations;
+    atomic_size_t huge_frees;
+    atomic_size_t huge_active_bytes;
+    atomic_size_t failed_allocations;
+} OafThreadCacheAllocatorState;
+
+int oaf_thread_cache_allocator_init(OafThreadCacheAllocatorState* state);
+void oaf_thread_cache_allocator_destroy(OafThreadCacheAllocatorState* state);
+void oaf_thread_cache_allocator_as_allocator(OafThreadCacheAllocatorState* state, OafAllocator* allocator);
+void oaf_thread_cache_allocator_flush(OafThreadCacheAllocatorState* state);
+void oaf_thread_cache_allocator_stats(OafThreadCacheAllocatorState* state, OafThreadCacheAllocatorStats* out_stats);
+size_t oaf_thread_cache_allocator_usable_size(const void* ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,15 +1,233 @@
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "arena_allocator.h"
 
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+static size_t chunk_header_size(void)
+{
+    return oaf_align_forward(sizeof(OafArenaChunk), 16);
+}
+
+static unsigned char* chunk_data(OafArenaChunk* chunk)
+{
+    return (unsigned char*)chunk + chunk_header_size();
+}
+
+static size_t page_size(void)
+{
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (size_t)size : 4096u;
+}
+
+static OafArenaChunk* chunk_create(size_t capacity)
+{
+    if (capacity > SIZE_MAX - chunk_header_size())
+    {
+        return NULL;
+    }
+
+    OafArenaChunk* chunk = (OafArenaChunk*)malloc(chunk_header_size() + capacity);
+    if (chunk == NULL)
+    {
+        return NULL;
+    }
+
+    chunk->prev = NULL;
+    chunk->capacity = capacity;
+    chunk->committed = capacity;
+    chunk->reserved_size = 0;
+    return chunk;
+}
+
+static OafArenaChunk* chunk_reserve(size_t reserve_size)
+{
+    size_t granule = oaf_align_forward(OAF_ARENA_COMMIT_GRANULE, page_size());
+    size_t mapped = oaf_align_forward(reserve_size < granule ? granule : reserve_size, granule);
+    void* mapping = mmap(NULL, mapped, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (mapping == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    if (mprotect(mapping, granule, PROT_READ | PROT_WRITE) != 0)
+    {
+        munmap(mapping, mapped);
+        return NULL;
+    }
+
+    OafArenaChunk* chunk = (OafArenaChunk*)mapping;
+    chunk->prev = NULL;
+    chunk->capacity = mapped - chunk_header_size();
+    chunk->committed = granule - chunk_header_size();
+    chunk->reserved_size = mapped;
+    return chunk;
+}
+
+static int chunk_commit(OafArenaChunk* chunk, size_t needed)
+{
+    size_t granule = oaf_align_forward(OAF_ARENA_COMMIT_GRANULE, page_size());
+    size_t committed_end = chunk_header_size() + chunk->committed;
+    size_t target = oaf_align_forward(chunk_header_size() + needed, granule);
+
+    if (target > chunk->reserved_size)
+    {
+        target = chunk->reserved_size;
+    }
+
+    if (mprotect((unsigned char*)chunk + committed_end, target - committed_end, PROT_READ | PROT_WRITE) != 0)
+    {
+        return 0;
+    }
+
+    chunk->committed = target - chunk_header_size();
+    return 1;
+}
+
+static void chunk_release(OafArenaChunk* chunk)
+{
+    if (chunk == NULL)
+    {
+        return;
+    }
+
+    if (chunk->reserved_size != 0)
+    {
+        munmap(chunk, chunk->reserved_size);
+        return;
+    }
+
+    free(chunk);
+}
+
+static void arena_enter(OafArenaAllocatorState* state, OafArenaChunk* chunk)
+{
+    state->current = chunk;
+    state->buffer = chunk != NULL ? chunk_data(chunk) : NULL;
+    state->capacity = chunk != NULL ? chunk->capacity : 0;
+    state->committed = chunk != NULL ? chunk->committed : 0;
+}
+
+static void arena_retire(OafArenaAllocatorState* state, OafArenaChunk* chunk)
+{
+    state->chunk_count--;
+    state->total_capacity -= chunk->capacity;
+
+    if (state->spare == NULL || chunk->capacity > state->spare->capacity)
+    {
+        chunk_release(state->spare);
+        chunk->prev = NULL;
+        state->spare = chunk;
+        return;
+    }
+
+    chunk_release(chunk);
+}
+
+static int arena_grow(OafArenaAllocatorState* state, size_t size, size_t alignment)
+{
+    size_t needed = size + (alignment > 16 ? alignment : 0);
+    OafArenaChunk* chunk = NULL;
+
+    if (needed < size)
+    {
+        return 0;
+    }
+
+    if (state->spare != NULL && state->spare->capacity >= needed)
+    {
+        chunk = state->spare;
+        state->spare = NULL;
+    }
+    else
+    {
+        size_t chunk_size = state->next_chunk_size;
+
+        while (chunk_size < needed && chunk_size < OAF_ARENA_MAX_CHUNK_SIZE)
+        {
+            chunk_size *= 2u;
+        }
+
+        if (chunk_size < needed)
+        {
+            chunk_size = needed;
+        }
+
+        chunk = chunk_create(chunk_size);
+        if (chunk == NULL)
+        {
+            return 0;
+        }
+
+        if (chunk_size >= state->next_chunk_size)
+        {
+            state->next_chunk_size = chunk_size < OAF_ARENA_MAX_CHUNK_SIZE / 2u ? chunk_size * 2u : OAF_ARENA_MAX_CHUNK_SIZE;
+        }
+    }
+
+    chunk->prev = state->current;
+    arena_enter(state, chunk);
+    state->offset = 0;
+    state->chunk_count++;
+    state->total_capacity += chunk->capacity;
+    return 1;
+}
+
+static size_t arena_aligned_offset(const OafArenaAllocatorState* state, size_t alignment)
+{
+    uintptr_t base = (uintptr_t)state->buffer;
+    return oaf_align_forward((size_t)(base + state->offset), alignment) - (size_t)base;
+}
+
+static int arena_ensure(OafArenaAllocatorState* state, size_t start, size_t size)
+{
+    if (start <= state->committed && size <= state->committed - start)
+    {
+        return 1;
+    }
+
+    if (state->current == NULL || state->current->reserved_size == 0 || start > state->capacity || size > state->capacity - start)
+    {
+        return 0;
+    }
+
+    if (!chunk_commit(state->current, start + size))
+    {
+        return 0;
+    }
+
+    state->committed = state->current->committed;
+    return 1;
+}
+
 static void* arena_alloc(void* state_ptr, size_t size, size_t alignment)
 {
     OafArenaAllocatorState* state = (OafArenaAllocatorState*)state_ptr;
-    size_t aligned_offset = oaf_align_forward(state->offset, alignment == 0 ? 1 : alignment);
+    size_t align = alignment == 0 ? 1 : alignment;
+    size_t aligned_offset = arena_aligned_offset(state, align);
 
-    if (aligned_offset + size > state->capacity)
+    if (!arena_ensure(state, aligned_offset, size))
     {
-        return NULL;
+        if (!arena_grow(state, size, align))
+        {
+            return NULL;
+        }
+
+        aligned_offset = arena_aligned_offset(state, align);
+        if (!arena_ensure(state, aligned_offset, size))
+        {
+            return NULL;
+        }
     }
 
     void* ptr = state->buffer + aligned_offset;
@@ -26,6 +244,17 @@ static void* arena_realloc(void* state_ptr, void* ptr, size_t old_size, size_t n
         return arena_alloc(state_ptr, new_size, alignment);
     }
 
+    unsigned char* bytes = (unsigned char*)ptr;
+    if (state->buffer != NULL && bytes >= state->buffer && bytes + old_size == state->buffer + state->offset)
+    {
+        size_t start = (size_t)(bytes - state->buffer);
+        if (arena_ensure(state, start, new_size))
+        {
+            state->offset = start + new_size;
+            return ptr;
+        }
+    }
+
     void* replacement = arena_alloc(state_ptr, new_size, alignment);
     if (replacement == NULL)
     {
@@ -42,32 +271,110 @@ static void arena_free(void* state_ptr, void* ptr)
     (void)ptr;
 }
 
-int oaf_arena_allocator_init(OafArenaAllocatorState* state, size_t capacity)
+static void arena_clear(OafArenaAllocatorState* state)
 {
-    state->buffer = (unsigned char*)malloc(capacity == 0 ? 1 : capacity);
-    if (state->buffer == NULL)
+    memset(state, 0, sizeof(*state));
+}
+
+static int arena_start(OafArenaAllocatorState* state, OafArenaChunk* chunk)
+{
+    arena_clear(state);
+    if (chunk == NULL)
     {
-        state->capacity = 0;
-        state->offset = 0;
         return 0;
     }
 
-    state->capacity = capacity == 0 ? 1 : capacity;
-    state->offset = 0;
+    arena_enter(state, chunk);
+    state->chunk_count = 1;
+    state->total_capacity = chunk->capacity;
+    state->next_chunk_size = chunk->capacity < OAF_ARENA_MAX_CHUNK_SIZE / 2u ? chunk->capacity * 2u : OAF_ARENA_MAX_CHUNK_SIZE;
     return 1;
 }
 
+int oaf_arena_allocator_init(OafArenaAllocatorState* state, size_t capacity)
+{
+    return arena_start(state, chunk_create(capacity == 0 ? 1 : capacity));
+}
+
+int oaf_arena_allocator_init_reserved(OafArenaAllocatorState* state, size_t reserve_size)
+{
+    return arena_start(state, chunk_reserve(reserve_size));
+}
+
 void oaf_arena_allocator_destroy(OafArenaAllocatorState* state)
 {
-    free(state->buffer);
-    state->buffer = NULL;
-    state->capacity = 0;
-    state->offset = 0;
+    OafArenaChunk* chunk = state->current;
+
+    while (chunk != NULL)
+    {
+        OafArenaChunk* prev = chunk->prev;
+        chunk_release(chunk);
+        chunk = prev;
+    }
+
+    chunk_release(state->spare);
+    arena_clear(state);
 }
 
 void oaf_arena_allocator_reset(OafArenaAllocatorState* state)
 {
+    OafArenaChunk* keep = state->spare;
+    OafArenaChunk* chunk = state->current;
+
+    while (chunk != NULL)
+    {
+        OafArenaChunk* prev = chunk->prev;
+
+        if (keep == NULL || chunk->capacity > keep->capacity)
+        {
+            chunk_release(keep);
+            keep = chunk;
+        }
+        else
+        {
+            chunk_release(chunk);
+        }
+
+        chunk = prev;
+    }
+
+    state->spare = NULL;
     state->offset = 0;
+    state->chunk_count = keep != NULL ? 1 : 0;
+    state->total_capacity = keep != NULL ? keep->capacity : 0;
+    if (keep != NULL)
+    {
+        keep->prev = NULL;
+    }
+
+    arena_enter(state, keep);
+}
+
+OafArenaCheckpoint oaf_arena_allocator_save(const OafArenaAllocatorState* state)
+{
+    OafArenaCheckpoint checkpoint;
+
+    checkpoint.chunk = state->current;
+    checkpoint.offset = state->offset;
+    return checkpoint;
+}
+
+void oaf_arena_allocator_restore(OafArenaAllocatorState* state, OafArenaCheckpoint checkpoint)
+{
+    if (checkpoint.chunk == NULL)
+    {
+        return;
+    }
+
+    while (state->current != NULL && state->current != checkpoint.chunk)
+    {
+        OafArenaChunk* chunk = state->current;
+        state->current = chunk->prev;
+        arena_retire(state, chunk);
+    }
+
+    arena_enter(state, state->current);
+    state->offset = state->current != NULL ? checkpoint.offset : 0;
 }
 
 void oaf_arena_allocator_as_allocator(OafArenaAllocatorState* state, OafAllocator* allocator)
@@ -44,11 +44,7 @@ static void* default_realloc(void* state_ptr, void* ptr, size_t old_size, size_t
 
     if (state->leak_detector != NULL)
     {
-        if (ptr != NULL)
-        {
-            oaf_leak_detector_track_free(state->leak_detector, ptr);
-        }
-        oaf_leak_detector_track_alloc(state->leak_detector, resized, new_size);
+        oaf_leak_detector_track_realloc(state->leak_detector, ptr, resized, new_size);
     }
 
     return resized;
@@ -0,0 +1,844 @@
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "heap_profiler_allocator.h"
+
+#define OAF_HEAP_NO_SITE UINT32_MAX
+#define OAF_HEAP_SIGNAL_POLL_NS 10000000ull
+/* Kept out of line so the unsampled paths compile to a check and a tail call, with no register saves. */
+#define OAF_HEAP_SLOW_PATH __attribute__((noinline))
+
+static _Thread_local size_t g_sample_countdown;
+static _Thread_local uint64_t g_sample_seed;
+
+/* A signal handler cannot tell profilers apart, so the signal dumper state is owned by one profiler at a time. */
+static _Atomic(OafHeapProfilerState*) g_signal_owner;
+static atomic_int g_dump_requested;
+static struct sigaction g_previous_action;
+
+static uint64_t pointer_hash(const void* ptr)
+{
+    return ((uint64_t)(uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ull;
+}
+
+/* Shifts and an xor rather than a multiply: the filter sits on every free, and a miss only costs the lock. */
+static atomic_uchar* filter_slot(OafHeapProfilerState* state, const void* ptr)
+{
+    uintptr_t address = (uintptr_t)ptr >> 4;
+
+    return &state->sampled_filter[(address ^ (address >> OAF_HEAP_PROFILER_FILTER_BITS)) & ((1u << OAF_HEAP_PROFILER_FILTER_BITS) - 1u)];
+}
+
+/* Writers hold site_mutex. A saturated slot never moves again; it only sends frees through the locked lookup. */
+static void adjust_filter(OafHeapProfilerState* state, const void* ptr, int delta)
+{
+    atomic_uchar* slot = filter_slot(state, ptr);
+    unsigned char value = atomic_load_explicit(slot, memory_order_relaxed);
+
+    if (value != UCHAR_MAX)
+    {
+        atomic_store_explicit(slot, (unsigned char)(value + delta), memory_order_relaxed);
+    }
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* The dumper waits on now_ns deadlines, so its condition variable measures CLOCK_MONOTONIC too. */
+static int init_monotonic_cond(pthread_cond_t* cond)
+{
+    pthread_condattr_t attributes;
+    int ok;
+
+    if (pthread_condattr_init(&attributes) != 0)
+    {
+        return 0;
+    }
+
+    ok = pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC) == 0 && pthread_cond_init(cond, &attributes) == 0;
+    pthread_condattr_destroy(&attributes);
+    return ok;
+}
+
+size_t oaf_heap_profiler_size_class(size_t size)
+{
+    size_t size_class = 0;
+
+    while (size > 0 && size_class + 1u < OAF_HEAP_PROFILER_SIZE_CLASSES)
+    {
+        size >>= 1;
+        size_class++;
+    }
+
+    return size_class;
+}
+
+static void count_block(OafHeapProfilerState* state, size_t size, size_t bytes, size_t count)
+{
+    OafHeapSizeClassStats* stats = &state->classes[oaf_heap_profiler_size_class(size)];
+
+    atomic_fetch_add_explicit(&stats->live_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->live_count, count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->total_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->total_count, count, memory_order_relaxed);
+}
+
+static void uncount_block(OafHeapProfilerState* state, size_t size, size_t bytes, size_t count)
+{
+    OafHeapSizeClassStats* stats = &state->classes[oaf_heap_profiler_size_class(size)];
+
+    atomic_fetch_sub_explicit(&stats->live_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&stats->live_count, count, memory_order_relaxed);
+}
+
+static size_t next_sample_gap(const OafHeapProfilerState* state)
+{
+    uint64_t seed = g_sample_seed != 0 ? g_sample_seed : 0x9E3779B97F4A7C15ull ^ (uint64_t)(uintptr_t)&g_sample_seed;
+
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    g_sample_seed = seed;
+    return 1u + (size_t)(seed % (state->sample_interval * 2u));
+}
+
+static void sample_weight(const OafHeapProfilerState* state, size_t size, size_t* bytes, size_t* count)
+{
+    if (state->sample_interval == 0 || size >= state->sample_interval)
+    {
+        *bytes = size;
+        *count = 1;
+        return;
+    }
+
+    *bytes = state->sample_interval;
+    *count = state->sample_interval / (size == 0 ? 1u : size);
+}
+
+static uint64_t location_hash(OafSourceLocation location)
+{
+    uint64_t hash = 1469598103934665603ull;
+    const char* text = location.file_name;
+
+    while (text != NULL && *text != '\0')
+    {
+        hash = (hash ^ (unsigned char)*text++) * 1099511628211ull;
+    }
+
+    hash ^= ((uint64_t)location.line << 32) | location.column;
+    return hash * 0x9E3779B97F4A7C15ull;
+}
+
+static int same_location(OafSourceLocation left, OafSourceLocation right)
+{
+    if (left.line != right.line || left.column != right.column)
+    {
+        return 0;
+    }
+
+    if (left.file_name == right.file_name)
+    {
+        return 1;
+    }
+
+    return left.file_name != NULL && right.file_name != NULL && strcmp(left.file_name, right.file_name) == 0;
+}
+
+static int reserve_sites(OafHeapProfilerState* state)
+{
+    uint32_t* slots;
+    size_t capacity;
+    size_t index;
+
+    if (state->site_count == state->site_capacity)
+    {
+        size_t site_capacity = state->site_capacity == 0 ? OAF_HEAP_PROFILER_INITIAL_SITES : state->site_capacity * 2u;
+        OafHeapSiteStats* sites = (OafHeapSiteStats*)realloc(state->sites, site_capacity * sizeof(OafHeapSiteStats));
+
+        if (sites == NULL)
+        {
+            return 0;
+        }
+
+        state->sites = sites;
+        state->site_capacity = site_capacity;
+    }
+
+    if ((state->site_count + 1u) * 2u <= state->site_slot_capacity)
+    {
+        return 1;
+    }
+
+    capacity = state->site_slot_capacity == 0 ? OAF_HEAP_PROFILER_INITIAL_SITES * 2u : state->site_slot_capacity * 2u;
+    slots = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    if (slots == NULL)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < state->site_count; index++)
+    {
+        size_t slot = (size_t)(location_hash(state->sites[index].location) >> 32) & (capacity - 1u);
+
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1u) & (capacity - 1u);
+        }
+
+        slots[slot] = (uint32_t)index + 1u;
+    }
+
+    free(state->site_slots);
+    state->site_slots = slots;
+    state->site_slot_capacity = capacity;
+    return 1;
+}
+
+static uint32_t find_site(OafHeapProfilerState* state, OafSourceLocation location)
+{
+    size_t slot;
+
+    if (!reserve_sites(state))
+    {
+        return OAF_HEAP_NO_SITE;
+    }
+
+    slot = (size_t)(location_hash(location) >> 32) & (state->site_slot_capacity - 1u);
+    while (state->site_slots[slot] != 0)
+    {
+        uint32_t site = state->site_slots[slot] - 1u;
+
+        if (same_location(state->sites[site].location, location))
+        {
+            return site;
+        }
+
+        slot = (slot + 1u) & (state->site_slot_capacity - 1u);
+    }
+
+    memset(&state->sites[state->site_count], 0, sizeof(OafHeapSiteStats));
+    state->sites[state->site_count].location = location;
+    state->site_slots[slot] = (uint32_t)state->site_count + 1u;
+    return (uint32_t)state->site_count++;
+}
+
+static int reserve_sampled(OafHeapProfilerState* state)
+{
+    OafHeapSampledBlock* blocks;
+    size_t capacity;
+    size_t index;
+
+    if ((state->sampled_count + 1u) * 2u <= state->sampled_capacity)
+    {
+        return 1;
+    }
+
+    capacity = state->sampled_capacity == 0 ? OAF_HEAP_PROFILER_INITIAL_SITES * 2u : state->sampled_capacity * 2u;
+    blocks = (OafHeapSampledBlock*)calloc(capacity, sizeof(OafHeapSampledBlock));
+    if (blocks == NULL)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < state->sampled_capacity; index++)
+    {
+        size_t slot;
+
+        if (state->sampled[index].ptr == NULL)
+        {
+            continue;
+        }
+
+        slot = (size_t)(pointer_hash(state->sampled[index].ptr) >> 32) & (capacity - 1u);
+        while (blocks[slot].ptr != NULL)
+        {
+            slot = (slot + 1u) & (capacity - 1u);
+        }
+
+        blocks[slot] = state->sampled[index];
+    }
+
+    free(state->sampled);
+    state->sampled = blocks;
+    state->sampled_capacity = capacity;
+    return 1;
+}
+
+/* Caller holds site_mutex. A block that cannot be tracked is left unsampled. */
+static void track_block(OafHeapProfilerState* state, void* ptr, size_t size, uint32_t site)
+{
+    size_t mask;
+    size_t slot;
+    size_t bytes;
+    size_t count;
+
+    if (site == OAF_HEAP_NO_SITE || !reserve_sampled(state))
+    {
+        return;
+    }
+
+    mask = state->sampled_capacity - 1u;
+    slot = (size_t)(pointer_hash(ptr) >> 32) & mask;
+    while (state->sampled[slot].ptr != NULL)
+    {
+        slot = (slot + 1u) & mask;
+    }
+
+    state->sampled[slot].ptr = ptr;
+    state->sampled[slot].size = size;
+    state->sampled[slot].site = site;
+    state->sampled_count++;
+
+    sample_weight(state, size, &bytes, &count);
+    state->sites[site].live_bytes += bytes;
+    state->sites[site].live_count += count;
+    state->sites[site].total_bytes += bytes;
+    state->sites[site].total_count += count;
+    count_block(state, size, bytes, count);
+    adjust_filter(state, ptr, 1);
+}
+
+/* Removes ptr from the side table with backward-shift deletion; returns 0 when ptr was not sampled. */
+static int untrack_block(OafHeapProfilerState* state, void* ptr, OafHeapSampledBlock* out_block)
+{
+    size_t mask;
+    size_t hole;
+    size_t next;
+    size_t bytes;
+    size_t count;
+
+    if (state->sampled_count == 0)
+    {
+        return 0;
+    }
+
+    mask = state->sampled_capacity - 1u;
+    hole = (size_t)(pointer_hash(ptr) >> 32) & mask;
+    while (state->sampled[hole].ptr != ptr)
+    {
+        if (state->sampled[hole].ptr == NULL)
+        {
+            return 0;
+        }
+
+        hole = (hole + 1u) & mask;
+    }
+
+    *out_block = state->sampled[hole];
+    next = (hole + 1u) & mask;
+    while (state->sampled[next].ptr != NULL)
+    {
+        size_t home = (size_t)(pointer_hash(state->sampled[next].ptr) >> 32) & mask;
+
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            state->sampled[hole] = state->sampled[next];
+            hole = next;
+        }
+
+        next = (next + 1u) & mask;
+    }
+
+    state->sampled[hole].ptr = NULL;
+    state->sampled_count--;
+
+    sample_weight(state, out_block->size, &bytes, &count);
+    state->sites[out_block->site].live_bytes -= bytes;
+    state->sites[out_block->site].live_count -= count;
+    uncount_block(state, out_block->size, bytes, count);
+    adjust_filter(state, ptr, -1);
+    return 1;
+}
+
+static void sample_block(OafHeapProfilerState* state, void* ptr, size_t size)
+{
+    OafSourceLocation location = {NULL, 0, 0};
+
+    if (state->site_proc != NULL)
+    {
+        location = state->site_proc(state->site_state);
+    }
+
+    pthread_mutex_lock(&state->site_mutex);
+    track_block(state, ptr, size, find_site(state, location));
+    pthread_mutex_unlock(&state->site_mutex);
+}
+
+/* Caller has seen a nonzero filter slot for ptr; returns 0 when ptr turns out not to be sampled. */
+static int release_block(OafHeapProfilerState* state, void* ptr, OafHeapSampledBlock* out_block)
+{
+    int sampled;
+
+    pthread_mutex_lock(&state->site_mutex);
+    sampled = untrack_block(state, ptr, out_block);
+    pthread_mutex_unlock(&state->site_mutex);
+    return sampled;
+}
+
+/* The filter only has false positives, so a zero slot proves ptr was never sampled without taking the lock. */
+static int maybe_sampled(OafHeapProfilerState* state, const void* ptr)
+{
+    return atomic_load_explicit(filter_slot(state, ptr), memory_order_relaxed) != 0;
+}
+
+/* Slow path of profiler_alloc: the countdown ran out, was never started on this thread, or the interval is 0. */
+OAF_HEAP_SLOW_PATH static void* alloc_counted(OafHeapProfilerState* state, size_t size, size_t alignment)
+{
+    void* ptr;
+
+    if (state->sample_interval != 0)
+    {
+        if (g_sample_countdown == 0)
+        {
+            g_sample_countdown = next_sample_gap(state);
+        }
+
+        if (size < g_sample_countdown)
+        {
+            g_sample_countdown -= size;
+            return state->inner_ops.alloc(state->inner_state, size, alignment);
+        }
+
+        g_sample_countdown = next_sample_gap(state);
+    }
+
+    ptr = state->inner_ops.alloc(state->inner_state, size, alignment);
+    if (ptr != NULL)
+    {
+        sample_block(state, ptr, size);
+    }
+
+    return ptr;
+}
+
+OAF_HEAP_SLOW_PATH static void free_sampled(OafHeapProfilerState* state, void* ptr)
+{
+    OafHeapSampledBlock block;
+
+    release_block(state, ptr, &block);
+    state->inner_ops.free(state->inner_state, ptr);
+}
+
+/* Slow path of profiler_realloc for an unsampled block whose growth used up the countdown: the resized block is
+   sampled, so buffers that start small and grow by realloc are seen like one large allocation. */
+OAF_HEAP_SLOW_PATH static void* realloc_counted(
+    OafHeapProfilerState* state,
+    void* ptr,
+    size_t old_size,
+    size_t new_size,
+    size_t alignment,
+    size_t growth)
+{
+    void* resized;
+
+    if (state->sample_interval != 0)
+    {
+        if (g_sample_countdown == 0)
+        {
+            g_sample_countdown = next_sample_gap(state);
+        }
+
+        if (growth < g_sample_countdown)
+        {
+            g_sample_countdown -= growth;
+            return state->inner_ops.realloc(state->inner_state, ptr, old_size, new_size, alignment);
+        }
+
+        g_sample_countdown = next_sample_gap(state);
+    }
+
+    resized = state->inner_ops.realloc(state->inner_state, ptr, old_size, new_size, alignment);
+    if (resized != NULL)
+    {
+        sample_block(state, resized, new_size);
+    }
+
+    return resized;
+}
+
+/* The unsampled paths only touch the countdown or one filter slot, then tail-call the inner allocator. */
+static void* profiler_alloc(void* state_ptr, size_t size, size_t alignment)
+{
+    OafHeapProfilerState* state = (OafHeapProfilerState*)state_ptr;
+
+    if (size < g_sample_countdown)
+    {
+        g_sample_countdown -= size;
+        return state->inner_ops.alloc(state->inner_state, size, alignment);
+    }
+
+    return alloc_counted(state, size, alignment);
+}
+
+/* A sampled block keeps its site across realloc; growth of an unsampled one is charged against the countdown. */
+static void* profiler_realloc(void* state_ptr, void* ptr, size_t old_size, size_t new_size, size_t alignment)
+{
+    OafHeapProfilerState* state = (OafHeapProfilerState*)state_ptr;
+    OafHeapSampledBlock block;
+    void* resized;
+
+    if (ptr == NULL)
+    {
+        return profiler_alloc(state_ptr, new_size, alignment);
+    }
+
+    if (!maybe_sampled(state, ptr) || !release_block(state, ptr, &block))
+    {
+        size_t growth = new_size > old_size ? new_size - old_size : 0;
+
+        if (growth < g_sample_countdown)
+        {
+            g_sample_countdown -= growth;
+            return state->inner_ops.realloc(state->inner_state, ptr, old_size, new_size, alignment);
+        }
+
+        return realloc_counted(state, ptr, old_size, new_size, alignment, growth);
+    }
+
+    resized = state->inner_ops.realloc(state->inner_state, ptr, old_size, new_size, alignment);
+    pthread_mutex_lock(&state->site_mutex);
+    if (resized != NULL)
+    {
+        track_block(state, resized, new_size, block.site);
+    }
+    else
+    {
+        track_block(state, ptr, block.size, block.site);
+    }
+    pthread_mutex_unlock(&state->site_mutex);
+    return resized;
+}
+
+static void profiler_free(void* state_ptr, void* ptr)
+{
+    OafHeapProfilerState* state = (OafHeapProfilerState*)state_ptr;
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    if (maybe_sampled(state, ptr))
+    {
+        free_sampled(state, ptr);
+        return;
+    }
+
+    state->inner_ops.free(state->inner_state, ptr);
+}
+
+int oaf_heap_profiler_init(OafHeapProfilerState* state, OafAllocator* inner, size_t sample_interval)
+{
+    if (state == NULL || inner == NULL)
+    {
+        return 0;
+    }
+
+    memset(state, 0, sizeof(*state));
+    if (pthread_mutex_init(&state->site_mutex, NULL) != 0)
+    {
+        return 0;
+    }
+
+    if (pthread_mutex_init(&state->dumper_mutex, NULL) != 0)
+    {
+        pthread_mutex_destroy(&state->site_mutex);
+        return 0;
+    }
+
+    if (!init_monotonic_cond(&state->dumper_wake))
+    {
+        pthread_mutex_destroy(&state->dumper_mutex);
+        pthread_mutex_destroy(&state->site_mutex);
+        return 0;
+    }
+
+    /* The hot paths call the inner allocator through this copy, saving a dependent load per operation. */
+    state->inner = inner;
+    state->inner_ops = inner->ops;
+    state->inner_state = inner->state;
+    state->sample_interval = sample_interval;
+    return 1;
+}
+
+void oaf_heap_profiler_destroy(OafHeapProfilerState* state)
+{
+    if (state == NULL || state->inner == NULL)
+    {
+        return;
+    }
+
+    oaf_heap_profiler_stop_dumper(state);
+    free(state->sites);
+    free(state->site_slots);
+    free(state->sampled);
+    pthread_cond_destroy(&state->dumper_wake);
+    pthread_mutex_destroy(&state->dumper_mutex);
+    pthread_mutex_destroy(&state->site_mutex);
+    memset(state, 0, sizeof(*state));
+}
+
+void oaf_heap_profiler_set_site_provider(OafHeapProfilerState* state, OafHeapProfilerSiteProc proc, void* site_state)
+{
+    if (state == NULL)
+    {
+        return;
+    }
+
+    state->site_proc = proc;
+    state->site_state = site_state;
+}
+
+void oaf_heap_profiler_as_allocator(OafHeapProfilerState* state, OafAllocator* allocator)
+{
+    allocator->state = state;
+    allocator->ops.alloc = profiler_alloc;
+    allocator->ops.realloc = profiler_realloc;
+    allocator->ops.free = profiler_free;
+}
+
+int oaf_heap_profiler_snapshot(OafHeapProfilerState* state, OafHeapProfileSnapshot* out_snapshot)
+{
+    size_t index;
+
+    if (state == NULL || out_snapshot == NULL)
+    {
+        return 0;
+    }
+
+    memset(out_snapshot, 0, sizeof(*out_snapshot));
+    for (index = 0; index < OAF_HEAP_PROFILER_SIZE_CLASSES; index++)
+    {
+        out_snapshot->live_bytes[index] = atomic_load_explicit(&state->classes[index].live_bytes, memory_order_relaxed);
+        out_snapshot->live_count[index] = atomic_load_explicit(&state->classes[index].live_count, memory_order_relaxed);
+        out_snapshot->total_bytes[index] = atomic_load_explicit(&state->classes[index].total_bytes, memory_order_relaxed);
+        out_snapshot->total_count[index] = atomic_load_explicit(&state->classes[index].total_count, memory_order_relaxed);
+    }
+
+    out_snapshot->sample_interval = state->sample_interval;
+    pthread_mutex_lock(&state->site_mutex);
+    out_snapshot->sequence = ++state->dump_sequence;
+    if (state->site_count > 0)
+    {
+        out_snapshot->sites = (OafHeapSiteStats*)malloc(state->site_count * sizeof(OafHeapSiteStats));
+        if (out_snapshot->sites == NULL)
+        {
+            pthread_mutex_unlock(&state->site_mutex);
+            return 0;
+        }
+
+        memcpy(out_snapshot->sites, state->sites, state->site_count * sizeof(OafHeapSiteStats));
+        out_snapshot->site_count = state->site_count;
+    }
+    pthread_mutex_unlock(&state->site_mutex);
+    return 1;
+}
+
+void oaf_heap_profile_snapshot_release(OafHeapProfileSnapshot* snapshot)
+{
+    if (snapshot == NULL)
+    {
+        return;
+    }
+
+    free(snapshot->sites);
+    snapshot->sites = NULL;
+    snapshot->site_count = 0;
+}
+
+static int write_snapshot(const OafHeapProfileSnapshot* snapshot, const char* path)
+{
+    char temporary[OAF_HEAP_PROFILER_PATH_CAPACITY + 8];
+    FILE* file;
+    size_t index;
+    int ok = 1;
+
+    if (snprintf(temporary, sizeof(temporary), "%s.tmp", path) >= (int)sizeof(temporary))
+    {
+        return 0;
+    }
+
+    file = fopen(temporary, "w");
+    if (file == NULL)
+    {
+        return 0;
+    }
+
+    for (index = 0; ok && index < snapshot->site_count; index++)
+    {
+        const OafHeapSiteStats* site = &snapshot->sites[index];
+
+        if (site->live_bytes == 0)
+        {
+            continue;
+        }
+
+        ok = fprintf(
+            file,
+            "oaf_heap;%s:%u:%u %zu\n",
+            site->location.file_name != NULL ? site->location.file_name : "<unknown>",
+            (unsigned)site->location.line,
+            (unsigned)site->location.column,
+            site->live_bytes) > 0;
+    }
+
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temporary, path) != 0)
+    {
+        remove(temporary);
+        return 0;
+    }
+
+    return 1;
+}
+
+int oaf_heap_profiler_write_folded(OafHeapProfilerState* state, const char* path)
+{
+    OafHeapProfileSnapshot snapshot;
+    int ok;
+
+    if (state == NULL || path == NULL || !oaf_heap_profiler_snapshot(state, &snapshot))
+    {
+        return 0;
+    }
+
+    ok = write_snapshot(&snapshot, path);
+    oaf_heap_profile_snapshot_release(&snapshot);
+    return ok;
+}
+
+static void dump_signal_handler(int signal_number)
+{
+    (void)signal_number;
+    atomic_store(&g_dump_requested, 1);
+}
+
+static void* dumper_main(void* argument)
+{
+    OafHeapProfilerState* state = (OafHeapProfilerState*)argument;
+    uint64_t next_dump = state->dump_interval_ns != 0 ? now_ns() + state->dump_interval_ns : 0;
+    uint64_t dumps = 0;
+
+    pthread_mutex_lock(&state->dumper_mutex);
+    while (!state->dumper_stop)
+    {
+        uint64_t now = now_ns();
+        uint64_t wait_ns = OAF_HEAP_SIGNAL_POLL_NS;
+        struct timespec deadline;
+
+        if (next_dump != 0)
+        {
+            uint64_t remaining = next_dump > now ? next_dump - now : 0;
+
+            if (state->dump_signal == 0 || remaining < wait_ns)
+            {
+                wait_ns = remaining;
+            }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += (time_t)(((uint64_t)deadline.tv_nsec + wait_ns) / 1000000000ull);
+        deadline.tv_nsec = (long)(((uint64_t)deadline.tv_nsec + wait_ns) % 1000000000ull);
+        pthread_cond_timedwait(&state->dumper_wake, &state->dumper_mutex, &deadline);
+        if (state->dumper_stop)
+        {
+            break;
+        }
+
+        now = now_ns();
+        if ((state->dump_signal != 0 && atomic_exchange(&g_dump_requested, 0)) || (next_dump != 0 && now >= next_dump))
+        {
+            OafHeapProfileSnapshot snapshot;
+            char path[OAF_HEAP_PROFILER_PATH_CAPACITY + 32];
+
+            pthread_mutex_unlock(&state->dumper_mutex);
+            if (oaf_heap_profiler_snapshot(state, &snapshot))
+            {
+                snprintf(path, sizeof(path), "%s.%llu.folded", state->dump_prefix, (unsigned long long)++dumps);
+                write_snapshot(&snapshot, path);
+                oaf_heap_profile_snapshot_release(&snapshot);
+            }
+            pthread_mutex_lock(&state->dumper_mutex);
+            next_dump = state->dump_interval_ns != 0 ? now + state->dump_interval_ns : 0;
+        }
+    }
+    pthread_mutex_unlock(&state->dumper_mutex);
+    return NULL;
+}
+
+int oaf_heap_profiler_start_dumper(OafHeapProfilerState* state, const char* path_prefix, uint64_t interval_ns, int signal_number)
+{
+    if (state == NULL || path_prefix == NULL || state->dumper_running || (interval_ns == 0 && signal_number == 0)
+        || strlen(path_prefix) >= OAF_HEAP_PROFILER_PATH_CAPACITY)
+    {
+        return 0;
+    }
+
+    strcpy(state->dump_prefix, path_prefix);
+    state->dump_interval_ns = interval_ns;
+    state->dump_signal = signal_number;
+    state->dumper_stop = 0;
+    if (signal_number != 0)
+    {
+        OafHeapProfilerState* expected = NULL;
+        struct sigaction action;
+
+        if (!atomic_compare_exchange_strong(&g_signal_owner, &expected, state))
+        {
+            return 0;
+        }
+
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = dump_signal_handler;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        atomic_store(&g_dump_requested, 0);
+        if (sigaction(signal_number, &action, &g_previous_action) != 0)
+        {
+            atomic_store(&g_signal_owner, NULL);
+            return 0;
+        }
+    }
+
+    if (pthread_create(&state->dumper_thread, NULL, dumper_main, state) != 0)
+    {
+        if (signal_number != 0)
+        {
+            sigaction(signal_number, &g_previous_action, NULL);
+            atomic_store(&g_signal_owner, NULL);
+        }
+        return 0;
+    }
+
+    state->dumper_running = 1;
+    return 1;
+}
+
+void oaf_heap_profiler_stop_dumper(OafHeapProfilerState* state)
+{
+    if (state == NULL || !state->dumper_running)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&state->dumper_mutex);
+    state->dumper_stop = 1;
+    pthread_cond_signal(&state->dumper_wake);
+    pthread_mutex_unlock(&state->dumper_mutex);
+    pthread_join(state->dumper_thread, NULL);
+    if (state->dump_signal != 0)
+    {
+        sigaction(state->dump_signal, &g_previous_action, NULL);
+        atomic_store(&g_signal_owner, NULL);
+    }
+
+    state->dumper_running = 0;
+}
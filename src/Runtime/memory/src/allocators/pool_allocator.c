@@ -1,6 +1,29 @@
 #include <stdlib.h>
+#include <string.h>
 #include "pool_allocator.h"
 
+#define OAF_MULTI_POOL_MAGIC 0x4F414650u
+#define OAF_MULTI_POOL_LARGE_CLASS 0xFFFFFFFFu
+
+typedef struct OafMultiPoolSlab
+{
+    uint32_t magic;
+    uint32_t class_index;
+    uint32_t slab_index;
+    uint32_t data_offset;
+    size_t large_size;
+} OafMultiPoolSlab;
+
+_Static_assert(sizeof(OafMultiPoolSlab) <= OAF_MULTI_POOL_SLAB_HEADER_SIZE, "slab header must fit its reserved prefix");
+
+#if defined(__GNUC__) || defined(__clang__)
+#define OAF_MULTI_POOL_NO_TSAN __attribute__((no_sanitize("thread")))
+#else
+#define OAF_MULTI_POOL_NO_TSAN
+#endif
+
+static const size_t g_default_class_sizes[] = {16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024};
+
 static void* pool_alloc(void* state_ptr, size_t size, size_t alignment)
 {
     (void)alignment;
@@ -103,3 +126,324 @@ void oaf_pool_allocator_as_allocator(OafPoolAllocatorState* state, OafAllocator*
     allocator->ops.realloc = pool_realloc;
     allocator->ops.free = pool_free;
 }
+
+static OafMultiPoolSlab* multi_pool_slab_of(const void* ptr)
+{
+    return (OafMultiPoolSlab*)((uintptr_t)ptr & ~(uintptr_t)(OAF_MULTI_POOL_SLAB_SIZE - 1u));
+}
+
+static _Atomic uint32_t* multi_pool_link(void* block)
+{
+    return (_Atomic uint32_t*)block;
+}
+
+/* A popper may read the link of a block another thread already took; the tagged CAS then rejects it. */
+OAF_MULTI_POOL_NO_TSAN static uint32_t multi_pool_read_link(void* block)
+{
+    return atomic_load_explicit(multi_pool_link(block), memory_order_relaxed);
+}
+
+static unsigned char* multi_pool_block_at(OafMultiPoolClass* pool_class, uint32_t index)
+{
+    size_t position = (size_t)index - 1u;
+    unsigned char* slab = atomic_load_explicit(&pool_class->slabs[position / pool_class->blocks_per_slab], memory_order_acquire);
+
+    return slab + OAF_MULTI_POOL_SLAB_HEADER_SIZE + (position % pool_class->blocks_per_slab) * pool_class->block_size;
+}
+
+static uint32_t multi_pool_block_index(OafMultiPoolClass* pool_class, const OafMultiPoolSlab* slab, const void* block)
+{
+    size_t offset = (size_t)((const unsigned char*)block - (const unsigned char*)slab) - OAF_MULTI_POOL_SLAB_HEADER_SIZE;
+
+    return (uint32_t)((size_t)slab->slab_index * pool_class->blocks_per_slab + offset / pool_class->block_size + 1u);
+}
+
+static void multi_pool_push_chain(OafMultiPoolClass* pool_class, uint32_t first, void* last)
+{
+    uint64_t old_head = atomic_load_explicit(&pool_class->head, memory_order_relaxed);
+    uint64_t new_head;
+
+    do
+    {
+        atomic_store_explicit(multi_pool_link(last), (uint32_t)old_head, memory_order_relaxed);
+        new_head = (((old_head >> 32) + 1u) << 32) | first;
+    } while (!atomic_compare_exchange_weak_explicit(&pool_class->head, &old_head, new_head, memory_order_release, memory_order_relaxed));
+}
+
+static void* multi_pool_pop(OafMultiPoolClass* pool_class)
+{
+    uint64_t old_head = atomic_load_explicit(&pool_class->head, memory_order_acquire);
+
+    while ((uint32_t)old_head != 0)
+    {
+        unsigned char* block = multi_pool_block_at(pool_class, (uint32_t)old_head);
+        uint32_t next = multi_pool_read_link(block);
+        uint64_t new_head = (((old_head >> 32) + 1u) << 32) | next;
+
+        if (atomic_compare_exchange_weak_explicit(&pool_class->head, &old_head, new_head, memory_order_acquire, memory_order_acquire))
+        {
+            return block;
+        }
+    }
+
+    return NULL;
+}
+
+static void* multi_pool_grow(OafMultiPoolClass* pool_class, uint32_t class_index)
+{
+    pthread_mutex_lock(&pool_class->grow_mutex);
+
+    void* block = multi_pool_pop(pool_class);
+    size_t slab_index = atomic_load_explicit(&pool_class->slab_count, memory_order_relaxed);
+    if (block != NULL || slab_index >= OAF_MULTI_POOL_MAX_SLABS)
+    {
+        pthread_mutex_unlock(&pool_class->grow_mutex);
+        return block;
+    }
+
+    unsigned char* slab = (unsigned char*)aligned_alloc(OAF_MULTI_POOL_SLAB_SIZE, OAF_MULTI_POOL_SLAB_SIZE);
+    if (slab == NULL)
+    {
+        pthread_mutex_unlock(&pool_class->grow_mutex);
+        return NULL;
+    }
+
+    OafMultiPoolSlab* header = (OafMultiPoolSlab*)slab;
+    header->magic = OAF_MULTI_POOL_MAGIC;
+    header->class_index = class_index;
+    header->slab_index = (uint32_t)slab_index;
+    header->data_offset = OAF_MULTI_POOL_SLAB_HEADER_SIZE;
+    header->large_size = 0;
+    atomic_store_explicit(&pool_class->slabs[slab_index], slab, memory_order_release);
+    atomic_store_explicit(&pool_class->slab_count, slab_index + 1u, memory_order_relaxed);
+
+    unsigned char* data = slab + OAF_MULTI_POOL_SLAB_HEADER_SIZE;
+    uint32_t first = multi_pool_block_index(pool_class, header, data);
+    size_t count = pool_class->blocks_per_slab;
+    for (size_t i = 1; i + 1 < count; i++)
+    {
+        atomic_store_explicit(multi_pool_link(data + i * pool_class->block_size), first + (uint32_t)i + 1u, memory_order_relaxed);
+    }
+
+    if (count > 1)
+    {
+        multi_pool_push_chain(pool_class, first + 1u, data + (count - 1u) * pool_class->block_size);
+    }
+
+    pthread_mutex_unlock(&pool_class->grow_mutex);
+    return data;
+}
+
+/* Large blocks start on a slab boundary so multi_pool_slab_of finds their header; posix_memalign, unlike
+   aligned_alloc, takes a size that is not a multiple of the alignment, so only the header is added. */
+static void* multi_pool_alloc_large(OafMultiPoolAllocatorState* state, size_t size, size_t alignment)
+{
+    size_t data_offset = alignment > OAF_MULTI_POOL_SLAB_HEADER_SIZE ? alignment : OAF_MULTI_POOL_SLAB_HEADER_SIZE;
+    void* base;
+
+    if (alignment > OAF_MULTI_POOL_MAX_ALIGNMENT || size > SIZE_MAX - data_offset
+        || posix_memalign(&base, OAF_MULTI_POOL_SLAB_SIZE, data_offset + size) != 0)
+    {
+        return NULL;
+    }
+
+    OafMultiPoolSlab* header = (OafMultiPoolSlab*)base;
+    header->magic = OAF_MULTI_POOL_MAGIC;
+    header->class_index = OAF_MULTI_POOL_LARGE_CLASS;
+    header->slab_index = 0;
+    header->data_offset = (uint32_t)data_offset;
+    header->large_size = size;
+    atomic_fetch_add_explicit(&state->large_allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&state->large_active, 1, memory_order_relaxed);
+    return (unsigned char*)base + data_offset;
+}
+
+static void* multi_pool_alloc(void* state_ptr, size_t size, size_t alignment)
+{
+    OafMultiPoolAllocatorState* state = (OafMultiPoolAllocatorState*)state_ptr;
+    size_t requested = size == 0 ? 1 : size;
+    size_t align = alignment == 0 ? 1 : alignment;
+
+    if (align <= OAF_MULTI_POOL_SLAB_HEADER_SIZE)
+    {
+        for (size_t i = 0; i < state->class_count; i++)
+        {
+            OafMultiPoolClass* pool_class = &state->classes[i];
+            if (pool_class->block_size < requested || (pool_class->block_size & (align - 1u)) != 0)
+            {
+                continue;
+            }
+
+            void* block = multi_pool_pop(pool_class);
+            if (block == NULL)
+            {
+                block = multi_pool_grow(pool_class, (uint32_t)i);
+            }
+
+            if (block != NULL)
+            {
+                atomic_fetch_add_explicit(&pool_class->active_blocks, 1, memory_order_relaxed);
+            }
+
+            return block;
+        }
+    }
+
+    return multi_pool_alloc_large(state, requested, align);
+}
+
+static size_t multi_pool_usable_size(OafMultiPoolAllocatorState* state, const void* ptr)
+{
+    const OafMultiPoolSlab* slab = multi_pool_slab_of(ptr);
+
+    return slab->class_index == OAF_MULTI_POOL_LARGE_CLASS ? slab->large_size : state->classes[slab->class_index].block_size;
+}
+
+static void multi_pool_free(void* state_ptr, void* ptr)
+{
+    OafMultiPoolAllocatorState* state = (OafMultiPoolAllocatorState*)state_ptr;
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    OafMultiPoolSlab* slab = multi_pool_slab_of(ptr);
+    if (slab->class_index == OAF_MULTI_POOL_LARGE_CLASS)
+    {
+        atomic_fetch_sub_explicit(&state->large_active, 1, memory_order_relaxed);
+        free(slab);
+        return;
+    }
+
+    OafMultiPoolClass* pool_class = &state->classes[slab->class_index];
+    multi_pool_push_chain(pool_class, multi_pool_block_index(pool_class, slab, ptr), ptr);
+    atomic_fetch_sub_explicit(&pool_class->active_blocks, 1, memory_order_relaxed);
+}
+
+static void* multi_pool_realloc(void* state_ptr, void* ptr, size_t old_size, size_t new_size, size_t alignment)
+{
+    OafMultiPoolAllocatorState* state = (OafMultiPoolAllocatorState*)state_ptr;
+
+    if (ptr == NULL)
+    {
+        return multi_pool_alloc(state_ptr, new_size, alignment);
+    }
+
+    size_t usable = multi_pool_usable_size(state, ptr);
+    if (new_size <= usable && ((uintptr_t)ptr & ((alignment == 0 ? 1 : alignment) - 1u)) == 0)
+    {
+        return ptr;
+    }
+
+    void* replacement = multi_pool_alloc(state_ptr, new_size, alignment);
+    if (replacement == NULL)
+    {
+        return NULL;
+    }
+
+    size_t copy = old_size < usable ? old_size : usable;
+    memcpy(replacement, ptr, copy < new_size ? copy : new_size);
+    multi_pool_free(state_ptr, ptr);
+    return replacement;
+}
+
+static void multi_pool_release_classes(OafMultiPoolAllocatorState* state)
+{
+    for (size_t i = 0; i < state->class_count; i++)
+    {
+        OafMultiPoolClass* pool_class = &state->classes[i];
+        size_t slab_count = atomic_load_explicit(&pool_class->slab_count, memory_order_relaxed);
+
+        for (size_t slab = 0; slab < slab_count; slab++)
+        {
+            free(atomic_load_explicit(&pool_class->slabs[slab], memory_order_relaxed));
+        }
+
+        free((void*)pool_class->slabs);
+        pthread_mutex_destroy(&pool_class->grow_mutex);
+    }
+
+    state->class_count = 0;
+}
+
+int oaf_multi_pool_allocator_init(OafMultiPoolAllocatorState* state, const size_t* class_sizes, size_t class_count)
+{
+    if (state == NULL)
+    {
+        return 0;
+    }
+
+    memset(state, 0, sizeof(*state));
+    if (class_sizes == NULL)
+    {
+        class_sizes = g_default_class_sizes;
+        class_count = sizeof(g_default_class_sizes) / sizeof(g_default_class_sizes[0]);
+    }
+
+    if (class_count == 0 || class_count > OAF_MULTI_POOL_MAX_CLASSES)
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < class_count; i++)
+    {
+        size_t block_size = class_sizes[i];
+        if (block_size < sizeof(uint32_t) || block_size % sizeof(uint32_t) != 0 ||
+            block_size > OAF_MULTI_POOL_SLAB_SIZE - OAF_MULTI_POOL_SLAB_HEADER_SIZE || (i > 0 && block_size <= class_sizes[i - 1]))
+        {
+            multi_pool_release_classes(state);
+            return 0;
+        }
+
+        OafMultiPoolClass* pool_class = &state->classes[i];
+        pool_class->slabs = (unsigned char* _Atomic*)calloc(OAF_MULTI_POOL_MAX_SLABS, sizeof(*pool_class->slabs));
+        if (pool_class->slabs == NULL || pthread_mutex_init(&pool_class->grow_mutex, NULL) != 0)
+        {
+            free((void*)pool_class->slabs);
+            multi_pool_release_classes(state);
+            return 0;
+        }
+
+        pool_class->block_size = block_size;
+        pool_class->blocks_per_slab = (OAF_MULTI_POOL_SLAB_SIZE - OAF_MULTI_POOL_SLAB_HEADER_SIZE) / block_size;
+        atomic_init(&pool_class->head, 0);
+        atomic_init(&pool_class->slab_count, 0);
+        atomic_init(&pool_class->active_blocks, 0);
+        state->class_count = i + 1u;
+    }
+
+    atomic_init(&state->large_allocations, 0);
+    atomic_init(&state->large_active, 0);
+    return 1;
+}
+
+void oaf_multi_pool_allocator_destroy(OafMultiPoolAllocatorState* state)
+{
+    if (state == NULL)
+    {
+        return;
+    }
+
+    multi_pool_release_classes(state);
+}
+
+void oaf_multi_pool_allocator_as_allocator(OafMultiPoolAllocatorState* state, OafAllocator* allocator)
+{
+    allocator->state = state;
+    allocator->ops.alloc = multi_pool_alloc;
+    allocator->ops.realloc = multi_pool_realloc;
+    allocator->ops.free = multi_pool_free;
+}
+
+size_t oaf_multi_pool_allocator_active_blocks(OafMultiPoolAllocatorState* state)
+{
+    size_t active = atomic_load_explicit(&state->large_active, memory_order_relaxed);
+
+    for (size_t i = 0; i < state->class_count; i++)
+    {
+        active += atomic_load_explicit(&state->classes[i].active_blocks, memory_order_relaxed);
+    }
+
+    return active;
+}
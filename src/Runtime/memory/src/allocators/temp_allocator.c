@@ -1,70 +1,52 @@
+#include <pthread.h>
 #include <stdlib.h>
 #include "temp_allocator.h"
 
-static void* temp_alloc(void* state_ptr, size_t size, size_t alignment)
+typedef struct OafTempMark
 {
-    OafTempAllocatorState* state = (OafTempAllocatorState*)state_ptr;
-    size_t aligned_offset = oaf_align_forward(state->offset, alignment == 0 ? 1 : alignment);
+    struct OafTempMark* prev;
+    OafArenaCheckpoint checkpoint;
+    size_t index;
+} OafTempMark;
 
-    if (aligned_offset + size > state->capacity)
-    {
-        return NULL;
-    }
-
-    void* ptr = state->buffer + aligned_offset;
-    state->offset = aligned_offset + size;
-    return ptr;
-}
-
-static void* temp_realloc(void* state_ptr, void* ptr, size_t old_size, size_t new_size, size_t alignment)
-{
-    (void)ptr;
-    (void)old_size;
-    return temp_alloc(state_ptr, new_size, alignment);
-}
-
-static void temp_free(void* state_ptr, void* ptr)
-{
-    (void)state_ptr;
-    (void)ptr;
-}
+static pthread_once_t g_thread_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_thread_key;
+static int g_thread_key_created = 0;
+static _Thread_local OafTempAllocatorState* g_bound_state = NULL;
+static _Thread_local OafTempAllocatorState* g_owned_state = NULL;
 
 int oaf_temp_allocator_init(OafTempAllocatorState* state, size_t capacity)
 {
-    state->buffer = (unsigned char*)malloc(capacity == 0 ? 1 : capacity);
-    if (state->buffer == NULL)
-    {
-        state->capacity = 0;
-        state->offset = 0;
-        state->mark_count = 0;
-        return 0;
-    }
-
-    state->capacity = capacity == 0 ? 1 : capacity;
-    state->offset = 0;
+    state->top_mark = NULL;
     state->mark_count = 0;
-    return 1;
+    return oaf_arena_allocator_init(&state->arena, capacity);
 }
 
 void oaf_temp_allocator_destroy(OafTempAllocatorState* state)
 {
-    free(state->buffer);
-    state->buffer = NULL;
-    state->capacity = 0;
-    state->offset = 0;
+    oaf_arena_allocator_destroy(&state->arena);
+    state->top_mark = NULL;
     state->mark_count = 0;
 }
 
 size_t oaf_temp_allocator_mark(OafTempAllocatorState* state)
 {
-    if (state->mark_count >= OAF_TEMP_MAX_MARKS)
+    OafAllocator allocator;
+    OafArenaCheckpoint checkpoint = oaf_arena_allocator_save(&state->arena);
+
+    oaf_arena_allocator_as_allocator(&state->arena, &allocator);
+    OafTempMark* mark = (OafTempMark*)oaf_allocator_alloc(&allocator, sizeof(OafTempMark), _Alignof(OafTempMark));
+    if (mark == NULL)
     {
         return (size_t)-1;
     }
 
-    state->marks[state->mark_count] = state->offset;
+    mark->prev = state->top_mark;
+    mark->checkpoint = checkpoint;
+    mark->index = state->mark_count;
+    state->top_mark = mark;
     state->mark_count++;
-    return state->mark_count - 1;
+    return mark->index;
 }
 
 int oaf_temp_allocator_reset_to_mark(OafTempAllocatorState* state, size_t mark_index)
@@ -74,21 +56,96 @@ int oaf_temp_allocator_reset_to_mark(OafTempAllocatorState* state, size_t mark_i
         return 0;
     }
 
-    state->offset = state->marks[mark_index];
+    OafTempMark* mark = state->top_mark;
+    while (mark->index != mark_index)
+    {
+        mark = mark->prev;
+    }
+
+    state->top_mark = mark->prev;
     state->mark_count = mark_index;
+    oaf_arena_allocator_restore(&state->arena, mark->checkpoint);
     return 1;
 }
 
 void oaf_temp_allocator_clear(OafTempAllocatorState* state)
 {
-    state->offset = 0;
+    oaf_arena_allocator_reset(&state->arena);
+    state->top_mark = NULL;
     state->mark_count = 0;
 }
 
 void oaf_temp_allocator_as_allocator(OafTempAllocatorState* state, OafAllocator* allocator)
 {
-    allocator->state = state;
-    allocator->ops.alloc = temp_alloc;
-    allocator->ops.realloc = temp_realloc;
-    allocator->ops.free = temp_free;
+    oaf_arena_allocator_as_allocator(&state->arena, allocator);
+}
+
+static void thread_state_destroy(void* value)
+{
+    OafTempAllocatorState* state = (OafTempAllocatorState*)value;
+
+    oaf_temp_allocator_destroy(state);
+    free(state);
+}
+
+static void thread_key_create(void)
+{
+    g_thread_key_created = pthread_key_create(&g_thread_key, thread_state_destroy) == 0;
+}
+
+OafTempAllocatorState* oaf_temp_allocator_thread_local(void)
+{
+    if (g_bound_state != NULL)
+    {
+        return g_bound_state;
+    }
+
+    if (g_owned_state != NULL)
+    {
+        return g_owned_state;
+    }
+
+    pthread_once(&g_thread_key_once, thread_key_create);
+    if (!g_thread_key_created)
+    {
+        return NULL;
+    }
+
+    OafTempAllocatorState* state = (OafTempAllocatorState*)malloc(sizeof(OafTempAllocatorState));
+    if (state == NULL)
+    {
+        return NULL;
+    }
+
+    if (!oaf_temp_allocator_init(state, OAF_TEMP_THREAD_DEFAULT_CAPACITY) || pthread_setspecific(g_thread_key, state) != 0)
+    {
+        oaf_temp_allocator_destroy(state);
+        free(state);
+        return NULL;
+    }
+
+    g_owned_state = state;
+    return state;
+}
+
+void oaf_temp_allocator_bind_thread(OafTempAllocatorState* state)
+{
+    g_bound_state = state;
+}
+
+OafTempAllocatorState* oaf_temp_allocator_bound_thread(void)
+{
+    return g_bound_state;
+}
+
+void oaf_temp_allocator_thread_release(void)
+{
+    if (g_owned_state == NULL)
+    {
+        return;
+    }
+
+    pthread_setspecific(g_thread_key, NULL);
+    thread_state_destroy(g_owned_state);
+    g_owned_state = NULL;
 }
@@ -0,0 +1,663 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "thread_cache_allocator.h"
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#define OAF_TC_SPAN_MAGIC 0x4F414654u
+#define OAF_TC_HUGE_CLASS 0xFFFFFFFFu
+#define OAF_TC_PAGE_SIZE ((size_t)4096)
+
+typedef struct OafTcSpanHeader
+{
+    uint32_t magic;
+    uint32_t size_class;
+    size_t block_size;
+    size_t mapped_size;
+    struct OafTcSpanHeader* next;
+    struct OafTcSpanHeader* prev;
+    OafThreadCacheAllocatorState* owner;
+} OafTcSpanHeader;
+
+_Static_assert(sizeof(OafTcSpanHeader) <= OAF_TC_SPAN_HEADER_SIZE, "span header must fit its reserved prefix");
+
+static size_t class_size(size_t size_class)
+{
+    size_t group;
+    size_t step;
+
+    if (size_class < 8)
+    {
+        return (size_class + 1u) * 16u;
+    }
+
+    group = 7u + (size_class - 8u) / 4u;
+    step = (size_class - 8u) % 4u;
+    return ((size_t)1 << group) + (step + 1u) * ((size_t)1 << (group - 2u));
+}
+
+static size_t size_to_class(size_t size)
+{
+    size_t top = 7;
+
+    if (size <= 128)
+    {
+        return size == 0 ? 0 : (size + 15u) / 16u - 1u;
+    }
+
+    while (((size_t)1 << (top + 1u)) < size)
+    {
+        top++;
+    }
+
+    return 8u + (top - 7u) * 4u + (((size - 1u) - ((size_t)1 << top)) >> (top - 2u));
+}
+
+static size_t block_alignment(size_t block_size)
+{
+    size_t low_bit = block_size & (~block_size + 1u);
+
+    return low_bit < OAF_TC_MAX_SMALL_ALIGNMENT ? low_bit : OAF_TC_MAX_SMALL_ALIGNMENT;
+}
+
+static size_t batch_size(size_t size_class)
+{
+    size_t batch = ((size_t)64 * 1024) / class_size(size_class);
+
+    if (batch < 2)
+    {
+        return 2;
+    }
+
+    return batch > OAF_TC_MAX_BATCH ? OAF_TC_MAX_BATCH : batch;
+}
+
+static int pick_class(size_t size, size_t alignment, size_t* out_class)
+{
+    size_t size_class;
+
+    if (size > OAF_TC_MAX_SMALL_SIZE || alignment > OAF_TC_MAX_SMALL_ALIGNMENT)
+    {
+        return 0;
+    }
+
+    size_class = size_to_class(size < alignment ? alignment : size);
+    while (size_class < OAF_TC_SIZE_CLASS_COUNT && block_alignment(class_size(size_class)) < alignment)
+    {
+        size_class++;
+    }
+
+    if (size_class >= OAF_TC_SIZE_CLASS_COUNT)
+    {
+        return 0;
+    }
+
+    *out_class = size_class;
+    return 1;
+}
+
+static OafTcSpanHeader* span_of(const void* ptr)
+{
+    return (OafTcSpanHeader*)((uintptr_t)ptr & ~(uintptr_t)(OAF_TC_SPAN_SIZE - 1u));
+}
+
+static void* map_aligned(size_t size)
+{
+    size_t padded = size + OAF_TC_SPAN_SIZE;
+    unsigned char* raw = (unsigned char*)mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (raw == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    unsigned char* base = (unsigned char*)oaf_align_forward((size_t)(uintptr_t)raw, OAF_TC_SPAN_SIZE);
+    size_t head = (size_t)(base - raw);
+    size_t tail = padded - head - size;
+
+    if (head > 0)
+    {
+        munmap(raw, head);
+    }
+
+    if (tail > 0)
+    {
+        munmap(base + size, tail);
+    }
+
+    return base;
+}
+
+static void bump(atomic_size_t* counter, size_t amount)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+static int grow_central(OafThreadCacheAllocatorState* state, size_t size_class)
+{
+    OafCentralFreeList* central = &state->central[size_class];
+    size_t block_size = class_size(size_class);
+    OafTcSpanHeader* span = (OafTcSpanHeader*)map_aligned(OAF_TC_SPAN_SIZE);
+
+    if (span == NULL)
+    {
+        return 0;
+    }
+
+    span->magic = OAF_TC_SPAN_MAGIC;
+    span->size_class = (uint32_t)size_class;
+    span->block_size = block_size;
+    span->mapped_size = OAF_TC_SPAN_SIZE;
+    span->prev = NULL;
+    span->owner = state;
+
+    pthread_mutex_lock(&state->registry_mutex);
+    span->next = (OafTcSpanHeader*)state->spans;
+    state->spans = span;
+    pthread_mutex_unlock(&state->registry_mutex);
+
+    central->carve_next = (unsigned char*)span
+        + oaf_align_forward(OAF_TC_SPAN_HEADER_SIZE, block_alignment(block_size));
+    central->carve_end = (unsigned char*)span + OAF_TC_SPAN_SIZE;
+    atomic_fetch_add_explicit(&state->span_count, 1u, memory_order_relaxed);
+    return 1;
+}
+
+static int refill_cache(OafThreadCacheAllocatorState* state, OafThreadCacheClass* cached, size_t size_class)
+{
+    OafCentralFreeList* central = &state->central[size_class];
+    size_t block_size = class_size(size_class);
+    size_t wanted = batch_size(size_class);
+    size_t moved = 0;
+
+    pthread_mutex_lock(&central->mutex);
+    while (moved < wanted && central->head != NULL)
+    {
+        void* block = central->head;
+        central->head = *(void**)block;
+        central->count--;
+        *(void**)block = cached->head;
+        cached->head = block;
+        moved++;
+    }
+
+    while (moved < wanted)
+    {
+        if (central->carve_next == NULL || central->carve_next + block_size > central->carve_end)
+        {
+            if (moved > 0 || !grow_central(state, size_class))
+            {
+                break;
+            }
+        }
+
+        *(void**)central->carve_next = cached->head;
+        cached->head = central->carve_next;
+        central->carve_next += block_size;
+        moved++;
+    }
+    pthread_mutex_unlock(&central->mutex);
+
+    cached->count += moved;
+    atomic_fetch_add_explicit(&state->central_transfers, 1u, memory_order_relaxed);
+    return moved > 0;
+}
+
+static void release_to_central(OafThreadCacheAllocatorState* state, OafThreadCacheClass* cached, size_t size_class, size_t count)
+{
+    OafCentralFreeList* central = &state->central[size_class];
+    void* first = cached->head;
+    void* last = first;
+    size_t moved = 1;
+
+    if (count == 0 || first == NULL)
+    {
+        return;
+    }
+
+    while (moved < count && *(void**)last != NULL)
+    {
+        last = *(void**)last;
+        moved++;
+    }
+
+    cached->head = *(void**)last;
+    cached->count -= moved;
+
+    pthread_mutex_lock(&central->mutex);
+    *(void**)last = central->head;
+    central->head = first;
+    central->count += moved;
+    pthread_mutex_unlock(&central->mutex);
+    atomic_fetch_add_explicit(&state->central_transfers, 1u, memory_order_relaxed);
+}
+
+static void flush_cache(OafThreadCache* cache)
+{
+    for (size_t size_class = 0; size_class < OAF_TC_SIZE_CLASS_COUNT; size_class++)
+    {
+        release_to_central(cache->owner, &cache->classes[size_class], size_class, cache->classes[size_class].count);
+    }
+}
+
+static void detach_cache(void* value)
+{
+    OafThreadCache* cache = (OafThreadCache*)value;
+
+    if (cache == NULL)
+    {
+        return;
+    }
+
+    flush_cache(cache);
+    pthread_mutex_lock(&cache->owner->registry_mutex);
+    cache->attached = 0;
+    pthread_mutex_unlock(&cache->owner->registry_mutex);
+}
+
+static OafThreadCache* current_cache(OafThreadCacheAllocatorState* state)
+{
+    OafThreadCache* cache = (OafThreadCache*)pthread_getspecific(state->cache_key);
+
+    if (cache != NULL)
+    {
+        return cache;
+    }
+
+    pthread_mutex_lock(&state->registry_mutex);
+    for (cache = state->caches; cache != NULL; cache = cache->next)
+    {
+        if (!cache->attached)
+        {
+            break;
+        }
+    }
+
+    if (cache == NULL)
+    {
+        cache = (OafThreadCache*)calloc(1, sizeof(OafThreadCache));
+        if (cache != NULL)
+        {
+            cache->owner = state;
+            atomic_init(&cache->allocations, 0u);
+            atomic_init(&cache->frees, 0u);
+            atomic_init(&cache->bytes_allocated, 0u);
+            cache->next = state->caches;
+            state->caches = cache;
+        }
+    }
+
+    if (cache != NULL)
+    {
+        cache->attached = 1;
+    }
+    pthread_mutex_unlock(&state->registry_mutex);
+
+    if (cache != NULL && pthread_setspecific(state->cache_key, cache) != 0)
+    {
+        detach_cache(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+static void* huge_alloc(OafThreadCacheAllocatorState* state, size_t size, size_t alignment)
+{
+    size_t offset = oaf_align_forward(OAF_TC_SPAN_HEADER_SIZE, alignment);
+
+    if (offset >= OAF_TC_SPAN_SIZE || size > SIZE_MAX - offset - OAF_TC_SPAN_SIZE)
+    {
+        return NULL;
+    }
+
+    size_t needed = oaf_align_forward(offset + size, OAF_TC_PAGE_SIZE);
+    OafTcSpanHeader* span = NULL;
+    OafTcSpanHeader** link;
+
+    pthread_mutex_lock(&state->registry_mutex);
+    for (link = (OafTcSpanHeader**)&state->huge_cache; *link != NULL; link = &(*link)->next)
+    {
+        if ((*link)->mapped_size >= needed && (*link)->mapped_size / 2u <= needed)
+        {
+            span = *link;
+            *link = span->next;
+            state->huge_cache_count--;
+            state->huge_cache_bytes -= span->mapped_size;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&state->registry_mutex);
+
+    if (span == NULL)
+    {
+        span = (OafTcSpanHeader*)map_aligned(needed);
+        if (span == NULL)
+        {
+            return NULL;
+        }
+
+        span->mapped_size = needed;
+    }
+
+    span->magic = OAF_TC_SPAN_MAGIC;
+    span->size_class = OAF_TC_HUGE_CLASS;
+    span->block_size = span->mapped_size - offset;
+    span->owner = state;
+    span->prev = NULL;
+
+    pthread_mutex_lock(&state->registry_mutex);
+    span->next = (OafTcSpanHeader*)state->huge_blocks;
+    if (span->next != NULL)
+    {
+        span->next->prev = span;
+    }
+    state->huge_blocks = span;
+    pthread_mutex_unlock(&state->registry_mutex);
+
+    atomic_fetch_add_explicit(&state->huge_allocations, 1u, memory_order_relaxed);
+    atomic_fetch_add_explicit(&state->huge_active_bytes, span->mapped_size, memory_order_relaxed);
+    return (unsigned char*)span + offset;
+}
+
+static void huge_free(OafThreadCacheAllocatorState* state, OafTcSpanHeader* span)
+{
+    pthread_mutex_lock(&state->registry_mutex);
+    if (span->prev != NULL)
+    {
+        span->prev->next = span->next;
+    }
+    else
+    {
+        state->huge_blocks = span->next;
+    }
+
+    if (span->next != NULL)
+    {
+        span->next->prev = span->prev;
+    }
+
+    atomic_fetch_add_explicit(&state->huge_frees, 1u, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&state->huge_active_bytes, span->mapped_size, memory_order_relaxed);
+    if (state->huge_cache_count < OAF_TC_HUGE_CACHE_ENTRIES
+        && state->huge_cache_bytes + span->mapped_size <= OAF_TC_HUGE_CACHE_MAX_BYTES)
+    {
+        span->next = (OafTcSpanHeader*)state->huge_cache;
+        state->huge_cache = span;
+        state->huge_cache_count++;
+        state->huge_cache_bytes += span->mapped_size;
+        span = NULL;
+    }
+    pthread_mutex_unlock(&state->registry_mutex);
+
+    if (span != NULL)
+    {
+        munmap(span, span->mapped_size);
+    }
+}
+
+static void* tc_alloc(void* state_ptr, size_t size, size_t alignment)
+{
+    OafThreadCacheAllocatorState* state = (OafThreadCacheAllocatorState*)state_ptr;
+    size_t size_class;
+
+    if (alignment < OAF_TC_MIN_ALIGNMENT)
+    {
+        alignment = OAF_TC_MIN_ALIGNMENT;
+    }
+
+    if ((alignment & (alignment - 1u)) != 0)
+    {
+        atomic_fetch_add_explicit(&state->failed_allocations, 1u, memory_order_relaxed);
+        return NULL;
+    }
+
+    if (!pick_class(size, alignment, &size_class))
+    {
+        void* huge = huge_alloc(state, size, alignment);
+        if (huge == NULL)
+        {
+            atomic_fetch_add_explicit(&state->failed_allocations, 1u, memory_order_relaxed);
+        }
+        return huge;
+    }
+
+    OafThreadCache* cache = current_cache(state);
+    if (cache == NULL)
+    {
+        atomic_fetch_add_explicit(&state->failed_allocations, 1u, memory_order_relaxed);
+        return NULL;
+    }
+
+    OafThreadCacheClass* cached = &cache->classes[size_class];
+    if (cached->head == NULL && !refill_cache(state, cached, size_class))
+    {
+        atomic_fetch_add_explicit(&state->failed_allocations, 1u, memory_order_relaxed);
+        return NULL;
+    }
+
+    void* block = cached->head;
+    cached->head = *(void**)block;
+    cached->count--;
+    bump(&cache->allocations, 1u);
+    bump(&cache->bytes_allocated, class_size(size_class));
+    return block;
+}
+
+static void tc_free(void* state_ptr, void* ptr)
+{
+    OafThreadCacheAllocatorState* state = (OafThreadCacheAllocatorState*)state_ptr;
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    OafTcSpanHeader* span = span_of(ptr);
+    if (span->size_class == OAF_TC_HUGE_CLASS)
+    {
+        huge_free(state, span);
+        return;
+    }
+
+    OafThreadCache* cache = current_cache(state);
+    if (cache == NULL)
+    {
+        OafCentralFreeList* central = &state->central[span->size_class];
+
+        pthread_mutex_lock(&central->mutex);
+        *(void**)ptr = central->head;
+        central->head = ptr;
+        central->count++;
+        pthread_mutex_unlock(&central->mutex);
+        return;
+    }
+
+    OafThreadCacheClass* cached = &cache->classes[span->size_class];
+    *(void**)ptr = cached->head;
+    cached->head = ptr;
+    cached->count++;
+    bump(&cache->frees, 1u);
+
+    if (cached->count > batch_size(span->size_class) * 2u)
+    {
+        release_to_central(state, cached, span->size_class, batch_size(span->size_class));
+    }
+}
+
+static void* tc_realloc(void* state_ptr, void* ptr, size_t old_size, size_t new_size, size_t alignment)
+{
+    if (ptr == NULL)
+    {
+        return tc_alloc(state_ptr, new_size, alignment);
+    }
+
+    size_t usable = oaf_thread_cache_allocator_usable_size(ptr);
+    size_t effective_alignment = alignment < OAF_TC_MIN_ALIGNMENT ? OAF_TC_MIN_ALIGNMENT : alignment;
+    if (new_size <= usable && ((uintptr_t)ptr & (effective_alignment - 1u)) == 0)
+    {
+        return ptr;
+    }
+
+    void* replacement = tc_alloc(state_ptr, new_size, alignment);
+    if (replacement == NULL)
+    {
+        return NULL;
+    }
+
+    size_t copy = old_size < new_size ? old_size : new_size;
+    memcpy(replacement, ptr, copy < usable ? copy : usable);
+    tc_free(state_ptr, ptr);
+    return replacement;
+}
+
+int oaf_thread_cache_allocator_init(OafThreadCacheAllocatorState* state)
+{
+    if (state == NULL)
+    {
+        return 0;
+    }
+
+    memset(state, 0, sizeof(*state));
+    if (pthread_key_create(&state->cache_key, detach_cache) != 0)
+    {
+        return 0;
+    }
+
+    state->key_created = 1;
+    pthread_mutex_init(&state->registry_mutex, NULL);
+    for (size_t size_class = 0; size_class < OAF_TC_SIZE_CLASS_COUNT; size_class++)
+    {
+        pthread_mutex_init(&state->central[size_class].mutex, NULL);
+    }
+
+    atomic_init(&state->span_count, 0u);
+    atomic_init(&state->central_transfers, 0u);
+    atomic_init(&state->huge_allocations, 0u);
+    atomic_init(&state->huge_frees, 0u);
+    atomic_init(&state->huge_active_bytes, 0u);
+    atomic_init(&state->failed_allocations, 0u);
+    return 1;
+}
+
+void oaf_thread_cache_allocator_destroy(OafThreadCacheAllocatorState* state)
+{
+    if (state == NULL || !state->key_created)
+    {
+        return;
+    }
+
+    pthread_key_delete(state->cache_key);
+    state->key_created = 0;
+
+    while (state->caches != NULL)
+    {
+        OafThreadCache* next = state->caches->next;
+        free(state->caches);
+        state->caches = next;
+    }
+
+    while (state->spans != NULL)
+    {
+        OafTcSpanHeader* span = (OafTcSpanHeader*)state->spans;
+        state->spans = span->next;
+        munmap(span, span->mapped_size);
+    }
+
+    while (state->huge_blocks != NULL)
+    {
+        OafTcSpanHeader* span = (OafTcSpanHeader*)state->huge_blocks;
+        state->huge_blocks = span->next;
+        munmap(span, span->mapped_size);
+    }
+
+    while (state->huge_cache != NULL)
+    {
+        OafTcSpanHeader* span = (OafTcSpanHeader*)state->huge_cache;
+        state->huge_cache = span->next;
+        munmap(span, span->mapped_size);
+    }
+
+    for (size_t size_class = 0; size_class < OAF_TC_SIZE_CLASS_COUNT; size_class++)
+    {
+        pthread_mutex_destroy(&state->central[size_class].mutex);
+    }
+    pthread_mutex_destroy(&state->registry_mutex);
+}
+
+void oaf_thread_cache_allocator_as_allocator(OafThreadCacheAllocatorState* state, OafAllocator* allocator)
+{
+    allocator->state = state;
+    allocator->ops.alloc = tc_alloc;
+    allocator->ops.realloc = tc_realloc;
+    allocator->ops.free = tc_free;
+}
+
+void oaf_thread_cache_allocator_flush(OafThreadCacheAllocatorState* state)
+{
+    if (state == NULL || !state->key_created)
+    {
+        return;
+    }
+
+    OafThreadCache* cache = (OafThreadCache*)pthread_getspecific(state->cache_key);
+    if (cache != NULL)
+    {
+        flush_cache(cache);
+    }
+}
+
+void oaf_thread_cache_allocator_stats(OafThreadCacheAllocatorState* state, OafThreadCacheAllocatorStats* out_stats)
+{
+    if (state == NULL || out_stats == NULL)
+    {
+        return;
+    }
+
+    memset(out_stats, 0, sizeof(*out_stats));
+    pthread_mutex_lock(&state->registry_mutex);
+    for (OafThreadCache* cache = state->caches; cache != NULL; cache = cache->next)
+    {
+        out_stats->allocations += atomic_load_explicit(&cache->allocations, memory_order_relaxed);
+        out_stats->frees += atomic_load_explicit(&cache->frees, memory_order_relaxed);
+        out_stats->bytes_allocated += atomic_load_explicit(&cache->bytes_allocated, memory_order_relaxed);
+        out_stats->thread_caches++;
+    }
+    pthread_mutex_unlock(&state->registry_mutex);
+
+    out_stats->huge_allocations = atomic_load_explicit(&state->huge_allocations, memory_order_relaxed);
+    out_stats->huge_active_bytes = atomic_load_explicit(&state->huge_active_bytes, memory_order_relaxed);
+    out_stats->allocations += out_stats->huge_allocations;
+    out_stats->frees += atomic_load_explicit(&state->huge_frees, memory_order_relaxed);
+    out_stats->active_allocations = out_stats->allocations > out_stats->frees
+        ? out_stats->allocations - out_stats->frees
+        : 0;
+    out_stats->spans = atomic_load_explicit(&state->span_count, memory_order_relaxed);
+    out_stats->central_transfers = atomic_load_explicit(&state->central_transfers, memory_order_relaxed);
+    out_stats->failed_allocations = atomic_load_explicit(&state->failed_allocations, memory_order_relaxed);
+}
+
+size_t oaf_thread_cache_allocator_usable_size(const void* ptr)
+{
+    if (ptr == NULL)
+    {
+        return 0;
+    }
+
+    OafTcSpanHeader* span = span_of(ptr);
+    if (span->magic != OAF_TC_SPAN_MAGIC)
+    {
+        return 0;
+    }
+
+    if (span->size_class == OAF_TC_HUGE_CLASS)
+    {
+        return (size_t)(((unsigned char*)span + span->mapped_size) - (const unsigned char*)ptr);
+    }
+
+    return span->block_size;
+}
@@ -1,386 +1,2077 @@
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "gc.h"
 
-static int find_object_index(const OafGarbageCollector* collector, const void* pointer)
+#define OAF_GC_NOT_ROOT ((size_t)-1)
+#define OAF_GC_INITIAL_CHILDREN 4
+#define OAF_GC_CHILD_INDEX_THRESHOLD 16u
+#define OAF_GC_CLOCK_INTERVAL 64u
+#define OAF_GC_MARK_DEQUE_INITIAL_CAPACITY 1024u
+
+typedef struct OafGcMarkBuffer
+{
+    size_t capacity;
+    struct OafGcMarkBuffer* retired;
+    _Atomic(OafGcObject*) entries[];
+} OafGcMarkBuffer;
+
+/* Chase-Lev deque: the owning worker pushes and takes at `bottom`, thieves steal from `top`. */
+typedef struct OafGcMarkDeque
+{
+    _Alignas(64) atomic_llong top;
+    atomic_llong bottom;
+    _Atomic(OafGcMarkBuffer*) buffer;
+    struct OafGcMarkTeam* team;
+    size_t index;
+} OafGcMarkDeque;
+
+/* Worker 0 is the collecting thread; the others park between cycles. */
+typedef struct OafGcMarkTeam
+{
+    OafGcMarkDeque* deques;
+    pthread_t* threads;
+    size_t worker_count;
+    size_t thread_count;
+    uint32_t epoch;
+    atomic_size_t busy;
+    atomic_int overflow;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    uint64_t round;
+    size_t finished;
+    int stop;
+} OafGcMarkTeam;
+
+static uint64_t gc_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* The background thread sleeps against CLOCK_MONOTONIC, so stepping the wall clock does not stall it. */
+static int init_monotonic_cond(pthread_cond_t* cond)
+{
+    pthread_condattr_t attributes;
+    int ok;
+
+    if (pthread_condattr_init(&attributes) != 0)
+    {
+        return 0;
+    }
+
+    ok = pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC) == 0 && pthread_cond_init(cond, &attributes) == 0;
+    pthread_condattr_destroy(&attributes);
+    return ok;
+}
+
+static void gc_lock(const OafGarbageCollector* collector)
+{
+    if (collector->background_running)
+    {
+        pthread_mutex_lock((pthread_mutex_t*)&collector->mutex);
+    }
+}
+
+static void gc_unlock(const OafGarbageCollector* collector)
+{
+    if (collector->background_running)
+    {
+        pthread_mutex_unlock((pthread_mutex_t*)&collector->mutex);
+    }
+}
+
+static size_t map_slot(const OafGarbageCollector* collector, const void* pointer)
+{
+    uint64_t hash = ((uint64_t)(uintptr_t)pointer >> 4) * 0x9E3779B97F4A7C15ull;
+
+    return (size_t)(hash >> 32) & (collector->map_capacity - 1u);
+}
+
+static OafGcObject* map_find(const OafGarbageCollector* collector, const void* pointer)
+{
+    size_t slot;
+
+    if (collector == NULL || pointer == NULL || collector->map_capacity == 0)
+    {
+        return NULL;
+    }
+
+    slot = map_slot(collector, pointer);
+    while (collector->map[slot].pointer != NULL)
+    {
+        if (collector->map[slot].pointer == pointer)
+        {
+            return collector->map[slot].object;
+        }
+
+        slot = (slot + 1u) & (collector->map_capacity - 1u);
+    }
+
+    return NULL;
+}
+
+static void map_put(OafGarbageCollector* collector, OafGcObject* object)
+{
+    size_t slot = map_slot(collector, object->pointer);
+
+    while (collector->map[slot].pointer != NULL)
+    {
+        slot = (slot + 1u) & (collector->map_capacity - 1u);
+    }
+
+    collector->map[slot].pointer = object->pointer;
+    collector->map[slot].object = object;
+}
+
+static void map_remove(OafGarbageCollector* collector, const void* pointer)
+{
+    size_t mask = collector->map_capacity - 1u;
+    size_t slot = map_slot(collector, pointer);
+    size_t next;
+
+    while (collector->map[slot].pointer != pointer)
+    {
+        if (collector->map[slot].pointer == NULL)
+        {
+            return;
+        }
+
+        slot = (slot + 1u) & mask;
+    }
+
+    next = (slot + 1u) & mask;
+    while (collector->map[next].pointer != NULL)
+    {
+        size_t home = map_slot(collector, collector->map[next].pointer);
+
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            collector->map[slot] = collector->map[next];
+            slot = next;
+        }
+
+        next = (next + 1u) & mask;
+    }
+
+    collector->map[slot].pointer = NULL;
+    collector->map[slot].object = NULL;
+}
+
+static int map_reserve(OafGarbageCollector* collector, size_t count)
+{
+    OafGcMapEntry* entries;
+    OafGcMapEntry* old_entries;
+    size_t capacity;
+    size_t index;
+
+    if (count * 2u <= collector->map_capacity)
+    {
+        return 1;
+    }
+
+    capacity = collector->map_capacity == 0 ? OAF_GC_INITIAL_CAPACITY * 2u : collector->map_capacity;
+    while (capacity < count * 2u)
+    {
+        capacity *= 2u;
+    }
+
+    entries = (OafGcMapEntry*)oaf_allocator_alloc(collector->allocator, capacity * sizeof(OafGcMapEntry), _Alignof(OafGcMapEntry));
+    if (entries == NULL)
+    {
+        return 0;
+    }
+
+    memset(entries, 0, capacity * sizeof(OafGcMapEntry));
+    old_entries = collector->map;
+    collector->map = entries;
+    collector->map_capacity = capacity;
+    for (index = 0; index < collector->active_count; index++)
+    {
+        map_put(collector, collector->objects[index]);
+    }
+
+    if (old_entries != NULL)
+    {
+        oaf_allocator_free(collector->allocator, old_entries);
+    }
+
+    return 1;
+}
+
+static int reserve_pointers(OafGarbageCollector* collector, OafGcObject*** array, size_t* capacity, size_t needed)
+{
+    OafGcObject** grown;
+    size_t new_capacity;
+
+    if (needed <= *capacity)
+    {
+        return 1;
+    }
+
+    new_capacity = *capacity == 0 ? OAF_GC_INITIAL_CAPACITY : *capacity;
+    while (new_capacity < needed)
+    {
+        new_capacity *= 2u;
+    }
+
+    grown = (OafGcObject**)oaf_allocator_realloc(
+        collector->allocator,
+        *array,
+        *capacity * sizeof(OafGcObject*),
+        new_capacity * sizeof(OafGcObject*),
+        _Alignof(OafGcObject*));
+    if (grown == NULL)
+    {
+        return 0;
+    }
+
+    *array = grown;
+    *capacity = new_capacity;
+    return 1;
+}
+
+static int add_root(OafGarbageCollector* collector, OafGcObject* object)
+{
+    if (!reserve_pointers(collector, &collector->roots, &collector->root_capacity, collector->root_count + 1u))
+    {
+        return 0;
+    }
+
+    object->root_index = collector->root_count;
+    collector->roots[collector->root_count] = object;
+    collector->root_count++;
+    return 1;
+}
+
+static void remove_root(OafGarbageCollector* collector, OafGcObject* object)
+{
+    OafGcObject* last;
+
+    if (object->root_index == OAF_GC_NOT_ROOT)
+    {
+        return;
+    }
+
+    last = collector->roots[collector->root_count - 1u];
+    collector->roots[object->root_index] = last;
+    last->root_index = object->root_index;
+    collector->root_count--;
+    object->root_index = OAF_GC_NOT_ROOT;
+}
+
+static size_t chunk_header_size(void)
+{
+    return oaf_align_forward(sizeof(OafGcNurseryChunk), OAF_GC_NURSERY_MAX_ALIGNMENT);
+}
+
+static void unqueue_chunk(OafGarbageCollector* collector, OafGcNurseryChunk* chunk)
+{
+    if (!chunk->recyclable)
+    {
+        return;
+    }
+
+    if (chunk->recycle_prev != NULL)
+    {
+        chunk->recycle_prev->recycle_next = chunk->recycle_next;
+    }
+    else
+    {
+        collector->nursery_recycle = chunk->recycle_next;
+    }
+
+    if (chunk->recycle_next != NULL)
+    {
+        chunk->recycle_next->recycle_prev = chunk->recycle_prev;
+    }
+
+    chunk->recycle_prev = NULL;
+    chunk->recycle_next = NULL;
+    chunk->recyclable = 0;
+}
+
+static void queue_chunk(OafGarbageCollector* collector, OafGcNurseryChunk* chunk)
+{
+    if (chunk->recyclable)
+    {
+        return;
+    }
+
+    chunk->recycle_prev = NULL;
+    chunk->recycle_next = collector->nursery_recycle;
+    if (collector->nursery_recycle != NULL)
+    {
+        collector->nursery_recycle->recycle_prev = chunk;
+    }
+
+    collector->nursery_recycle = chunk;
+    chunk->recyclable = 1;
+}
+
+static void release_chunk(OafGarbageCollector* collector, OafGcNurseryChunk* chunk)
+{
+    unqueue_chunk(collector, chunk);
+    if (collector->nursery_spare == NULL)
+    {
+        chunk->offset = 0;
+        chunk->limit = chunk->capacity;
+        collector->nursery_spare = chunk;
+        return;
+    }
+
+    oaf_allocator_free(collector->allocator, chunk);
+    collector->nursery_chunks--;
+}
+
+/* Adds delta to every line [offset, offset + total) overlaps; returns how many lines became free. */
+static size_t mark_lines(OafGcNurseryChunk* chunk, size_t offset, size_t total, int delta)
+{
+    size_t line = offset / OAF_GC_NURSERY_LINE_SIZE;
+    size_t last = (offset + total - 1u) / OAF_GC_NURSERY_LINE_SIZE;
+    size_t freed = 0;
+
+    for (; line <= last; line++)
+    {
+        chunk->line_live[line] = (unsigned char)(chunk->line_live[line] + delta);
+        freed += chunk->line_live[line] == 0;
+    }
+
+    return freed;
+}
+
+/* Moves the chunk's bump range to the next run of free lines at or after offset; returns 0 when none is left. */
+static int find_hole(OafGcNurseryChunk* chunk, size_t offset)
+{
+    size_t line = (offset + OAF_GC_NURSERY_LINE_SIZE - 1u) / OAF_GC_NURSERY_LINE_SIZE;
+    size_t end;
+
+    while (line < OAF_GC_NURSERY_LINES && chunk->line_live[line] != 0)
+    {
+        line++;
+    }
+
+    if (line == OAF_GC_NURSERY_LINES)
+    {
+        return 0;
+    }
+
+    end = line;
+    while (end < OAF_GC_NURSERY_LINES && chunk->line_live[end] == 0)
+    {
+        end++;
+    }
+
+    chunk->offset = line * OAF_GC_NURSERY_LINE_SIZE;
+    chunk->limit = end * OAF_GC_NURSERY_LINE_SIZE;
+    return 1;
+}
+
+static void free_object(OafGarbageCollector* collector, OafGcObject* object)
+{
+    OafGcNurseryChunk* chunk = object->chunk;
+    size_t freed;
+
+    if (object->children != NULL)
+    {
+        oaf_allocator_free(collector->allocator, object->children);
+    }
+
+    if (object->child_index != NULL)
+    {
+        oaf_allocator_free(collector->allocator, object->child_index);
+    }
+
+    if (chunk == NULL)
+    {
+        oaf_allocator_free(collector->allocator, object);
+        return;
+    }
+
+    freed = mark_lines(
+        chunk,
+        (size_t)((unsigned char*)object - ((unsigned char*)chunk + chunk_header_size())),
+        (size_t)((unsigned char*)object->pointer - (unsigned char*)object) + object->size,
+        -1);
+    chunk->live_objects--;
+    if (chunk->live_objects == 0 && chunk != collector->nursery_chunk)
+    {
+        release_chunk(collector, chunk);
+    }
+    else if (freed != 0)
+    {
+        queue_chunk(collector, chunk);
+    }
+}
+
+static void remove_young(OafGarbageCollector* collector, OafGcObject* object)
+{
+    OafGcObject* last = collector->young[collector->young_count - 1u];
+
+    collector->young[object->young_index] = last;
+    last->young_index = object->young_index;
+    collector->young_count--;
+    object->young_index = OAF_GC_NOT_ROOT;
+    object->flags &= ~OAF_GC_FLAG_YOUNG;
+    collector->young_bytes -= object->size;
+}
+
+static void remove_remembered(OafGarbageCollector* collector, OafGcObject* object)
+{
+    OafGcObject* last;
+
+    if (object->remembered_index == OAF_GC_NOT_ROOT)
+    {
+        return;
+    }
+
+    last = collector->remembered[collector->remembered_count - 1u];
+    collector->remembered[object->remembered_index] = last;
+    last->remembered_index = object->remembered_index;
+    collector->remembered_count--;
+    object->remembered_index = OAF_GC_NOT_ROOT;
+}
+
+static void unlink_object(OafGarbageCollector* collector, OafGcObject* object)
+{
+    OafGcObject* last = collector->objects[collector->active_count - 1u];
+
+    map_remove(collector, object->pointer);
+    remove_root(collector, object);
+    remove_remembered(collector, object);
+    if ((object->flags & OAF_GC_FLAG_YOUNG) != 0)
+    {
+        remove_young(collector, object);
+    }
+
+    collector->objects[object->index] = last;
+    last->index = object->index;
+    collector->active_count--;
+
+    if (collector->managed_bytes >= object->size)
+    {
+        collector->managed_bytes -= object->size;
+    }
+    else
+    {
+        collector->managed_bytes = 0;
+    }
+}
+
+/* Recycled chunks with free lines come first, then the spare chunk, then a new one. */
+static OafGcNurseryChunk* next_nursery_chunk(OafGarbageCollector* collector)
+{
+    OafGcNurseryChunk* chunk;
+
+    while (collector->nursery_recycle != NULL)
+    {
+        chunk = collector->nursery_recycle;
+        unqueue_chunk(collector, chunk);
+        if (find_hole(chunk, 0))
+        {
+            return chunk;
+        }
+    }
+
+    if (collector->nursery_spare != NULL)
+    {
+        chunk = collector->nursery_spare;
+        collector->nursery_spare = NULL;
+        return chunk;
+    }
+
+    chunk = (OafGcNurseryChunk*)oaf_allocator_alloc(
+        collector->allocator,
+        chunk_header_size() + OAF_GC_NURSERY_CHUNK_SIZE,
+        OAF_GC_NURSERY_MAX_ALIGNMENT);
+    if (chunk == NULL)
+    {
+        return NULL;
+    }
+
+    memset(chunk, 0, sizeof(*chunk));
+    chunk->capacity = OAF_GC_NURSERY_CHUNK_SIZE;
+    chunk->limit = OAF_GC_NURSERY_CHUNK_SIZE;
+    collector->nursery_chunks++;
+    return chunk;
+}
+
+static OafGcObject* nursery_alloc(OafGarbageCollector* collector, size_t total, size_t align)
+{
+    OafGcNurseryChunk* chunk = collector->nursery_chunk;
+    size_t offset;
+
+    for (;;)
+    {
+        if (chunk != NULL)
+        {
+            offset = oaf_align_forward(chunk->offset, align);
+            if (offset + total <= chunk->limit)
+            {
+                break;
+            }
+
+            if (find_hole(chunk, chunk->limit))
+            {
+                continue;
+            }
+
+            if (chunk->live_objects == 0)
+            {
+                chunk->offset = 0;
+                chunk->limit = chunk->capacity;
+                continue;
+            }
+        }
+
+        chunk = next_nursery_chunk(collector);
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+
+        collector->nursery_chunk = chunk;
+    }
+
+    chunk->offset = offset + total;
+    mark_lines(chunk, offset, total, 1);
+    chunk->live_objects++;
+    return (OafGcObject*)((unsigned char*)chunk + chunk_header_size() + offset);
+}
+
+static uint32_t object_epoch(const OafGcObject* object)
+{
+    return atomic_load_explicit(&object->mark_epoch, memory_order_relaxed);
+}
+
+static void set_object_epoch(OafGcObject* object, uint32_t epoch)
+{
+    atomic_store_explicit(&object->mark_epoch, epoch, memory_order_relaxed);
+}
+
+static uint32_t next_epoch(OafGarbageCollector* collector)
+{
+    size_t index;
+
+    collector->mark_epoch++;
+    if (collector->mark_epoch == 0)
+    {
+        for (index = 0; index < collector->active_count; index++)
+        {
+            set_object_epoch(collector->objects[index], 0);
+        }
+        collector->mark_epoch = 1;
+    }
+
+    return collector->mark_epoch;
+}
+
+static void shade(OafGarbageCollector* collector, OafGcObject* object)
+{
+    if (object_epoch(object) != collector->mark_epoch)
+    {
+        set_object_epoch(object, collector->mark_epoch);
+        collector->mark_stack[collector->mark_depth++] = object;
+    }
+}
+
+static void record_pause(OafGarbageCollector* collector, uint64_t pause_ns)
+{
+    OafGcPauseHistogram* pauses = &collector->pauses;
+    uint64_t micros = pause_ns / 1000u;
+    size_t bucket = 0;
+
+    while (micros > 0 && bucket + 1u < OAF_GC_PAUSE_BUCKETS)
+    {
+        micros >>= 1;
+        bucket++;
+    }
+
+    pauses->buckets[bucket]++;
+    pauses->count++;
+    pauses->total_ns += pause_ns;
+    pauses->max_ns = pause_ns > pauses->max_ns ? pause_ns : pauses->max_ns;
+}
+
+static int begin_cycle(OafGarbageCollector* collector)
+{
+    size_t index;
+
+    if (!reserve_pointers(collector, &collector->mark_stack, &collector->mark_stack_capacity, collector->active_count))
+    {
+        return 0;
+    }
+
+    next_epoch(collector);
+    collector->mark_depth = 0;
+    for (index = 0; index < collector->root_count; index++)
+    {
+        shade(collector, collector->roots[index]);
+    }
+
+    for (index = 0; index < collector->fresh_count; index++)
+    {
+        shade(collector, collector->fresh[index]);
+    }
+
+    collector->fresh_count = 0;
+    collector->phase = OAF_GC_PHASE_MARKING;
+    return 1;
+}
+
+static int mark_some(OafGarbageCollector* collector, uint64_t deadline_ns)
+{
+    size_t scanned = 0;
+
+    while (collector->mark_depth > 0)
+    {
+        OafGcObject* object = collector->mark_stack[--collector->mark_depth];
+        size_t child;
+
+        for (child = 0; child < object->child_count; child++)
+        {
+            shade(collector, object->children[child]);
+        }
+
+        scanned++;
+        if (collector->mark_depth > 0 && deadline_ns != 0 && scanned % OAF_GC_CLOCK_INTERVAL == 0 && gc_now_ns() >= deadline_ns)
+        {
+            return 0;
+        }
+    }
+
+    collector->phase = OAF_GC_PHASE_SWEEPING;
+    collector->sweep_cursor = collector->active_count;
+    return 1;
+}
+
+static OafGcMarkBuffer* mark_buffer_create(size_t capacity)
+{
+    OafGcMarkBuffer* buffer = (OafGcMarkBuffer*)malloc(sizeof(OafGcMarkBuffer) + capacity * sizeof(_Atomic(OafGcObject*)));
+
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+
+    buffer->capacity = capacity;
+    buffer->retired = NULL;
+    return buffer;
+}
+
+static void mark_buffer_release_retired(OafGcMarkBuffer* buffer)
+{
+    OafGcMarkBuffer* retired = buffer->retired;
+
+    buffer->retired = NULL;
+    while (retired != NULL)
+    {
+        OafGcMarkBuffer* next = retired->retired;
+        free(retired);
+        retired = next;
+    }
+}
+
+static int mark_deque_push(OafGcMarkDeque* deque, OafGcObject* object)
+{
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    OafGcMarkBuffer* buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+
+    if ((size_t)(bottom - top) >= buffer->capacity)
+    {
+        OafGcMarkBuffer* grown = mark_buffer_create(buffer->capacity * 2u);
+        long long index;
+
+        if (grown == NULL)
+        {
+            return 0;
+        }
+
+        for (index = top; index < bottom; index++)
+        {
+            OafGcObject* entry = atomic_load_explicit(&buffer->entries[(size_t)index & (buffer->capacity - 1u)], memory_order_relaxed);
+            atomic_store_explicit(&grown->entries[(size_t)index & (grown->capacity - 1u)], entry, memory_order_relaxed);
+        }
+
+        grown->retired = buffer;
+        atomic_store_explicit(&deque->buffer, grown, memory_order_release);
+        buffer = grown;
+    }
+
+    atomic_store_explicit(&buffer->entries[(size_t)bottom & (buffer->capacity - 1u)], object, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return 1;
+}
+
+static OafGcObject* mark_deque_take(OafGcMarkDeque* deque)
+{
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    OafGcMarkBuffer* buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+    OafGcObject* object = NULL;
+    long long top;
+
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    if (top > bottom)
+    {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    object = atomic_load_explicit(&buffer->entries[(size_t)bottom & (buffer->capacity - 1u)], memory_order_relaxed);
+    if (top == bottom)
+    {
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+        {
+            object = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+
+    return object;
+}
+
+static OafGcObject* mark_deque_steal(OafGcMarkDeque* deque)
+{
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    long long bottom;
+    OafGcMarkBuffer* buffer;
+    OafGcObject* object;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom)
+    {
+        return NULL;
+    }
+
+    buffer = atomic_load_explicit(&deque->buffer, memory_order_acquire);
+    object = atomic_load_explicit(&buffer->entries[(size_t)top & (buffer->capacity - 1u)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+    {
+        return NULL;
+    }
+
+    return object;
+}
+
+static int mark_deque_has_work(OafGcMarkDeque* deque)
+{
+    return atomic_load_explicit(&deque->top, memory_order_relaxed) < atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+}
+
+static OafGcObject* mark_steal_any(OafGcMarkTeam* team, size_t index)
+{
+    size_t offset;
+
+    for (offset = 1; offset < team->worker_count; offset++)
+    {
+        OafGcObject* object = mark_deque_steal(&team->deques[(index + offset) % team->worker_count]);
+
+        if (object != NULL)
+        {
+            return object;
+        }
+    }
+
+    return NULL;
+}
+
+static OafGcObject* mark_wait_for_work(OafGcMarkTeam* team, size_t index)
+{
+    while (atomic_load(&team->busy) != 0)
+    {
+        size_t victim;
+
+        for (victim = 0; victim < team->worker_count; victim++)
+        {
+            if (mark_deque_has_work(&team->deques[victim]))
+            {
+                OafGcObject* object;
+
+                atomic_fetch_add(&team->busy, 1u);
+                object = mark_steal_any(team, index);
+                if (object != NULL)
+                {
+                    return object;
+                }
+                atomic_fetch_sub(&team->busy, 1u);
+                break;
+            }
+        }
+
+        sched_yield();
+    }
+
+    return NULL;
+}
+
+static void mark_worker_run(OafGcMarkTeam* team, size_t index)
+{
+    OafGcMarkDeque* self = &team->deques[index];
+
+    for (;;)
+    {
+        OafGcObject* object = mark_deque_take(self);
+        size_t child;
+
+        if (object == NULL)
+        {
+            object = mark_steal_any(team, index);
+        }
+
+        if (object == NULL)
+        {
+            atomic_fetch_sub(&team->busy, 1u);
+            object = mark_wait_for_work(team, index);
+            if (object == NULL)
+            {
+                return;
+            }
+        }
+
+        for (child = 0; child < object->child_count; child++)
+        {
+            OafGcObject* target = object->children[child];
+
+            if (object_epoch(target) != team->epoch
+                && atomic_exchange_explicit(&target->mark_epoch, team->epoch, memory_order_relaxed) != team->epoch
+                && !mark_deque_push(self, target))
+            {
+                atomic_store(&team->overflow, 1);
+            }
+        }
+    }
+}
+
+static void* mark_thread_main(void* argument)
+{
+    OafGcMarkDeque* deque = (OafGcMarkDeque*)argument;
+    OafGcMarkTeam* team = deque->team;
+    uint64_t seen = 0;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&team->mutex);
+        while (!team->stop && team->round == seen)
+        {
+            pthread_cond_wait(&team->wake, &team->mutex);
+        }
+
+        if (team->stop)
+        {
+            pthread_mutex_unlock(&team->mutex);
+            return NULL;
+        }
+
+        seen = team->round;
+        pthread_mutex_unlock(&team->mutex);
+
+        mark_worker_run(team, deque->index);
+
+        pthread_mutex_lock(&team->mutex);
+        team->finished++;
+        pthread_cond_signal(&team->done);
+        pthread_mutex_unlock(&team->mutex);
+    }
+}
+
+static void mark_team_reset(OafGcMarkTeam* team)
+{
+    size_t index;
+
+    for (index = 0; index < team->worker_count; index++)
+    {
+        OafGcMarkDeque* deque = &team->deques[index];
+
+        atomic_store_explicit(&deque->top, 0, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, 0, memory_order_relaxed);
+        mark_buffer_release_retired(atomic_load_explicit(&deque->buffer, memory_order_relaxed));
+    }
+}
+
+static void mark_team_destroy(OafGarbageCollector* collector)
+{
+    OafGcMarkTeam* team = collector->mark_team;
+    size_t index;
+
+    if (team == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&team->mutex);
+    team->stop = 1;
+    pthread_cond_broadcast(&team->wake);
+    pthread_mutex_unlock(&team->mutex);
+    for (index = 0; index < team->thread_count; index++)
+    {
+        pthread_join(team->threads[index], NULL);
+    }
+
+    for (index = 0; index < team->worker_count; index++)
+    {
+        OafGcMarkBuffer* buffer = atomic_load_explicit(&team->deques[index].buffer, memory_order_relaxed);
+
+        if (buffer != NULL)
+        {
+            mark_buffer_release_retired(buffer);
+            free(buffer);
+        }
+    }
+
+    pthread_cond_destroy(&team->done);
+    pthread_cond_destroy(&team->wake);
+    pthread_mutex_destroy(&team->mutex);
+    oaf_allocator_free(collector->allocator, team->threads);
+    oaf_allocator_free(collector->allocator, team->deques);
+    oaf_allocator_free(collector->allocator, team);
+    collector->mark_team = NULL;
+}
+
+static int mark_team_create(OafGarbageCollector* collector, size_t worker_count)
+{
+    OafGcMarkTeam* team = (OafGcMarkTeam*)oaf_allocator_alloc(collector->allocator, sizeof(OafGcMarkTeam), _Alignof(OafGcMarkTeam));
+    size_t index;
+
+    if (team == NULL)
+    {
+        return 0;
+    }
+
+    memset(team, 0, sizeof(*team));
+    team->deques = (OafGcMarkDeque*)oaf_allocator_alloc(collector->allocator, worker_count * sizeof(OafGcMarkDeque), _Alignof(OafGcMarkDeque));
+    if (team->deques == NULL)
+    {
+        oaf_allocator_free(collector->allocator, team);
+        return 0;
+    }
+
+    team->threads = (pthread_t*)oaf_allocator_alloc(collector->allocator, worker_count * sizeof(pthread_t), _Alignof(pthread_t));
+    if (team->threads == NULL)
+    {
+        oaf_allocator_free(collector->allocator, team->deques);
+        oaf_allocator_free(collector->allocator, team);
+        return 0;
+    }
+
+    memset(team->deques, 0, worker_count * sizeof(OafGcMarkDeque));
+    pthread_mutex_init(&team->mutex, NULL);
+    pthread_cond_init(&team->wake, NULL);
+    pthread_cond_init(&team->done, NULL);
+    team->worker_count = worker_count;
+    collector->mark_team = team;
+    for (index = 0; index < worker_count; index++)
+    {
+        OafGcMarkDeque* deque = &team->deques[index];
+
+        atomic_init(&deque->top, 0);
+        atomic_init(&deque->bottom, 0);
+        atomic_init(&deque->buffer, mark_buffer_create(OAF_GC_MARK_DEQUE_INITIAL_CAPACITY));
+        deque->team = team;
+        deque->index = index;
+        if (atomic_load_explicit(&deque->buffer, memory_order_relaxed) == NULL)
+        {
+            mark_team_destroy(collector);
+            return 0;
+        }
+    }
+
+    for (index = 1; index < worker_count; index++)
+    {
+        if (pthread_create(&team->threads[team->thread_count], NULL, mark_thread_main, &team->deques[index]) != 0)
+        {
+            mark_team_destroy(collector);
+            return 0;
+        }
+        team->thread_count++;
+    }
+
+    return 1;
+}
+
+static void mark_parallel(OafGarbageCollector* collector)
+{
+    OafGcMarkTeam* team = collector->mark_team;
+    size_t index;
+
+    if (team == NULL || collector->active_count < OAF_GC_PARALLEL_MARK_MIN_OBJECTS || collector->mark_depth == 0)
+    {
+        return;
+    }
+
+    for (index = 0; index < collector->mark_depth; index++)
+    {
+        if (!mark_deque_push(&team->deques[index % team->worker_count], collector->mark_stack[index]))
+        {
+            mark_team_reset(team);
+            return;
+        }
+    }
+
+    collector->mark_depth = 0;
+    team->epoch = collector->mark_epoch;
+    atomic_store(&team->overflow, 0);
+    atomic_store(&team->busy, team->worker_count);
+    pthread_mutex_lock(&team->mutex);
+    team->round++;
+    team->finished = 0;
+    pthread_cond_broadcast(&team->wake);
+    pthread_mutex_unlock(&team->mutex);
+
+    mark_worker_run(team, 0);
+
+    pthread_mutex_lock(&team->mutex);
+    while (team->finished < team->thread_count)
+    {
+        pthread_cond_wait(&team->done, &team->mutex);
+    }
+    pthread_mutex_unlock(&team->mutex);
+    mark_team_reset(team);
+
+    if (atomic_load(&team->overflow))
+    {
+        for (index = 0; index < collector->active_count; index++)
+        {
+            OafGcObject* object = collector->objects[index];
+            size_t child;
+
+            if (object_epoch(object) != collector->mark_epoch)
+            {
+                continue;
+            }
+
+            for (child = 0; child < object->child_count; child++)
+            {
+                shade(collector, object->children[child]);
+            }
+        }
+    }
+}
+
+static int sweep_some(OafGarbageCollector* collector, uint64_t deadline_ns, size_t* collected)
+{
+    size_t visited = 0;
+
+    while (collector->sweep_cursor > 0)
+    {
+        OafGcObject* object = collector->objects[--collector->sweep_cursor];
+
+        if (object_epoch(object) != collector->mark_epoch)
+        {
+            unlink_object(collector, object);
+            free_object(collector, object);
+            (*collected)++;
+        }
+
+        visited++;
+        if (deadline_ns != 0 && visited % OAF_GC_CLOCK_INTERVAL == 0 && gc_now_ns() >= deadline_ns)
+        {
+            break;
+        }
+    }
+
+    if (collector->sweep_cursor > 0)
+    {
+        return 0;
+    }
+
+    collector->phase = OAF_GC_PHASE_IDLE;
+    collector->cycles++;
+    collector->next_trigger = collector->active_count * 2u > OAF_GC_INITIAL_TRIGGER ? collector->active_count * 2u : OAF_GC_INITIAL_TRIGGER;
+    return 1;
+}
+
+static size_t step_locked(OafGarbageCollector* collector)
+{
+    uint64_t started;
+    uint64_t deadline;
+    size_t collected = 0;
+    int marked = 0;
+
+    if (!collector->enabled || (collector->phase == OAF_GC_PHASE_IDLE && collector->active_count < collector->next_trigger))
+    {
+        return 0;
+    }
+
+    started = gc_now_ns();
+    deadline = collector->pause_budget_ns != 0 ? started + collector->pause_budget_ns : 0;
+    if (collector->phase == OAF_GC_PHASE_IDLE && !begin_cycle(collector))
+    {
+        return 0;
+    }
+
+    if (collector->phase == OAF_GC_PHASE_MARKING)
+    {
+        marked = 1;
+        mark_some(collector, deadline);
+    }
+
+    if (collector->phase == OAF_GC_PHASE_SWEEPING && (!marked || deadline == 0 || gc_now_ns() < deadline))
+    {
+        sweep_some(collector, deadline, &collected);
+    }
+
+    record_pause(collector, gc_now_ns() - started);
+    return collected;
+}
+
+static void* background_main(void* argument)
+{
+    OafGarbageCollector* collector = (OafGarbageCollector*)argument;
+
+    pthread_mutex_lock(&collector->mutex);
+    while (!collector->background_stop)
+    {
+        struct timespec wake_at;
+        uint64_t wake_ns;
+
+        step_locked(collector);
+        clock_gettime(CLOCK_MONOTONIC, &wake_at);
+        wake_ns = (uint64_t)wake_at.tv_nsec + collector->background_interval_ns;
+        wake_at.tv_sec += (time_t)(wake_ns / 1000000000ull);
+        wake_at.tv_nsec = (long)(wake_ns % 1000000000ull);
+        if (!collector->background_stop)
+        {
+            pthread_cond_timedwait(&collector->background_wake, &collector->mutex, &wake_at);
+        }
+    }
+    pthread_mutex_unlock(&collector->mutex);
+    return NULL;
+}
+
+static int detect_cycles_locked(const OafGarbageCollector* collector)
+{
+    unsigned char* state;
+    OafGcObject** path;
+    size_t* positions;
+    size_t count;
+    size_t index;
+    int found = 0;
+
+    if (collector->active_count == 0)
+    {
+        return 0;
+    }
+
+    count = collector->active_count;
+    state = (unsigned char*)oaf_allocator_alloc(collector->allocator, count, 1);
+    path = (OafGcObject**)oaf_allocator_alloc(collector->allocator, count * sizeof(OafGcObject*), _Alignof(OafGcObject*));
+    positions = (size_t*)oaf_allocator_alloc(collector->allocator, count * sizeof(size_t), _Alignof(size_t));
+    if (state != NULL && path != NULL && positions != NULL)
+    {
+        memset(state, 0, count);
+        for (index = 0; index < count && !found; index++)
+        {
+            size_t depth;
+
+            if (state[index] != 0)
+            {
+                continue;
+            }
+
+            state[index] = 1;
+            path[0] = collector->objects[index];
+            positions[0] = 0;
+            depth = 1;
+
+            while (depth > 0 && !found)
+            {
+                OafGcObject* object = path[depth - 1u];
+                OafGcObject* child;
+
+                if (positions[depth - 1u] == object->child_count)
+                {
+                    state[object->index] = 2;
+                    depth--;
+                    continue;
+                }
+
+                child = object->children[positions[depth - 1u]++];
+                if (state[child->index] == 1)
+                {
+                    found = 1;
+                }
+                else if (state[child->index] == 0)
+                {
+                    state[child->index] = 1;
+                    path[depth] = child;
+                    positions[depth] = 0;
+                    depth++;
+                }
+            }
+        }
+    }
+
+    if (state != NULL)
+    {
+        oaf_allocator_free(collector->allocator, state);
+    }
+
+    if (path != NULL)
+    {
+        oaf_allocator_free(collector->allocator, path);
+    }
+
+    if (positions != NULL)
+    {
+        oaf_allocator_free(collector->allocator, positions);
+    }
+
+    return found;
+}
+
+int oaf_gc_init(OafGarbageCollector* collector, OafAllocator* allocator, int enabled)
+{
+    if (collector == NULL || allocator == NULL)
+    {
+        return 0;
+    }
+
+    memset(collector, 0, sizeof(*collector));
+    if (pthread_mutex_init(&collector->mutex, NULL) != 0)
+    {
+        return 0;
+    }
+
+    if (!init_monotonic_cond(&collector->background_wake))
+    {
+        pthread_mutex_destroy(&collector->mutex);
+        return 0;
+    }
+
+    collector->allocator = allocator;
+    collector->next_trigger = OAF_GC_INITIAL_TRIGGER;
+    collector->background_interval_ns = OAF_GC_BACKGROUND_INTERVAL_NS;
+    collector->phase = OAF_GC_PHASE_IDLE;
+    collector->enabled = enabled != 0;
+    return 1;
+}
+
+void oaf_gc_destroy(OafGarbageCollector* collector)
+{
+    size_t index;
+
+    if (collector == NULL || collector->allocator == NULL)
+    {
+        return;
+    }
+
+    oaf_gc_stop_background(collector);
+    mark_team_destroy(collector);
+    for (index = 0; index < collector->active_count; index++)
+    {
+        free_object(collector, collector->objects[index]);
+    }
+
+    if (collector->objects != NULL)
+    {
+        oaf_allocator_free(collector->allocator, collector->objects);
+    }
+
+    if (collector->roots != NULL)
+    {
+        oaf_allocator_free(collector->allocator, collector->roots);
+    }
+
+    if (collector->map != NULL)
+    {
+        oaf_allocator_free(collector->allocator, collector->map);
+    }
+
+    if (collector->mark_stack != NULL)
+    {
+        oaf_allocator_free(collector->allocator, collector->mark_stack);
+    }
+
+    if (collector->fresh != NULL)
+    {
+        oaf_allocator_free(collector->allocator, collector->fresh);
+    }
+
+    if (collector->young != NULL)
+    {
+        oaf_allocator_free(collector->allocator, collector->young);
+    }
+
+    if (collector->remembered != NULL)
+    {
+        oaf_allocator_free(collector->allocator, collector->remembered);
+    }
+
+    if (collector->nursery_chunk != NULL)
+    {
+        oaf_allocator_free(collector->allocator, collector->nursery_chunk);
+    }
+
+    if (collector->nursery_spare != NULL)
+    {
+        oaf_allocator_free(collector->allocator, collector->nursery_spare);
+    }
+
+    pthread_cond_destroy(&collector->background_wake);
+    pthread_mutex_destroy(&collector->mutex);
+    memset(collector, 0, sizeof(*collector));
+}
+
+void oaf_gc_set_enabled(OafGarbageCollector* collector, int enabled)
 {
-    size_t index;
+    if (collector == NULL)
+    {
+        return;
+    }
+
+    gc_lock(collector);
+    collector->enabled = enabled != 0;
+    gc_unlock(collector);
+}
+
+void* oaf_gc_alloc(OafGarbageCollector* collector, size_t size, size_t alignment)
+{
+    OafGcObject* object;
+    size_t align;
+    size_t header_size;
+    int track_fresh;
+    int young;
+
+    if (collector == NULL || collector->allocator == NULL)
+    {
+        return NULL;
+    }
 
-    if (collector == NULL || pointer == NULL)
+    align = alignment > _Alignof(OafGcObject) ? alignment : _Alignof(OafGcObject);
+    header_size = oaf_align_forward(sizeof(OafGcObject), align);
+    if (size > (size_t)-1 - header_size)
     {
-        return -1;
+        return NULL;
     }
 
-    for (index = 0; index < OAF_GC_MAX_OBJECTS; index++)
+    gc_lock(collector);
+    track_fresh = collector->pause_budget_ns != 0 || collector->background_running;
+    young = collector->nursery_limit != 0 && align <= OAF_GC_NURSERY_MAX_ALIGNMENT && header_size + size <= OAF_GC_NURSERY_CHUNK_SIZE / 4u;
+    if (!collector->enabled
+        || !map_reserve(collector, collector->active_count + 1u)
+        || !reserve_pointers(collector, &collector->objects, &collector->object_capacity, collector->active_count + 1u)
+        || (track_fresh && !reserve_pointers(collector, &collector->fresh, &collector->fresh_capacity, collector->fresh_count + 1u))
+        || (young && !reserve_pointers(collector, &collector->young, &collector->young_capacity, collector->young_count + 1u)))
     {
-        const OafGcObject* object = &collector->objects[index];
-        if (object->active && object->pointer == pointer)
-        {
-            return (int)index;
-        }
+        gc_unlock(collector);
+        return NULL;
+    }
+
+    object = young
+        ? nursery_alloc(collector, header_size + size, align)
+        : (OafGcObject*)oaf_allocator_alloc(collector->allocator, header_size + size, align);
+    if (object == NULL)
+    {
+        gc_unlock(collector);
+        return NULL;
+    }
+
+    object->pointer = (unsigned char*)object + header_size;
+    object->size = size;
+    object->external_refs = 0;
+    object->index = collector->active_count;
+    object->root_index = OAF_GC_NOT_ROOT;
+    object->young_index = OAF_GC_NOT_ROOT;
+    object->remembered_index = OAF_GC_NOT_ROOT;
+    object->chunk = young ? collector->nursery_chunk : NULL;
+    object->children = NULL;
+    object->child_count = 0;
+    object->child_capacity = 0;
+    object->child_index = NULL;
+    object->child_index_capacity = 0;
+    atomic_init(&object->mark_epoch, collector->phase != OAF_GC_PHASE_IDLE ? collector->mark_epoch : 0);
+    object->flags = 0;
+    if (young)
+    {
+        object->flags |= OAF_GC_FLAG_YOUNG;
+        object->young_index = collector->young_count;
+        collector->young[collector->young_count++] = object;
+        collector->young_bytes += size;
+    }
+
+    collector->objects[collector->active_count] = object;
+    collector->active_count++;
+    collector->managed_bytes += size;
+    map_put(collector, object);
+    if (track_fresh)
+    {
+        collector->fresh[collector->fresh_count++] = object;
     }
 
-    return -1;
+    gc_unlock(collector);
+    return object->pointer;
 }
 
-static int find_free_index(const OafGarbageCollector* collector)
+int oaf_gc_retain(OafGarbageCollector* collector, void* pointer)
 {
-    size_t index;
+    OafGcObject* object;
+    int ok = 0;
 
     if (collector == NULL)
     {
-        return -1;
+        return 0;
     }
 
-    for (index = 0; index < OAF_GC_MAX_OBJECTS; index++)
+    gc_lock(collector);
+    object = map_find(collector, pointer);
+    if (object != NULL && (object->external_refs > 0 || add_root(collector, object)))
     {
-        if (!collector->objects[index].active)
+        object->external_refs++;
+        if (collector->phase == OAF_GC_PHASE_MARKING)
         {
-            return (int)index;
+            shade(collector, object);
         }
+        ok = 1;
     }
 
-    return -1;
+    gc_unlock(collector);
+    return ok;
 }
 
-static void clear_edges_for_index(OafGarbageCollector* collector, int index)
+int oaf_gc_release(OafGarbageCollector* collector, void* pointer)
 {
-    size_t column;
-    size_t row;
+    OafGcObject* object;
+    int ok = 0;
 
-    for (column = 0; column < OAF_GC_MAX_OBJECTS; column++)
+    if (collector == NULL)
     {
-        collector->edges[(size_t)index][column] = 0;
+        return 0;
     }
 
-    for (row = 0; row < OAF_GC_MAX_OBJECTS; row++)
+    gc_lock(collector);
+    object = map_find(collector, pointer);
+    if (object != NULL && object->external_refs > 0)
     {
-        collector->edges[row][(size_t)index] = 0;
+        object->external_refs--;
+        if (object->external_refs == 0)
+        {
+            remove_root(collector, object);
+        }
+        ok = 1;
     }
+
+    gc_unlock(collector);
+    return ok;
 }
 
-static void mark_reachable(OafGarbageCollector* collector, int index)
+static size_t child_slot(const OafGcObject* source, const OafGcObject* target)
 {
-    size_t child;
-    OafGcObject* object;
+    uint64_t hash = ((uint64_t)(uintptr_t)target >> 4) * 0x9E3779B97F4A7C15ull;
+
+    return (size_t)(hash >> 32) & (source->child_index_capacity - 1u);
+}
 
-    object = &collector->objects[(size_t)index];
-    if (!object->active || object->marked)
+/* Slot in child_index holding position + 1 of target, or the empty slot that ends its probe run. */
+static size_t child_index_probe(const OafGcObject* source, const OafGcObject* target)
+{
+    size_t mask = source->child_index_capacity - 1u;
+    size_t slot = child_slot(source, target);
+
+    while (source->child_index[slot] != 0 && source->children[source->child_index[slot] - 1u] != target)
     {
-        return;
+        slot = (slot + 1u) & mask;
     }
 
-    object->marked = 1;
+    return slot;
+}
+
+static size_t find_child(const OafGcObject* source, const OafGcObject* target)
+{
+    size_t index;
+
+    if (source->child_index != NULL)
+    {
+        index = source->child_index[child_index_probe(source, target)];
+        return index == 0 ? OAF_GC_NOT_ROOT : index - 1u;
+    }
 
-    for (child = 0; child < OAF_GC_MAX_OBJECTS; child++)
+    for (index = 0; index < source->child_count; index++)
     {
-        if (collector->edges[(size_t)index][child] != 0)
+        if (source->children[index] == target)
         {
-            mark_reachable(collector, (int)child);
+            return index;
         }
     }
+
+    return OAF_GC_NOT_ROOT;
 }
 
-static int dfs_cycle(const OafGarbageCollector* collector, int index, unsigned char* state)
+/* Sized to stay at most half full for child_capacity edges and rebuilt from children. */
+static int rebuild_child_index(OafGarbageCollector* collector, OafGcObject* source)
 {
-    size_t child;
+    size_t capacity = OAF_GC_CHILD_INDEX_THRESHOLD * 2u;
+    size_t* entries;
+    size_t index;
 
-    state[(size_t)index] = 1;
+    while (capacity < source->child_capacity * 2u)
+    {
+        capacity *= 2u;
+    }
+
+    entries = (size_t*)oaf_allocator_alloc(collector->allocator, capacity * sizeof(size_t), _Alignof(size_t));
+    if (entries == NULL)
+    {
+        return 0;
+    }
+
+    memset(entries, 0, capacity * sizeof(size_t));
+    if (source->child_index != NULL)
+    {
+        oaf_allocator_free(collector->allocator, source->child_index);
+    }
+
+    source->child_index = entries;
+    source->child_index_capacity = capacity;
+    for (index = 0; index < source->child_count; index++)
+    {
+        source->child_index[child_index_probe(source, source->children[index])] = index + 1u;
+    }
+
+    return 1;
+}
+
+/* Small out-degrees are scanned; past OAF_GC_CHILD_INDEX_THRESHOLD edges each object keeps a position index. */
+static int add_child(OafGarbageCollector* collector, OafGcObject* source, OafGcObject* target)
+{
+    if (find_child(source, target) != OAF_GC_NOT_ROOT)
+    {
+        return 1;
+    }
 
-    for (child = 0; child < OAF_GC_MAX_OBJECTS; child++)
+    if (source->child_count == source->child_capacity)
     {
-        if (!collector->objects[child].active || collector->edges[(size_t)index][child] == 0)
+        size_t capacity = source->child_capacity == 0 ? OAF_GC_INITIAL_CHILDREN : source->child_capacity * 2u;
+        OafGcObject** children = (OafGcObject**)oaf_allocator_realloc(
+            collector->allocator,
+            source->children,
+            source->child_capacity * sizeof(OafGcObject*),
+            capacity * sizeof(OafGcObject*),
+            _Alignof(OafGcObject*));
+
+        if (children == NULL)
         {
-            continue;
+            return 0;
         }
 
-        if (state[child] == 1)
+        source->children = children;
+        source->child_capacity = capacity;
+    }
+
+    if ((source->child_index != NULL || source->child_count + 1u >= OAF_GC_CHILD_INDEX_THRESHOLD)
+        && source->child_index_capacity < source->child_capacity * 2u
+        && !rebuild_child_index(collector, source))
+    {
+        return 0;
+    }
+
+    source->children[source->child_count] = target;
+    if (source->child_index != NULL)
+    {
+        source->child_index[child_index_probe(source, target)] = source->child_count + 1u;
+    }
+    source->child_count++;
+    return 1;
+}
+
+static void remove_child(OafGcObject* source, size_t position)
+{
+    size_t last = source->child_count - 1u;
+
+    if (source->child_index != NULL)
+    {
+        size_t mask = source->child_index_capacity - 1u;
+        size_t slot = child_index_probe(source, source->children[position]);
+        size_t next = (slot + 1u) & mask;
+
+        while (source->child_index[next] != 0)
         {
-            return 1;
+            size_t home = child_slot(source, source->children[source->child_index[next] - 1u]);
+
+            if (((next - home) & mask) >= ((next - slot) & mask))
+            {
+                source->child_index[slot] = source->child_index[next];
+                slot = next;
+            }
+
+            next = (next + 1u) & mask;
         }
 
-        if (state[child] == 0 && dfs_cycle(collector, (int)child, state))
+        source->child_index[slot] = 0;
+        if (position != last)
         {
-            return 1;
+            source->child_index[child_index_probe(source, source->children[last])] = position + 1u;
         }
     }
 
-    state[(size_t)index] = 2;
-    return 0;
+    source->children[position] = source->children[last];
+    source->child_count = last;
 }
 
-int oaf_gc_init(OafGarbageCollector* collector, OafAllocator* allocator, int enabled)
+int oaf_gc_add_reference(OafGarbageCollector* collector, void* from, void* to)
 {
-    size_t index;
-    size_t edge_index;
+    OafGcObject* source;
+    OafGcObject* target;
+    int remember;
+    int ok = 0;
 
-    if (collector == NULL || allocator == NULL)
+    if (collector == NULL)
     {
         return 0;
     }
 
-    collector->allocator = allocator;
-    collector->active_count = 0;
-    collector->managed_bytes = 0;
-    collector->enabled = enabled != 0;
-
-    for (index = 0; index < OAF_GC_MAX_OBJECTS; index++)
+    gc_lock(collector);
+    source = map_find(collector, from);
+    target = map_find(collector, to);
+    remember = source != NULL && target != NULL
+        && (source->flags & OAF_GC_FLAG_YOUNG) == 0
+        && (target->flags & OAF_GC_FLAG_YOUNG) != 0
+        && source->remembered_index == OAF_GC_NOT_ROOT;
+    if (source != NULL && target != NULL
+        && (!remember || reserve_pointers(collector, &collector->remembered, &collector->remembered_capacity, collector->remembered_count + 1u))
+        && add_child(collector, source, target))
     {
-        collector->objects[index].pointer = NULL;
-        collector->objects[index].size = 0;
-        collector->objects[index].external_refs = 0;
-        collector->objects[index].marked = 0;
-        collector->objects[index].active = 0;
+        if (remember)
+        {
+            source->remembered_index = collector->remembered_count;
+            collector->remembered[collector->remembered_count++] = source;
+        }
 
-        for (edge_index = 0; edge_index < OAF_GC_MAX_OBJECTS; edge_index++)
+        if (collector->phase == OAF_GC_PHASE_MARKING)
         {
-            collector->edges[index][edge_index] = 0;
+            shade(collector, target);
         }
+        ok = 1;
     }
 
-    return 1;
+    gc_unlock(collector);
+    return ok;
 }
 
-void oaf_gc_destroy(OafGarbageCollector* collector)
+int oaf_gc_remove_reference(OafGarbageCollector* collector, void* from, void* to)
 {
+    OafGcObject* source;
+    OafGcObject* target;
     size_t index;
+    int ok = 0;
 
-    if (collector == NULL || collector->allocator == NULL)
+    if (collector == NULL)
     {
-        return;
+        return 0;
     }
 
-    for (index = 0; index < OAF_GC_MAX_OBJECTS; index++)
+    gc_lock(collector);
+    source = map_find(collector, from);
+    target = map_find(collector, to);
+    if (source != NULL && target != NULL)
     {
-        OafGcObject* object = &collector->objects[index];
-
-        if (!object->active)
+        index = find_child(source, target);
+        if (index != OAF_GC_NOT_ROOT)
         {
-            continue;
+            remove_child(source, index);
         }
 
-        oaf_allocator_free(collector->allocator, object->pointer);
-        object->pointer = NULL;
-        object->size = 0;
-        object->external_refs = 0;
-        object->marked = 0;
-        object->active = 0;
+        if (collector->phase == OAF_GC_PHASE_MARKING)
+        {
+            shade(collector, target);
+        }
+        ok = 1;
     }
 
-    collector->active_count = 0;
-    collector->managed_bytes = 0;
+    gc_unlock(collector);
+    return ok;
 }
 
-void oaf_gc_set_enabled(OafGarbageCollector* collector, int enabled)
+size_t oaf_gc_collect(OafGarbageCollector* collector)
 {
+    uint64_t started;
+    size_t collected = 0;
+
     if (collector == NULL)
     {
-        return;
+        return 0;
     }
 
-    collector->enabled = enabled != 0;
-}
+    gc_lock(collector);
+    if (!collector->enabled)
+    {
+        gc_unlock(collector);
+        return 0;
+    }
 
-void* oaf_gc_alloc(OafGarbageCollector* collector, size_t size, size_t alignment)
-{
-    int index;
-    void* pointer;
-    OafGcObject* object;
+    started = gc_now_ns();
+    if (collector->phase == OAF_GC_PHASE_MARKING)
+    {
+        mark_some(collector, 0);
+    }
 
-    if (collector == NULL || collector->allocator == NULL || !collector->enabled)
+    if (collector->phase == OAF_GC_PHASE_SWEEPING)
     {
-        return NULL;
+        sweep_some(collector, 0, &collected);
     }
 
-    index = find_free_index(collector);
-    if (index < 0)
+    collector->fresh_count = 0;
+    if (begin_cycle(collector))
     {
-        return NULL;
+        mark_parallel(collector);
+        mark_some(collector, 0);
+        sweep_some(collector, 0, &collected);
     }
 
-    pointer = oaf_allocator_alloc(collector->allocator, size, alignment);
-    if (pointer == NULL)
+    record_pause(collector, gc_now_ns() - started);
+    gc_unlock(collector);
+    return collected;
+}
+
+void oaf_gc_set_pause_budget(OafGarbageCollector* collector, uint64_t budget_ns)
+{
+    if (collector == NULL)
     {
-        return NULL;
+        return;
     }
 
-    object = &collector->objects[(size_t)index];
-    object->pointer = pointer;
-    object->size = size;
-    object->external_refs = 0;
-    object->marked = 0;
-    object->active = 1;
-    clear_edges_for_index(collector, index);
-    collector->active_count++;
-    collector->managed_bytes += size;
-    return pointer;
+    gc_lock(collector);
+    collector->pause_budget_ns = budget_ns;
+    gc_unlock(collector);
 }
 
-int oaf_gc_retain(OafGarbageCollector* collector, void* pointer)
+size_t oaf_gc_step(OafGarbageCollector* collector)
 {
-    int index = find_object_index(collector, pointer);
-    if (index < 0)
+    size_t collected;
+
+    if (collector == NULL)
     {
         return 0;
     }
 
-    collector->objects[(size_t)index].external_refs++;
-    return 1;
+    gc_lock(collector);
+    collected = step_locked(collector);
+    gc_unlock(collector);
+    return collected;
 }
 
-int oaf_gc_release(OafGarbageCollector* collector, void* pointer)
+int oaf_gc_is_collecting(const OafGarbageCollector* collector)
 {
-    int index = find_object_index(collector, pointer);
-    OafGcObject* object;
+    int collecting;
+
+    if (collector == NULL)
+    {
+        return 0;
+    }
+
+    gc_lock(collector);
+    collecting = collector->phase != OAF_GC_PHASE_IDLE;
+    gc_unlock(collector);
+    return collecting;
+}
 
-    if (index < 0)
+int oaf_gc_start_background(OafGarbageCollector* collector, uint64_t interval_ns)
+{
+    if (collector == NULL || collector->allocator == NULL)
     {
         return 0;
     }
 
-    object = &collector->objects[(size_t)index];
-    if (object->external_refs == 0)
+    if (collector->background_running)
+    {
+        return 1;
+    }
+
+    collector->background_interval_ns = interval_ns != 0 ? interval_ns : OAF_GC_BACKGROUND_INTERVAL_NS;
+    collector->background_stop = 0;
+    collector->background_running = 1;
+    if (pthread_create(&collector->background_thread, NULL, background_main, collector) != 0)
     {
+        collector->background_running = 0;
         return 0;
     }
 
-    object->external_refs--;
     return 1;
 }
 
-int oaf_gc_add_reference(OafGarbageCollector* collector, void* from, void* to)
+void oaf_gc_stop_background(OafGarbageCollector* collector)
+{
+    if (collector == NULL || !collector->background_running)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&collector->mutex);
+    collector->background_stop = 1;
+    pthread_cond_signal(&collector->background_wake);
+    pthread_mutex_unlock(&collector->mutex);
+    pthread_join(collector->background_thread, NULL);
+    collector->background_running = 0;
+}
+
+void oaf_gc_pause_histogram(const OafGarbageCollector* collector, OafGcPauseHistogram* out_histogram)
+{
+    if (collector == NULL || out_histogram == NULL)
+    {
+        return;
+    }
+
+    gc_lock(collector);
+    *out_histogram = collector->pauses;
+    gc_unlock(collector);
+}
+
+uint64_t oaf_gc_pause_percentile_ns(const OafGarbageCollector* collector, double percentile)
 {
-    int from_index = find_object_index(collector, from);
-    int to_index = find_object_index(collector, to);
+    OafGcPauseHistogram histogram;
+    uint64_t target;
+    uint64_t seen = 0;
+    size_t bucket;
 
-    if (from_index < 0 || to_index < 0)
+    if (collector == NULL)
     {
         return 0;
     }
 
-    collector->edges[(size_t)from_index][(size_t)to_index] = 1;
-    return 1;
+    oaf_gc_pause_histogram(collector, &histogram);
+    if (histogram.count == 0)
+    {
+        return 0;
+    }
+
+    percentile = percentile < 0.0 ? 0.0 : (percentile > 1.0 ? 1.0 : percentile);
+    target = (uint64_t)(percentile * (double)histogram.count + 0.999999);
+    target = target == 0 ? 1 : target;
+    for (bucket = 0; bucket < OAF_GC_PAUSE_BUCKETS; bucket++)
+    {
+        seen += histogram.buckets[bucket];
+        if (seen >= target)
+        {
+            uint64_t upper = 1000ull << bucket;
+            return upper < histogram.max_ns ? upper : histogram.max_ns;
+        }
+    }
+
+    return histogram.max_ns;
 }
 
-int oaf_gc_remove_reference(OafGarbageCollector* collector, void* from, void* to)
+void oaf_gc_set_nursery_size(OafGarbageCollector* collector, size_t bytes)
+{
+    if (collector == NULL)
+    {
+        return;
+    }
+
+    gc_lock(collector);
+    collector->nursery_limit = bytes;
+    gc_unlock(collector);
+}
+
+int oaf_gc_nursery_full(const OafGarbageCollector* collector)
 {
-    int from_index = find_object_index(collector, from);
-    int to_index = find_object_index(collector, to);
+    int full;
 
-    if (from_index < 0 || to_index < 0)
+    if (collector == NULL)
     {
         return 0;
     }
 
-    collector->edges[(size_t)from_index][(size_t)to_index] = 0;
-    return 1;
+    gc_lock(collector);
+    full = collector->nursery_limit != 0 && collector->young_bytes >= collector->nursery_limit;
+    gc_unlock(collector);
+    return full;
 }
 
-size_t oaf_gc_collect(OafGarbageCollector* collector)
+size_t oaf_gc_collect_minor(OafGarbageCollector* collector)
 {
-    size_t index;
+    uint64_t started;
     size_t collected = 0;
+    size_t index;
 
-    if (collector == NULL || !collector->enabled)
+    if (collector == NULL)
     {
         return 0;
     }
 
-    for (index = 0; index < OAF_GC_MAX_OBJECTS; index++)
+    gc_lock(collector);
+    if (!collector->enabled || collector->phase != OAF_GC_PHASE_IDLE || collector->young_count == 0
+        || !reserve_pointers(collector, &collector->mark_stack, &collector->mark_stack_capacity, collector->young_count))
     {
-        collector->objects[index].marked = 0;
+        gc_unlock(collector);
+        return 0;
     }
 
-    for (index = 0; index < OAF_GC_MAX_OBJECTS; index++)
+    started = gc_now_ns();
+    next_epoch(collector);
+    collector->mark_depth = 0;
+    for (index = 0; index < collector->root_count; index++)
     {
-        const OafGcObject* object = &collector->objects[index];
-        if (object->active && object->external_refs > 0)
+        if ((collector->roots[index]->flags & OAF_GC_FLAG_YOUNG) != 0)
         {
-            mark_reachable(collector, (int)index);
+            shade(collector, collector->roots[index]);
         }
     }
 
-    for (index = 0; index < OAF_GC_MAX_OBJECTS; index++)
+    for (index = 0; index < collector->remembered_count; index++)
     {
-        OafGcObject* object = &collector->objects[index];
+        OafGcObject* source = collector->remembered[index];
+        size_t child;
 
-        if (!object->active || object->marked)
+        for (child = 0; child < source->child_count; child++)
         {
-            continue;
+            if ((source->children[child]->flags & OAF_GC_FLAG_YOUNG) != 0)
+            {
+                shade(collector, source->children[child]);
+            }
         }
+        source->remembered_index = OAF_GC_NOT_ROOT;
+    }
+    collector->remembered_count = 0;
 
-        oaf_allocator_free(collector->allocator, object->pointer);
-        clear_edges_for_index(collector, (int)index);
-        if (collector->managed_bytes >= object->size)
-        {
-            collector->managed_bytes -= object->size;
-        }
-        else
+    while (collector->mark_depth > 0)
+    {
+        OafGcObject* object = collector->mark_stack[--collector->mark_depth];
+        size_t child;
+
+        for (child = 0; child < object->child_count; child++)
         {
-            collector->managed_bytes = 0;
+            if ((object->children[child]->flags & OAF_GC_FLAG_YOUNG) != 0)
+            {
+                shade(collector, object->children[child]);
+            }
         }
+    }
 
-        object->pointer = NULL;
-        object->size = 0;
-        object->external_refs = 0;
-        object->marked = 0;
-        object->active = 0;
+    index = collector->young_count;
+    while (index > 0)
+    {
+        OafGcObject* object = collector->young[--index];
 
-        if (collector->active_count > 0)
+        if (object_epoch(object) != collector->mark_epoch)
         {
-            collector->active_count--;
+            unlink_object(collector, object);
+            free_object(collector, object);
+            collected++;
+            continue;
         }
-        collected++;
+
+        object->flags &= ~OAF_GC_FLAG_YOUNG;
+        object->young_index = OAF_GC_NOT_ROOT;
+        collector->promoted_objects++;
+        collector->promoted_bytes += object->size;
+    }
+
+    collector->young_count = 0;
+    collector->young_bytes = 0;
+    collector->fresh_count = 0;
+    /* Keep bumping into the current chunk; its lines freed here are picked up as holes behind the bump range. */
+    if (collector->nursery_chunk != NULL && collector->nursery_chunk->live_objects == 0)
+    {
+        collector->nursery_chunk->offset = 0;
+        collector->nursery_chunk->limit = collector->nursery_chunk->capacity;
     }
 
+    collector->minor_collections++;
+    record_pause(collector, gc_now_ns() - started);
+    gc_unlock(collector);
     return collected;
 }
 
-int oaf_gc_detect_cycles(const OafGarbageCollector* collector)
+void oaf_gc_generation_stats(const OafGarbageCollector* collector, OafGcGenerationStats* out_stats)
 {
-    unsigned char state[OAF_GC_MAX_OBJECTS];
-    size_t index;
+    if (collector == NULL || out_stats == NULL)
+    {
+        return;
+    }
 
-    if (collector == NULL)
+    gc_lock(collector);
+    out_stats->young_objects = collector->young_count;
+    out_stats->young_bytes = collector->young_bytes;
+    out_stats->old_objects = collector->active_count - collector->young_count;
+    out_stats->old_bytes = collector->managed_bytes - collector->young_bytes;
+    out_stats->remembered_objects = collector->remembered_count;
+    out_stats->minor_collections = collector->minor_collections;
+    out_stats->promoted_objects = collector->promoted_objects;
+    out_stats->promoted_bytes = collector->promoted_bytes;
+    out_stats->nursery_chunk_bytes = collector->nursery_chunks * OAF_GC_NURSERY_CHUNK_SIZE;
+    gc_unlock(collector);
+}
+
+int oaf_gc_set_mark_workers(OafGarbageCollector* collector, size_t worker_count)
+{
+    int ok;
+
+    if (collector == NULL || worker_count > OAF_GC_MAX_MARK_WORKERS)
     {
         return 0;
     }
 
-    for (index = 0; index < OAF_GC_MAX_OBJECTS; index++)
+    gc_lock(collector);
+    mark_team_destroy(collector);
+    ok = worker_count <= 1 || mark_team_create(collector, worker_count);
+    gc_unlock(collector);
+    return ok;
+}
+
+size_t oaf_gc_mark_workers(const OafGarbageCollector* collector)
+{
+    size_t workers;
+
+    if (collector == NULL)
     {
-        state[index] = 0;
+        return 0;
     }
 
-    for (index = 0; index < OAF_GC_MAX_OBJECTS; index++)
-    {
-        if (!collector->objects[index].active || state[index] != 0)
-        {
-            continue;
-        }
+    gc_lock(collector);
+    workers = collector->mark_team != NULL ? collector->mark_team->worker_count : 1;
+    gc_unlock(collector);
+    return workers;
+}
 
-        if (dfs_cycle(collector, (int)index, state))
-        {
-            return 1;
-        }
+int oaf_gc_detect_cycles(const OafGarbageCollector* collector)
+{
+    int found;
+
+    if (collector == NULL)
+    {
+        return 0;
     }
 
-    return 0;
+    gc_lock(collector);
+    found = detect_cycles_locked(collector);
+    gc_unlock(collector);
+    return found;
 }
 
 size_t oaf_gc_object_count(const OafGarbageCollector* collector)
 {
+    size_t count;
+
     if (collector == NULL)
     {
         return 0;
     }
 
-    return collector->active_count;
+    gc_lock(collector);
+    count = collector->active_count;
+    gc_unlock(collector);
+    return count;
 }
 
 size_t oaf_gc_managed_bytes(const OafGarbageCollector* collector)
 {
+    size_t bytes;
+
     if (collector == NULL)
     {
         return 0;
     }
 
-    return collector->managed_bytes;
+    gc_lock(collector);
+    bytes = collector->managed_bytes;
+    gc_unlock(collector);
+    return bytes;
 }
@@ -1,145 +1,417 @@
+#include <stdlib.h>
+#include <string.h>
 #include "leak_detector.h"
 
-static OafLeakRecord* find_record(OafLeakDetector* detector, void* pointer)
+#define OAF_LEAK_NO_SITE UINT32_MAX
+
+static size_t record_slot(const OafLeakDetector* detector, const void* pointer)
 {
-    size_t index;
+    uint64_t hash = (uint64_t)(uintptr_t)pointer * 0x9E3779B97F4A7C15ull;
+    return (size_t)(hash >> 32) & (detector->record_capacity - 1u);
+}
 
-    if (detector == NULL || pointer == NULL)
+static OafLeakRecord* find_record(const OafLeakDetector* detector, const void* pointer)
+{
+    size_t slot;
+
+    if (detector->record_capacity == 0)
     {
         return NULL;
     }
 
-    for (index = 0; index < OAF_LEAK_DETECTOR_MAX_RECORDS; index++)
+    slot = record_slot(detector, pointer);
+    while (detector->records[slot].pointer != NULL)
     {
-        OafLeakRecord* record = &detector->records[index];
-
-        if (record->active && record->pointer == pointer)
+        if (detector->records[slot].pointer == pointer)
         {
-            return record;
+            return &detector->records[slot];
         }
+
+        slot = (slot + 1u) & (detector->record_capacity - 1u);
     }
 
     return NULL;
 }
 
-static OafLeakRecord* find_free_slot(OafLeakDetector* detector)
+static void put_record(OafLeakDetector* detector, void* pointer, size_t size, uint32_t site)
 {
-    size_t index;
+    size_t slot = record_slot(detector, pointer);
 
-    if (detector == NULL)
+    while (detector->records[slot].pointer != NULL)
     {
-        return NULL;
+        slot = (slot + 1u) & (detector->record_capacity - 1u);
     }
 
-    for (index = 0; index < OAF_LEAK_DETECTOR_MAX_RECORDS; index++)
+    detector->records[slot].pointer = pointer;
+    detector->records[slot].size = size;
+    detector->records[slot].site = site;
+}
+
+static void remove_record(OafLeakDetector* detector, OafLeakRecord* record)
+{
+    size_t mask = detector->record_capacity - 1u;
+    size_t slot = (size_t)(record - detector->records);
+    size_t next = (slot + 1u) & mask;
+
+    while (detector->records[next].pointer != NULL)
     {
-        OafLeakRecord* record = &detector->records[index];
-        if (!record->active)
+        size_t home = record_slot(detector, detector->records[next].pointer);
+
+        if (((next - home) & mask) >= ((next - slot) & mask))
         {
-            return record;
+            detector->records[slot] = detector->records[next];
+            slot = next;
         }
+
+        next = (next + 1u) & mask;
     }
 
-    return NULL;
+    detector->records[slot].pointer = NULL;
+    detector->records[slot].size = 0;
+    detector->records[slot].site = 0;
+    detector->record_count--;
 }
 
-void oaf_leak_detector_init(OafLeakDetector* detector)
+static int reserve_records(OafLeakDetector* detector, size_t count)
 {
+    OafLeakRecord* old_records = detector->records;
+    size_t old_capacity = detector->record_capacity;
+    size_t capacity;
     size_t index;
 
-    if (detector == NULL)
+    if (count * 2u <= detector->record_capacity)
     {
-        return;
+        return 1;
     }
 
-    detector->active_allocations = 0;
-    detector->active_bytes = 0;
-    detector->peak_bytes = 0;
-    detector->dropped_records = 0;
+    capacity = old_capacity == 0 ? OAF_LEAK_DETECTOR_INITIAL_CAPACITY : old_capacity * 2u;
+    detector->records = (OafLeakRecord*)calloc(capacity, sizeof(OafLeakRecord));
+    if (detector->records == NULL)
+    {
+        detector->records = old_records;
+        return 0;
+    }
 
-    for (index = 0; index < OAF_LEAK_DETECTOR_MAX_RECORDS; index++)
+    detector->record_capacity = capacity;
+    for (index = 0; index < old_capacity; index++)
     {
-        detector->records[index].pointer = NULL;
-        detector->records[index].size = 0;
-        detector->records[index].active = 0;
+        if (old_records[index].pointer != NULL)
+        {
+            put_record(detector, old_records[index].pointer, old_records[index].size, old_records[index].site);
+        }
     }
+
+    free(old_records);
+    return 1;
 }
 
-int oaf_leak_detector_track_alloc(OafLeakDetector* detector, void* pointer, size_t size)
+static uint64_t location_hash(OafSourceLocation location)
 {
-    OafLeakRecord* record;
+    uint64_t hash = 1469598103934665603ull;
+    const char* text = location.file_name;
 
-    if (detector == NULL || pointer == NULL)
+    while (text != NULL && *text != '\0')
+    {
+        hash = (hash ^ (unsigned char)*text++) * 1099511628211ull;
+    }
+
+    hash ^= ((uint64_t)location.line << 32) | location.column;
+    return hash * 0x9E3779B97F4A7C15ull;
+}
+
+static int same_location(OafSourceLocation left, OafSourceLocation right)
+{
+    if (left.line != right.line || left.column != right.column)
     {
         return 0;
     }
 
-    record = find_record(detector, pointer);
-    if (record != NULL)
+    if (left.file_name == right.file_name)
     {
-        detector->active_bytes -= record->size;
-        record->size = size;
-        detector->active_bytes += size;
-        if (detector->active_bytes > detector->peak_bytes)
+        return 1;
+    }
+
+    return left.file_name != NULL && right.file_name != NULL && strcmp(left.file_name, right.file_name) == 0;
+}
+
+static int reserve_sites(OafLeakDetector* detector)
+{
+    uint32_t* slots;
+    size_t capacity;
+    size_t index;
+
+    if (detector->site_count == detector->site_capacity)
+    {
+        size_t site_capacity = detector->site_capacity == 0 ? OAF_LEAK_DETECTOR_INITIAL_SITES : detector->site_capacity * 2u;
+        OafLeakSite* sites = (OafLeakSite*)realloc(detector->sites, site_capacity * sizeof(OafLeakSite));
+
+        if (sites == NULL)
         {
-            detector->peak_bytes = detector->active_bytes;
+            return 0;
         }
+
+        detector->sites = sites;
+        detector->site_capacity = site_capacity;
+    }
+
+    if ((detector->site_count + 1u) * 2u <= detector->site_slot_capacity)
+    {
         return 1;
     }
 
-    record = find_free_slot(detector);
-    if (record == NULL)
+    capacity = detector->site_slot_capacity == 0 ? OAF_LEAK_DETECTOR_INITIAL_SITES * 2u : detector->site_slot_capacity * 2u;
+    slots = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    if (slots == NULL)
     {
-        detector->dropped_records++;
         return 0;
     }
 
-    record->pointer = pointer;
-    record->size = size;
-    record->active = 1;
-    detector->active_allocations++;
-    detector->active_bytes += size;
+    for (index = 0; index < detector->site_count; index++)
+    {
+        size_t slot = (size_t)(location_hash(detector->sites[index].location) >> 32) & (capacity - 1u);
+
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1u) & (capacity - 1u);
+        }
+
+        slots[slot] = (uint32_t)index + 1u;
+    }
 
+    free(detector->site_slots);
+    detector->site_slots = slots;
+    detector->site_slot_capacity = capacity;
+    return 1;
+}
+
+static uint32_t find_site(OafLeakDetector* detector, OafSourceLocation location)
+{
+    size_t slot;
+
+    if (!reserve_sites(detector))
+    {
+        return OAF_LEAK_NO_SITE;
+    }
+
+    slot = (size_t)(location_hash(location) >> 32) & (detector->site_slot_capacity - 1u);
+    while (detector->site_slots[slot] != 0)
+    {
+        uint32_t site = detector->site_slots[slot] - 1u;
+
+        if (same_location(detector->sites[site].location, location))
+        {
+            return site;
+        }
+
+        slot = (slot + 1u) & (detector->site_slot_capacity - 1u);
+    }
+
+    detector->site_slots[slot] = (uint32_t)detector->site_count + 1u;
+    detector->sites[detector->site_count].location = location;
+    detector->sites[detector->site_count].active_allocations = 0;
+    detector->sites[detector->site_count].active_bytes = 0;
+    detector->sites[detector->site_count].total_allocations = 0;
+    return (uint32_t)detector->site_count++;
+}
+
+static int should_sample(OafLeakDetector* detector)
+{
+    uint64_t seed;
+
+    if (detector->sample_rate <= 1u)
+    {
+        return 1;
+    }
+
+    if (--detector->sample_countdown > 0)
+    {
+        return 0;
+    }
+
+    seed = detector->sample_seed;
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    detector->sample_seed = seed;
+    detector->sample_countdown = 1u + (size_t)(seed % (detector->sample_rate * 2u - 1u));
+    return 1;
+}
+
+static void add_bytes(OafLeakDetector* detector, OafLeakSite* site, size_t size)
+{
+    site->active_bytes += size;
+    detector->active_bytes += size;
     if (detector->active_bytes > detector->peak_bytes)
     {
         detector->peak_bytes = detector->active_bytes;
     }
+}
 
+static int insert_record(OafLeakDetector* detector, void* pointer, size_t size, uint32_t site)
+{
+    if (site == OAF_LEAK_NO_SITE || !reserve_records(detector, detector->record_count + 1u))
+    {
+        detector->dropped_records++;
+        return 0;
+    }
+
+    put_record(detector, pointer, size, site);
+    detector->record_count++;
+    detector->active_allocations++;
+    detector->sites[site].active_allocations++;
+    detector->sites[site].total_allocations++;
+    add_bytes(detector, &detector->sites[site], size);
     return 1;
 }
 
-int oaf_leak_detector_track_free(OafLeakDetector* detector, void* pointer)
+static void release_record(OafLeakDetector* detector, OafLeakRecord* record)
 {
-    OafLeakRecord* record;
+    OafLeakSite* site = &detector->sites[record->site];
+
+    detector->active_allocations--;
+    detector->active_bytes -= record->size;
+    site->active_allocations--;
+    site->active_bytes -= record->size;
+    remove_record(detector, record);
+}
+
+static int track_at(OafLeakDetector* detector, void* pointer, size_t size, OafSourceLocation location)
+{
+    OafLeakRecord* record = find_record(detector, pointer);
+
+    if (record != NULL)
+    {
+        OafLeakSite* site = &detector->sites[record->site];
+
+        detector->active_bytes -= record->size;
+        site->active_bytes -= record->size;
+        record->size = size;
+        add_bytes(detector, site, size);
+        return 1;
+    }
+
+    return insert_record(detector, pointer, size, find_site(detector, location));
+}
+
+void oaf_leak_detector_init(OafLeakDetector* detector)
+{
+    if (detector == NULL)
+    {
+        return;
+    }
+
+    memset(detector, 0, sizeof(*detector));
+    detector->sample_rate = 1;
+    detector->sample_seed = 0x9E3779B97F4A7C15ull ^ (uint64_t)(uintptr_t)detector;
+}
+
+void oaf_leak_detector_destroy(OafLeakDetector* detector)
+{
+    if (detector == NULL)
+    {
+        return;
+    }
+
+    free(detector->records);
+    free(detector->sites);
+    free(detector->site_slots);
+    oaf_leak_detector_init(detector);
+}
+
+void oaf_leak_detector_set_sample_rate(OafLeakDetector* detector, size_t sample_rate)
+{
+    if (detector == NULL)
+    {
+        return;
+    }
+
+    detector->sample_rate = sample_rate == 0 ? 1 : sample_rate;
+    detector->sample_countdown = 1;
+}
+
+void oaf_leak_detector_set_site_provider(OafLeakDetector* detector, OafLeakSiteProc proc, void* state)
+{
+    if (detector == NULL)
+    {
+        return;
+    }
+
+    detector->site_proc = proc;
+    detector->site_state = state;
+}
+
+int oaf_leak_detector_track_alloc(OafLeakDetector* detector, void* pointer, size_t size)
+{
+    OafSourceLocation location = {NULL, 0, 0};
 
     if (detector == NULL || pointer == NULL)
     {
         return 0;
     }
 
-    record = find_record(detector, pointer);
-    if (record == NULL)
+    if (!should_sample(detector))
+    {
+        return 1;
+    }
+
+    if (detector->site_proc != NULL)
+    {
+        location = detector->site_proc(detector->site_state);
+    }
+
+    return track_at(detector, pointer, size, location);
+}
+
+int oaf_leak_detector_track_alloc_at(OafLeakDetector* detector, void* pointer, size_t size, OafSourceLocation location)
+{
+    if (detector == NULL || pointer == NULL)
     {
         return 0;
     }
 
-    if (detector->active_allocations > 0)
+    return !should_sample(detector) || track_at(detector, pointer, size, location);
+}
+
+int oaf_leak_detector_track_realloc(OafLeakDetector* detector, void* old_pointer, void* new_pointer, size_t size)
+{
+    OafLeakRecord* record;
+    uint32_t site;
+
+    if (detector == NULL || new_pointer == NULL)
     {
-        detector->active_allocations--;
+        return 0;
     }
 
-    if (detector->active_bytes >= record->size)
+    record = old_pointer != NULL ? find_record(detector, old_pointer) : NULL;
+    if (record == NULL)
     {
-        detector->active_bytes -= record->size;
+        return old_pointer == NULL || detector->sample_rate <= 1u
+            ? oaf_leak_detector_track_alloc(detector, new_pointer, size)
+            : 1;
+    }
+
+    site = record->site;
+    release_record(detector, record);
+    detector->sites[site].total_allocations--;
+    return insert_record(detector, new_pointer, size, site);
+}
+
+int oaf_leak_detector_track_free(OafLeakDetector* detector, void* pointer)
+{
+    OafLeakRecord* record;
+
+    if (detector == NULL || pointer == NULL)
+    {
+        return 0;
     }
-    else
+
+    record = find_record(detector, pointer);
+    if (record == NULL)
     {
-        detector->active_bytes = 0;
+        return 0;
     }
 
-    record->active = 0;
-    record->pointer = NULL;
-    record->size = 0;
+    release_record(detector, record);
     return 1;
 }
 
@@ -182,3 +454,136 @@ int oaf_leak_detector_has_leaks(const OafLeakDetector* detector)
 
     return detector->active_allocations > 0;
 }
+
+static int compare_sites(const void* left, const void* right)
+{
+    const OafLeakSite* a = (const OafLeakSite*)left;
+    const OafLeakSite* b = (const OafLeakSite*)right;
+
+    if (a->active_bytes != b->active_bytes)
+    {
+        return a->active_bytes > b->active_bytes ? -1 : 1;
+    }
+
+    return a->active_allocations > b->active_allocations ? -1 : a->active_allocations < b->active_allocations;
+}
+
+size_t oaf_leak_detector_report(const OafLeakDetector* detector, OafLeakSite* out_sites, size_t capacity)
+{
+    OafLeakSite* leaking;
+    size_t count = 0;
+    size_t index;
+
+    if (detector == NULL || detector->site_count == 0)
+    {
+        return 0;
+    }
+
+    leaking = (OafLeakSite*)malloc(detector->site_count * sizeof(OafLeakSite));
+    if (leaking == NULL)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < detector->site_count; index++)
+    {
+        if (detector->sites[index].active_allocations > 0)
+        {
+            leaking[count++] = detector->sites[index];
+        }
+    }
+
+    qsort(leaking, count, sizeof(OafLeakSite), compare_sites);
+    if (out_sites != NULL)
+    {
+        memcpy(out_sites, leaking, (count < capacity ? count : capacity) * sizeof(OafLeakSite));
+    }
+
+    free(leaking);
+    return count;
+}
+
+static size_t append_text(char* buffer, size_t capacity, size_t offset, const char* text)
+{
+    while (*text != '\0' && offset + 1u < capacity)
+    {
+        buffer[offset++] = *text++;
+    }
+
+    buffer[offset] = '\0';
+    return offset;
+}
+
+static size_t append_uint(char* buffer, size_t capacity, size_t offset, size_t value)
+{
+    char digits[32];
+    size_t length = 0;
+
+    do
+    {
+        digits[length++] = (char)('0' + value % 10u);
+        value /= 10u;
+    } while (value > 0);
+
+    while (length > 0 && offset + 1u < capacity)
+    {
+        buffer[offset++] = digits[--length];
+    }
+
+    buffer[offset] = '\0';
+    return offset;
+}
+
+int oaf_leak_detector_format_report(const OafLeakDetector* detector, char* buffer, size_t capacity)
+{
+    OafLeakSite* sites;
+    size_t count;
+    size_t offset = 0;
+    size_t index;
+
+    if (detector == NULL || buffer == NULL || capacity == 0)
+    {
+        return 0;
+    }
+
+    buffer[0] = '\0';
+    offset = append_uint(buffer, capacity, offset, detector->active_bytes);
+    offset = append_text(buffer, capacity, offset, " byte(s) leaked in ");
+    offset = append_uint(buffer, capacity, offset, detector->active_allocations);
+    offset = append_text(buffer, capacity, offset, " allocation(s)");
+    if (detector->sample_rate > 1u)
+    {
+        offset = append_text(buffer, capacity, offset, ", sampled 1 in ");
+        offset = append_uint(buffer, capacity, offset, detector->sample_rate);
+    }
+
+    count = oaf_leak_detector_report(detector, NULL, 0);
+    if (count == 0)
+    {
+        return 1;
+    }
+
+    sites = (OafLeakSite*)malloc(count * sizeof(OafLeakSite));
+    if (sites == NULL)
+    {
+        return 0;
+    }
+
+    oaf_leak_detector_report(detector, sites, count);
+    for (index = 0; index < count; index++)
+    {
+        offset = append_text(buffer, capacity, offset, "\n  ");
+        offset = append_uint(buffer, capacity, offset, sites[index].active_bytes);
+        offset = append_text(buffer, capacity, offset, " byte(s) in ");
+        offset = append_uint(buffer, capacity, offset, sites[index].active_allocations);
+        offset = append_text(buffer, capacity, offset, " allocation(s) at ");
+        offset = append_text(buffer, capacity, offset, sites[index].location.file_name == NULL ? "<unknown>" : sites[index].location.file_name);
+        offset = append_text(buffer, capacity, offset, ":");
+        offset = append_uint(buffer, capacity, offset, sites[index].location.line);
+        offset = append_text(buffer, capacity, offset, ":");
+        offset = append_uint(buffer, capacity, offset, sites[index].location.column);
+    }
+
+    free(sites);
+    return 1;
+}
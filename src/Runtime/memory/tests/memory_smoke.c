@@ -1,10 +1,20 @@
 #include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
 #include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 #include "allocator.h"
 #include "default_allocator.h"
 #include "arena_allocator.h"
 #include "pool_allocator.h"
 #include "temp_allocator.h"
+#include "thread_cache_allocator.h"
+#include "heap_profiler_allocator.h"
 #include "ownership.h"
 #include "lifetime.h"
 #include "bounds.h"
@@ -52,6 +62,159 @@ static int test_arena_allocator(void)
     return ok;
 }
 
+static void* temp_thread_main(void* argument)
+{
+    OafTempAllocatorState* state = oaf_temp_allocator_thread_local();
+    OafAllocator allocator;
+
+    if (state == NULL || state == (OafTempAllocatorState*)argument || state != oaf_temp_allocator_thread_local())
+    {
+        return NULL;
+    }
+
+    oaf_temp_allocator_as_allocator(state, &allocator);
+    size_t mark = oaf_temp_allocator_mark(state);
+    unsigned char* scratch = (unsigned char*)oaf_allocator_alloc(&allocator, (size_t)256 * 1024, 16);
+    if (scratch == NULL)
+    {
+        return NULL;
+    }
+
+    memset(scratch, 0x11, (size_t)256 * 1024);
+    return oaf_temp_allocator_reset_to_mark(state, mark) ? state : NULL;
+}
+
+static int test_temp_allocator_nesting_and_threads(void)
+{
+    OafTempAllocatorState state;
+    OafAllocator allocator;
+    void* first_at_depth[2000];
+    pthread_t thread;
+    void* result = NULL;
+
+    if (!oaf_temp_allocator_init(&state, 64))
+    {
+        return 0;
+    }
+
+    oaf_temp_allocator_as_allocator(&state, &allocator);
+
+    int ok = 1;
+    for (size_t depth = 0; ok && depth < 2000; depth++)
+    {
+        ok = oaf_temp_allocator_mark(&state) == depth;
+        first_at_depth[depth] = oaf_allocator_alloc(&allocator, 40, 8);
+        ok = ok && first_at_depth[depth] != NULL;
+    }
+
+    ok = ok && state.mark_count == 2000 && state.arena.chunk_count > 1;
+    ok = ok && oaf_temp_allocator_reset_to_mark(&state, 1500) && state.mark_count == 1500;
+    ok = ok && oaf_temp_allocator_mark(&state) == 1500;
+    ok = ok && oaf_allocator_alloc(&allocator, 40, 8) == first_at_depth[1500];
+    ok = ok && !oaf_temp_allocator_reset_to_mark(&state, 1501);
+
+    unsigned char* grown = (unsigned char*)oaf_allocator_alloc(&allocator, 8, 8);
+    if (grown != NULL)
+    {
+        memset(grown, 0x7E, 8);
+    }
+    grown = (unsigned char*)oaf_allocator_realloc(&allocator, grown, 8, 4096, 8);
+    ok = ok && grown != NULL && grown[7] == 0x7E;
+
+    ok = ok && oaf_temp_allocator_reset_to_mark(&state, 0) && state.mark_count == 0;
+    oaf_temp_allocator_clear(&state);
+    ok = ok && state.arena.chunk_count == 1 && state.arena.offset == 0;
+    oaf_temp_allocator_destroy(&state);
+
+    oaf_temp_allocator_bind_thread(&state);
+    ok = ok && oaf_temp_allocator_thread_local() == &state;
+    ok = ok && pthread_create(&thread, NULL, temp_thread_main, &state) == 0;
+    ok = ok && pthread_join(thread, &result) == 0 && result != NULL;
+    oaf_temp_allocator_bind_thread(NULL);
+
+    OafTempAllocatorState* owned = oaf_temp_allocator_thread_local();
+    ok = ok && owned != NULL && owned != &state && owned == oaf_temp_allocator_thread_local();
+    oaf_temp_allocator_thread_release();
+    return ok;
+}
+
+static int test_growable_arena(void)
+{
+    OafArenaAllocatorState state;
+    OafAllocator allocator;
+
+    if (!oaf_arena_allocator_init(&state, 64))
+    {
+        return 0;
+    }
+
+    oaf_arena_allocator_as_allocator(&state, &allocator);
+
+    int ok = 1;
+    for (size_t i = 0; i < 1000 && ok; i++)
+    {
+        unsigned char* block = (unsigned char*)oaf_allocator_alloc(&allocator, 24, 8);
+        ok = block != NULL && ((uintptr_t)block % 8u) == 0;
+        if (ok)
+        {
+            memset(block, (int)(i & 0xFFu), 24);
+        }
+    }
+
+    ok = ok && state.chunk_count > 1 && state.total_capacity >= 24000;
+
+    unsigned char* aligned = (unsigned char*)oaf_allocator_alloc(&allocator, 100, 256);
+    ok = ok && aligned != NULL && ((uintptr_t)aligned % 256u) == 0;
+
+    OafArenaCheckpoint checkpoint = oaf_arena_allocator_save(&state);
+    size_t chunks_at_checkpoint = state.chunk_count;
+    void* marked = oaf_allocator_alloc(&allocator, 32, 8);
+    for (size_t i = 0; i < 64 && ok; i++)
+    {
+        ok = oaf_allocator_alloc(&allocator, 4096, 16) != NULL;
+    }
+
+    ok = ok && state.chunk_count > chunks_at_checkpoint;
+    oaf_arena_allocator_restore(&state, checkpoint);
+    ok = ok && state.chunk_count == chunks_at_checkpoint && state.spare != NULL;
+    ok = ok && oaf_allocator_alloc(&allocator, 32, 8) == marked;
+
+    unsigned char* grown = (unsigned char*)oaf_allocator_alloc(&allocator, 8, 8);
+    ok = ok && grown != NULL && oaf_allocator_realloc(&allocator, grown, 8, 16, 8) == grown;
+
+    size_t largest = state.spare != NULL && state.spare->capacity > state.capacity ? state.spare->capacity : state.capacity;
+    for (OafArenaChunk* chunk = state.current; chunk != NULL; chunk = chunk->prev)
+    {
+        largest = chunk->capacity > largest ? chunk->capacity : largest;
+    }
+
+    oaf_arena_allocator_reset(&state);
+    ok = ok && state.chunk_count == 1 && state.capacity == largest && state.offset == 0 && state.spare == NULL;
+    ok = ok && oaf_allocator_alloc(&allocator, largest / 2u, 8) != NULL && state.chunk_count == 1;
+    oaf_arena_allocator_destroy(&state);
+
+    if (!oaf_arena_allocator_init_reserved(&state, (size_t)1024 * 1024))
+    {
+        return 0;
+    }
+
+    oaf_arena_allocator_as_allocator(&state, &allocator);
+    size_t initial_commit = state.committed;
+    unsigned char* big = (unsigned char*)oaf_allocator_alloc(&allocator, (size_t)300 * 1024, 64);
+    ok = ok && big != NULL && state.committed > initial_commit && state.committed < state.capacity;
+    if (big != NULL)
+    {
+        memset(big, 0x5A, (size_t)300 * 1024);
+    }
+
+    checkpoint = oaf_arena_allocator_save(&state);
+    ok = ok && oaf_allocator_alloc(&allocator, (size_t)900 * 1024, 16) != NULL && state.chunk_count == 2;
+    oaf_arena_allocator_restore(&state, checkpoint);
+    ok = ok && state.chunk_count == 1 && state.current->reserved_size != 0;
+    oaf_arena_allocator_destroy(&state);
+    return ok;
+}
+
 static int test_pool_allocator(void)
 {
     OafPoolAllocatorState state;
@@ -118,6 +281,212 @@ static int test_temp_allocator(void)
     return ok;
 }
 
+typedef struct RemoteFreeState
+{
+    OafAllocator* allocator;
+    void** blocks;
+    size_t count;
+} RemoteFreeState;
+
+static void* remote_free_main(void* argument)
+{
+    RemoteFreeState* remote = (RemoteFreeState*)argument;
+
+    for (size_t i = 0; i < remote->count; i++)
+    {
+        oaf_allocator_free(remote->allocator, remote->blocks[i]);
+    }
+
+    void* scratch = oaf_allocator_alloc(remote->allocator, 48, 8);
+    oaf_allocator_free(remote->allocator, scratch);
+    return scratch;
+}
+
+static int test_thread_cache_allocator(void)
+{
+    static const size_t sizes[] = {1, 16, 24, 100, 129, 500, 1000, 4096, 5000, 32768, 40000, 1u << 20};
+    static const size_t alignments[] = {1, 8, 16, 64, 256, 4096, 8192};
+    OafThreadCacheAllocatorState state;
+    OafThreadCacheAllocatorStats stats;
+    OafAllocator allocator;
+    void* blocks[256];
+    int ok = 1;
+
+    if (!oaf_thread_cache_allocator_init(&state))
+    {
+        return 0;
+    }
+
+    oaf_thread_cache_allocator_as_allocator(&state, &allocator);
+
+    for (size_t s = 0; ok && s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        for (size_t a = 0; ok && a < sizeof(alignments) / sizeof(alignments[0]); a++)
+        {
+            unsigned char* ptr = (unsigned char*)oaf_allocator_alloc(&allocator, sizes[s], alignments[a]);
+            ok = ptr != NULL
+                && ((uintptr_t)ptr % alignments[a]) == 0
+                && oaf_thread_cache_allocator_usable_size(ptr) >= sizes[s];
+            if (ok)
+            {
+                memset(ptr, 0xA5, sizes[s]);
+            }
+            oaf_allocator_free(&allocator, ptr);
+        }
+    }
+
+    unsigned char* grown = (unsigned char*)oaf_allocator_alloc(&allocator, 16, 8);
+    for (size_t size = 16; ok && grown != NULL && size < 200000; size *= 2)
+    {
+        memset(grown, (int)(size & 0xFF), size);
+        grown = (unsigned char*)oaf_allocator_realloc(&allocator, grown, size, size * 2, 8);
+        ok = grown != NULL && grown[0] == (unsigned char)(size & 0xFF) && grown[size - 1] == (unsigned char)(size & 0xFF);
+    }
+    oaf_allocator_free(&allocator, grown);
+
+    for (size_t i = 0; ok && i < 256; i++)
+    {
+        blocks[i] = oaf_allocator_alloc(&allocator, 48, 8);
+        ok = blocks[i] != NULL;
+    }
+
+    if (ok)
+    {
+        RemoteFreeState remote = {&allocator, blocks, 256};
+        pthread_t thread;
+
+        ok = pthread_create(&thread, NULL, remote_free_main, &remote) == 0;
+        ok = ok && pthread_join(thread, NULL) == 0;
+    }
+
+    oaf_thread_cache_allocator_stats(&state, &stats);
+    ok = ok
+        && stats.active_allocations == 0
+        && stats.allocations == stats.frees
+        && stats.huge_allocations > 0
+        && stats.huge_active_bytes == 0
+        && stats.thread_caches == 2
+        && stats.failed_allocations == 0;
+
+    oaf_thread_cache_allocator_destroy(&state);
+    return ok;
+}
+
+static void* multi_pool_churn_main(void* argument)
+{
+    OafAllocator* allocator = (OafAllocator*)argument;
+    unsigned char* blocks[64];
+    size_t failures = 0;
+
+    for (size_t round = 0; round < 200; round++)
+    {
+        for (size_t i = 0; i < 64; i++)
+        {
+            blocks[i] = (unsigned char*)oaf_allocator_alloc(allocator, 40 + (i & 1u) * 24, 8);
+            if (blocks[i] == NULL)
+            {
+                failures++;
+                continue;
+            }
+            memset(blocks[i], (int)i, 40);
+        }
+
+        for (size_t i = 0; i < 64; i++)
+        {
+            failures += blocks[i] != NULL && blocks[i][39] != (unsigned char)i;
+            oaf_allocator_free(allocator, blocks[i]);
+        }
+    }
+
+    return failures == 0 ? argument : NULL;
+}
+
+static int test_multi_pool_allocator(void)
+{
+    static const size_t bad_sizes[] = {32, 16};
+    OafMultiPoolAllocatorState state;
+    OafAllocator allocator;
+    void* blocks[256];
+    pthread_t threads[4];
+    int ok = !oaf_multi_pool_allocator_init(&state, bad_sizes, 2);
+
+    if (!oaf_multi_pool_allocator_init(&state, NULL, 0))
+    {
+        return 0;
+    }
+
+    oaf_multi_pool_allocator_as_allocator(&state, &allocator);
+
+    void* small = oaf_allocator_alloc(&allocator, 10, 8);
+    void* node = oaf_allocator_alloc(&allocator, 48, 16);
+    void* aligned = oaf_allocator_alloc(&allocator, 100, 64);
+    void* large = oaf_allocator_alloc(&allocator, 5000, 4096);
+    ok = ok && small != NULL && node != NULL && aligned != NULL && large != NULL;
+    ok = ok && ((uintptr_t)node % 16u) == 0 && ((uintptr_t)aligned % 64u) == 0 && ((uintptr_t)large % 4096u) == 0;
+    ok = ok && state.classes[0].active_blocks == 1 && state.classes[2].active_blocks == 1 && state.large_active == 1;
+    ok = ok && oaf_allocator_realloc(&allocator, small, 10, 16, 8) == small;
+
+    memset(small, 0x3C, 16);
+    unsigned char* moved = (unsigned char*)oaf_allocator_realloc(&allocator, small, 16, 300, 8);
+    ok = ok && moved != NULL && moved[15] == 0x3C && state.classes[0].active_blocks == 0;
+    oaf_allocator_free(&allocator, moved);
+    oaf_allocator_free(&allocator, node);
+    oaf_allocator_free(&allocator, aligned);
+    oaf_allocator_free(&allocator, large);
+
+    /* Mid-sized large blocks sit right behind a slab-aligned header instead of a slab's worth of padding. */
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    size_t heap_in_use = mallinfo2().uordblks;
+#endif
+    memset(blocks, 0, sizeof(blocks));
+    for (size_t i = 0; ok && i < 64; i++)
+    {
+        blocks[i] = oaf_allocator_alloc(&allocator, 2048, 128);
+        ok = blocks[i] != NULL && ((uintptr_t)blocks[i] % OAF_MULTI_POOL_SLAB_SIZE) == 128u;
+    }
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    ok = ok && mallinfo2().uordblks - heap_in_use < 64u * 4096u;
+#endif
+
+    for (size_t i = 0; i < 64; i++)
+    {
+        oaf_allocator_free(&allocator, blocks[i]);
+    }
+
+    ok = ok && state.large_active == 0;
+
+    for (size_t i = 0; ok && i < 256; i++)
+    {
+        blocks[i] = oaf_allocator_alloc(&allocator, 64, 8);
+        ok = blocks[i] != NULL;
+    }
+
+    if (ok)
+    {
+        RemoteFreeState remote = {&allocator, blocks, 256};
+        pthread_t thread;
+
+        ok = pthread_create(&thread, NULL, remote_free_main, &remote) == 0;
+        ok = ok && pthread_join(thread, NULL) == 0;
+    }
+
+    for (size_t i = 0; ok && i < 4; i++)
+    {
+        ok = pthread_create(&threads[i], NULL, multi_pool_churn_main, &allocator) == 0;
+    }
+
+    for (size_t i = 0; ok && i < 4; i++)
+    {
+        void* result = NULL;
+        ok = pthread_join(threads[i], &result) == 0 && result == &allocator;
+    }
+
+    ok = ok && oaf_multi_pool_allocator_active_blocks(&state) == 0;
+    ok = ok && state.classes[3].slab_count == 1 && state.classes[2].slab_count == 1;
+    oaf_multi_pool_allocator_destroy(&state);
+    return ok;
+}
+
 static int test_ownership_and_lifetime(void)
 {
     OafOwnershipToken token;
@@ -296,8 +665,243 @@ static int test_leak_detection(void)
     }
 
     oaf_allocator_free(&allocator, second);
-    return !oaf_leak_detector_has_leaks(&detector)
-        && oaf_leak_detector_peak_bytes(&detector) >= 96;
+    if (oaf_leak_detector_has_leaks(&detector) || oaf_leak_detector_peak_bytes(&detector) < 96)
+    {
+        oaf_leak_detector_destroy(&detector);
+        return 0;
+    }
+
+    oaf_leak_detector_destroy(&detector);
+    return 1;
+}
+
+static OafSourceLocation g_leak_site;
+
+static OafSourceLocation current_leak_site(void* state)
+{
+    (void)state;
+    return g_leak_site;
+}
+
+static int test_leak_detector_sites_and_sampling(void)
+{
+    static void* blocks[6000];
+    OafLeakDetector detector;
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafLeakSite sites[4];
+    char report[512];
+    void* grown;
+    size_t index;
+    size_t sampled;
+    int ok = 1;
+
+    oaf_leak_detector_init(&detector);
+    oaf_leak_detector_set_site_provider(&detector, current_leak_site, NULL);
+    oaf_default_allocator_init(&state, &allocator);
+    oaf_default_allocator_attach_leak_detector(&state, &detector);
+
+    g_leak_site.file_name = "alpha.oaf";
+    g_leak_site.line = 10;
+    g_leak_site.column = 2;
+    for (index = 0; ok && index < 5000; index++)
+    {
+        blocks[index] = oaf_allocator_alloc(&allocator, 16, 8);
+        ok = blocks[index] != NULL;
+    }
+
+    g_leak_site.file_name = "beta.oaf";
+    g_leak_site.line = 42;
+    for (index = 5000; ok && index < 5100; index++)
+    {
+        blocks[index] = oaf_allocator_alloc(&allocator, 64, 8);
+        ok = blocks[index] != NULL;
+    }
+
+    g_leak_site.file_name = "gamma.oaf";
+    grown = ok ? oaf_allocator_realloc(&allocator, blocks[5000], 64, 128, 8) : NULL;
+    ok = ok && grown != NULL;
+    if (ok)
+    {
+        blocks[5000] = grown;
+    }
+
+    for (index = 3; ok && index < 5000; index++)
+    {
+        oaf_allocator_free(&allocator, blocks[index]);
+    }
+
+    ok = ok && detector.dropped_records == 0 && oaf_leak_detector_active_allocations(&detector) == 103;
+    ok = ok && oaf_leak_detector_report(&detector, sites, 4) == 2;
+    ok = ok && strcmp(sites[0].location.file_name, "beta.oaf") == 0 && sites[0].active_bytes == 6464 && sites[0].total_allocations == 100;
+    ok = ok && sites[1].location.line == 10 && sites[1].active_allocations == 3 && sites[1].active_bytes == 48;
+    ok = ok && oaf_leak_detector_format_report(&detector, report, sizeof(report));
+    ok = ok && strstr(report, "6512 byte(s) leaked in 103 allocation(s)") != NULL && strstr(report, "alpha.oaf:10:2") != NULL;
+
+    for (index = 0; index < 5100; index++)
+    {
+        if (index < 3 || index >= 5000)
+        {
+            oaf_allocator_free(&allocator, blocks[index]);
+        }
+    }
+    ok = ok && !oaf_leak_detector_has_leaks(&detector);
+
+    oaf_leak_detector_set_sample_rate(&detector, 100);
+    for (index = 0; ok && index < 6000; index++)
+    {
+        blocks[index] = oaf_allocator_alloc(&allocator, 8, 8);
+        ok = blocks[index] != NULL;
+    }
+
+    sampled = oaf_leak_detector_active_allocations(&detector);
+    ok = ok && sampled >= 20 && sampled <= 300;
+    ok = ok && oaf_leak_detector_format_report(&detector, report, sizeof(report)) && strstr(report, "sampled 1 in 100") != NULL;
+    for (index = 0; index < 6000; index++)
+    {
+        oaf_allocator_free(&allocator, blocks[index]);
+    }
+
+    ok = ok && !oaf_leak_detector_has_leaks(&detector) && state.active_allocations == 0;
+    oaf_leak_detector_destroy(&detector);
+    return ok;
+}
+
+static int file_contains(const char* path, const char* text)
+{
+    char contents[1024];
+    FILE* file = fopen(path, "r");
+    size_t length;
+
+    if (file == NULL)
+    {
+        return 0;
+    }
+
+    length = fread(contents, 1, sizeof(contents) - 1u, file);
+    contents[length] = '\0';
+    fclose(file);
+    return strstr(contents, text) != NULL;
+}
+
+static int test_heap_profiler(void)
+{
+    static void* blocks[20000];
+    OafDefaultAllocatorState inner_state;
+    OafAllocator inner;
+    OafHeapProfilerState profiler;
+    OafHeapProfilerState other;
+    OafAllocator allocator;
+    OafHeapProfileSnapshot snapshot;
+    struct timespec pause = {0, 1000000};
+    char path[128];
+    char dump_path[160];
+    size_t index;
+    size_t waited;
+    size_t estimate = 0;
+    int ok;
+
+    oaf_default_allocator_init(&inner_state, &inner);
+    if (!oaf_heap_profiler_init(&profiler, &inner, 0))
+    {
+        return 0;
+    }
+
+    oaf_heap_profiler_set_site_provider(&profiler, current_leak_site, NULL);
+    oaf_heap_profiler_as_allocator(&profiler, &allocator);
+    g_leak_site.file_name = "alpha.oaf";
+    g_leak_site.line = 3;
+    g_leak_site.column = 1;
+    ok = 1;
+    for (index = 0; ok && index < 100; index++)
+    {
+        blocks[index] = oaf_allocator_alloc(&allocator, 48, index % 2u == 0 ? 8 : 32);
+        ok = blocks[index] != NULL && ((uintptr_t)blocks[index] % 16u) == 0;
+    }
+
+    /* Blocks pass through to the inner allocator at their requested size, with no profiler header. */
+    ok = ok && inner_state.total_allocated_bytes == 100u * 48u;
+
+    g_leak_site.file_name = "beta.oaf";
+    blocks[100] = ok ? oaf_allocator_alloc(&allocator, 1000, 8) : NULL;
+    blocks[100] = blocks[100] != NULL ? oaf_allocator_realloc(&allocator, blocks[100], 1000, 5000, 8) : NULL;
+    ok = ok && blocks[100] != NULL;
+    for (index = 0; ok && index < 50; index++)
+    {
+        oaf_allocator_free(&allocator, blocks[index]);
+    }
+
+    ok = ok && oaf_heap_profiler_snapshot(&profiler, &snapshot);
+    ok = ok && oaf_heap_profiler_size_class(48) == 6 && snapshot.live_count[6] == 50 && snapshot.live_bytes[6] == 2400;
+    ok = ok && snapshot.total_count[6] == 100 && snapshot.live_count[13] == 1 && snapshot.live_bytes[13] == 5000;
+    ok = ok && snapshot.live_count[10] == 0 && snapshot.total_count[10] == 1 && snapshot.site_count == 2;
+    ok = ok && snapshot.sites[0].live_bytes == 2400 && snapshot.sites[0].total_count == 100 && snapshot.sites[1].live_bytes == 5000;
+    oaf_heap_profile_snapshot_release(&snapshot);
+
+    snprintf(path, sizeof(path), "/tmp/oaf_heap_profile_%ld", (long)getpid());
+    ok = ok && oaf_heap_profiler_write_folded(&profiler, path);
+    ok = ok && file_contains(path, "oaf_heap;alpha.oaf:3:1 2400\n") && file_contains(path, "oaf_heap;beta.oaf:3:1 5000\n");
+    remove(path);
+
+    ok = ok && oaf_heap_profiler_start_dumper(&profiler, path, 0, SIGUSR2);
+    ok = ok && oaf_heap_profiler_init(&other, &inner, 0);
+    ok = ok && !oaf_heap_profiler_start_dumper(&other, path, 0, SIGUSR1);
+    oaf_heap_profiler_destroy(&other);
+    ok = ok && raise(SIGUSR2) == 0;
+    snprintf(dump_path, sizeof(dump_path), "%s.1.folded", path);
+    for (waited = 0; ok && waited < 2000 && access(dump_path, F_OK) != 0; waited++)
+    {
+        nanosleep(&pause, NULL);
+    }
+    oaf_heap_profiler_stop_dumper(&profiler);
+    ok = ok && file_contains(dump_path, "oaf_heap;beta.oaf:3:1 5000\n");
+    remove(dump_path);
+
+    for (index = 50; index <= 100; index++)
+    {
+        oaf_allocator_free(&allocator, blocks[index]);
+    }
+    oaf_heap_profiler_destroy(&profiler);
+    if (!ok || inner_state.active_allocations != 0 || !oaf_heap_profiler_init(&profiler, &inner, 4096))
+    {
+        return 0;
+    }
+
+    oaf_heap_profiler_as_allocator(&profiler, &allocator);
+    for (index = 0; ok && index < 20000; index++)
+    {
+        blocks[index] = oaf_allocator_alloc(&allocator, 64, 8);
+        ok = blocks[index] != NULL;
+    }
+
+    ok = ok && oaf_heap_profiler_snapshot(&profiler, &snapshot);
+    if (ok && snapshot.site_count == 1)
+    {
+        estimate = snapshot.sites[0].live_bytes;
+    }
+    ok = ok && snapshot.live_bytes[7] == estimate && estimate > 20000u * 64u / 2u && estimate < 20000u * 64u * 2u;
+    oaf_heap_profile_snapshot_release(&snapshot);
+    for (index = 0; index < 20000 && blocks[index] != NULL; index++)
+    {
+        oaf_allocator_free(&allocator, blocks[index]);
+    }
+
+    ok = ok && oaf_heap_profiler_snapshot(&profiler, &snapshot) && snapshot.site_count == 1 && snapshot.sites[0].live_bytes == 0;
+    oaf_heap_profile_snapshot_release(&snapshot);
+
+    /* Growth by realloc counts against the sample countdown, so a buffer grown from 16 bytes to 64 KiB is seen. */
+    blocks[0] = ok ? oaf_allocator_alloc(&allocator, 16, 8) : NULL;
+    for (index = 16; blocks[0] != NULL && index < 64u * 1024u; index += 16u)
+    {
+        blocks[0] = oaf_allocator_realloc(&allocator, blocks[0], index, index + 16u, 8);
+    }
+
+    ok = ok && blocks[0] != NULL && oaf_heap_profiler_snapshot(&profiler, &snapshot);
+    ok = ok && snapshot.sites[0].live_bytes == 64u * 1024u && snapshot.live_count[oaf_heap_profiler_size_class(64u * 1024u)] == 1;
+    oaf_heap_profile_snapshot_release(&snapshot);
+    oaf_allocator_free(&allocator, blocks[0]);
+    oaf_heap_profiler_destroy(&profiler);
+    return ok && inner_state.active_allocations == 0;
 }
 
 static int test_gc_cycle_collection(void)
@@ -356,17 +960,454 @@ static int test_gc_cycle_collection(void)
     return state.active_allocations == 0;
 }
 
+static int test_gc_large_graph(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafGarbageCollector collector;
+    const size_t chain_length = 200000;
+    const size_t garbage_count = 100000;
+    void* head = NULL;
+    void* previous = NULL;
+    void* first_garbage = NULL;
+    size_t index;
+    int local = 0;
+    int ok = 1;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_gc_init(&collector, &allocator, 1))
+    {
+        return 0;
+    }
+
+    for (index = 0; ok && index < chain_length; index++)
+    {
+        void* node = oaf_gc_alloc(&collector, 32, 16);
+
+        ok = node != NULL && ((uintptr_t)node % 16u) == 0;
+        if (ok && previous != NULL)
+        {
+            ok = oaf_gc_add_reference(&collector, previous, node);
+        }
+        head = head == NULL ? node : head;
+        previous = node;
+    }
+
+    previous = NULL;
+    for (index = 0; ok && index < garbage_count; index++)
+    {
+        void* node = oaf_gc_alloc(&collector, 16, 8);
+
+        ok = node != NULL;
+        if (ok && previous != NULL)
+        {
+            ok = oaf_gc_add_reference(&collector, previous, node)
+                && oaf_gc_add_reference(&collector, node, previous);
+        }
+        first_garbage = first_garbage == NULL ? node : first_garbage;
+        previous = node;
+    }
+
+    ok = ok && oaf_gc_add_reference(&collector, head, head) && oaf_gc_add_reference(&collector, head, head);
+    ok = ok && oaf_gc_remove_reference(&collector, head, head);
+    ok = ok && !oaf_gc_retain(&collector, &local) && oaf_gc_retain(&collector, head);
+    ok = ok && oaf_gc_object_count(&collector) == chain_length + garbage_count;
+    ok = ok && oaf_gc_collect(&collector) == garbage_count;
+    ok = ok && oaf_gc_object_count(&collector) == chain_length;
+    ok = ok && oaf_gc_managed_bytes(&collector) == chain_length * 32u;
+    ok = ok && !oaf_gc_retain(&collector, first_garbage);
+    ok = ok && !oaf_gc_detect_cycles(&collector);
+    ok = ok && oaf_gc_collect(&collector) == 0;
+
+    ok = ok && oaf_gc_release(&collector, head) && !oaf_gc_release(&collector, head);
+    ok = ok && oaf_gc_collect(&collector) == chain_length && oaf_gc_object_count(&collector) == 0;
+
+    oaf_gc_destroy(&collector);
+    return ok && state.active_allocations == 0;
+}
+
+static int test_gc_wide_fanout(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafGarbageCollector collector;
+    const size_t fanout = 50000;
+    void** children;
+    void* hub;
+    size_t index;
+    int ok;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_gc_init(&collector, &allocator, 1))
+    {
+        return 0;
+    }
+
+    children = (void**)oaf_allocator_alloc(&allocator, fanout * sizeof(void*), _Alignof(void*));
+    hub = oaf_gc_alloc(&collector, 16, 8);
+    ok = children != NULL && hub != NULL && oaf_gc_retain(&collector, hub);
+    for (index = 0; ok && index < fanout; index++)
+    {
+        children[index] = oaf_gc_alloc(&collector, 16, 8);
+        ok = children[index] != NULL
+            && oaf_gc_add_reference(&collector, hub, children[index])
+            && oaf_gc_add_reference(&collector, hub, children[index]);
+    }
+
+    /* Duplicate edges are folded, so one removal per child drops it whatever the out-degree. */
+    for (index = 0; ok && index < fanout; index += 2u)
+    {
+        ok = oaf_gc_remove_reference(&collector, hub, children[index])
+            && oaf_gc_remove_reference(&collector, hub, children[index]);
+    }
+
+    ok = ok && oaf_gc_collect(&collector) == fanout / 2u;
+    ok = ok && oaf_gc_object_count(&collector) == fanout / 2u + 1u;
+    for (index = 1; ok && index < fanout; index += 2u)
+    {
+        ok = oaf_gc_retain(&collector, children[index]) && oaf_gc_release(&collector, children[index]);
+    }
+
+    ok = ok && oaf_gc_release(&collector, hub) && oaf_gc_collect(&collector) == fanout / 2u + 1u;
+    oaf_allocator_free(&allocator, children);
+    oaf_gc_destroy(&collector);
+    return ok && state.active_allocations == 0;
+}
+
+static int test_gc_incremental_marking(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafGarbageCollector collector;
+    OafGcPauseHistogram pauses;
+    void* chain[10000];
+    void* witness;
+    void* pending;
+    void* late;
+    void* orphan;
+    void* previous = NULL;
+    size_t collected = 0;
+    size_t steps = 0;
+    size_t index;
+    int ok = 1;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_gc_init(&collector, &allocator, 1))
+    {
+        return 0;
+    }
+
+    for (index = 0; ok && index < 10000; index++)
+    {
+        chain[index] = oaf_gc_alloc(&collector, 32, 8);
+        ok = chain[index] != NULL && (index == 0 || oaf_gc_add_reference(&collector, chain[index - 1u], chain[index]));
+    }
+
+    for (index = 0; ok && index < 5000; index++)
+    {
+        void* node = oaf_gc_alloc(&collector, 16, 8);
+        ok = node != NULL && (previous == NULL || oaf_gc_add_reference(&collector, node, previous));
+        previous = node;
+    }
+
+    witness = oaf_gc_alloc(&collector, 16, 8);
+    ok = ok && witness != NULL && oaf_gc_retain(&collector, chain[0]);
+    ok = ok && oaf_gc_add_reference(&collector, chain[9000], witness);
+
+    oaf_gc_set_pause_budget(&collector, 1);
+    pending = oaf_gc_alloc(&collector, 16, 8);
+    collector.next_trigger = 0;
+    collected += oaf_gc_step(&collector);
+    steps++;
+    ok = ok && pending != NULL && oaf_gc_is_collecting(&collector);
+
+    late = oaf_gc_alloc(&collector, 16, 8);
+    orphan = oaf_gc_alloc(&collector, 16, 8);
+    ok = ok && late != NULL && orphan != NULL && oaf_gc_add_reference(&collector, chain[0], late);
+    ok = ok && oaf_gc_add_reference(&collector, chain[0], witness) && oaf_gc_remove_reference(&collector, chain[9000], witness);
+
+    while (ok && oaf_gc_is_collecting(&collector) && steps < 100000)
+    {
+        collected += oaf_gc_step(&collector);
+        steps++;
+    }
+
+    oaf_gc_pause_histogram(&collector, &pauses);
+    ok = ok && !oaf_gc_is_collecting(&collector) && steps > 2 && collected == 5000;
+    ok = ok && pauses.count == steps && pauses.max_ns > 0 && oaf_gc_pause_percentile_ns(&collector, 0.99) > 0;
+    ok = ok && oaf_gc_retain(&collector, witness) && oaf_gc_release(&collector, witness);
+    ok = ok && oaf_gc_retain(&collector, late) && oaf_gc_release(&collector, late);
+
+    /* Objects allocated while marking get the same one-cycle grace as the rest: orphan outlives the next cycle. */
+    collected = 0;
+    collector.next_trigger = 0;
+    do
+    {
+        collected += oaf_gc_step(&collector);
+    } while (ok && oaf_gc_is_collecting(&collector));
+    ok = ok && collected == 1 && oaf_gc_object_count(&collector) == 10003;
+    ok = ok && oaf_gc_retain(&collector, orphan) && oaf_gc_release(&collector, orphan);
+    ok = ok && oaf_gc_collect(&collector) == 1 && oaf_gc_object_count(&collector) == 10002;
+
+    oaf_gc_destroy(&collector);
+    return ok && state.active_allocations == 0;
+}
+
+static int test_gc_background_marking(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafGarbageCollector collector;
+    struct timespec pause = {0, 1000000};
+    void* root;
+    size_t index;
+    size_t kept = 0;
+    size_t waited;
+    int ok = 1;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_gc_init(&collector, &allocator, 1))
+    {
+        return 0;
+    }
+
+    oaf_gc_set_pause_budget(&collector, 100000);
+    if (!oaf_gc_start_background(&collector, 100000))
+    {
+        oaf_gc_destroy(&collector);
+        return 0;
+    }
+
+    /* Keep allocating until the background thread frees something, however early its first cycle ran. */
+    root = oaf_gc_alloc(&collector, 64, 8);
+    ok = root != NULL && oaf_gc_retain(&collector, root);
+    for (index = 0; ok && index < 1000000 && oaf_gc_object_count(&collector) > index; index++)
+    {
+        void* node = oaf_gc_alloc(&collector, 24, 8);
+
+        ok = node != NULL;
+        if (ok && index % 4u == 0)
+        {
+            ok = oaf_gc_add_reference(&collector, root, node);
+            kept++;
+        }
+    }
+
+    for (waited = 0; ok && waited < 5000 && oaf_gc_object_count(&collector) > index; waited++)
+    {
+        nanosleep(&pause, NULL);
+    }
+
+    ok = ok && oaf_gc_object_count(&collector) <= index && oaf_gc_object_count(&collector) >= kept + 1u;
+    oaf_gc_stop_background(&collector);
+    ok = ok && !collector.background_running && collector.cycles >= 1;
+    ok = ok && oaf_gc_release(&collector, root) && oaf_gc_collect(&collector) > 0 && oaf_gc_object_count(&collector) == 0;
+    oaf_gc_destroy(&collector);
+    return ok && state.active_allocations == 0;
+}
+
+static int test_gc_generational_nursery(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafGarbageCollector collector;
+    OafGcGenerationStats stats;
+    void* old;
+    void* root;
+    void* held;
+    void* child;
+    void* previous = NULL;
+    size_t allocations = 0;
+    size_t round;
+    size_t index;
+    int ok;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_gc_init(&collector, &allocator, 1))
+    {
+        return 0;
+    }
+
+    oaf_gc_set_nursery_size(&collector, 64 * 1024);
+    old = oaf_gc_alloc(&collector, OAF_GC_NURSERY_CHUNK_SIZE / 2u, 8);
+    root = oaf_gc_alloc(&collector, 32, 8);
+    held = oaf_gc_alloc(&collector, 32, 8);
+    child = oaf_gc_alloc(&collector, 48, 16);
+    ok = old != NULL && root != NULL && held != NULL && child != NULL;
+    ok = ok && oaf_gc_retain(&collector, old) && oaf_gc_retain(&collector, root);
+    ok = ok && oaf_gc_add_reference(&collector, old, held) && oaf_gc_add_reference(&collector, held, child);
+
+    for (round = 0; ok && round < 2; round++)
+    {
+        for (index = 0; ok && index < 20000; index++)
+        {
+            void* node = oaf_gc_alloc(&collector, 32, 8);
+
+            ok = node != NULL && (previous == NULL || oaf_gc_add_reference(&collector, node, previous));
+            previous = node;
+        }
+
+        previous = NULL;
+        oaf_gc_generation_stats(&collector, &stats);
+        ok = ok && oaf_gc_nursery_full(&collector) && stats.young_objects == (round == 0 ? 20003u : 20000u);
+        ok = ok && stats.remembered_objects == (round == 0 ? 1u : 0u) && stats.old_objects == (round == 0 ? 1u : 4u);
+        ok = ok && oaf_gc_collect_minor(&collector) == 20000 && oaf_gc_object_count(&collector) == 4;
+        if (round == 0)
+        {
+            allocations = state.active_allocations;
+        }
+    }
+
+    oaf_gc_generation_stats(&collector, &stats);
+    ok = ok && stats.young_objects == 0 && stats.old_objects == 4 && stats.minor_collections == 2;
+    ok = ok && stats.promoted_objects == 3 && stats.promoted_bytes == 112 && !oaf_gc_nursery_full(&collector);
+    ok = ok && state.active_allocations == allocations;
+    ok = ok && oaf_gc_release(&collector, root) && oaf_gc_remove_reference(&collector, old, held);
+    ok = ok && oaf_gc_collect(&collector) == 3 && oaf_gc_object_count(&collector) == 1;
+    ok = ok && oaf_gc_release(&collector, old) && oaf_gc_collect(&collector) == 1;
+
+    oaf_gc_destroy(&collector);
+    return ok && state.active_allocations == 0;
+}
+
+static int test_gc_nursery_retention(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafGarbageCollector collector;
+    OafGcGenerationStats stats;
+    const size_t count = 8000;
+    const size_t rounds = 24;
+    void* first;
+    void* pinned[24];
+    size_t round;
+    size_t index;
+    int ok;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_gc_init(&collector, &allocator, 1))
+    {
+        return 0;
+    }
+
+    /* A survivor is promoted in place, and allocation carries on in its chunk instead of opening another. */
+    oaf_gc_set_nursery_size(&collector, 1024 * 1024);
+    first = oaf_gc_alloc(&collector, 64, 8);
+    ok = first != NULL && oaf_gc_retain(&collector, first) && oaf_gc_collect_minor(&collector) == 0;
+    ok = ok && oaf_gc_alloc(&collector, 64, 8) != NULL && oaf_gc_collect_minor(&collector) == 1;
+    oaf_gc_generation_stats(&collector, &stats);
+    ok = ok && stats.nursery_chunk_bytes == OAF_GC_NURSERY_CHUNK_SIZE;
+
+    /* A steady trickle of long-lived survivors leaves holes that later rounds fill, so the nursery stays bounded. */
+    for (round = 0; ok && round < rounds; round++)
+    {
+        for (index = 0; ok && index < count; index++)
+        {
+            void* node = oaf_gc_alloc(&collector, 64, 8);
+
+            ok = node != NULL && (index != count / 2u || oaf_gc_retain(&collector, pinned[round] = node));
+        }
+
+        ok = ok && oaf_gc_collect_minor(&collector) == count - 1u;
+        oaf_gc_generation_stats(&collector, &stats);
+        ok = ok && stats.nursery_chunk_bytes <= 8u * OAF_GC_NURSERY_CHUNK_SIZE;
+        ok = ok && oaf_gc_object_count(&collector) == round + 2u;
+    }
+
+    for (round = 0; ok && round < rounds; round++)
+    {
+        ok = oaf_gc_release(&collector, pinned[round]);
+    }
+
+    ok = ok && oaf_gc_release(&collector, first) && oaf_gc_collect(&collector) == rounds + 1u;
+    oaf_gc_generation_stats(&collector, &stats);
+    ok = ok && stats.nursery_chunk_bytes <= 2u * OAF_GC_NURSERY_CHUNK_SIZE;
+    oaf_gc_destroy(&collector);
+    return ok && state.active_allocations == 0;
+}
+
+static int test_gc_parallel_marking(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafGarbageCollector collector;
+    void* nodes[30000];
+    void* garbage = NULL;
+    size_t round;
+    size_t index;
+    int ok = 1;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_gc_init(&collector, &allocator, 1))
+    {
+        return 0;
+    }
+
+    ok = oaf_gc_set_mark_workers(&collector, 4) && oaf_gc_mark_workers(&collector) == 4;
+    ok = ok && !oaf_gc_set_mark_workers(&collector, OAF_GC_MAX_MARK_WORKERS + 1u);
+    ok = ok && oaf_gc_set_mark_workers(&collector, 4);
+    for (index = 0; ok && index < 30000; index++)
+    {
+        nodes[index] = oaf_gc_alloc(&collector, 24, 8);
+        ok = nodes[index] != NULL;
+        if (ok && index > 0 && index < 20000)
+        {
+            ok = oaf_gc_add_reference(&collector, nodes[(index - 1u) / 3u], nodes[index]);
+        }
+        else if (ok && index > 20000)
+        {
+            ok = oaf_gc_add_reference(&collector, nodes[index - 1u], nodes[index]);
+        }
+    }
+
+    for (index = 0; ok && index < 12000; index++)
+    {
+        void* node = oaf_gc_alloc(&collector, 16, 8);
+
+        ok = node != NULL && (garbage == NULL || oaf_gc_add_reference(&collector, node, garbage));
+        garbage = node;
+    }
+
+    ok = ok && oaf_gc_retain(&collector, nodes[0]) && oaf_gc_retain(&collector, nodes[20000]);
+    ok = ok && oaf_gc_add_reference(&collector, nodes[29999], nodes[7]);
+    for (round = 0; ok && round < 3; round++)
+    {
+        ok = oaf_gc_collect(&collector) == (round == 0 ? 12000u : 0u) && oaf_gc_object_count(&collector) == 30000;
+    }
+
+    ok = ok && oaf_gc_release(&collector, nodes[20000]) && oaf_gc_collect(&collector) == 10000;
+    ok = ok && oaf_gc_set_mark_workers(&collector, 1) && oaf_gc_mark_workers(&collector) == 1;
+    ok = ok && oaf_gc_release(&collector, nodes[0]) && oaf_gc_collect(&collector) == 20000;
+
+    ok = ok && oaf_gc_set_mark_workers(&collector, 3);
+    oaf_gc_destroy(&collector);
+    return ok && state.active_allocations == 0;
+}
+
 int main(void)
 {
     int ok = 1;
     ok = ok && test_default_allocator();
     ok = ok && test_arena_allocator();
+    ok = ok && test_growable_arena();
     ok = ok && test_pool_allocator();
     ok = ok && test_temp_allocator();
+    ok = ok && test_temp_allocator_nesting_and_threads();
+    ok = ok && test_thread_cache_allocator();
+    ok = ok && test_multi_pool_allocator();
     ok = ok && test_ownership_and_lifetime();
     ok = ok && test_bounds_and_null_safety();
     ok = ok && test_leak_detection();
+    ok = ok && test_leak_detector_sites_and_sampling();
+    ok = ok && test_heap_profiler();
     ok = ok && test_gc_cycle_collection();
+    ok = ok && test_gc_large_graph();
+    ok = ok && test_gc_wide_fanout();
+    ok = ok && test_gc_incremental_marking();
+    ok = ok && test_gc_background_marking();
+    ok = ok && test_gc_generational_nursery();
+    ok = ok && test_gc_nursery_retention();
+    ok = ok && test_gc_parallel_marking();
 
     if (!ok)
     {
@@ -0,0 +1,937 @@
+#include <stdint.h>
+#include <string.h>
+#include "concurrent_dict.h"
+
+struct OafConcurrentDictNode
+{
+    _Atomic(struct OafConcurrentDictNode*) next;
+    struct OafConcurrentDictNode* retired_next;
+    size_t hash;
+    _Alignas(max_align_t) unsigned char payload[];
+};
+
+/* Once next is set every bucket is copied there and replaced by the forwarding marker. Buckets a helper failed to
+   copy are left from retry_index on (SIZE_MAX when none) and rescanned once transfer_index passes the end. */
+struct OafConcurrentDictTable
+{
+    struct OafConcurrentDictTable* retired_next;
+    _Atomic(struct OafConcurrentDictTable*) next;
+    atomic_size_t transfer_index;
+    atomic_size_t retry_index;
+    atomic_size_t transferred;
+    size_t bucket_count;
+    _Atomic(OafConcurrentDictNode*) buckets[];
+};
+
+struct OafConcurrentDictStripe
+{
+    _Alignas(64) OafMutex lock;
+    atomic_size_t count;
+};
+
+struct OafConcurrentDictReaderShard
+{
+    _Alignas(64) atomic_size_t active[2];
+};
+
+typedef struct ReadSection
+{
+    OafConcurrentDictReaderShard* shard;
+    unsigned int parity;
+} ReadSection;
+
+static OafConcurrentDictNode g_forwarded_bucket;
+static atomic_uint g_next_reader_shard;
+static _Thread_local unsigned int t_reader_shard;
+
+#define FORWARDED_BUCKET (&g_forwarded_bucket)
+
+static unsigned char* node_key(OafConcurrentDictNode* node)
+{
+    return node->payload;
+}
+
+static unsigned char* node_value(const OafConcurrentDict* dict, OafConcurrentDictNode* node)
+{
+    return node->payload + dict->key_size;
+}
+
+static size_t hash_key(const OafConcurrentDict* dict, const void* key)
+{
+    if (dict->hash != NULL)
+    {
+        return dict->hash(key, dict->callback_state);
+    }
+
+    return oaf_dict_hash_bytes(key, dict->key_size);
+}
+
+static int keys_equal(const OafConcurrentDict* dict, const void* left, const void* right)
+{
+    if (dict->equals != NULL)
+    {
+        return dict->equals(left, right, dict->callback_state);
+    }
+
+    return memcmp(left, right, dict->key_size) == 0;
+}
+
+static OafConcurrentDictStripe* stripe_for_hash(const OafConcurrentDict* dict, size_t hash)
+{
+    return &dict->stripes[hash & (OAF_CONCURRENT_DICT_STRIPES - 1u)];
+}
+
+static ReadSection enter_read(OafConcurrentDict* dict)
+{
+    ReadSection section;
+
+    if (t_reader_shard == 0)
+    {
+        t_reader_shard = atomic_fetch_add_explicit(&g_next_reader_shard, 1u, memory_order_relaxed) + 1u;
+    }
+
+    section.shard = &dict->readers[(t_reader_shard - 1u) & (OAF_CONCURRENT_DICT_READER_SHARDS - 1u)];
+    for (;;)
+    {
+        unsigned int epoch = atomic_load(&dict->epoch);
+
+        section.parity = epoch & 1u;
+        atomic_fetch_add(&section.shard->active[section.parity], 1u);
+        if (atomic_load(&dict->epoch) == epoch)
+        {
+            return section;
+        }
+
+        atomic_fetch_sub_explicit(&section.shard->active[section.parity], 1u, memory_order_release);
+    }
+}
+
+static void leave_read(ReadSection section)
+{
+    atomic_fetch_sub_explicit(&section.shard->active[section.parity], 1u, memory_order_release);
+}
+
+static OafConcurrentDictNode* create_node(OafConcurrentDict* dict, size_t hash, const void* key, const void* value)
+{
+    OafConcurrentDictNode* node = (OafConcurrentDictNode*)oaf_allocator_alloc(
+        dict->allocator,
+        sizeof(OafConcurrentDictNode) + dict->key_size + dict->value_size,
+        _Alignof(OafConcurrentDictNode));
+
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    atomic_init(&node->next, NULL);
+    node->retired_next = NULL;
+    node->hash = hash;
+    memcpy(node_key(node), key, dict->key_size);
+    if (value != NULL)
+    {
+        memcpy(node_value(dict, node), value, dict->value_size);
+    }
+    else
+    {
+        memset(node_value(dict, node), 0, dict->value_size);
+    }
+
+    return node;
+}
+
+static void release_chain(OafConcurrentDict* dict, OafConcurrentDictNode* node)
+{
+    while (node != NULL && node != FORWARDED_BUCKET)
+    {
+        OafConcurrentDictNode* next = atomic_load_explicit(&node->next, memory_order_relaxed);
+        oaf_allocator_free(dict->allocator, node);
+        node = next;
+    }
+}
+
+static OafConcurrentDictTable* create_table(OafConcurrentDict* dict, size_t bucket_count)
+{
+    OafConcurrentDictTable* table;
+    size_t index;
+
+    if (bucket_count > (SIZE_MAX - sizeof(OafConcurrentDictTable)) / sizeof(table->buckets[0]))
+    {
+        return NULL;
+    }
+
+    table = (OafConcurrentDictTable*)oaf_allocator_alloc(
+        dict->allocator,
+        sizeof(OafConcurrentDictTable) + bucket_count * sizeof(table->buckets[0]),
+        _Alignof(OafConcurrentDictTable));
+    if (table == NULL)
+    {
+        return NULL;
+    }
+
+    table->retired_next = NULL;
+    atomic_init(&table->next, NULL);
+    atomic_init(&table->transfer_index, 0);
+    atomic_init(&table->retry_index, SIZE_MAX);
+    atomic_init(&table->transferred, 0);
+    table->bucket_count = bucket_count;
+    for (index = 0; index < bucket_count; index++)
+    {
+        atomic_init(&table->buckets[index], NULL);
+    }
+
+    return table;
+}
+
+static void retire_node(OafConcurrentDict* dict, OafConcurrentDictNode* node)
+{
+    OafConcurrentDictNode* head = atomic_load_explicit(&dict->retired_nodes, memory_order_relaxed);
+
+    do
+    {
+        node->retired_next = head;
+    } while (!atomic_compare_exchange_weak(&dict->retired_nodes, &head, node));
+
+    atomic_fetch_add_explicit(&dict->retired_count, 1u, memory_order_relaxed);
+}
+
+static void retire_table(OafConcurrentDict* dict, OafConcurrentDictTable* table)
+{
+    OafConcurrentDictTable* head = atomic_load_explicit(&dict->retired_tables, memory_order_relaxed);
+
+    do
+    {
+        table->retired_next = head;
+    } while (!atomic_compare_exchange_weak(&dict->retired_tables, &head, table));
+
+    atomic_fetch_add_explicit(&dict->retired_count, 1u, memory_order_relaxed);
+}
+
+static void free_retired(OafConcurrentDict* dict, OafConcurrentDictNode* nodes, OafConcurrentDictTable* tables)
+{
+    size_t freed = 0;
+
+    while (nodes != NULL)
+    {
+        OafConcurrentDictNode* next = nodes->retired_next;
+        oaf_allocator_free(dict->allocator, nodes);
+        nodes = next;
+        freed++;
+    }
+
+    while (tables != NULL)
+    {
+        OafConcurrentDictTable* next = tables->retired_next;
+        oaf_allocator_free(dict->allocator, tables);
+        tables = next;
+        freed++;
+    }
+
+    atomic_fetch_sub_explicit(&dict->retired_count, freed, memory_order_relaxed);
+}
+
+static int readers_drained(const OafConcurrentDict* dict, unsigned int parity)
+{
+    size_t shard;
+
+    for (shard = 0; shard < OAF_CONCURRENT_DICT_READER_SHARDS; shard++)
+    {
+        if (atomic_load(&dict->readers[shard].active[parity]) != 0)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Called outside read sections and never waits: a batch is detached and the epoch bumped, and the batch is freed on a
+   later attempt once no reader is left in the epoch it was detached in. Attempts are spaced a batch of retirements apart. */
+static void reclaim(OafConcurrentDict* dict)
+{
+    int expected = 0;
+
+    if (atomic_load_explicit(&dict->retired_count, memory_order_relaxed) < atomic_load_explicit(&dict->reclaim_at, memory_order_relaxed))
+    {
+        return;
+    }
+
+    if (!atomic_compare_exchange_strong(&dict->reclaiming, &expected, 1))
+    {
+        return;
+    }
+
+    if (dict->pending_nodes == NULL && dict->pending_tables == NULL)
+    {
+        /* Nothing detached yet. */
+    }
+    else if (readers_drained(dict, dict->pending_parity))
+    {
+        free_retired(dict, dict->pending_nodes, dict->pending_tables);
+        dict->pending_nodes = NULL;
+        dict->pending_tables = NULL;
+    }
+
+    if (dict->pending_nodes == NULL && dict->pending_tables == NULL)
+    {
+        dict->pending_nodes = atomic_exchange(&dict->retired_nodes, NULL);
+        dict->pending_tables = atomic_exchange(&dict->retired_tables, NULL);
+        dict->pending_parity = atomic_fetch_add(&dict->epoch, 1u) & 1u;
+    }
+
+    atomic_store_explicit(
+        &dict->reclaim_at,
+        atomic_load_explicit(&dict->retired_count, memory_order_relaxed) + OAF_CONCURRENT_DICT_RECLAIM_BATCH,
+        memory_order_relaxed);
+    atomic_store_explicit(&dict->reclaiming, 0, memory_order_release);
+}
+
+/* Caller holds the stripe lock for hash, which also pins whether its bucket has been forwarded. */
+static _Atomic(OafConcurrentDictNode*)* locked_bucket(OafConcurrentDict* dict, size_t hash)
+{
+    OafConcurrentDictTable* table = atomic_load_explicit(&dict->table, memory_order_acquire);
+
+    for (;;)
+    {
+        _Atomic(OafConcurrentDictNode*)* bucket = &table->buckets[hash & (table->bucket_count - 1u)];
+
+        if (atomic_load_explicit(bucket, memory_order_acquire) != FORWARDED_BUCKET)
+        {
+            return bucket;
+        }
+
+        table = atomic_load_explicit(&table->next, memory_order_acquire);
+    }
+}
+
+static OafConcurrentDictNode* find_in_chain(
+    const OafConcurrentDict* dict,
+    _Atomic(OafConcurrentDictNode*)** link,
+    size_t hash,
+    const void* key)
+{
+    OafConcurrentDictNode* node = atomic_load_explicit(*link, memory_order_acquire);
+
+    while (node != NULL)
+    {
+        if (node->hash == hash && keys_equal(dict, node_key(node), key))
+        {
+            return node;
+        }
+
+        *link = &node->next;
+        node = atomic_load_explicit(*link, memory_order_acquire);
+    }
+
+    return NULL;
+}
+
+static OafConcurrentDictNode* find_node(OafConcurrentDict* dict, size_t hash, const void* key)
+{
+    OafConcurrentDictTable* table = atomic_load_explicit(&dict->table, memory_order_acquire);
+    OafConcurrentDictNode* node = atomic_load_explicit(&table->buckets[hash & (table->bucket_count - 1u)], memory_order_acquire);
+
+    while (node == FORWARDED_BUCKET)
+    {
+        table = atomic_load_explicit(&table->next, memory_order_acquire);
+        node = atomic_load_explicit(&table->buckets[hash & (table->bucket_count - 1u)], memory_order_acquire);
+    }
+
+    while (node != NULL)
+    {
+        if (node->hash == hash && keys_equal(dict, node_key(node), key))
+        {
+            return node;
+        }
+
+        node = atomic_load_explicit(&node->next, memory_order_acquire);
+    }
+
+    return NULL;
+}
+
+/* Copies one bucket into the next table and counts it in *moved unless another helper already did; on allocation
+   failure the bucket stays where it is and 0 is returned so the caller can hand it back for a retry. */
+static int transfer_bucket(
+    OafConcurrentDict* dict,
+    OafConcurrentDictTable* table,
+    OafConcurrentDictTable* next,
+    size_t bucket,
+    size_t* moved)
+{
+    OafConcurrentDictStripe* stripe = &dict->stripes[bucket & (OAF_CONCURRENT_DICT_STRIPES - 1u)];
+    OafConcurrentDictNode* low = NULL;
+    OafConcurrentDictNode* high = NULL;
+    OafConcurrentDictNode* head;
+    OafConcurrentDictNode* node;
+
+    oaf_mutex_lock(&stripe->lock);
+    head = atomic_load_explicit(&table->buckets[bucket], memory_order_relaxed);
+    if (head == FORWARDED_BUCKET)
+    {
+        oaf_mutex_unlock(&stripe->lock);
+        return 1;
+    }
+
+    for (node = head; node != NULL; node = atomic_load_explicit(&node->next, memory_order_relaxed))
+    {
+        OafConcurrentDictNode* copy = create_node(dict, node->hash, node_key(node), node_value(dict, node));
+
+        if (copy == NULL)
+        {
+            oaf_mutex_unlock(&stripe->lock);
+            release_chain(dict, low);
+            release_chain(dict, high);
+            return 0;
+        }
+
+        if ((node->hash & table->bucket_count) != 0)
+        {
+            atomic_store_explicit(&copy->next, high, memory_order_relaxed);
+            high = copy;
+        }
+        else
+        {
+            atomic_store_explicit(&copy->next, low, memory_order_relaxed);
+            low = copy;
+        }
+    }
+
+    atomic_store_explicit(&next->buckets[bucket], low, memory_order_release);
+    atomic_store_explicit(&next->buckets[bucket + table->bucket_count], high, memory_order_release);
+    atomic_store_explicit(&table->buckets[bucket], FORWARDED_BUCKET, memory_order_release);
+    oaf_mutex_unlock(&stripe->lock);
+    (*moved)++;
+
+    while (head != NULL)
+    {
+        node = atomic_load_explicit(&head->next, memory_order_relaxed);
+        retire_node(dict, head);
+        head = node;
+    }
+
+    return 1;
+}
+
+static void retry_from(OafConcurrentDictTable* table, size_t bucket)
+{
+    size_t current = atomic_load(&table->retry_index);
+
+    while (bucket < current && !atomic_compare_exchange_weak(&table->retry_index, &current, bucket))
+    {
+    }
+}
+
+/* Once every chunk is claimed, a helper takes over the retry range and moves up to one chunk of what is left. */
+static size_t retry_transfer(OafConcurrentDict* dict, OafConcurrentDictTable* table, OafConcurrentDictTable* next)
+{
+    size_t bucket = atomic_exchange(&table->retry_index, SIZE_MAX);
+    size_t moved = 0;
+    size_t attempts = 0;
+
+    for (; bucket < table->bucket_count && attempts < OAF_CONCURRENT_DICT_TRANSFER_CHUNK; bucket++)
+    {
+        if (atomic_load_explicit(&table->buckets[bucket], memory_order_acquire) == FORWARDED_BUCKET)
+        {
+            continue;
+        }
+
+        attempts++;
+        if (!transfer_bucket(dict, table, next, bucket, &moved))
+        {
+            break;
+        }
+    }
+
+    if (bucket < table->bucket_count)
+    {
+        retry_from(table, bucket);
+    }
+
+    return moved;
+}
+
+static void help_resize(OafConcurrentDict* dict)
+{
+    OafConcurrentDictTable* table = atomic_load_explicit(&dict->table, memory_order_acquire);
+    OafConcurrentDictTable* next = atomic_load_explicit(&table->next, memory_order_acquire);
+    size_t start;
+    size_t end;
+    size_t bucket;
+    size_t moved = 0;
+
+    if (next == NULL)
+    {
+        return;
+    }
+
+    start = atomic_fetch_add(&table->transfer_index, OAF_CONCURRENT_DICT_TRANSFER_CHUNK);
+    if (start >= table->bucket_count)
+    {
+        if (atomic_load_explicit(&table->retry_index, memory_order_relaxed) == SIZE_MAX)
+        {
+            return;
+        }
+
+        moved = retry_transfer(dict, table, next);
+    }
+    else
+    {
+        end = start + OAF_CONCURRENT_DICT_TRANSFER_CHUNK;
+        end = end > table->bucket_count ? table->bucket_count : end;
+        for (bucket = start; bucket < end; bucket++)
+        {
+            if (!transfer_bucket(dict, table, next, bucket, &moved))
+            {
+                retry_from(table, bucket);
+                break;
+            }
+        }
+    }
+
+    if (moved != 0 && atomic_fetch_add(&table->transferred, moved) + moved == table->bucket_count)
+    {
+        atomic_store(&dict->bucket_count, next->bucket_count);
+        atomic_store_explicit(&dict->table, next, memory_order_release);
+        retire_table(dict, table);
+    }
+}
+
+/* Each stripe owns an equal share of buckets, so only a stripe past 3/4 of its share pays for summing the total. */
+static void maybe_grow(OafConcurrentDict* dict, OafConcurrentDictStripe* stripe)
+{
+    OafConcurrentDictTable* table = atomic_load_explicit(&dict->table, memory_order_acquire);
+    OafConcurrentDictTable* next;
+    OafConcurrentDictTable* expected = NULL;
+    size_t share = table->bucket_count / OAF_CONCURRENT_DICT_STRIPES;
+
+    if (atomic_load_explicit(&stripe->count, memory_order_relaxed) * 4u <= share * 3u
+        || atomic_load_explicit(&table->next, memory_order_relaxed) != NULL
+        || oaf_concurrent_dict_count(dict) * 4u <= table->bucket_count * 3u
+        || table->bucket_count > (SIZE_MAX / 2u))
+    {
+        return;
+    }
+
+    next = create_table(dict, table->bucket_count * 2u);
+    if (next == NULL)
+    {
+        return;
+    }
+
+    if (!atomic_compare_exchange_strong(&table->next, &expected, next))
+    {
+        oaf_allocator_free(dict->allocator, next);
+        return;
+    }
+
+    atomic_fetch_add_explicit(&dict->resizes, 1u, memory_order_relaxed);
+    help_resize(dict);
+}
+
+static int insert_if_absent(
+    OafConcurrentDict* dict,
+    const void* key,
+    const void* value,
+    OafConcurrentDictComputeProc compute,
+    void* compute_state,
+    void* out_value,
+    int* out_inserted)
+{
+    OafConcurrentDictStripe* stripe;
+    _Atomic(OafConcurrentDictNode*)* bucket;
+    _Atomic(OafConcurrentDictNode*)* link;
+    OafConcurrentDictNode* node;
+    ReadSection section;
+    size_t hash;
+    int inserted = 0;
+    int result = 1;
+
+    hash = hash_key(dict, key);
+    section = enter_read(dict);
+    node = find_node(dict, hash, key);
+    if (node == NULL)
+    {
+        help_resize(dict);
+        stripe = stripe_for_hash(dict, hash);
+        oaf_mutex_lock(&stripe->lock);
+        bucket = locked_bucket(dict, hash);
+        link = bucket;
+        node = find_in_chain(dict, &link, hash, key);
+        if (node == NULL)
+        {
+            node = create_node(dict, hash, key, value);
+            if (node != NULL && compute != NULL && !compute(key, node_value(dict, node), compute_state))
+            {
+                oaf_allocator_free(dict->allocator, node);
+                node = NULL;
+            }
+
+            if (node != NULL)
+            {
+                atomic_store_explicit(&node->next, atomic_load_explicit(bucket, memory_order_relaxed), memory_order_relaxed);
+                atomic_store_explicit(bucket, node, memory_order_release);
+                atomic_fetch_add_explicit(&stripe->count, 1u, memory_order_relaxed);
+                inserted = 1;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+
+        if (node != NULL && out_value != NULL)
+        {
+            memcpy(out_value, node_value(dict, node), dict->value_size);
+        }
+
+        oaf_mutex_unlock(&stripe->lock);
+        if (inserted)
+        {
+            maybe_grow(dict, stripe);
+        }
+    }
+    else if (out_value != NULL)
+    {
+        memcpy(out_value, node_value(dict, node), dict->value_size);
+    }
+
+    leave_read(section);
+    reclaim(dict);
+
+    if (out_inserted != NULL)
+    {
+        *out_inserted = inserted;
+    }
+
+    return result;
+}
+
+int oaf_concurrent_dict_init(
+    OafConcurrentDict* dict,
+    size_t key_size,
+    size_t value_size,
+    size_t initial_capacity,
+    OafDictHashProc hash,
+    OafDictEqualsProc equals,
+    void* callback_state,
+    OafAllocator* allocator)
+{
+    OafConcurrentDictTable* table;
+    size_t bucket_count = OAF_CONCURRENT_DICT_STRIPES;
+    size_t index;
+
+    if (dict == NULL || allocator == NULL || key_size == 0)
+    {
+        return 0;
+    }
+
+    if (key_size > (SIZE_MAX - value_size) || (key_size + value_size) > (SIZE_MAX - sizeof(OafConcurrentDictNode)))
+    {
+        return 0;
+    }
+
+    while (bucket_count * 3u / 4u < initial_capacity)
+    {
+        if (bucket_count > (SIZE_MAX / 8u))
+        {
+            return 0;
+        }
+
+        bucket_count *= 2u;
+    }
+
+    dict->allocator = allocator;
+    dict->key_size = key_size;
+    dict->value_size = value_size;
+    dict->hash = hash;
+    dict->equals = equals;
+    dict->callback_state = callback_state;
+    dict->stripes = (OafConcurrentDictStripe*)oaf_allocator_alloc(
+        allocator,
+        OAF_CONCURRENT_DICT_STRIPES * sizeof(OafConcurrentDictStripe),
+        _Alignof(OafConcurrentDictStripe));
+    dict->readers = (OafConcurrentDictReaderShard*)oaf_allocator_alloc(
+        allocator,
+        OAF_CONCURRENT_DICT_READER_SHARDS * sizeof(OafConcurrentDictReaderShard),
+        _Alignof(OafConcurrentDictReaderShard));
+    table = dict->stripes != NULL && dict->readers != NULL ? create_table(dict, bucket_count) : NULL;
+    if (table == NULL)
+    {
+        if (dict->stripes != NULL)
+        {
+            oaf_allocator_free(allocator, dict->stripes);
+        }
+
+        if (dict->readers != NULL)
+        {
+            oaf_allocator_free(allocator, dict->readers);
+        }
+
+        dict->stripes = NULL;
+        dict->readers = NULL;
+        return 0;
+    }
+
+    for (index = 0; index < OAF_CONCURRENT_DICT_STRIPES; index++)
+    {
+        oaf_mutex_init(&dict->stripes[index].lock);
+        atomic_init(&dict->stripes[index].count, 0);
+    }
+
+    for (index = 0; index < OAF_CONCURRENT_DICT_READER_SHARDS; index++)
+    {
+        atomic_init(&dict->readers[index].active[0], 0);
+        atomic_init(&dict->readers[index].active[1], 0);
+    }
+
+    atomic_init(&dict->table, table);
+    atomic_init(&dict->bucket_count, bucket_count);
+    atomic_init(&dict->epoch, 0);
+    atomic_init(&dict->retired_nodes, NULL);
+    atomic_init(&dict->retired_tables, NULL);
+    atomic_init(&dict->retired_count, 0);
+    atomic_init(&dict->reclaiming, 0);
+    atomic_init(&dict->reclaim_at, OAF_CONCURRENT_DICT_RECLAIM_BATCH);
+    atomic_init(&dict->resizes, 0);
+    dict->pending_nodes = NULL;
+    dict->pending_tables = NULL;
+    dict->pending_parity = 0;
+    return 1;
+}
+
+void oaf_concurrent_dict_destroy(OafConcurrentDict* dict)
+{
+    OafConcurrentDictTable* table;
+    size_t index;
+
+    if (dict == NULL || dict->stripes == NULL)
+    {
+        return;
+    }
+
+    table = atomic_load(&dict->table);
+    while (table != NULL)
+    {
+        OafConcurrentDictTable* next = atomic_load(&table->next);
+
+        for (index = 0; index < table->bucket_count; index++)
+        {
+            release_chain(dict, atomic_load_explicit(&table->buckets[index], memory_order_relaxed));
+        }
+
+        oaf_allocator_free(dict->allocator, table);
+        table = next;
+    }
+
+    free_retired(dict, dict->pending_nodes, dict->pending_tables);
+    free_retired(dict, atomic_exchange(&dict->retired_nodes, NULL), atomic_exchange(&dict->retired_tables, NULL));
+
+    for (index = 0; index < OAF_CONCURRENT_DICT_STRIPES; index++)
+    {
+        oaf_mutex_destroy(&dict->stripes[index].lock);
+    }
+
+    oaf_allocator_free(dict->allocator, dict->stripes);
+    oaf_allocator_free(dict->allocator, dict->readers);
+    atomic_store(&dict->table, NULL);
+    dict->stripes = NULL;
+    dict->readers = NULL;
+    dict->allocator = NULL;
+}
+
+size_t oaf_concurrent_dict_count(const OafConcurrentDict* dict)
+{
+    size_t count = 0;
+    size_t index;
+
+    if (dict == NULL || dict->stripes == NULL)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < OAF_CONCURRENT_DICT_STRIPES; index++)
+    {
+        count += atomic_load_explicit(&dict->stripes[index].count, memory_order_relaxed);
+    }
+
+    return count;
+}
+
+size_t oaf_concurrent_dict_bucket_count(const OafConcurrentDict* dict)
+{
+    if (dict == NULL)
+    {
+        return 0;
+    }
+
+    return atomic_load_explicit(&dict->bucket_count, memory_order_relaxed);
+}
+
+size_t oaf_concurrent_dict_resize_count(const OafConcurrentDict* dict)
+{
+    if (dict == NULL)
+    {
+        return 0;
+    }
+
+    return atomic_load_explicit(&dict->resizes, memory_order_relaxed);
+}
+
+int oaf_concurrent_dict_set(OafConcurrentDict* dict, const void* key, const void* value)
+{
+    OafConcurrentDictStripe* stripe;
+    _Atomic(OafConcurrentDictNode*)* bucket;
+    _Atomic(OafConcurrentDictNode*)* link;
+    OafConcurrentDictNode* existing;
+    OafConcurrentDictNode* replacement;
+    ReadSection section;
+    size_t hash;
+
+    if (dict == NULL || dict->stripes == NULL || key == NULL || value == NULL)
+    {
+        return 0;
+    }
+
+    hash = hash_key(dict, key);
+    replacement = create_node(dict, hash, key, value);
+    if (replacement == NULL)
+    {
+        return 0;
+    }
+
+    section = enter_read(dict);
+    help_resize(dict);
+    stripe = stripe_for_hash(dict, hash);
+    oaf_mutex_lock(&stripe->lock);
+    bucket = locked_bucket(dict, hash);
+    link = bucket;
+    existing = find_in_chain(dict, &link, hash, key);
+    if (existing != NULL)
+    {
+        atomic_store_explicit(&replacement->next, atomic_load_explicit(&existing->next, memory_order_relaxed), memory_order_relaxed);
+        atomic_store_explicit(link, replacement, memory_order_release);
+        oaf_mutex_unlock(&stripe->lock);
+        retire_node(dict, existing);
+    }
+    else
+    {
+        atomic_store_explicit(&replacement->next, atomic_load_explicit(bucket, memory_order_relaxed), memory_order_relaxed);
+        atomic_store_explicit(bucket, replacement, memory_order_release);
+        atomic_fetch_add_explicit(&stripe->count, 1u, memory_order_relaxed);
+        oaf_mutex_unlock(&stripe->lock);
+        maybe_grow(dict, stripe);
+    }
+
+    leave_read(section);
+    reclaim(dict);
+    return 1;
+}
+
+int oaf_concurrent_dict_try_get(OafConcurrentDict* dict, const void* key, void* out_value)
+{
+    OafConcurrentDictNode* node;
+    ReadSection section;
+    size_t hash;
+
+    if (dict == NULL || dict->stripes == NULL || key == NULL || out_value == NULL)
+    {
+        return 0;
+    }
+
+    hash = hash_key(dict, key);
+    section = enter_read(dict);
+    node = find_node(dict, hash, key);
+    if (node != NULL)
+    {
+        memcpy(out_value, node_value(dict, node), dict->value_size);
+    }
+
+    leave_read(section);
+    return node != NULL;
+}
+
+int oaf_concurrent_dict_contains_key(OafConcurrentDict* dict, const void* key)
+{
+    ReadSection section;
+    size_t hash;
+    int found;
+
+    if (dict == NULL || dict->stripes == NULL || key == NULL)
+    {
+        return 0;
+    }
+
+    hash = hash_key(dict, key);
+    section = enter_read(dict);
+    found = find_node(dict, hash, key) != NULL;
+    leave_read(section);
+    return found;
+}
+
+int oaf_concurrent_dict_remove(OafConcurrentDict* dict, const void* key, void* out_value)
+{
+    OafConcurrentDictStripe* stripe;
+    _Atomic(OafConcurrentDictNode*)* link;
+    OafConcurrentDictNode* node;
+    ReadSection section;
+    size_t hash;
+
+    if (dict == NULL || dict->stripes == NULL || key == NULL)
+    {
+        return 0;
+    }
+
+    hash = hash_key(dict, key);
+    section = enter_read(dict);
+    help_resize(dict);
+    stripe = stripe_for_hash(dict, hash);
+    oaf_mutex_lock(&stripe->lock);
+    link = locked_bucket(dict, hash);
+    node = find_in_chain(dict, &link, hash, key);
+    if (node != NULL)
+    {
+        if (out_value != NULL)
+        {
+            memcpy(out_value, node_value(dict, node), dict->value_size);
+        }
+
+        atomic_store_explicit(link, atomic_load_explicit(&node->next, memory_order_relaxed), memory_order_release);
+        atomic_fetch_sub_explicit(&stripe->count, 1u, memory_order_relaxed);
+    }
+
+    oaf_mutex_unlock(&stripe->lock);
+    if (node != NULL)
+    {
+        retire_node(dict, node);
+    }
+
+    leave_read(section);
+    reclaim(dict);
+    return node != NULL;
+}
+
+int oaf_concurrent_dict_get_or_insert(OafConcurrentDict* dict, const void* key, const void* value, void* out_value, int* out_inserted)
+{
+    if (dict == NULL || dict->stripes == NULL || key == NULL || value == NULL)
+    {
+        return 0;
+    }
+
+    return insert_if_absent(dict, key, value, NULL, NULL, out_value, out_inserted);
+}
+
+int oaf_concurrent_dict_compute_if_absent(
+    OafConcurrentDict* dict,
+    const void* key,
+    OafConcurrentDictComputeProc compute,
+    void* compute_state,
+    void* out_value,
+    int* out_inserted)
+{
+    if (dict == NULL || dict->stripes == NULL || key == NULL || compute == NULL)
+    {
+        return 0;
+    }
+
+    return insert_if_absent(dict, key, NULL, compute, compute_state, out_value, out_inserted);
+}
@@ -1,64 +1,190 @@
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/random.h>
 #include "dict.h"
+#include "dict_table.h"
 
-struct OafDictNode
-{
-    struct OafDictNode* next;
-    size_t hash;
-    unsigned char payload[];
-};
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define OAF_DICT_AES 1
+#else
+#define OAF_DICT_AES 0
+#endif
 
-static size_t fnv1a_bytes(const unsigned char* bytes, size_t length)
-{
-    size_t index;
-#if SIZE_MAX == UINT64_MAX
-    size_t hash = 1469598103934665603ull;
-    const size_t prime = 1099511628211ull;
+#if defined(__GNUC__) || defined(__clang__)
+#define DICT_PREFETCH(address) __builtin_prefetch((address), 0, 3)
 #else
-    size_t hash = 2166136261u;
-    const size_t prime = 16777619u;
+#define DICT_PREFETCH(address) ((void)(address))
 #endif
 
-    for (index = 0; index < length; index++)
+static const uint64_t g_hash_secret[4] = {OAF_DICT_SECRET_0, OAF_DICT_SECRET_1, OAF_DICT_SECRET_2, OAF_DICT_SECRET_3};
+
+static pthread_once_t g_hash_seed_once = PTHREAD_ONCE_INIT;
+static atomic_int g_hash_seeded;
+static uint64_t g_hash_seed;
+static int g_hash_use_aes;
+
+static uint64_t read_u64(const unsigned char* bytes)
+{
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint64_t read_u32(const unsigned char* bytes)
+{
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+/* wyhash-style: 48-byte stripes through three multiply-fold lanes, with overlapping reads for the tail. */
+static uint64_t hash_words(const unsigned char* bytes, size_t length, uint64_t seed)
+{
+    uint64_t first;
+    uint64_t second;
+    size_t remaining = length;
+
+    seed ^= oaf_dict_mix(seed ^ g_hash_secret[0], g_hash_secret[1]);
+    if (length <= 16u)
+    {
+        if (length >= 4u)
+        {
+            size_t offset = (length >> 3) << 2;
+            first = (read_u32(bytes) << 32) | read_u32(bytes + offset);
+            second = (read_u32(bytes + length - 4u) << 32) | read_u32(bytes + length - 4u - offset);
+        }
+        else
+        {
+            first = ((uint64_t)bytes[0] << 16) | ((uint64_t)bytes[length >> 1] << 8) | bytes[length - 1u];
+            second = 0;
+        }
+    }
+    else
     {
-        hash ^= (size_t)bytes[index];
-        hash *= prime;
+        if (remaining > 48u)
+        {
+            uint64_t lane1 = seed;
+            uint64_t lane2 = seed;
+
+            do
+            {
+                seed = oaf_dict_mix(read_u64(bytes) ^ g_hash_secret[1], read_u64(bytes + 8) ^ seed);
+                lane1 = oaf_dict_mix(read_u64(bytes + 16) ^ g_hash_secret[2], read_u64(bytes + 24) ^ lane1);
+                lane2 = oaf_dict_mix(read_u64(bytes + 32) ^ g_hash_secret[3], read_u64(bytes + 40) ^ lane2);
+                bytes += 48;
+                remaining -= 48u;
+            } while (remaining > 48u);
+
+            seed ^= lane1 ^ lane2;
+        }
+
+        while (remaining > 16u)
+        {
+            seed = oaf_dict_mix(read_u64(bytes) ^ g_hash_secret[1], read_u64(bytes + 8) ^ seed);
+            bytes += 16;
+            remaining -= 16u;
+        }
+
+        first = read_u64(bytes + remaining - 16u);
+        second = read_u64(bytes + remaining - 8u);
+    }
+
+    first ^= g_hash_secret[1];
+    second ^= seed;
+    oaf_dict_multiply(&first, &second);
+    return oaf_dict_mix(first ^ g_hash_secret[0] ^ (uint64_t)length, second ^ g_hash_secret[1]);
+}
+
+#if OAF_DICT_AES
+/* Four AES lanes absorb 64-byte stripes (the last stripe overlaps the previous one); used for keys of 64 bytes and up. */
+__attribute__((target("aes,sse2"))) static uint64_t hash_aes(const unsigned char* bytes, size_t length, uint64_t seed)
+{
+    __m128i key = _mm_set_epi64x((long long)(seed ^ g_hash_secret[1]), (long long)(seed ^ g_hash_secret[0]));
+    __m128i lane0 = _mm_set_epi64x((long long)g_hash_secret[2], (long long)(seed ^ (uint64_t)length));
+    __m128i lane1 = _mm_set_epi64x((long long)g_hash_secret[3], (long long)(seed + (uint64_t)length));
+    __m128i lane2 = _mm_xor_si128(lane0, key);
+    __m128i lane3 = _mm_xor_si128(lane1, key);
+    const unsigned char* last = bytes + length - 64u;
+    uint64_t parts[2];
+
+    for (;;)
+    {
+        const unsigned char* stripe = bytes < last ? bytes : last;
+
+        lane0 = _mm_aesenc_si128(_mm_xor_si128(lane0, _mm_loadu_si128((const __m128i*)stripe)), key);
+        lane1 = _mm_aesenc_si128(_mm_xor_si128(lane1, _mm_loadu_si128((const __m128i*)(stripe + 16))), key);
+        lane2 = _mm_aesenc_si128(_mm_xor_si128(lane2, _mm_loadu_si128((const __m128i*)(stripe + 32))), key);
+        lane3 = _mm_aesenc_si128(_mm_xor_si128(lane3, _mm_loadu_si128((const __m128i*)(stripe + 48))), key);
+        if (stripe == last)
+        {
+            break;
+        }
+
+        bytes += 64;
     }
 
-    return hash;
+    lane0 = _mm_aesenc_si128(lane0, lane1);
+    lane2 = _mm_aesenc_si128(lane2, lane3);
+    lane0 = _mm_aesenc_si128(lane0, lane2);
+    lane0 = _mm_aesenc_si128(lane0, key);
+    lane0 = _mm_aesenc_si128(lane0, key);
+    _mm_storeu_si128((__m128i*)parts, lane0);
+    return oaf_dict_mix(parts[0] ^ g_hash_secret[0], parts[1] ^ g_hash_secret[1]);
 }
+#endif
 
-static size_t bucket_index_for_hash(size_t hash, size_t bucket_count)
+static void hash_seed_init(void)
 {
-    if (bucket_count == 0)
+    uint64_t seed = 0;
+
+    if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != (ssize_t)sizeof(seed))
     {
-        return 0;
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        seed = ((uint64_t)now.tv_sec << 32) ^ (uint64_t)now.tv_nsec ^ (uint64_t)getpid() ^ (uint64_t)(uintptr_t)&seed;
     }
 
-    return hash % bucket_count;
+    g_hash_seed = oaf_dict_mix(seed ^ g_hash_secret[2], g_hash_secret[3]);
+#if OAF_DICT_AES
+    __builtin_cpu_init();
+    g_hash_use_aes = __builtin_cpu_supports("aes");
+#endif
+    atomic_store_explicit(&g_hash_seeded, 1, memory_order_release);
 }
 
-static unsigned char* node_key(const OafDict* dict, OafDictNode* node)
+static uint64_t hash_seed(void)
 {
-    (void)dict;
-    return node->payload;
+    if (!atomic_load_explicit(&g_hash_seeded, memory_order_acquire))
+    {
+        pthread_once(&g_hash_seed_once, hash_seed_init);
+    }
+
+    return g_hash_seed;
 }
 
-static unsigned char* node_value(const OafDict* dict, OafDictNode* node)
+static unsigned char* slot_key(const OafDict* dict, size_t slot)
 {
-    return node->payload + dict->key_size;
+    return dict->slots + slot * dict->slot_size;
 }
 
-static const unsigned char* node_key_const(const OafDict* dict, const OafDictNode* node)
+static unsigned char* slot_value(const OafDict* dict, size_t slot)
 {
-    (void)dict;
-    return node->payload;
+    return dict->slots + slot * dict->slot_size + dict->key_size;
 }
 
-static const unsigned char* node_value_const(const OafDict* dict, const OafDictNode* node)
+static void set_control(OafDict* dict, size_t slot, unsigned char control)
 {
-    return node->payload + dict->key_size;
+    dict->controls[slot] = control;
+    if (slot < OAF_DICT_GROUP_WIDTH)
+    {
+        dict->controls[dict->bucket_count + slot] = control;
+    }
 }
 
 static int keys_equal(const OafDict* dict, const void* left, const void* right)
@@ -73,99 +199,165 @@ static int keys_equal(const OafDict* dict, const void* left, const void* right)
 
 static size_t hash_key(const OafDict* dict, const void* key)
 {
-    if (dict->hash != NULL)
+    /* The built-in hashes are already seeded and well mixed; only foreign callbacks need spreading. */
+    if (dict->hash == oaf_dict_hash_i64 || dict->hash == oaf_dict_hash_cstr)
     {
         return dict->hash(key, dict->callback_state);
     }
 
+    if (dict->hash != NULL)
+    {
+        return oaf_dict_spread(dict->hash(key, dict->callback_state), dict->seed);
+    }
+
     return oaf_dict_hash_bytes(key, dict->key_size);
 }
 
-static int node_payload_size(const OafDict* dict, size_t* out_size)
+static int slot_stride(size_t key_size, size_t value_size, size_t* out_size)
 {
-    if (dict == NULL || out_size == NULL)
-    {
-        return 0;
-    }
+    size_t alignment = key_size & (~key_size + 1u);
+    size_t payload;
 
-    if (dict->key_size > (SIZE_MAX - dict->value_size))
+    if (alignment > _Alignof(max_align_t))
     {
-        return 0;
+        alignment = _Alignof(max_align_t);
     }
 
-    if ((dict->key_size + dict->value_size) > (SIZE_MAX - sizeof(OafDictNode)))
+    if (key_size > (SIZE_MAX - value_size) || (key_size + value_size) > (SIZE_MAX - alignment))
     {
         return 0;
     }
 
-    *out_size = sizeof(OafDictNode) + dict->key_size + dict->value_size;
+    payload = key_size + value_size;
+    *out_size = (payload + alignment - 1u) & ~(alignment - 1u);
     return 1;
 }
 
-static void free_chain(OafDict* dict, OafDictNode* head)
+static int table_layout(const OafDict* dict, size_t capacity, size_t* out_hashes_offset, size_t* out_controls_offset, size_t* out_bytes)
 {
-    OafDictNode* node = head;
+    return oaf_dict_table_layout(capacity, dict->slot_size, out_hashes_offset, out_controls_offset, out_bytes);
+}
 
-    while (node != NULL)
+/* Returns the slot holding key, or SIZE_MAX with *out_insert_slot set to the empty slot ending its probe run. */
+static size_t find_slot(const OafDict* dict, const void* key, size_t key_hash, size_t* out_insert_slot)
+{
+    size_t mask = dict->bucket_count - 1u;
+    size_t position = oaf_dict_home_slot(key_hash, dict->bucket_count);
+    unsigned char tag = oaf_dict_hash_tag(key_hash);
+
+    for (;;)
     {
-        OafDictNode* next = node->next;
-        oaf_allocator_free(dict->allocator, node);
-        node = next;
+        const unsigned char* group = dict->controls + position;
+        OafDictGroupMask empty = oaf_dict_group_match_empty(group);
+        OafDictGroupMask match = oaf_dict_group_match(group, tag);
+
+        match = oaf_dict_group_before_empty(match, empty);
+        while (match != 0)
+        {
+            size_t slot = (position + oaf_dict_group_lowest(match)) & mask;
+            if (keys_equal(dict, slot_key(dict, slot), key))
+            {
+                return slot;
+            }
+
+            match &= match - 1u;
+        }
+
+        if (empty != 0)
+        {
+            if (out_insert_slot != NULL)
+            {
+                *out_insert_slot = (position + oaf_dict_group_lowest(empty)) & mask;
+            }
+            return SIZE_MAX;
+        }
+
+        position = (position + OAF_DICT_GROUP_WIDTH) & mask;
     }
 }
 
-static int ensure_bucket_array(OafDict* dict, size_t bucket_count)
+static size_t find_empty(const OafDict* dict, size_t key_hash)
 {
-    size_t bytes;
+    size_t mask = dict->bucket_count - 1u;
+    size_t position = oaf_dict_home_slot(key_hash, dict->bucket_count);
 
-    if (dict == NULL || dict->allocator == NULL)
+    for (;;)
     {
-        return 0;
+        OafDictGroupMask empty = oaf_dict_group_match_empty(dict->controls + position);
+        if (empty != 0)
+        {
+            return (position + oaf_dict_group_lowest(empty)) & mask;
+        }
+
+        position = (position + OAF_DICT_GROUP_WIDTH) & mask;
     }
+}
 
-    if (bucket_count == 0)
+static void release_table(OafDict* dict)
+{
+    if (dict->slots != NULL)
     {
-        if (dict->buckets != NULL)
-        {
-            oaf_allocator_free(dict->allocator, dict->buckets);
-        }
-        dict->buckets = NULL;
-        dict->bucket_count = 0;
-        return 1;
+        oaf_allocator_free(dict->allocator, dict->slots);
     }
 
-    if (bucket_count > (SIZE_MAX / sizeof(OafDictNode*)))
+    dict->slots = NULL;
+    dict->hashes = NULL;
+    dict->controls = NULL;
+    dict->bucket_count = 0;
+}
+
+static int rehash(OafDict* dict, size_t capacity)
+{
+    unsigned char* previous_slots = dict->slots;
+    size_t* previous_hashes = dict->hashes;
+    unsigned char* previous_controls = dict->controls;
+    size_t previous_capacity = dict->bucket_count;
+    size_t hashes_offset;
+    size_t controls_offset;
+    size_t bytes;
+    unsigned char* block;
+    size_t slot;
+
+    if (!table_layout(dict, capacity, &hashes_offset, &controls_offset, &bytes))
     {
         return 0;
     }
 
-    bytes = bucket_count * sizeof(OafDictNode*);
-    dict->buckets = (OafDictNode**)oaf_allocator_alloc(dict->allocator, bytes, _Alignof(OafDictNode*));
-    if (dict->buckets == NULL)
+    block = (unsigned char*)oaf_allocator_alloc(dict->allocator, bytes, _Alignof(max_align_t));
+    if (block == NULL)
     {
         return 0;
     }
 
-    memset(dict->buckets, 0, bytes);
-    dict->bucket_count = bucket_count;
-    return 1;
-}
-
-static size_t next_bucket_count(size_t min_capacity)
-{
-    size_t capacity = 8u;
+    dict->slots = block;
+    dict->hashes = (size_t*)(block + hashes_offset);
+    dict->controls = block + controls_offset;
+    dict->bucket_count = capacity;
+    memset(dict->controls, OAF_DICT_CONTROL_EMPTY, capacity + OAF_DICT_GROUP_WIDTH);
 
-    while (capacity < min_capacity)
+    for (slot = 0; slot < previous_capacity; slot++)
     {
-        if (capacity > (SIZE_MAX / 2u))
+        size_t key_hash;
+        size_t target;
+
+        if ((previous_controls[slot] & OAF_DICT_CONTROL_EMPTY) != 0)
         {
-            return min_capacity;
+            continue;
         }
 
-        capacity *= 2u;
+        key_hash = previous_hashes[slot];
+        target = find_empty(dict, key_hash);
+        memcpy(slot_key(dict, target), previous_slots + slot * dict->slot_size, dict->slot_size);
+        dict->hashes[target] = key_hash;
+        set_control(dict, target, oaf_dict_hash_tag(key_hash));
+    }
+
+    if (previous_slots != NULL)
+    {
+        oaf_allocator_free(dict->allocator, previous_slots);
     }
 
-    return capacity;
+    return 1;
 }
 
 int oaf_dict_init(
@@ -178,7 +370,9 @@ int oaf_dict_init(
     void* callback_state,
     OafAllocator* allocator)
 {
-    if (dict == NULL || allocator == NULL || key_size == 0)
+    size_t slot_size;
+
+    if (dict == NULL || allocator == NULL || key_size == 0 || !slot_stride(key_size, value_size, &slot_size))
     {
         return 0;
     }
@@ -186,12 +380,16 @@ int oaf_dict_init(
     dict->allocator = allocator;
     dict->key_size = key_size;
     dict->value_size = value_size;
+    dict->slot_size = slot_size;
     dict->count = 0;
     dict->bucket_count = 0;
     dict->hash = hash;
     dict->equals = equals;
     dict->callback_state = callback_state;
-    dict->buckets = NULL;
+    dict->seed = hash_seed();
+    dict->controls = NULL;
+    dict->slots = NULL;
+    dict->hashes = NULL;
 
     if (initial_capacity == 0)
     {
@@ -213,6 +411,7 @@ void oaf_dict_destroy(OafDict* dict)
     dict->allocator = NULL;
     dict->key_size = 0;
     dict->value_size = 0;
+    dict->slot_size = 0;
     dict->hash = NULL;
     dict->equals = NULL;
     dict->callback_state = NULL;
@@ -220,27 +419,13 @@ void oaf_dict_destroy(OafDict* dict)
 
 void oaf_dict_clear(OafDict* dict)
 {
-    size_t bucket_index;
-
     if (dict == NULL || dict->allocator == NULL)
     {
         return;
     }
 
-    for (bucket_index = 0; bucket_index < dict->bucket_count; bucket_index++)
-    {
-        free_chain(dict, dict->buckets[bucket_index]);
-        dict->buckets[bucket_index] = NULL;
-    }
-
-    if (dict->buckets != NULL)
-    {
-        oaf_allocator_free(dict->allocator, dict->buckets);
-        dict->buckets = NULL;
-    }
-
+    release_table(dict);
     dict->count = 0;
-    dict->bucket_count = 0;
 }
 
 size_t oaf_dict_count(const OafDict* dict)
@@ -265,248 +450,308 @@ size_t oaf_dict_bucket_count(const OafDict* dict)
 
 int oaf_dict_reserve(OafDict* dict, size_t min_capacity)
 {
-    OafDictNode** previous_buckets;
-    size_t previous_bucket_count;
-    size_t target_bucket_count;
-    size_t bucket_index;
+    size_t capacity;
 
-    if (dict == NULL)
+    if (dict == NULL || dict->allocator == NULL)
     {
         return 0;
     }
 
-    if (dict->bucket_count >= min_capacity)
+    if (dict->bucket_count != 0 && oaf_dict_max_load(dict->bucket_count) >= min_capacity)
     {
         return 1;
     }
 
-    target_bucket_count = next_bucket_count(min_capacity);
-    if (target_bucket_count < 8u)
+    capacity = oaf_dict_capacity_for(min_capacity > dict->count ? min_capacity : dict->count);
+    if (capacity == 0)
     {
-        target_bucket_count = 8u;
+        return 0;
     }
 
-    previous_buckets = dict->buckets;
-    previous_bucket_count = dict->bucket_count;
+    return rehash(dict, capacity);
+}
 
-    dict->buckets = NULL;
-    dict->bucket_count = 0;
-    if (!ensure_bucket_array(dict, target_bucket_count))
+static int insert_hashed(OafDict* dict, const void* key, const void* value, size_t key_hash)
+{
+    size_t slot;
+    size_t insert_slot = 0;
+
+    slot = find_slot(dict, key, key_hash, &insert_slot);
+    if (slot != SIZE_MAX)
     {
-        dict->buckets = previous_buckets;
-        dict->bucket_count = previous_bucket_count;
-        return 0;
+        memcpy(slot_value(dict, slot), value, dict->value_size);
+        return 1;
     }
 
-    for (bucket_index = 0; bucket_index < previous_bucket_count; bucket_index++)
+    if (dict->count >= oaf_dict_max_load(dict->bucket_count))
     {
-        OafDictNode* node = previous_buckets[bucket_index];
-        while (node != NULL)
+        if (dict->bucket_count > (SIZE_MAX / 2u) || !rehash(dict, dict->bucket_count * 2u))
         {
-            OafDictNode* next = node->next;
-            size_t target_index = bucket_index_for_hash(node->hash, dict->bucket_count);
-            node->next = dict->buckets[target_index];
-            dict->buckets[target_index] = node;
-            node = next;
+            return 0;
         }
+
+        insert_slot = find_empty(dict, key_hash);
     }
 
-    if (previous_buckets != NULL)
+    memcpy(slot_key(dict, insert_slot), key, dict->key_size);
+    memcpy(slot_value(dict, insert_slot), value, dict->value_size);
+    dict->hashes[insert_slot] = key_hash;
+    set_control(dict, insert_slot, oaf_dict_hash_tag(key_hash));
+    dict->count++;
+    return 1;
+}
+
+/* Hashes up to OAF_DICT_BATCH_SIZE keys and prefetches their home groups so the probes that follow overlap their misses. */
+static size_t hash_batch(const OafDict* dict, const unsigned char* keys, size_t count, size_t* out_hashes)
+{
+    size_t batch = count < OAF_DICT_BATCH_SIZE ? count : OAF_DICT_BATCH_SIZE;
+    size_t index;
+
+    for (index = 0; index < batch; index++)
     {
-        oaf_allocator_free(dict->allocator, previous_buckets);
+        size_t home;
+
+        out_hashes[index] = hash_key(dict, keys + index * dict->key_size);
+        home = oaf_dict_home_slot(out_hashes[index], dict->bucket_count);
+        DICT_PREFETCH(dict->controls + home);
+        DICT_PREFETCH(slot_key(dict, home));
     }
 
-    return 1;
+    return batch;
 }
 
 int oaf_dict_set(OafDict* dict, const void* key, const void* value)
 {
-    size_t key_hash;
-    size_t bucket_index;
-    OafDictNode* node;
-    size_t allocation_size;
-    size_t target_buckets;
-
     if (dict == NULL || key == NULL || value == NULL)
     {
         return 0;
     }
 
-    target_buckets = dict->bucket_count == 0 ? 8u : dict->bucket_count;
-    if (dict->count >= target_buckets)
+    if (dict->bucket_count == 0 && !oaf_dict_reserve(dict, OAF_DICT_MIN_CAPACITY))
     {
-        if (!oaf_dict_reserve(dict, target_buckets * 2u))
-        {
-            return 0;
-        }
+        return 0;
     }
-    else if (dict->bucket_count == 0)
+
+    return insert_hashed(dict, key, value, hash_key(dict, key));
+}
+
+int oaf_dict_set_many(OafDict* dict, const void* keys, const void* values, size_t count)
+{
+    const unsigned char* key_bytes = (const unsigned char*)keys;
+    const unsigned char* value_bytes = (const unsigned char*)values;
+    size_t hashes[OAF_DICT_BATCH_SIZE];
+    size_t done = 0;
+
+    if (dict == NULL || (count != 0 && (keys == NULL || values == NULL)))
     {
-        if (!oaf_dict_reserve(dict, 8u))
-        {
-            return 0;
-        }
+        return 0;
     }
 
-    key_hash = hash_key(dict, key);
-    bucket_index = bucket_index_for_hash(key_hash, dict->bucket_count);
-    node = dict->buckets[bucket_index];
+    /* Sized for every key being new, so duplicates may leave the table larger than a key-by-key build would. */
+    if (count > SIZE_MAX - dict->count || !oaf_dict_reserve(dict, dict->count + count))
+    {
+        return 0;
+    }
 
-    while (node != NULL)
+    while (done < count)
     {
-        if (node->hash == key_hash && keys_equal(dict, node_key_const(dict, node), key))
+        size_t batch = hash_batch(dict, key_bytes + done * dict->key_size, count - done, hashes);
+        size_t index;
+
+        for (index = 0; index < batch; index++)
         {
-            memcpy(node_value(dict, node), value, dict->value_size);
-            return 1;
+            size_t item = done + index;
+
+            if (!insert_hashed(dict, key_bytes + item * dict->key_size, value_bytes + item * dict->value_size, hashes[index]))
+            {
+                return 0;
+            }
         }
-        node = node->next;
+
+        done += batch;
     }
 
-    if (!node_payload_size(dict, &allocation_size))
+    return 1;
+}
+
+int oaf_dict_try_get(const OafDict* dict, const void* key, void* out_value)
+{
+    size_t slot;
+
+    if (dict == NULL || key == NULL || out_value == NULL || dict->bucket_count == 0)
     {
         return 0;
     }
 
-    node = (OafDictNode*)oaf_allocator_alloc(dict->allocator, allocation_size, _Alignof(OafDictNode));
-    if (node == NULL)
+    slot = find_slot(dict, key, hash_key(dict, key), NULL);
+    if (slot == SIZE_MAX)
     {
         return 0;
     }
 
-    node->hash = key_hash;
-    memcpy(node_key(dict, node), key, dict->key_size);
-    memcpy(node_value(dict, node), value, dict->value_size);
-
-    node->next = dict->buckets[bucket_index];
-    dict->buckets[bucket_index] = node;
-    dict->count++;
+    memcpy(out_value, slot_value(dict, slot), dict->value_size);
     return 1;
 }
 
-int oaf_dict_try_get(const OafDict* dict, const void* key, void* out_value)
+size_t oaf_dict_try_get_many(const OafDict* dict, const void* keys, size_t count, void* out_values, unsigned char* out_found)
 {
-    size_t key_hash;
-    size_t bucket_index;
-    OafDictNode* node;
+    const unsigned char* key_bytes = (const unsigned char*)keys;
+    unsigned char* value_bytes = (unsigned char*)out_values;
+    size_t hashes[OAF_DICT_BATCH_SIZE];
+    size_t found = 0;
+    size_t done = 0;
 
-    if (dict == NULL || key == NULL || out_value == NULL || dict->bucket_count == 0)
+    if (dict == NULL || count == 0 || keys == NULL || out_values == NULL)
     {
         return 0;
     }
 
-    key_hash = hash_key(dict, key);
-    bucket_index = bucket_index_for_hash(key_hash, dict->bucket_count);
-    node = dict->buckets[bucket_index];
+    if (dict->bucket_count == 0)
+    {
+        if (out_found != NULL)
+        {
+            memset(out_found, 0, count);
+        }
+
+        return 0;
+    }
 
-    while (node != NULL)
+    while (done < count)
     {
-        if (node->hash == key_hash && keys_equal(dict, node_key_const(dict, node), key))
+        size_t batch = hash_batch(dict, key_bytes + done * dict->key_size, count - done, hashes);
+        size_t index;
+
+        for (index = 0; index < batch; index++)
         {
-            memcpy(out_value, node_value_const(dict, node), dict->value_size);
-            return 1;
+            size_t item = done + index;
+            size_t slot = find_slot(dict, key_bytes + item * dict->key_size, hashes[index], NULL);
+
+            if (slot != SIZE_MAX)
+            {
+                memcpy(value_bytes + item * dict->value_size, slot_value(dict, slot), dict->value_size);
+                found++;
+            }
+
+            if (out_found != NULL)
+            {
+                out_found[item] = (unsigned char)(slot != SIZE_MAX);
+            }
         }
 
-        node = node->next;
+        done += batch;
     }
 
-    return 0;
+    return found;
 }
 
 int oaf_dict_contains_key(const OafDict* dict, const void* key)
 {
-    size_t key_hash;
-    size_t bucket_index;
-    OafDictNode* node;
-
     if (dict == NULL || key == NULL || dict->bucket_count == 0)
     {
         return 0;
     }
 
-    key_hash = hash_key(dict, key);
-    bucket_index = bucket_index_for_hash(key_hash, dict->bucket_count);
-    node = dict->buckets[bucket_index];
-
-    while (node != NULL)
-    {
-        if (node->hash == key_hash && keys_equal(dict, node_key_const(dict, node), key))
-        {
-            return 1;
-        }
-
-        node = node->next;
-    }
-
-    return 0;
+    return find_slot(dict, key, hash_key(dict, key), NULL) != SIZE_MAX;
 }
 
 int oaf_dict_remove(OafDict* dict, const void* key, void* out_value)
 {
-    size_t key_hash;
-    size_t bucket_index;
-    OafDictNode* previous = NULL;
-    OafDictNode* node;
+    size_t mask;
+    size_t hole;
+    size_t next;
 
     if (dict == NULL || key == NULL || dict->bucket_count == 0)
     {
         return 0;
     }
 
-    key_hash = hash_key(dict, key);
-    bucket_index = bucket_index_for_hash(key_hash, dict->bucket_count);
-    node = dict->buckets[bucket_index];
+    hole = find_slot(dict, key, hash_key(dict, key), NULL);
+    if (hole == SIZE_MAX)
+    {
+        return 0;
+    }
 
-    while (node != NULL)
+    if (out_value != NULL)
     {
-        if (node->hash == key_hash && keys_equal(dict, node_key_const(dict, node), key))
-        {
-            if (out_value != NULL)
-            {
-                memcpy(out_value, node_value_const(dict, node), dict->value_size);
-            }
+        memcpy(out_value, slot_value(dict, hole), dict->value_size);
+    }
 
-            if (previous == NULL)
-            {
-                dict->buckets[bucket_index] = node->next;
-            }
-            else
-            {
-                previous->next = node->next;
-            }
+    /* Backward shift: pull later members of the probe run into the hole unless that would move them before their home slot. */
+    mask = dict->bucket_count - 1u;
+    next = (hole + 1u) & mask;
+    while ((dict->controls[next] & OAF_DICT_CONTROL_EMPTY) == 0)
+    {
+        size_t home = oaf_dict_home_slot(dict->hashes[next], dict->bucket_count);
 
-            oaf_allocator_free(dict->allocator, node);
-            dict->count--;
-            return 1;
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            memcpy(slot_key(dict, hole), slot_key(dict, next), dict->slot_size);
+            dict->hashes[hole] = dict->hashes[next];
+            set_control(dict, hole, dict->controls[next]);
+            hole = next;
         }
 
-        previous = node;
-        node = node->next;
+        next = (next + 1u) & mask;
+    }
+
+    set_control(dict, hole, (unsigned char)OAF_DICT_CONTROL_EMPTY);
+    dict->count--;
+    return 1;
+}
+
+uint64_t oaf_dict_hash_seed(void)
+{
+    return hash_seed();
+}
+
+int oaf_dict_hash_uses_aes(void)
+{
+    hash_seed();
+    return g_hash_use_aes;
+}
+
+size_t oaf_dict_hash_bytes_seeded(const void* data, size_t length, uint64_t seed)
+{
+    if (data == NULL || length == 0)
+    {
+        return 0;
     }
 
-    return 0;
+    return oaf_dict_fold(hash_words((const unsigned char*)data, length, seed));
 }
 
 size_t oaf_dict_hash_bytes(const void* data, size_t length)
 {
+    uint64_t seed;
+
     if (data == NULL || length == 0)
     {
         return 0;
     }
 
-    return fnv1a_bytes((const unsigned char*)data, length);
+    seed = hash_seed();
+#if OAF_DICT_AES
+    if (length >= 64u && g_hash_use_aes)
+    {
+        return oaf_dict_fold(hash_aes((const unsigned char*)data, length, seed));
+    }
+#endif
+
+    return oaf_dict_fold(hash_words((const unsigned char*)data, length, seed));
 }
 
 size_t oaf_dict_hash_i64(const void* key, void* state)
 {
-    const int64_t* value = (const int64_t*)key;
+    uint64_t value;
     (void)state;
 
-    if (value == NULL)
+    if (key == NULL)
     {
         return 0;
     }
 
-    return oaf_dict_hash_bytes(value, sizeof(int64_t));
+    memcpy(&value, key, sizeof(value));
+    return oaf_dict_hash_u64(value, hash_seed());
 }
 
 size_t oaf_dict_hash_cstr(const void* key, void* state)
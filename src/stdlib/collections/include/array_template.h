@@ -0,0 +1,254 @@
+#ifndef OAF_STDLIB_ARRAY_TEMPLATE_H
+#define OAF_STDLIB_ARRAY_TEMPLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+
+/* Storage alignment for a template element: max_align_t unless the type asks for more. */
+#define OAF_TEMPLATE_ALIGNMENT(T) (_Alignof(T) > _Alignof(max_align_t) ? _Alignof(T) : _Alignof(max_align_t))
+
+/* OAF_ARRAY_DEFINE(Name, prefix, T) declares Name, a growable array of T with the OafArray semantics, and
+   static inline prefix_init/destroy/reserve/resize/clear/at/get/set/push/pop/insert/remove_at. Elements are
+   passed by value and copied by assignment, so the compiler sees the element type. OafArray remains the
+   type-erased form for FFI and runtime-sized elements. */
+#define OAF_ARRAY_DEFINE(Name, prefix, T) \
+    typedef struct Name \
+    { \
+        T* data; \
+        size_t length; \
+        size_t capacity; \
+        OafAllocator* allocator; \
+    } Name; \
+\
+    static inline int prefix##_reserve(Name* array, size_t min_capacity); \
+\
+    static inline int prefix##_grow(Name* array, size_t min_capacity) \
+    { \
+        size_t next_capacity; \
+\
+        if (min_capacity <= array->capacity) \
+        { \
+            return 1; \
+        } \
+\
+        next_capacity = array->capacity == 0 ? 4u : array->capacity; \
+        while (next_capacity < min_capacity) \
+        { \
+            if (next_capacity > (SIZE_MAX / 2u)) \
+            { \
+                next_capacity = min_capacity; \
+                break; \
+            } \
+\
+            next_capacity *= 2u; \
+        } \
+\
+        return prefix##_reserve(array, next_capacity); \
+    } \
+\
+    static inline int prefix##_init(Name* array, size_t initial_capacity, OafAllocator* allocator) \
+    { \
+        if (array == NULL || allocator == NULL) \
+        { \
+            return 0; \
+        } \
+\
+        array->data = NULL; \
+        array->length = 0; \
+        array->capacity = 0; \
+        array->allocator = allocator; \
+        return initial_capacity == 0 || prefix##_reserve(array, initial_capacity); \
+    } \
+\
+    static inline void prefix##_destroy(Name* array) \
+    { \
+        if (array == NULL) \
+        { \
+            return; \
+        } \
+\
+        if (array->data != NULL && array->allocator != NULL) \
+        { \
+            oaf_allocator_free(array->allocator, array->data); \
+        } \
+\
+        array->data = NULL; \
+        array->length = 0; \
+        array->capacity = 0; \
+        array->allocator = NULL; \
+    } \
+\
+    static inline int prefix##_reserve(Name* array, size_t min_capacity) \
+    { \
+        T* resized; \
+\
+        if (array == NULL || array->allocator == NULL) \
+        { \
+            return 0; \
+        } \
+\
+        if (min_capacity <= array->capacity) \
+        { \
+            return 1; \
+        } \
+\
+        if (min_capacity > (SIZE_MAX / sizeof(T))) \
+        { \
+            return 0; \
+        } \
+\
+        if (array->data == NULL) \
+        { \
+            resized = (T*)oaf_allocator_alloc(array->allocator, min_capacity * sizeof(T), OAF_TEMPLATE_ALIGNMENT(T)); \
+        } \
+        else \
+        { \
+            resized = (T*)oaf_allocator_realloc( \
+                array->allocator, \
+                array->data, \
+                array->capacity * sizeof(T), \
+                min_capacity * sizeof(T), \
+                OAF_TEMPLATE_ALIGNMENT(T)); \
+        } \
+\
+        if (resized == NULL) \
+        { \
+            return 0; \
+        } \
+\
+        array->data = resized; \
+        array->capacity = min_capacity; \
+        return 1; \
+    } \
+\
+    static inline int prefix##_resize(Name* array, size_t new_length) \
+    { \
+        if (array == NULL) \
+        { \
+            return 0; \
+        } \
+\
+        if (new_length > array->length) \
+        { \
+            if (!prefix##_grow(array, new_length)) \
+            { \
+                return 0; \
+            } \
+\
+            memset(array->data + array->length, 0, (new_length - array->length) * sizeof(T)); \
+        } \
+\
+        array->length = new_length; \
+        return 1; \
+    } \
+\
+    static inline void prefix##_clear(Name* array) \
+    { \
+        if (array != NULL) \
+        { \
+            array->length = 0; \
+        } \
+    } \
+\
+    static inline T* prefix##_at(Name* array, size_t index) \
+    { \
+        if (array == NULL || index >= array->length) \
+        { \
+            return NULL; \
+        } \
+\
+        return array->data + index; \
+    } \
+\
+    static inline int prefix##_get(const Name* array, size_t index, T* out_element) \
+    { \
+        if (array == NULL || out_element == NULL || index >= array->length) \
+        { \
+            return 0; \
+        } \
+\
+        *out_element = array->data[index]; \
+        return 1; \
+    } \
+\
+    static inline int prefix##_set(Name* array, size_t index, T element) \
+    { \
+        if (array == NULL || index >= array->length) \
+        { \
+            return 0; \
+        } \
+\
+        array->data[index] = element; \
+        return 1; \
+    } \
+\
+    static inline int prefix##_push(Name* array, T element) \
+    { \
+        if (array == NULL || (array->length == array->capacity && !prefix##_grow(array, array->length + 1u))) \
+        { \
+            return 0; \
+        } \
+\
+        array->data[array->length++] = element; \
+        return 1; \
+    } \
+\
+    static inline int prefix##_pop(Name* array, T* out_element) \
+    { \
+        if (array == NULL || array->length == 0) \
+        { \
+            return 0; \
+        } \
+\
+        array->length--; \
+        if (out_element != NULL) \
+        { \
+            *out_element = array->data[array->length]; \
+        } \
+\
+        memset(array->data + array->length, 0, sizeof(T)); \
+        return 1; \
+    } \
+\
+    static inline int prefix##_insert(Name* array, size_t index, T element) \
+    { \
+        if (array == NULL || index > array->length || !prefix##_grow(array, array->length + 1u)) \
+        { \
+            return 0; \
+        } \
+\
+        if (index < array->length) \
+        { \
+            memmove(array->data + index + 1u, array->data + index, (array->length - index) * sizeof(T)); \
+        } \
+\
+        array->data[index] = element; \
+        array->length++; \
+        return 1; \
+    } \
+\
+    static inline int prefix##_remove_at(Name* array, size_t index, T* out_element) \
+    { \
+        if (array == NULL || index >= array->length) \
+        { \
+            return 0; \
+        } \
+\
+        if (out_element != NULL) \
+        { \
+            *out_element = array->data[index]; \
+        } \
+\
+        if (index + 1u < array->length) \
+        { \
+            memmove(array->data + index, array->data + index + 1u, (array->length - index - 1u) * sizeof(T)); \
+        } \
+\
+        array->length--; \
+        memset(array->data + array->length, 0, sizeof(T)); \
+        return 1; \
+    }
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef OAF_STDLIB_CONCURRENT_DICT_H
+#define OAF_STDLIB_CONCURRENT_DICT_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "allocator.h"
+#include "dict.h"
+#include "sync_primitives.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OAF_CONCURRENT_DICT_STRIPES 64
+#define OAF_CONCURRENT_DICT_READER_SHARDS 64
+#define OAF_CONCURRENT_DICT_TRANSFER_CHUNK 64
+#define OAF_CONCURRENT_DICT_RECLAIM_BATCH 1024
+
+typedef struct OafConcurrentDictNode OafConcurrentDictNode;
+typedef struct OafConcurrentDictTable OafConcurrentDictTable;
+typedef struct OafConcurrentDictStripe OafConcurrentDictStripe;
+typedef struct OafConcurrentDictReaderShard OafConcurrentDictReaderShard;
+
+/* Produces the value for an absent key; runs under the key's stripe lock and must not call back into the dict. */
+typedef int (*OafConcurrentDictComputeProc)(const void* key, void* out_value, void* state);
+
+/* Chained table guarded by striped writer locks. Readers take no locks: entries are immutable nodes replaced
+   copy-on-write and freed through epoch-based reclamation. Growing to a new table is shared by writers a chunk of
+   buckets at a time, with moved buckets forwarding lookups to the new table. The allocator must be thread-safe. */
+typedef struct OafConcurrentDict
+{
+    OafAllocator* allocator;
+    size_t key_size;
+    size_t value_size;
+    OafDictHashProc hash;
+    OafDictEqualsProc equals;
+    void* callback_state;
+    _Atomic(OafConcurrentDictTable*) table;
+    atomic_size_t bucket_count;
+    OafConcurrentDictStripe* stripes;
+    OafConcurrentDictReaderShard* readers;
+    atomic_uint epoch;
+    _Atomic(OafConcurrentDictNode*) retired_nodes;
+    _Atomic(OafConcurrentDictTable*) retired_tables;
+    atomic_size_t retired_count;
+    atomic_size_t reclaim_at;
+    atomic_int reclaiming;
+    OafConcurrentDictNode* pending_nodes;
+    OafConcurrentDictTable* pending_tables;
+    unsigned int pending_parity;
+    atomic_size_t resizes;
+} OafConcurrentDict;
+
+int oaf_concurrent_dict_init(
+    OafConcurrentDict* dict,
+    size_t key_size,
+    size_t value_size,
+    size_t initial_capacity,
+    OafDictHashProc hash,
+    OafDictEqualsProc equals,
+    void* callback_state,
+    OafAllocator* allocator);
+void oaf_concurrent_dict_destroy(OafConcurrentDict* dict);
+
+size_t oaf_concurrent_dict_count(const OafConcurrentDict* dict);
+size_t oaf_concurrent_dict_bucket_count(const OafConcurrentDict* dict);
+size_t oaf_concurrent_dict_resize_count(const OafConcurrentDict* dict);
+
+int oaf_concurrent_dict_set(OafConcurrentDict* dict, const void* key, const void* value);
+int oaf_concurrent_dict_try_get(OafConcurrentDict* dict, const void* key, void* out_value);
+int oaf_concurrent_dict_contains_key(OafConcurrentDict* dict, const void* key);
+int oaf_concurrent_dict_remove(OafConcurrentDict* dict, const void* key, void* out_value);
+int oaf_concurrent_dict_get_or_insert(OafConcurrentDict* dict, const void* key, const void* value, void* out_value, int* out_inserted);
+int oaf_concurrent_dict_compute_if_absent(
+    OafConcurrentDict* dict,
+    const void* key,
+    OafConcurrentDictComputeProc compute,
+    void* compute_state,
+    void* out_value,
+    int* out_inserted);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
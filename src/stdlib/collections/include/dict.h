@@ -2,6 +2,7 @@
 #define OAF_STDLIB_DICT_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include "allocator.h"
 
 #ifdef __cplusplus
@@ -11,19 +12,28 @@ extern "C" {
 typedef size_t (*OafDictHashProc)(const void* key, void* state);
 typedef int (*OafDictEqualsProc)(const void* left, const void* right, void* state);
 
-typedef struct OafDictNode OafDictNode;
+#define OAF_DICT_GROUP_WIDTH 16
+#define OAF_DICT_MIN_CAPACITY 16
+#define OAF_DICT_BATCH_SIZE 16
 
+/* Flat linear-probing table: one control byte per slot (0x80 when empty, otherwise 7 hash bits) scanned a
+   group at a time, keys and values stored inline, and removal by backward shift so no tombstones are left.
+   Callback hashes are re-mixed with a per-dict seed before probing, so weak hashes such as identity are safe. */
 typedef struct OafDict
 {
     OafAllocator* allocator;
     size_t key_size;
     size_t value_size;
+    size_t slot_size;
     size_t count;
     size_t bucket_count;
     OafDictHashProc hash;
     OafDictEqualsProc equals;
     void* callback_state;
-    OafDictNode** buckets;
+    uint64_t seed;
+    unsigned char* controls;
+    unsigned char* slots;
+    size_t* hashes;
 } OafDict;
 
 int oaf_dict_init(
@@ -47,7 +57,16 @@ int oaf_dict_try_get(const OafDict* dict, const void* key, void* out_value);
 int oaf_dict_contains_key(const OafDict* dict, const void* key);
 int oaf_dict_remove(OafDict* dict, const void* key, void* out_value);
 
+/* Batched forms over packed key and value arrays: the table is sized once, and each batch of keys is hashed and
+   its slots prefetched before probing. Missing keys leave their output value untouched; out_found may be NULL. */
+int oaf_dict_set_many(OafDict* dict, const void* keys, const void* values, size_t count);
+size_t oaf_dict_try_get_many(const OafDict* dict, const void* keys, size_t count, void* out_values, unsigned char* out_found);
+
+/* Hashes are seeded once per process from the OS entropy source, so they differ between runs. */
+uint64_t oaf_dict_hash_seed(void);
+int oaf_dict_hash_uses_aes(void);
 size_t oaf_dict_hash_bytes(const void* data, size_t length);
+size_t oaf_dict_hash_bytes_seeded(const void* data, size_t length, uint64_t seed);
 size_t oaf_dict_hash_i64(const void* key, void* state);
 size_t oaf_dict_hash_cstr(const void* key, void* state);
 int oaf_dict_equals_i64(const void* left, const void* right, void* state);
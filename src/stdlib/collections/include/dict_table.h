@@ -0,0 +1,228 @@
+#ifndef OAF_STDLIB_DICT_TABLE_H
+#define OAF_STDLIB_DICT_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dict.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define OAF_DICT_SSE2 1
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define OAF_DICT_NEON 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Table primitives shared by OafDict and the OAF_DICT_DEFINE instantiations so both probe the same layout. */
+
+#define OAF_DICT_CONTROL_EMPTY 0x80u
+#define OAF_DICT_HASH_BITS 7u
+
+#define OAF_DICT_SECRET_0 0x2d358dccaa6c78a5ull
+#define OAF_DICT_SECRET_1 0x8bb84b93962eacc9ull
+#define OAF_DICT_SECRET_2 0x4b33a62ed433d4a3ull
+#define OAF_DICT_SECRET_3 0x4d5a2da51de1aa47ull
+
+#if defined(OAF_DICT_NEON)
+#define OAF_DICT_MASK_SHIFT 2u
+#else
+#define OAF_DICT_MASK_SHIFT 0u
+#endif
+
+/* Bit mask over one group of control bytes; bit (index << OAF_DICT_MASK_SHIFT) is set for each matching slot. */
+typedef uint64_t OafDictGroupMask;
+
+static inline void oaf_dict_multiply(uint64_t* left, uint64_t* right)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = (__uint128_t)*left * *right;
+    *left = (uint64_t)product;
+    *right = (uint64_t)(product >> 64);
+#else
+    uint64_t left_high = *left >> 32;
+    uint64_t left_low = (uint32_t)*left;
+    uint64_t right_high = *right >> 32;
+    uint64_t right_low = (uint32_t)*right;
+    uint64_t high_high = left_high * right_high;
+    uint64_t high_low = left_high * right_low;
+    uint64_t low_high = left_low * right_high;
+    uint64_t low_low = left_low * right_low;
+    uint64_t middle = (low_low >> 32) + (uint32_t)high_low + (uint32_t)low_high;
+    *left = (middle << 32) | (uint32_t)low_low;
+    *right = high_high + (high_low >> 32) + (low_high >> 32) + (middle >> 32);
+#endif
+}
+
+static inline uint64_t oaf_dict_mix(uint64_t left, uint64_t right)
+{
+    oaf_dict_multiply(&left, &right);
+    return left ^ right;
+}
+
+static inline size_t oaf_dict_fold(uint64_t hash)
+{
+#if SIZE_MAX == UINT64_MAX
+    return (size_t)hash;
+#else
+    return (size_t)(hash ^ (hash >> 32));
+#endif
+}
+
+/* The oaf_dict_hash_i64 mixer with the seed passed in, so typed tables can fetch the process seed once. */
+static inline size_t oaf_dict_hash_u64(uint64_t value, uint64_t seed)
+{
+    seed ^= OAF_DICT_SECRET_1;
+    value ^= OAF_DICT_SECRET_0;
+    oaf_dict_multiply(&value, &seed);
+    return oaf_dict_fold(oaf_dict_mix(value ^ OAF_DICT_SECRET_0, seed ^ OAF_DICT_SECRET_1));
+}
+
+#if defined(OAF_DICT_SSE2)
+static inline OafDictGroupMask oaf_dict_group_match(const unsigned char* controls, unsigned char tag)
+{
+    __m128i group = _mm_loadu_si128((const __m128i*)controls);
+    return (OafDictGroupMask)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+}
+
+static inline OafDictGroupMask oaf_dict_group_match_empty(const unsigned char* controls)
+{
+    return (OafDictGroupMask)(unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)controls));
+}
+#elif defined(OAF_DICT_NEON)
+static inline OafDictGroupMask oaf_dict_narrow_mask(uint8x16_t lanes)
+{
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(lanes), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull;
+}
+
+static inline OafDictGroupMask oaf_dict_group_match(const unsigned char* controls, unsigned char tag)
+{
+    return oaf_dict_narrow_mask(vceqq_u8(vld1q_u8(controls), vdupq_n_u8(tag)));
+}
+
+static inline OafDictGroupMask oaf_dict_group_match_empty(const unsigned char* controls)
+{
+    return oaf_dict_narrow_mask(vtstq_u8(vld1q_u8(controls), vdupq_n_u8((uint8_t)OAF_DICT_CONTROL_EMPTY)));
+}
+#else
+static inline OafDictGroupMask oaf_dict_group_match(const unsigned char* controls, unsigned char tag)
+{
+    OafDictGroupMask mask = 0;
+    size_t index;
+
+    for (index = 0; index < OAF_DICT_GROUP_WIDTH; index++)
+    {
+        mask |= (OafDictGroupMask)(controls[index] == tag) << index;
+    }
+
+    return mask;
+}
+
+static inline OafDictGroupMask oaf_dict_group_match_empty(const unsigned char* controls)
+{
+    OafDictGroupMask mask = 0;
+    size_t index;
+
+    for (index = 0; index < OAF_DICT_GROUP_WIDTH; index++)
+    {
+        mask |= (OafDictGroupMask)((controls[index] & OAF_DICT_CONTROL_EMPTY) != 0) << index;
+    }
+
+    return mask;
+}
+#endif
+
+/* Drops candidate matches at or past the first empty slot, which ends the probe run. */
+static inline OafDictGroupMask oaf_dict_group_before_empty(OafDictGroupMask match, OafDictGroupMask empty)
+{
+    return empty != 0 ? match & ((empty & (~empty + 1u)) - 1u) : match;
+}
+
+static inline size_t oaf_dict_group_lowest(OafDictGroupMask mask)
+{
+    return (size_t)__builtin_ctzll(mask) >> OAF_DICT_MASK_SHIFT;
+}
+
+/* Callback hashes may be weak (identity over integers is common), so the table only probes with a spread hash. */
+static inline size_t oaf_dict_spread(size_t hash, uint64_t seed)
+{
+    return oaf_dict_fold(oaf_dict_mix((uint64_t)hash ^ seed, OAF_DICT_SECRET_2));
+}
+
+/* Home slot from the high bits of a spread hash; the tag comes from the low bits, so the two stay independent. */
+static inline size_t oaf_dict_home_slot(size_t hash, size_t capacity)
+{
+    return hash >> (sizeof(size_t) * 8u - (size_t)__builtin_ctzll((unsigned long long)capacity));
+}
+
+static inline unsigned char oaf_dict_hash_tag(size_t hash)
+{
+    return (unsigned char)(hash & 0x7fu);
+}
+
+static inline size_t oaf_dict_max_load(size_t capacity)
+{
+    return capacity - capacity / 8u;
+}
+
+/* Smallest power-of-two capacity whose load limit holds min_count entries, or 0 on overflow. */
+static inline size_t oaf_dict_capacity_for(size_t min_count)
+{
+    size_t capacity = OAF_DICT_MIN_CAPACITY;
+
+    while (oaf_dict_max_load(capacity) < min_count)
+    {
+        if (capacity > (SIZE_MAX / 2u))
+        {
+            return 0;
+        }
+
+        capacity *= 2u;
+    }
+
+    return capacity;
+}
+
+/* One block per table: slots, then the side array of full hashes, then capacity + group width control bytes. */
+static inline int oaf_dict_table_layout(
+    size_t capacity,
+    size_t slot_size,
+    size_t* out_hashes_offset,
+    size_t* out_controls_offset,
+    size_t* out_bytes)
+{
+    size_t slot_bytes;
+    size_t hashes_offset;
+
+    if (capacity > (SIZE_MAX / slot_size) || capacity > (SIZE_MAX / sizeof(size_t)))
+    {
+        return 0;
+    }
+
+    slot_bytes = capacity * slot_size;
+    if (slot_bytes > SIZE_MAX - (sizeof(size_t) - 1u))
+    {
+        return 0;
+    }
+
+    hashes_offset = (slot_bytes + sizeof(size_t) - 1u) & ~(sizeof(size_t) - 1u);
+    if (hashes_offset > SIZE_MAX - capacity * sizeof(size_t) - capacity - OAF_DICT_GROUP_WIDTH)
+    {
+        return 0;
+    }
+
+    *out_hashes_offset = hashes_offset;
+    *out_controls_offset = hashes_offset + capacity * sizeof(size_t);
+    *out_bytes = *out_controls_offset + capacity + OAF_DICT_GROUP_WIDTH;
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,366 @@
+#ifndef OAF_STDLIB_DICT_TEMPLATE_H
+#define OAF_STDLIB_DICT_TEMPLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+#include "array_template.h"
+#include "dict.h"
+#include "dict_table.h"
+
+/* Key callbacks for OAF_DICT_DEFINE. The table spreads every hash with its seed, so the i64 hash can be the key. */
+static inline size_t oaf_dict_key_hash_i64(const int64_t* key, uint64_t seed)
+{
+    (void)seed;
+    return (size_t)*key;
+}
+
+static inline int oaf_dict_key_equals_i64(const int64_t* left, const int64_t* right)
+{
+    return *left == *right;
+}
+
+/* OAF_DICT_DEFINE(Name, prefix, K, V, hash, equals) declares Name, an OafDict-layout table with K keys and V values
+   stored in typed slots, and static inline prefix_init/destroy/clear/count/bucket_count/reserve/set/get/try_get/
+   contains_key/remove. hash is size_t (*)(const K*, uint64_t seed) and equals is int (*)(const K*, const K*);
+   naming functions here lets the compiler inline them along with the key and value copies. The process hash seed
+   is read once at init, and hash results are spread with it before probing, so weak hashes are safe. OafDict
+   remains the type-erased form for FFI and runtime-sized keys. */
+#define OAF_DICT_DEFINE(Name, prefix, K, V, hash, equals) \
+    typedef struct Name##Slot \
+    { \
+        K key; \
+        V value; \
+    } Name##Slot; \
+\
+    typedef struct Name \
+    { \
+        OafAllocator* allocator; \
+        size_t count; \
+        size_t bucket_count; \
+        uint64_t seed; \
+        unsigned char* controls; \
+        Name##Slot* slots; \
+        size_t* hashes; \
+    } Name; \
+\
+    static inline void prefix##_set_control(Name* dict, size_t slot, unsigned char control) \
+    { \
+        dict->controls[slot] = control; \
+        if (slot < OAF_DICT_GROUP_WIDTH) \
+        { \
+            dict->controls[dict->bucket_count + slot] = control; \
+        } \
+    } \
+\
+    static inline size_t prefix##_hash(const Name* dict, const K* key) \
+    { \
+        return oaf_dict_spread(hash(key, dict->seed), dict->seed); \
+    } \
+\
+    static inline size_t prefix##_find(const Name* dict, const K* key, size_t key_hash, size_t* out_insert_slot) \
+    { \
+        size_t mask = dict->bucket_count - 1u; \
+        size_t position = oaf_dict_home_slot(key_hash, dict->bucket_count); \
+        unsigned char tag = oaf_dict_hash_tag(key_hash); \
+\
+        for (;;) \
+        { \
+            const unsigned char* group = dict->controls + position; \
+            OafDictGroupMask empty = oaf_dict_group_match_empty(group); \
+            OafDictGroupMask match = oaf_dict_group_before_empty(oaf_dict_group_match(group, tag), empty); \
+\
+            while (match != 0) \
+            { \
+                size_t slot = (position + oaf_dict_group_lowest(match)) & mask; \
+                if (equals(&dict->slots[slot].key, key)) \
+                { \
+                    return slot; \
+                } \
+\
+                match &= match - 1u; \
+            } \
+\
+            if (empty != 0) \
+            { \
+                if (out_insert_slot != NULL) \
+                { \
+                    *out_insert_slot = (position + oaf_dict_group_lowest(empty)) & mask; \
+                } \
+                return SIZE_MAX; \
+            } \
+\
+            position = (position + OAF_DICT_GROUP_WIDTH) & mask; \
+        } \
+    } \
+\
+    static inline size_t prefix##_find_empty(const Name* dict, size_t key_hash) \
+    { \
+        size_t mask = dict->bucket_count - 1u; \
+        size_t position = oaf_dict_home_slot(key_hash, dict->bucket_count); \
+\
+        for (;;) \
+        { \
+            OafDictGroupMask empty = oaf_dict_group_match_empty(dict->controls + position); \
+            if (empty != 0) \
+            { \
+                return (position + oaf_dict_group_lowest(empty)) & mask; \
+            } \
+\
+            position = (position + OAF_DICT_GROUP_WIDTH) & mask; \
+        } \
+    } \
+\
+    static inline int prefix##_rehash(Name* dict, size_t capacity) \
+    { \
+        Name##Slot* previous_slots = dict->slots; \
+        size_t* previous_hashes = dict->hashes; \
+        unsigned char* previous_controls = dict->controls; \
+        size_t previous_capacity = dict->bucket_count; \
+        size_t hashes_offset; \
+        size_t controls_offset; \
+        size_t bytes; \
+        unsigned char* block; \
+        size_t slot; \
+\
+        if (!oaf_dict_table_layout(capacity, sizeof(Name##Slot), &hashes_offset, &controls_offset, &bytes)) \
+        { \
+            return 0; \
+        } \
+\
+        block = (unsigned char*)oaf_allocator_alloc(dict->allocator, bytes, OAF_TEMPLATE_ALIGNMENT(Name##Slot)); \
+        if (block == NULL) \
+        { \
+            return 0; \
+        } \
+\
+        dict->slots = (Name##Slot*)block; \
+        dict->hashes = (size_t*)(block + hashes_offset); \
+        dict->controls = block + controls_offset; \
+        dict->bucket_count = capacity; \
+        memset(dict->controls, OAF_DICT_CONTROL_EMPTY, capacity + OAF_DICT_GROUP_WIDTH); \
+\
+        for (slot = 0; slot < previous_capacity; slot++) \
+        { \
+            size_t target; \
+\
+            if ((previous_controls[slot] & OAF_DICT_CONTROL_EMPTY) != 0) \
+            { \
+                continue; \
+            } \
+\
+            target = prefix##_find_empty(dict, previous_hashes[slot]); \
+            dict->slots[target] = previous_slots[slot]; \
+            dict->hashes[target] = previous_hashes[slot]; \
+            prefix##_set_control(dict, target, oaf_dict_hash_tag(previous_hashes[slot])); \
+        } \
+\
+        if (previous_slots != NULL) \
+        { \
+            oaf_allocator_free(dict->allocator, previous_slots); \
+        } \
+\
+        return 1; \
+    } \
+\
+    static inline int prefix##_reserve(Name* dict, size_t min_capacity) \
+    { \
+        size_t capacity; \
+\
+        if (dict == NULL || dict->allocator == NULL) \
+        { \
+            return 0; \
+        } \
+\
+        if (dict->bucket_count != 0 && oaf_dict_max_load(dict->bucket_count) >= min_capacity) \
+        { \
+            return 1; \
+        } \
+\
+        capacity = oaf_dict_capacity_for(min_capacity > dict->count ? min_capacity : dict->count); \
+        return capacity != 0 && prefix##_rehash(dict, capacity); \
+    } \
+\
+    static inline int prefix##_init(Name* dict, size_t initial_capacity, OafAllocator* allocator) \
+    { \
+        if (dict == NULL || allocator == NULL) \
+        { \
+            return 0; \
+        } \
+\
+        dict->allocator = allocator; \
+        dict->count = 0; \
+        dict->bucket_count = 0; \
+        dict->seed = oaf_dict_hash_seed(); \
+        dict->controls = NULL; \
+        dict->slots = NULL; \
+        dict->hashes = NULL; \
+        return initial_capacity == 0 || prefix##_reserve(dict, initial_capacity); \
+    } \
+\
+    static inline void prefix##_clear(Name* dict) \
+    { \
+        if (dict == NULL || dict->allocator == NULL) \
+        { \
+            return; \
+        } \
+\
+        if (dict->slots != NULL) \
+        { \
+            oaf_allocator_free(dict->allocator, dict->slots); \
+        } \
+\
+        dict->slots = NULL; \
+        dict->hashes = NULL; \
+        dict->controls = NULL; \
+        dict->bucket_count = 0; \
+        dict->count = 0; \
+    } \
+\
+    static inline void prefix##_destroy(Name* dict) \
+    { \
+        if (dict == NULL) \
+        { \
+            return; \
+        } \
+\
+        prefix##_clear(dict); \
+        dict->allocator = NULL; \
+    } \
+\
+    static inline size_t prefix##_count(const Name* dict) \
+    { \
+        return dict == NULL ? 0 : dict->count; \
+    } \
+\
+    static inline size_t prefix##_bucket_count(const Name* dict) \
+    { \
+        return dict == NULL ? 0 : dict->bucket_count; \
+    } \
+\
+    static inline int prefix##_set(Name* dict, K key, V value) \
+    { \
+        size_t key_hash; \
+        size_t slot; \
+        size_t insert_slot = 0; \
+\
+        if (dict == NULL || (dict->bucket_count == 0 && !prefix##_reserve(dict, OAF_DICT_MIN_CAPACITY))) \
+        { \
+            return 0; \
+        } \
+\
+        key_hash = prefix##_hash(dict, &key); \
+        slot = prefix##_find(dict, &key, key_hash, &insert_slot); \
+        if (slot != SIZE_MAX) \
+        { \
+            dict->slots[slot].value = value; \
+            return 1; \
+        } \
+\
+        if (dict->count >= oaf_dict_max_load(dict->bucket_count)) \
+        { \
+            if (dict->bucket_count > (SIZE_MAX / 2u) || !prefix##_rehash(dict, dict->bucket_count * 2u)) \
+            { \
+                return 0; \
+            } \
+\
+            insert_slot = prefix##_find_empty(dict, key_hash); \
+        } \
+\
+        dict->slots[insert_slot].key = key; \
+        dict->slots[insert_slot].value = value; \
+        dict->hashes[insert_slot] = key_hash; \
+        prefix##_set_control(dict, insert_slot, oaf_dict_hash_tag(key_hash)); \
+        dict->count++; \
+        return 1; \
+    } \
+\
+    /* The returned pointer is invalidated by the next set or remove. */ \
+    static inline V* prefix##_get(Name* dict, K key) \
+    { \
+        size_t slot; \
+\
+        if (dict == NULL || dict->bucket_count == 0) \
+        { \
+            return NULL; \
+        } \
+\
+        slot = prefix##_find(dict, &key, prefix##_hash(dict, &key), NULL); \
+        return slot == SIZE_MAX ? NULL : &dict->slots[slot].value; \
+    } \
+\
+    static inline int prefix##_try_get(const Name* dict, K key, V* out_value) \
+    { \
+        size_t slot; \
+\
+        if (dict == NULL || out_value == NULL || dict->bucket_count == 0) \
+        { \
+            return 0; \
+        } \
+\
+        slot = prefix##_find(dict, &key, prefix##_hash(dict, &key), NULL); \
+        if (slot == SIZE_MAX) \
+        { \
+            return 0; \
+        } \
+\
+        *out_value = dict->slots[slot].value; \
+        return 1; \
+    } \
+\
+    static inline int prefix##_contains_key(const Name* dict, K key) \
+    { \
+        if (dict == NULL || dict->bucket_count == 0) \
+        { \
+            return 0; \
+        } \
+\
+        return prefix##_find(dict, &key, prefix##_hash(dict, &key), NULL) != SIZE_MAX; \
+    } \
+\
+    static inline int prefix##_remove(Name* dict, K key, V* out_value) \
+    { \
+        size_t mask; \
+        size_t hole; \
+        size_t next; \
+\
+        if (dict == NULL || dict->bucket_count == 0) \
+        { \
+            return 0; \
+        } \
+\
+        hole = prefix##_find(dict, &key, prefix##_hash(dict, &key), NULL); \
+        if (hole == SIZE_MAX) \
+        { \
+            return 0; \
+        } \
+\
+        if (out_value != NULL) \
+        { \
+            *out_value = dict->slots[hole].value; \
+        } \
+\
+        mask = dict->bucket_count - 1u; \
+        next = (hole + 1u) & mask; \
+        while ((dict->controls[next] & OAF_DICT_CONTROL_EMPTY) == 0) \
+        { \
+            size_t home = oaf_dict_home_slot(dict->hashes[next], dict->bucket_count); \
+\
+            if (((next - home) & mask) >= ((next - hole) & mask)) \
+            { \
+                dict->slots[hole] = dict->slots[next]; \
+                dict->hashes[hole] = dict->hashes[next]; \
+                prefix##_set_control(dict, hole, dict->controls[next]); \
+                hole = next; \
+            } \
+\
+            next = (next + 1u) & mask; \
+        } \
+\
+        prefix##_set_control(dict, hole, (unsigned char)OAF_DICT_CONTROL_EMPTY); \
+        dict->count--; \
+        return 1; \
+    }
+
+#endif
@@ -31,6 +31,7 @@ size_t oaf_set_count(const OafSet* set);
 int oaf_set_reserve(OafSet* set, size_t min_capacity);
 
 int oaf_set_add(OafSet* set, const void* element);
+int oaf_set_add_many(OafSet* set, const void* elements, size_t count);
 int oaf_set_contains(const OafSet* set, const void* element);
 int oaf_set_remove(OafSet* set, const void* element);
 
@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <string.h>
 #include "set.h"
 
 int oaf_set_init(
@@ -78,6 +79,38 @@ int oaf_set_add(OafSet* set, const void* element)
     return oaf_dict_set(&set->storage, element, &marker);
 }
 
+int oaf_set_add_many(OafSet* set, const void* elements, size_t count)
+{
+    const unsigned char* element_bytes = (const unsigned char*)elements;
+    uint8_t markers[OAF_DICT_BATCH_SIZE * 16];
+    size_t done = 0;
+
+    if (set == NULL || (count != 0 && elements == NULL))
+    {
+        return 0;
+    }
+
+    if (count > SIZE_MAX - set->storage.count || !oaf_dict_reserve(&set->storage, set->storage.count + count))
+    {
+        return 0;
+    }
+
+    memset(markers, 1, sizeof(markers));
+    while (done < count)
+    {
+        size_t chunk = count - done < sizeof(markers) ? count - done : sizeof(markers);
+
+        if (!oaf_dict_set_many(&set->storage, element_bytes + done * set->storage.key_size, markers, chunk))
+        {
+            return 0;
+        }
+
+        done += chunk;
+    }
+
+    return 1;
+}
+
 int oaf_set_contains(const OafSet* set, const void* element)
 {
     if (set == NULL || element == NULL)
@@ -1,11 +1,42 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include "array.h"
+#include "arena_allocator.h"
+#include "array_template.h"
 #include "list.h"
 #include "dict.h"
+#include "dict_template.h"
 #include "set.h"
 #include "default_allocator.h"
 
+typedef struct GridPoint
+{
+    int32_t x;
+    int32_t y;
+} GridPoint;
+
+static size_t hash_grid_point(const GridPoint* point, uint64_t seed)
+{
+    return oaf_dict_hash_u64(((uint64_t)(uint32_t)point->x << 32) | (uint32_t)point->y, seed);
+}
+
+static int equals_grid_point(const GridPoint* left, const GridPoint* right)
+{
+    return left->x == right->x && left->y == right->y;
+}
+
+typedef struct WideLane
+{
+    _Alignas(64) int64_t lanes[2];
+} WideLane;
+
+OAF_ARRAY_DEFINE(I64Array, i64_array, int64_t)
+OAF_ARRAY_DEFINE(WideArray, wide_array, WideLane)
+OAF_DICT_DEFINE(WideDict, wide_dict, int64_t, WideLane, oaf_dict_key_hash_i64, oaf_dict_key_equals_i64)
+OAF_DICT_DEFINE(I64Dict, i64_dict, int64_t, int64_t, oaf_dict_key_hash_i64, oaf_dict_key_equals_i64)
+OAF_DICT_DEFINE(GridDict, grid_dict, GridPoint, GridPoint, hash_grid_point, equals_grid_point)
+
 static int equals_int(const void* element, const void* needle, void* state)
 {
     const int* left = (const int*)element;
@@ -178,6 +209,400 @@ static int test_dict(void)
     return ok && state.active_allocations == 0;
 }
 
+static size_t hash_low_bits(const void* key, void* state)
+{
+    const int64_t* value = (const int64_t*)key;
+    (void)state;
+    return (size_t)(*value & 0x3) << 7;
+}
+
+static size_t hash_identity(const void* key, void* state)
+{
+    (void)state;
+    return (size_t)*(const int64_t*)key;
+}
+
+static int equals_counted(const void* left, const void* right, void* state)
+{
+    size_t* calls = (size_t*)state;
+    (*calls)++;
+    return *(const int64_t*)left == *(const int64_t*)right;
+}
+
+static int test_dict_open_addressing(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafDict dict;
+    OafDict colliding;
+    unsigned char present[4096];
+    int64_t key;
+    int64_t value;
+    size_t capacity;
+    size_t expected = 0;
+    size_t round;
+    uint32_t seed = 12345u;
+    int ok = 1;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_dict_init(&dict, sizeof(int64_t), sizeof(int64_t), 1000, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, &allocator))
+    {
+        return 0;
+    }
+
+    capacity = oaf_dict_bucket_count(&dict);
+    ok = ok && capacity >= 1000 && (capacity & (capacity - 1u)) == 0;
+    memset(present, 0, sizeof(present));
+
+    for (round = 0; ok && round < 200000; round++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        key = (int64_t)((seed >> 8) % 1000u);
+        if ((seed & 1u) != 0)
+        {
+            value = key + 7;
+            ok = oaf_dict_set(&dict, &key, &value);
+            expected += present[key] ? 0u : 1u;
+            present[key] = 1;
+        }
+        else
+        {
+            ok = oaf_dict_remove(&dict, &key, &value) == present[key] && (!present[key] || value == key + 7);
+            expected -= present[key] ? 1u : 0u;
+            present[key] = 0;
+        }
+    }
+
+    ok = ok && oaf_dict_count(&dict) == expected && oaf_dict_bucket_count(&dict) == capacity;
+    for (key = 0; ok && key < 1000; key++)
+    {
+        ok = oaf_dict_try_get(&dict, &key, &value) == present[key] && (!present[key] || value == key + 7);
+    }
+
+    oaf_dict_destroy(&dict);
+
+    if (!oaf_dict_init(&colliding, sizeof(int64_t), sizeof(int64_t), 0, hash_low_bits, oaf_dict_equals_i64, NULL, &allocator))
+    {
+        return 0;
+    }
+
+    for (key = 0; ok && key < 4096; key++)
+    {
+        ok = oaf_dict_set(&colliding, &key, &key);
+    }
+
+    for (key = 0; ok && key < 4096; key += 2)
+    {
+        ok = oaf_dict_remove(&colliding, &key, NULL);
+    }
+
+    for (key = 0; ok && key < 4096; key++)
+    {
+        ok = oaf_dict_try_get(&colliding, &key, &value) == (int)(key & 1) && (!(key & 1) || value == key);
+    }
+
+    ok = ok && oaf_dict_count(&colliding) == 2048;
+    oaf_dict_destroy(&colliding);
+    return ok && state.active_allocations == 0;
+}
+
+static int test_dict_weak_hash(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafDict dict;
+    size_t equals_calls = 0;
+    int64_t key;
+    int64_t value;
+    int ok = 1;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_dict_init(&dict, sizeof(int64_t), sizeof(int64_t), 0, hash_identity, equals_counted, &equals_calls, &allocator))
+    {
+        return 0;
+    }
+
+    for (key = 0; ok && key < 100000; key++)
+    {
+        ok = oaf_dict_set(&dict, &key, &key);
+    }
+
+    for (key = 0; ok && key < 200000; key++)
+    {
+        ok = oaf_dict_try_get(&dict, &key, &value) == (key < 100000) && (key >= 100000 || value == key);
+    }
+
+    /* Identity hashes over sequential keys must not collapse into one probe run: hits compare about once each. */
+    ok = ok && oaf_dict_count(&dict) == 100000 && equals_calls < 300000;
+    oaf_dict_destroy(&dict);
+    return ok && state.active_allocations == 0;
+}
+
+static int test_dict_hashing(void)
+{
+    unsigned char buffer[4200];
+    unsigned char seen[1024];
+    size_t hashes[160];
+    size_t length;
+    size_t index;
+    size_t buckets = 0;
+    int64_t key;
+    int ok = 1;
+
+    for (index = 0; index < sizeof(buffer); index++)
+    {
+        buffer[index] = (unsigned char)(index * 31u + 7u);
+    }
+
+    ok = ok && oaf_dict_hash_seed() == oaf_dict_hash_seed();
+    ok = ok && oaf_dict_hash_bytes(NULL, 8) == 0 && oaf_dict_hash_bytes(buffer, 0) == 0;
+
+    for (length = 1; ok && length <= 160; length++)
+    {
+        hashes[length - 1u] = oaf_dict_hash_bytes(buffer, length);
+        ok = oaf_dict_hash_bytes(buffer + 1, length) != hashes[length - 1u];
+        for (index = 0; ok && index + 1u < length; index++)
+        {
+            ok = hashes[index] != hashes[length - 1u];
+        }
+    }
+
+    for (length = 64; ok && length <= 4096; length *= 4u)
+    {
+        memmove(buffer + 3, buffer, length);
+        index = oaf_dict_hash_bytes(buffer + 3, length);
+        memmove(buffer, buffer + 3, length);
+        ok = oaf_dict_hash_bytes(buffer, length) == index;
+        buffer[length / 2u] ^= 1u;
+        ok = ok && oaf_dict_hash_bytes(buffer, length) != index;
+        buffer[length / 2u] ^= 1u;
+    }
+
+    ok = ok && oaf_dict_hash_bytes_seeded(buffer, 32, 1) == oaf_dict_hash_bytes_seeded(buffer, 32, 1);
+    ok = ok && oaf_dict_hash_bytes_seeded(buffer, 32, 1) != oaf_dict_hash_bytes_seeded(buffer, 32, 2);
+
+    memset(seen, 0, sizeof(seen));
+    for (key = 0; key < 1024; key++)
+    {
+        size_t bucket = (oaf_dict_hash_i64(&key, NULL) >> 7) & 1023u;
+        buckets += seen[bucket] ? 0u : 1u;
+        seen[bucket] = 1;
+    }
+
+    return ok && buckets > 550;
+}
+
+static int test_dict_batched(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    OafDict batched;
+    OafDict single;
+    OafSet set;
+    static int64_t keys[3000];
+    static int64_t values[3000];
+    static int64_t probes[5000];
+    static int64_t found_values[5000];
+    static unsigned char found[5000];
+    int64_t expected;
+    size_t index;
+    int ok = 1;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!oaf_dict_init(&batched, sizeof(int64_t), sizeof(int64_t), 0, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, &allocator))
+    {
+        return 0;
+    }
+
+    if (!oaf_dict_init(&single, sizeof(int64_t), sizeof(int64_t), 0, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, &allocator))
+    {
+        oaf_dict_destroy(&batched);
+        return 0;
+    }
+
+    for (index = 0; index < 3000; index++)
+    {
+        keys[index] = (int64_t)((index * 7919u) % 2500u);
+        values[index] = (int64_t)index;
+        ok = ok && oaf_dict_set(&single, &keys[index], &values[index]);
+    }
+
+    ok = ok && oaf_dict_set_many(&batched, keys, values, 0);
+    ok = ok && oaf_dict_set_many(&batched, keys, values, 3000);
+    ok = ok && oaf_dict_count(&batched) == 2500 && oaf_dict_count(&single) == 2500;
+    ok = ok && oaf_dict_bucket_count(&batched) == 4096;
+
+    for (index = 0; index < 5000; index++)
+    {
+        probes[index] = (int64_t)(4999u - index);
+        found_values[index] = -1;
+    }
+
+    ok = ok && oaf_dict_try_get_many(&batched, probes, 5000, found_values, found) == 2500;
+    for (index = 0; ok && index < 5000; index++)
+    {
+        int present = oaf_dict_try_get(&single, &probes[index], &expected);
+        ok = found[index] == (unsigned char)present && found_values[index] == (present ? expected : -1);
+    }
+
+    ok = ok && oaf_dict_try_get_many(&batched, probes, 5000, found_values, NULL) == 2500;
+    oaf_dict_destroy(&batched);
+    oaf_dict_destroy(&single);
+
+    if (!oaf_set_init(&set, sizeof(int64_t), 0, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, &allocator))
+    {
+        return 0;
+    }
+
+    ok = ok && oaf_set_add_many(&set, keys, 3000) && oaf_set_count(&set) == 2500;
+    ok = ok && oaf_set_contains(&set, &keys[2999]) && !oaf_set_contains(&set, &probes[0]);
+    oaf_set_destroy(&set);
+    return ok && state.active_allocations == 0;
+}
+
+static int test_typed_collections(void)
+{
+    OafDefaultAllocatorState state;
+    OafAllocator allocator;
+    I64Array array;
+    I64Dict typed;
+    OafDict generic;
+    GridDict grid;
+    GridPoint point;
+    GridPoint stored;
+    int64_t key;
+    int64_t value;
+    int64_t expected;
+    int64_t* slot;
+    size_t round;
+    uint32_t seed = 777u;
+    int ok = 1;
+
+    oaf_default_allocator_init(&state, &allocator);
+    if (!i64_array_init(&array, 0, &allocator))
+    {
+        return 0;
+    }
+
+    for (key = 0; ok && key < 100; key++)
+    {
+        ok = i64_array_push(&array, key * 3);
+    }
+
+    ok = ok && array.length == 100 && array.capacity == 128;
+    ok = ok && i64_array_insert(&array, 0, -1) && i64_array_remove_at(&array, 50, &value) && value == 147;
+    ok = ok && i64_array_get(&array, 0, &value) && value == -1 && *i64_array_at(&array, 99) == 297;
+    ok = ok && i64_array_set(&array, 1, 5) && i64_array_get(&array, 1, &value) && value == 5;
+    ok = ok && !i64_array_get(&array, 100, &value) && i64_array_at(&array, 100) == NULL;
+    ok = ok && i64_array_pop(&array, &value) && value == 297 && array.length == 99;
+    ok = ok && i64_array_resize(&array, 120) && *i64_array_at(&array, 119) == 0;
+    i64_array_destroy(&array);
+
+    if (!i64_dict_init(&typed, 0, &allocator))
+    {
+        return 0;
+    }
+
+    if (!oaf_dict_init(&generic, sizeof(int64_t), sizeof(int64_t), 0, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, &allocator))
+    {
+        i64_dict_destroy(&typed);
+        return 0;
+    }
+
+    for (round = 0; ok && round < 100000; round++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        key = (int64_t)((seed >> 8) % 3000u);
+        if ((seed & 3u) != 0)
+        {
+            ok = i64_dict_set(&typed, key, key * 5) && oaf_dict_set(&generic, &key, &key);
+        }
+        else
+        {
+            ok = i64_dict_remove(&typed, key, &value) == oaf_dict_remove(&generic, &key, NULL);
+        }
+    }
+
+    ok = ok && i64_dict_count(&typed) == oaf_dict_count(&generic);
+    ok = ok && i64_dict_bucket_count(&typed) == oaf_dict_bucket_count(&generic);
+    for (key = 0; ok && key < 3000; key++)
+    {
+        int present = oaf_dict_try_get(&generic, &key, &expected);
+        slot = i64_dict_get(&typed, key);
+        ok = i64_dict_contains_key(&typed, key) == present && (slot != NULL) == present;
+        ok = ok && (!present || (i64_dict_try_get(&typed, key, &value) && value == key * 5 && *slot == value));
+    }
+
+    i64_dict_clear(&typed);
+    for (key = 0; ok && key < 100000; key++)
+    {
+        ok = i64_dict_set(&typed, key, key);
+    }
+
+    for (key = 0; ok && key < 100000; key++)
+    {
+        ok = i64_dict_try_get(&typed, key, &value) && value == key;
+    }
+
+    i64_dict_destroy(&typed);
+    oaf_dict_destroy(&generic);
+
+    if (!grid_dict_init(&grid, 16, &allocator))
+    {
+        return 0;
+    }
+
+    for (point.x = -20; ok && point.x < 20; point.x++)
+    {
+        for (point.y = -20; ok && point.y < 20; point.y++)
+        {
+            GridPoint mirrored = {point.y, point.x};
+            ok = grid_dict_set(&grid, point, mirrored);
+        }
+    }
+
+    point.x = -3;
+    point.y = 11;
+    ok = ok && grid_dict_count(&grid) == 1600 && grid_dict_try_get(&grid, point, &stored) && stored.x == 11 && stored.y == -3;
+    ok = ok && grid_dict_remove(&grid, point, NULL) && !grid_dict_contains_key(&grid, point) && grid_dict_count(&grid) == 1599;
+    grid_dict_clear(&grid);
+    ok = ok && grid_dict_count(&grid) == 0 && grid_dict_bucket_count(&grid) == 0;
+    grid_dict_destroy(&grid);
+    return ok && state.active_allocations == 0;
+}
+
+static int test_typed_alignment(void)
+{
+    OafArenaAllocatorState arena;
+    OafAllocator allocator;
+    WideArray array;
+    WideDict dict;
+    WideLane lane;
+    int64_t key;
+    int ok = 1;
+
+    if (!oaf_arena_allocator_init(&arena, 1u << 20))
+    {
+        return 0;
+    }
+
+    oaf_arena_allocator_as_allocator(&arena, &allocator);
+    ok = wide_array_init(&array, 0, &allocator) && wide_dict_init(&dict, 0, &allocator);
+    for (key = 0; ok && key < 200; key++)
+    {
+        lane.lanes[0] = key;
+        lane.lanes[1] = -key;
+        ok = wide_array_push(&array, lane) && wide_dict_set(&dict, key, lane);
+        ok = ok && ((uintptr_t)array.data & 63u) == 0 && ((uintptr_t)dict.slots & 63u) == 0;
+    }
+
+    ok = ok && wide_dict_try_get(&dict, 150, &lane) && lane.lanes[1] == -150;
+    wide_array_destroy(&array);
+    wide_dict_destroy(&dict);
+    oaf_arena_allocator_destroy(&arena);
+    return ok;
+}
+
 static int test_set(void)
 {
     OafDefaultAllocatorState state;
@@ -223,7 +648,7 @@ static int test_set(void)
 
 int main(void)
 {
-    if (!test_array() || !test_list() || !test_dict() || !test_set())
+    if (!test_array() || !test_list() || !test_dict() || !test_dict_open_addressing() || !test_dict_weak_hash() || !test_dict_hashing() || !test_dict_batched() || !test_typed_collections() || !test_typed_alignment() || !test_set())
     {
         fprintf(stderr, "collections smoke tests failed\n");
         return 1;
@@ -9,9 +9,17 @@
 extern "C" {
 #endif
 
+#define OAF_PARALLEL_TARGET_BLOCK_NS 20000u
+#define OAF_PARALLEL_FEEDBACK_SAMPLES 8u
+#define OAF_PARALLEL_SPLITS_PER_WORKER 256u
+#define OAF_PARALLEL_REDUCE_MAX_CHUNKS 256u
+
+/* chunk_size 0 selects adaptive mode: lazy binary splitting with a grain sized from timed first blocks. */
 typedef void (*OafParallelForProc)(size_t index, void* state);
 typedef void (*OafParallelMapProc)(size_t index, const void* input, void* output, void* state);
 typedef int64_t (*OafParallelReduceProcI64)(size_t index, void* state);
+typedef void (*OafParallelReduceMapProc)(size_t index, void* accumulator, void* state);
+typedef void (*OafParallelReduceCombineProc)(void* accumulator, const void* other, void* state);
 
 int oaf_parallel_for(
     OafThreadPool* pool,
@@ -38,6 +46,18 @@ int oaf_parallel_reduce_i64(
     void* state,
     int64_t* out_result);
 
+/* Each chunk folds into its own cache-line padded copy of identity; the partials then merge in a fixed pairwise tree. */
+int oaf_parallel_reduce(
+    OafThreadPool* pool,
+    size_t count,
+    size_t chunk_size,
+    size_t element_size,
+    const void* identity,
+    OafParallelReduceMapProc map_proc,
+    OafParallelReduceCombineProc combine_proc,
+    void* state,
+    void* out_result);
+
 #ifdef __cplusplus
 }
 #endif
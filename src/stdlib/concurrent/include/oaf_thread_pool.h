@@ -2,46 +2,121 @@
 #define OAF_STDLIB_THREAD_POOL_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <pthread.h>
+#include "atomic_ops.h"
 #include "sync_primitives.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define OAF_THREAD_POOL_DEQUE_INITIAL_CAPACITY 64
+#define OAF_THREAD_POOL_SPIN_ROUNDS 32
+
 typedef void (*OafThreadPoolTaskProc)(void* state);
 
+struct OafThreadPool;
+
+/* Fork-join scope: tasks spawned into a group are awaited together, and a waiting worker runs queued tasks meanwhile. */
+typedef struct OafTaskGroup
+{
+    struct OafThreadPool* pool;
+    atomic_size_t pending;
+} OafTaskGroup;
+
 typedef struct OafThreadPoolTask
 {
     OafThreadPoolTaskProc proc;
     void* state;
+    OafTaskGroup* group;
 } OafThreadPoolTask;
 
+typedef struct OafThreadPoolDequeEntry
+{
+    _Atomic(OafThreadPoolTaskProc) proc;
+    _Atomic(void*) state;
+    _Atomic(OafTaskGroup*) group;
+} OafThreadPoolDequeEntry;
+
+typedef struct OafThreadPoolDequeBuffer
+{
+    size_t capacity;
+    struct OafThreadPoolDequeBuffer* retired;
+    OafThreadPoolDequeEntry entries[];
+} OafThreadPoolDequeBuffer;
+
+typedef struct OafThreadPoolWorkerStats
+{
+    size_t submitted;
+    size_t executed;
+    size_t local_pops;
+    size_t global_pops;
+    size_t steals;
+    size_t parks;
+    size_t helped;
+    size_t splits;
+} OafThreadPoolWorkerStats;
+
+/* Snapshot refreshed by oaf_thread_pool_stats; workers points at worker_count per-worker entries. */
 typedef struct OafThreadPoolStats
 {
     size_t submitted;
     size_t completed;
     size_t rejected;
+    size_t local_pops;
+    size_t global_pops;
+    size_t steals;
+    size_t parks;
+    size_t helped;
+    size_t splits;
+    size_t worker_count;
+    OafThreadPoolWorkerStats* workers;
 } OafThreadPoolStats;
 
+/* Each worker owns a Chase-Lev deque: it pushes and pops at the bottom, idle workers steal from the top. */
+typedef struct OafThreadPoolWorker
+{
+    _Alignas(OAF_CACHE_LINE_SIZE) atomic_ptrdiff_t top;
+    _Alignas(OAF_CACHE_LINE_SIZE) atomic_ptrdiff_t bottom;
+    _Alignas(OAF_CACHE_LINE_SIZE) _Atomic(OafThreadPoolDequeBuffer*) buffer;
+    struct OafThreadPool* pool;
+    pthread_t thread;
+    size_t index;
+    uint64_t rng_state;
+    atomic_size_t submitted;
+    atomic_size_t executed;
+    atomic_size_t local_pops;
+    atomic_size_t global_pops;
+    atomic_size_t steals;
+    atomic_size_t parks;
+    atomic_size_t helped;
+    atomic_size_t splits;
+} OafThreadPoolWorker;
+
 typedef struct OafThreadPool
 {
-    pthread_t* workers;
+    OafThreadPoolWorker* workers;
     size_t worker_count;
 
     OafThreadPoolTask* queue;
     size_t queue_capacity;
     size_t queue_head;
     size_t queue_tail;
-    size_t queue_count;
-    size_t active_workers;
+    atomic_size_t queue_count;
 
-    int shutting_down;
+    atomic_size_t pending;
+    atomic_size_t idle_workers;
+    atomic_size_t submitted;
+    atomic_size_t rejected;
+    atomic_int shutting_down;
 
     OafMutex mutex;
-    OafCondVar has_work;
     OafCondVar has_space;
-    OafCondVar idle;
+    OafEventCount work_available;
+    OafEventCount idle;
+    OafEventCount group_done;
 
     OafThreadPoolStats stats;
 } OafThreadPool;
@@ -54,7 +129,14 @@ int oaf_thread_pool_try_submit(OafThreadPool* pool, OafThreadPoolTaskProc proc,
 int oaf_thread_pool_wait_idle(OafThreadPool* pool);
 
 size_t oaf_thread_pool_worker_count(const OafThreadPool* pool);
-const OafThreadPoolStats* oaf_thread_pool_stats(const OafThreadPool* pool);
+int oaf_thread_pool_current_worker(const OafThreadPool* pool, size_t* out_index);
+int oaf_thread_pool_wants_split(const OafThreadPool* pool);
+void oaf_thread_pool_note_split(OafThreadPool* pool);
+const OafThreadPoolStats* oaf_thread_pool_stats(OafThreadPool* pool);
+
+int oaf_task_group_init(OafTaskGroup* group, OafThreadPool* pool);
+int oaf_task_group_spawn(OafTaskGroup* group, OafThreadPoolTaskProc proc, void* state);
+int oaf_task_group_wait(OafTaskGroup* group);
 
 #ifdef __cplusplus
 }
@@ -1,13 +1,31 @@
 #include <stdlib.h>
+#include <string.h>
 #include "oaf_parallel.h"
 
-typedef struct OafParallelLatch
+typedef void (*OafParallelBlockProc)(size_t start, size_t end, size_t node, void* job);
+
+typedef struct OafParallelSplitNode
 {
-    OafMutex mutex;
-    OafCondVar completed;
-    size_t remaining;
-    int failed;
-} OafParallelLatch;
+    struct OafParallelSplitJob* split;
+    size_t start;
+    size_t end;
+    size_t index;
+} OafParallelSplitNode;
+
+/* Lazy binary splitting: a range only forks its upper half while some worker is idle and ours has nothing to steal. */
+typedef struct OafParallelSplitJob
+{
+    OafThreadPool* pool;
+    OafTaskGroup group;
+    OafParallelBlockProc block;
+    void* job;
+    OafParallelSplitNode* nodes;
+    size_t node_capacity;
+    atomic_size_t node_count;
+    atomic_size_t grain;
+    atomic_size_t samples;
+    size_t max_grain;
+} OafParallelSplitJob;
 
 typedef struct OafParallelForTask
 {
@@ -15,7 +33,6 @@ typedef struct OafParallelForTask
     size_t end;
     OafParallelForProc proc;
     void* state;
-    OafParallelLatch* latch;
 } OafParallelForTask;
 
 typedef struct OafParallelMapTask
@@ -27,7 +44,6 @@ typedef struct OafParallelMapTask
     size_t element_size;
     OafParallelMapProc proc;
     void* state;
-    OafParallelLatch* latch;
 } OafParallelMapTask;
 
 typedef struct OafParallelReduceTaskI64
@@ -37,45 +53,25 @@ typedef struct OafParallelReduceTaskI64
     OafParallelReduceProcI64 proc;
     void* state;
     int64_t partial;
-    OafParallelLatch* latch;
 } OafParallelReduceTaskI64;
 
-static size_t choose_chunk_size(const OafThreadPool* pool, size_t count, size_t preferred)
+typedef struct OafParallelReduceJob
 {
-    size_t workers;
-    size_t target_tasks;
-    size_t chunk;
-
-    if (preferred > 0)
-    {
-        return preferred;
-    }
-
-    workers = oaf_thread_pool_worker_count(pool);
-    if (workers == 0)
-    {
-        workers = 1;
-    }
-
-    target_tasks = workers * 4u;
-    if (target_tasks == 0)
-    {
-        target_tasks = 1;
-    }
-
-    chunk = count / target_tasks;
-    if ((count % target_tasks) != 0)
-    {
-        chunk++;
-    }
-
-    if (chunk == 0)
-    {
-        chunk = 1;
-    }
+    unsigned char* partials;
+    size_t partial_stride;
+    size_t element_size;
+    const void* identity;
+    OafParallelReduceMapProc map_proc;
+    void* state;
+} OafParallelReduceJob;
 
-    return chunk;
-}
+typedef struct OafParallelReduceTask
+{
+    size_t start;
+    size_t end;
+    size_t slot;
+    OafParallelReduceJob* job;
+} OafParallelReduceTask;
 
 static size_t task_count_for_range(size_t count, size_t chunk_size)
 {
@@ -87,200 +83,270 @@ static size_t task_count_for_range(size_t count, size_t chunk_size)
     return (count + chunk_size - 1u) / chunk_size;
 }
 
-static int latch_init(OafParallelLatch* latch, size_t remaining)
+static void run_parallel_for_task(void* task_state)
 {
-    if (latch == NULL)
+    OafParallelForTask* task = (OafParallelForTask*)task_state;
+    size_t index;
+
+    for (index = task->start; index < task->end; index++)
     {
-        return 0;
+        task->proc(index, task->state);
     }
+}
+
+static void run_parallel_map_task(void* task_state)
+{
+    OafParallelMapTask* task = (OafParallelMapTask*)task_state;
+    size_t index;
 
-    if (!oaf_mutex_init(&latch->mutex) || !oaf_cond_var_init(&latch->completed))
+    for (index = task->start; index < task->end; index++)
     {
-        oaf_cond_var_destroy(&latch->completed);
-        oaf_mutex_destroy(&latch->mutex);
-        return 0;
+        const void* input_element = task->input + (index * task->element_size);
+        void* output_element = task->output + (index * task->element_size);
+        task->proc(index, input_element, output_element, task->state);
     }
-
-    latch->remaining = remaining;
-    latch->failed = 0;
-    return 1;
 }
 
-static void latch_destroy(OafParallelLatch* latch)
+static void run_parallel_reduce_task_i64(void* task_state)
 {
-    if (latch == NULL)
+    OafParallelReduceTaskI64* task = (OafParallelReduceTaskI64*)task_state;
+    size_t index;
+    int64_t partial = 0;
+
+    for (index = task->start; index < task->end; index++)
     {
-        return;
+        partial += task->proc(index, task->state);
     }
 
-    oaf_cond_var_destroy(&latch->completed);
-    oaf_mutex_destroy(&latch->mutex);
-    latch->remaining = 0;
-    latch->failed = 0;
+    task->partial = partial;
 }
 
-static void latch_mark_done(OafParallelLatch* latch, int failed)
+static void run_parallel_reduce_task(void* task_state)
 {
-    if (latch == NULL || !oaf_mutex_lock(&latch->mutex))
-    {
-        return;
-    }
+    OafParallelReduceTask* task = (OafParallelReduceTask*)task_state;
+    OafParallelReduceJob* job = task->job;
+    void* accumulator = job->partials + (task->slot * job->partial_stride);
+    size_t index;
 
-    if (failed)
+    memcpy(accumulator, job->identity, job->element_size);
+    for (index = task->start; index < task->end; index++)
     {
-        latch->failed = 1;
+        job->map_proc(index, accumulator, job->state);
     }
+}
+
+static int run_tasks(
+    OafThreadPool* pool,
+    void* tasks,
+    size_t task_count,
+    size_t task_stride,
+    OafThreadPoolTaskProc proc)
+{
+    OafTaskGroup group;
+    size_t index;
 
-    if (latch->remaining > 0)
+    if (!oaf_task_group_init(&group, pool))
     {
-        latch->remaining--;
+        return 0;
     }
 
-    if (latch->remaining == 0)
+    for (index = 0; index < task_count; index++)
     {
-        oaf_cond_var_broadcast(&latch->completed);
+        void* task = (unsigned char*)tasks + (index * task_stride);
+
+        if (!oaf_task_group_spawn(&group, proc, task))
+        {
+            proc(task);
+        }
     }
 
-    oaf_mutex_unlock(&latch->mutex);
+    return oaf_task_group_wait(&group);
 }
 
-static void latch_mark_unscheduled(OafParallelLatch* latch, size_t unscheduled)
+static void update_grain(OafParallelSplitJob* split, size_t measured, uint64_t elapsed_ns)
 {
-    if (latch == NULL || unscheduled == 0 || !oaf_mutex_lock(&latch->mutex))
-    {
-        return;
-    }
+    size_t current = atomic_load_explicit(&split->grain, memory_order_relaxed);
+    uint64_t target;
 
-    latch->failed = 1;
-    if (unscheduled >= latch->remaining)
+    if (elapsed_ns == 0)
     {
-        latch->remaining = 0;
-    }
-    else
-    {
-        latch->remaining -= unscheduled;
+        elapsed_ns = 1;
     }
 
-    if (latch->remaining == 0)
+    target = (uint64_t)measured * OAF_PARALLEL_TARGET_BLOCK_NS / elapsed_ns;
+    if (target > split->max_grain)
     {
-        oaf_cond_var_broadcast(&latch->completed);
+        target = split->max_grain;
     }
 
-    oaf_mutex_unlock(&latch->mutex);
+    target = (target + current) / 2u;
+    atomic_store_explicit(&split->grain, target > 0 ? (size_t)target : 1u, memory_order_relaxed);
 }
 
-static int latch_await(OafParallelLatch* latch)
+static OafParallelSplitNode* acquire_node(OafParallelSplitJob* split)
 {
-    int failed;
+    size_t index = atomic_fetch_add_explicit(&split->node_count, 1u, memory_order_relaxed);
 
-    if (latch == NULL || !oaf_mutex_lock(&latch->mutex))
+    if (index >= split->node_capacity)
     {
-        return 0;
+        return NULL;
     }
 
-    while (latch->remaining > 0)
+    split->nodes[index].split = split;
+    split->nodes[index].index = index;
+    return &split->nodes[index];
+}
+
+static void run_split_node(void* node_state)
+{
+    OafParallelSplitNode* node = (OafParallelSplitNode*)node_state;
+    OafParallelSplitJob* split = node->split;
+    size_t start = node->start;
+    size_t end = node->end;
+
+    while (start < end)
     {
-        if (!oaf_cond_var_wait(&latch->completed, &latch->mutex))
+        size_t grain = atomic_load_explicit(&split->grain, memory_order_relaxed);
+        size_t block_end;
+
+        if (end - start >= grain * 2u && oaf_thread_pool_wants_split(split->pool))
+        {
+            OafParallelSplitNode* child = acquire_node(split);
+
+            if (child != NULL)
+            {
+                child->start = start + (end - start) / 2u;
+                child->end = end;
+                if (oaf_task_group_spawn(&split->group, run_split_node, child))
+                {
+                    oaf_thread_pool_note_split(split->pool);
+                    end = child->start;
+                }
+            }
+        }
+
+        block_end = end - start > grain ? start + grain : end;
+        if (atomic_load_explicit(&split->samples, memory_order_relaxed) < OAF_PARALLEL_FEEDBACK_SAMPLES)
         {
-            oaf_mutex_unlock(&latch->mutex);
-            return 0;
+            uint64_t started = oaf_monotonic_time_ns();
+
+            split->block(start, block_end, node->index, split->job);
+            atomic_fetch_add_explicit(&split->samples, 1u, memory_order_relaxed);
+            update_grain(split, block_end - start, oaf_monotonic_time_ns() - started);
+        }
+        else
+        {
+            split->block(start, block_end, node->index, split->job);
         }
+
+        start = block_end;
     }
+}
+
+static size_t split_node_capacity(const OafThreadPool* pool, size_t count)
+{
+    size_t capacity = oaf_thread_pool_worker_count(pool) * OAF_PARALLEL_SPLITS_PER_WORKER;
 
-    failed = latch->failed;
-    oaf_mutex_unlock(&latch->mutex);
-    return failed ? 0 : 1;
+    return capacity < count ? capacity : count;
 }
 
-static void run_parallel_for_task(void* task_state)
+static int run_split(
+    OafThreadPool* pool,
+    size_t count,
+    OafParallelSplitNode* nodes,
+    size_t node_capacity,
+    OafParallelBlockProc block,
+    void* job)
 {
-    OafParallelForTask* task = (OafParallelForTask*)task_state;
-    size_t index;
-    int failed = 0;
+    OafParallelSplitJob split;
+    size_t workers = oaf_thread_pool_worker_count(pool);
 
-    if (task == NULL || task->proc == NULL)
+    if (!oaf_task_group_init(&split.group, pool))
     {
-        latch_mark_done(task != NULL ? task->latch : NULL, 1);
-        return;
+        return 0;
     }
 
-    for (index = task->start; index < task->end; index++)
+    split.pool = pool;
+    split.block = block;
+    split.job = job;
+    split.nodes = nodes;
+    split.node_capacity = node_capacity;
+    split.max_grain = count / (workers * 4u) > 0 ? count / (workers * 4u) : 1u;
+    atomic_init(&split.node_count, 1u);
+    atomic_init(&split.grain, 1u);
+    atomic_init(&split.samples, 0u);
+
+    nodes[0].split = &split;
+    nodes[0].start = 0;
+    nodes[0].end = count;
+    nodes[0].index = 0;
+
+    if (oaf_thread_pool_current_worker(pool, NULL)
+        || !oaf_task_group_spawn(&split.group, run_split_node, &nodes[0]))
     {
-        task->proc(index, task->state);
+        run_split_node(&nodes[0]);
     }
 
-    latch_mark_done(task->latch, failed);
+    return oaf_task_group_wait(&split.group);
 }
 
-static void run_parallel_map_task(void* task_state)
+static void for_block(size_t start, size_t end, size_t node, void* job)
 {
-    OafParallelMapTask* task = (OafParallelMapTask*)task_state;
+    OafParallelForTask* task = (OafParallelForTask*)job;
     size_t index;
 
-    if (task == NULL || task->proc == NULL)
+    (void)node;
+    for (index = start; index < end; index++)
     {
-        latch_mark_done(task != NULL ? task->latch : NULL, 1);
-        return;
+        task->proc(index, task->state);
     }
+}
 
-    for (index = task->start; index < task->end; index++)
+static void map_block(size_t start, size_t end, size_t node, void* job)
+{
+    OafParallelMapTask* task = (OafParallelMapTask*)job;
+    size_t index;
+
+    (void)node;
+    for (index = start; index < end; index++)
     {
-        const void* input_element = task->input + (index * task->element_size);
-        void* output_element = task->output + (index * task->element_size);
-        task->proc(index, input_element, output_element, task->state);
+        task->proc(
+            index,
+            task->input + (index * task->element_size),
+            task->output + (index * task->element_size),
+            task->state);
     }
-
-    latch_mark_done(task->latch, 0);
 }
 
-static void run_parallel_reduce_task_i64(void* task_state)
+static void reduce_block_i64(size_t start, size_t end, size_t node, void* job)
 {
-    OafParallelReduceTaskI64* task = (OafParallelReduceTaskI64*)task_state;
+    OafParallelReduceTaskI64* tasks = (OafParallelReduceTaskI64*)job;
+    OafParallelReduceTaskI64* task = &tasks[node];
     size_t index;
     int64_t partial = 0;
 
-    if (task == NULL || task->proc == NULL)
-    {
-        latch_mark_done(task != NULL ? task->latch : NULL, 1);
-        return;
-    }
-
-    for (index = task->start; index < task->end; index++)
+    for (index = start; index < end; index++)
     {
         partial += task->proc(index, task->state);
     }
 
-    task->partial = partial;
-    latch_mark_done(task->latch, 0);
+    task->partial += partial;
 }
 
-static int submit_tasks(
-    OafThreadPool* pool,
-    void* tasks,
-    size_t task_count,
-    size_t task_stride,
-    OafThreadPoolTaskProc proc,
-    OafParallelLatch* latch)
+static int run_split_for(OafThreadPool* pool, size_t count, OafParallelBlockProc block, void* job)
 {
-    size_t submitted = 0;
-
-    while (submitted < task_count)
-    {
-        void* task = (unsigned char*)tasks + (submitted * task_stride);
-        if (!oaf_thread_pool_submit(pool, proc, task))
-        {
-            break;
-        }
-
-        submitted++;
-    }
+    size_t capacity = split_node_capacity(pool, count);
+    OafParallelSplitNode* nodes = (OafParallelSplitNode*)malloc(sizeof(OafParallelSplitNode) * capacity);
+    int ok;
 
-    if (submitted < task_count)
+    if (nodes == NULL)
     {
-        latch_mark_unscheduled(latch, task_count - submitted);
+        return 0;
     }
 
-    return latch_await(latch);
+    ok = run_split(pool, count, nodes, capacity, block, job);
+    free(nodes);
+    return ok;
 }
 
 int oaf_parallel_for(
@@ -290,10 +356,8 @@ int oaf_parallel_for(
     OafParallelForProc proc,
     void* state)
 {
-    size_t actual_chunk_size;
     size_t task_count;
     OafParallelForTask* tasks;
-    OafParallelLatch latch;
     size_t index;
     int ok;
 
@@ -307,24 +371,28 @@ int oaf_parallel_for(
         return 1;
     }
 
-    actual_chunk_size = choose_chunk_size(pool, count, chunk_size);
-    task_count = task_count_for_range(count, actual_chunk_size);
-    if (task_count == 0)
+    if (chunk_size == 0)
     {
-        return 1;
+        OafParallelForTask job;
+
+        job.start = 0;
+        job.end = count;
+        job.proc = proc;
+        job.state = state;
+        return run_split_for(pool, count, for_block, &job);
     }
 
+    task_count = task_count_for_range(count, chunk_size);
     tasks = (OafParallelForTask*)malloc(sizeof(OafParallelForTask) * task_count);
-    if (tasks == NULL || !latch_init(&latch, task_count))
+    if (tasks == NULL)
     {
-        free(tasks);
         return 0;
     }
 
     for (index = 0; index < task_count; index++)
     {
-        size_t start = index * actual_chunk_size;
-        size_t end = start + actual_chunk_size;
+        size_t start = index * chunk_size;
+        size_t end = start + chunk_size;
         if (end > count)
         {
             end = count;
@@ -334,11 +402,9 @@ int oaf_parallel_for(
         tasks[index].end = end;
         tasks[index].proc = proc;
         tasks[index].state = state;
-        tasks[index].latch = &latch;
     }
 
-    ok = submit_tasks(pool, tasks, task_count, sizeof(OafParallelForTask), run_parallel_for_task, &latch);
-    latch_destroy(&latch);
+    ok = run_tasks(pool, tasks, task_count, sizeof(OafParallelForTask), run_parallel_for_task);
     free(tasks);
     return ok;
 }
@@ -353,10 +419,8 @@ int oaf_parallel_map(
     OafParallelMapProc proc,
     void* state)
 {
-    size_t actual_chunk_size;
     size_t task_count;
     OafParallelMapTask* tasks;
-    OafParallelLatch latch;
     size_t index;
     int ok;
 
@@ -370,24 +434,31 @@ int oaf_parallel_map(
         return 1;
     }
 
-    actual_chunk_size = choose_chunk_size(pool, count, chunk_size);
-    task_count = task_count_for_range(count, actual_chunk_size);
-    if (task_count == 0)
+    if (chunk_size == 0)
     {
-        return 1;
+        OafParallelMapTask job;
+
+        job.start = 0;
+        job.end = count;
+        job.input = (const unsigned char*)input;
+        job.output = (unsigned char*)output;
+        job.element_size = element_size;
+        job.proc = proc;
+        job.state = state;
+        return run_split_for(pool, count, map_block, &job);
     }
 
+    task_count = task_count_for_range(count, chunk_size);
     tasks = (OafParallelMapTask*)malloc(sizeof(OafParallelMapTask) * task_count);
-    if (tasks == NULL || !latch_init(&latch, task_count))
+    if (tasks == NULL)
     {
-        free(tasks);
         return 0;
     }
 
     for (index = 0; index < task_count; index++)
     {
-        size_t start = index * actual_chunk_size;
-        size_t end = start + actual_chunk_size;
+        size_t start = index * chunk_size;
+        size_t end = start + chunk_size;
         if (end > count)
         {
             end = count;
@@ -400,11 +471,9 @@ int oaf_parallel_map(
         tasks[index].element_size = element_size;
         tasks[index].proc = proc;
         tasks[index].state = state;
-        tasks[index].latch = &latch;
     }
 
-    ok = submit_tasks(pool, tasks, task_count, sizeof(OafParallelMapTask), run_parallel_map_task, &latch);
-    latch_destroy(&latch);
+    ok = run_tasks(pool, tasks, task_count, sizeof(OafParallelMapTask), run_parallel_map_task);
     free(tasks);
     return ok;
 }
@@ -417,10 +486,9 @@ int oaf_parallel_reduce_i64(
     void* state,
     int64_t* out_result)
 {
-    size_t actual_chunk_size;
     size_t task_count;
     OafParallelReduceTaskI64* tasks;
-    OafParallelLatch latch;
+    OafParallelSplitNode* nodes = NULL;
     size_t index;
     int ok;
     int64_t total = 0;
@@ -436,25 +504,24 @@ int oaf_parallel_reduce_i64(
         return 1;
     }
 
-    actual_chunk_size = choose_chunk_size(pool, count, chunk_size);
-    task_count = task_count_for_range(count, actual_chunk_size);
-    if (task_count == 0)
+    task_count = chunk_size == 0 ? split_node_capacity(pool, count) : task_count_for_range(count, chunk_size);
+    tasks = (OafParallelReduceTaskI64*)malloc(sizeof(OafParallelReduceTaskI64) * task_count);
+    if (chunk_size == 0)
     {
-        *out_result = 0;
-        return 1;
+        nodes = (OafParallelSplitNode*)malloc(sizeof(OafParallelSplitNode) * task_count);
     }
 
-    tasks = (OafParallelReduceTaskI64*)malloc(sizeof(OafParallelReduceTaskI64) * task_count);
-    if (tasks == NULL || !latch_init(&latch, task_count))
+    if (tasks == NULL || (chunk_size == 0 && nodes == NULL))
     {
+        free(nodes);
         free(tasks);
         return 0;
     }
 
     for (index = 0; index < task_count; index++)
     {
-        size_t start = index * actual_chunk_size;
-        size_t end = start + actual_chunk_size;
+        size_t start = chunk_size == 0 ? 0 : index * chunk_size;
+        size_t end = start + chunk_size;
         if (end > count)
         {
             end = count;
@@ -465,10 +532,17 @@ int oaf_parallel_reduce_i64(
         tasks[index].proc = proc;
         tasks[index].state = state;
         tasks[index].partial = 0;
-        tasks[index].latch = &latch;
     }
 
-    ok = submit_tasks(pool, tasks, task_count, sizeof(OafParallelReduceTaskI64), run_parallel_reduce_task_i64, &latch);
+    if (chunk_size == 0)
+    {
+        ok = run_split(pool, count, nodes, task_count, reduce_block_i64, tasks);
+    }
+    else
+    {
+        ok = run_tasks(pool, tasks, task_count, sizeof(OafParallelReduceTaskI64), run_parallel_reduce_task_i64);
+    }
+
     if (ok)
     {
         for (index = 0; index < task_count; index++)
@@ -478,7 +552,92 @@ int oaf_parallel_reduce_i64(
         *out_result = total;
     }
 
-    latch_destroy(&latch);
+    free(nodes);
+    free(tasks);
+    return ok;
+}
+
+int oaf_parallel_reduce(
+    OafThreadPool* pool,
+    size_t count,
+    size_t chunk_size,
+    size_t element_size,
+    const void* identity,
+    OafParallelReduceMapProc map_proc,
+    OafParallelReduceCombineProc combine_proc,
+    void* state,
+    void* out_result)
+{
+    OafParallelReduceJob job;
+    OafParallelReduceTask* tasks;
+    size_t task_count;
+    size_t stride;
+    size_t index;
+    int ok;
+
+    if (pool == NULL
+        || element_size == 0
+        || identity == NULL
+        || map_proc == NULL
+        || combine_proc == NULL
+        || out_result == NULL)
+    {
+        return 0;
+    }
+
+    if (count == 0)
+    {
+        memmove(out_result, identity, element_size);
+        return 1;
+    }
+
+    if (chunk_size == 0)
+    {
+        chunk_size = task_count_for_range(count, OAF_PARALLEL_REDUCE_MAX_CHUNKS);
+    }
+
+    task_count = task_count_for_range(count, chunk_size);
+    job.partial_stride = (element_size + OAF_CACHE_LINE_SIZE - 1u) / OAF_CACHE_LINE_SIZE * OAF_CACHE_LINE_SIZE;
+    job.partials = (unsigned char*)aligned_alloc(OAF_CACHE_LINE_SIZE, job.partial_stride * task_count);
+    tasks = (OafParallelReduceTask*)malloc(sizeof(OafParallelReduceTask) * task_count);
+    if (job.partials == NULL || tasks == NULL)
+    {
+        free(tasks);
+        free(job.partials);
+        return 0;
+    }
+
+    job.element_size = element_size;
+    job.identity = identity;
+    job.map_proc = map_proc;
+    job.state = state;
+
+    for (index = 0; index < task_count; index++)
+    {
+        tasks[index].start = index * chunk_size;
+        tasks[index].end = tasks[index].start + chunk_size < count ? tasks[index].start + chunk_size : count;
+        tasks[index].slot = index;
+        tasks[index].job = &job;
+    }
+
+    ok = run_tasks(pool, tasks, task_count, sizeof(OafParallelReduceTask), run_parallel_reduce_task);
+    if (ok)
+    {
+        for (stride = 1; stride < task_count; stride *= 2u)
+        {
+            for (index = 0; index + stride < task_count; index += stride * 2u)
+            {
+                combine_proc(
+                    job.partials + (index * job.partial_stride),
+                    job.partials + ((index + stride) * job.partial_stride),
+                    state);
+            }
+        }
+
+        memcpy(out_result, job.partials, element_size);
+    }
+
     free(tasks);
+    free(job.partials);
     return ok;
 }
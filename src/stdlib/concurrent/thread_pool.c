@@ -1,98 +1,477 @@
 #include <stdlib.h>
+#include <sched.h>
 #include "oaf_thread_pool.h"
 
-static int queue_push(OafThreadPool* pool, OafThreadPoolTaskProc proc, void* state)
+static _Thread_local OafThreadPoolWorker* g_current_worker = NULL;
+
+static OafThreadPoolDequeBuffer* deque_buffer_create(size_t capacity)
+{
+    OafThreadPoolDequeBuffer* buffer = (OafThreadPoolDequeBuffer*)malloc(
+        sizeof(OafThreadPoolDequeBuffer) + capacity * sizeof(OafThreadPoolDequeEntry));
+    size_t index;
+
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+
+    buffer->capacity = capacity;
+    buffer->retired = NULL;
+    for (index = 0; index < capacity; index++)
+    {
+        atomic_init(&buffer->entries[index].proc, NULL);
+        atomic_init(&buffer->entries[index].state, NULL);
+        atomic_init(&buffer->entries[index].group, NULL);
+    }
+
+    return buffer;
+}
+
+static int deque_init(OafThreadPoolWorker* worker)
+{
+    OafThreadPoolDequeBuffer* buffer = deque_buffer_create(OAF_THREAD_POOL_DEQUE_INITIAL_CAPACITY);
+
+    if (buffer == NULL)
+    {
+        return 0;
+    }
+
+    atomic_init(&worker->top, 0);
+    atomic_init(&worker->bottom, 0);
+    atomic_init(&worker->buffer, buffer);
+    return 1;
+}
+
+static void deque_destroy(OafThreadPoolWorker* worker)
+{
+    OafThreadPoolDequeBuffer* buffer = atomic_load_explicit(&worker->buffer, memory_order_relaxed);
+
+    while (buffer != NULL)
+    {
+        OafThreadPoolDequeBuffer* retired = buffer->retired;
+        free(buffer);
+        buffer = retired;
+    }
+
+    atomic_store_explicit(&worker->buffer, NULL, memory_order_relaxed);
+}
+
+static int deque_is_empty(OafThreadPoolWorker* worker)
+{
+    ptrdiff_t top = atomic_load_explicit(&worker->top, memory_order_acquire);
+    ptrdiff_t bottom = atomic_load_explicit(&worker->bottom, memory_order_acquire);
+
+    return bottom <= top;
+}
+
+static void entry_store(OafThreadPoolDequeEntry* entry, const OafThreadPoolTask* task)
+{
+    atomic_store_explicit(&entry->proc, task->proc, memory_order_relaxed);
+    atomic_store_explicit(&entry->state, task->state, memory_order_relaxed);
+    atomic_store_explicit(&entry->group, task->group, memory_order_relaxed);
+}
+
+static void entry_load(OafThreadPoolDequeEntry* entry, OafThreadPoolTask* out_task)
+{
+    out_task->proc = atomic_load_explicit(&entry->proc, memory_order_relaxed);
+    out_task->state = atomic_load_explicit(&entry->state, memory_order_relaxed);
+    out_task->group = atomic_load_explicit(&entry->group, memory_order_relaxed);
+}
+
+static OafThreadPoolDequeBuffer* deque_grow(
+    OafThreadPoolWorker* worker,
+    OafThreadPoolDequeBuffer* buffer,
+    ptrdiff_t top,
+    ptrdiff_t bottom)
+{
+    OafThreadPoolDequeBuffer* grown = deque_buffer_create(buffer->capacity * 2u);
+    ptrdiff_t index;
+
+    if (grown == NULL)
+    {
+        return NULL;
+    }
+
+    for (index = top; index < bottom; index++)
+    {
+        OafThreadPoolTask task;
+
+        entry_load(&buffer->entries[(size_t)index & (buffer->capacity - 1u)], &task);
+        entry_store(&grown->entries[(size_t)index & (grown->capacity - 1u)], &task);
+    }
+
+    grown->retired = buffer;
+    atomic_store_explicit(&worker->buffer, grown, memory_order_release);
+    return grown;
+}
+
+static int deque_push(OafThreadPoolWorker* worker, const OafThreadPoolTask* task)
 {
-    if (pool->queue_count >= pool->queue_capacity)
+    ptrdiff_t bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed);
+    ptrdiff_t top = atomic_load_explicit(&worker->top, memory_order_acquire);
+    OafThreadPoolDequeBuffer* buffer = atomic_load_explicit(&worker->buffer, memory_order_relaxed);
+
+    if (bottom - top >= (ptrdiff_t)buffer->capacity)
     {
+        buffer = deque_grow(worker, buffer, top, bottom);
+        if (buffer == NULL)
+        {
+            return 0;
+        }
+    }
+
+    entry_store(&buffer->entries[(size_t)bottom & (buffer->capacity - 1u)], task);
+    atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_release);
+    return 1;
+}
+
+static int deque_pop(OafThreadPoolWorker* worker, OafThreadPoolTask* out_task)
+{
+    ptrdiff_t bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed) - 1;
+    OafThreadPoolDequeBuffer* buffer = atomic_load_explicit(&worker->buffer, memory_order_relaxed);
+    ptrdiff_t top;
+    int popped = 1;
+
+    atomic_store_explicit(&worker->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    top = atomic_load_explicit(&worker->top, memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
         return 0;
     }
 
-    pool->queue[pool->queue_tail].proc = proc;
-    pool->queue[pool->queue_tail].state = state;
+    entry_load(&buffer->entries[(size_t)bottom & (buffer->capacity - 1u)], out_task);
+    if (top == bottom)
+    {
+        popped = atomic_compare_exchange_strong_explicit(
+            &worker->top,
+            &top,
+            top + 1,
+            memory_order_seq_cst,
+            memory_order_relaxed);
+        atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+    }
+
+    return popped;
+}
+
+static int deque_steal(OafThreadPoolWorker* worker, OafThreadPoolTask* out_task)
+{
+    ptrdiff_t top = atomic_load_explicit(&worker->top, memory_order_acquire);
+    ptrdiff_t bottom;
+    OafThreadPoolDequeBuffer* buffer;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    bottom = atomic_load_explicit(&worker->bottom, memory_order_acquire);
+    if (top >= bottom)
+    {
+        return 0;
+    }
+
+    buffer = atomic_load_explicit(&worker->buffer, memory_order_acquire);
+    entry_load(&buffer->entries[(size_t)top & (buffer->capacity - 1u)], out_task);
+    return atomic_compare_exchange_strong_explicit(
+        &worker->top,
+        &top,
+        top + 1,
+        memory_order_seq_cst,
+        memory_order_relaxed);
+}
+
+static int queue_push(OafThreadPool* pool, const OafThreadPoolTask* task)
+{
+    if (atomic_load_explicit(&pool->queue_count, memory_order_relaxed) >= pool->queue_capacity)
+    {
+        return 0;
+    }
+
+    pool->queue[pool->queue_tail] = *task;
     pool->queue_tail = (pool->queue_tail + 1u) % pool->queue_capacity;
-    pool->queue_count++;
+    atomic_fetch_add_explicit(&pool->queue_count, 1u, memory_order_release);
     return 1;
 }
 
 static int queue_pop(OafThreadPool* pool, OafThreadPoolTask* out_task)
 {
-    if (pool->queue_count == 0 || out_task == NULL)
+    int popped = 0;
+
+    if (atomic_load_explicit(&pool->queue_count, memory_order_acquire) == 0
+        || !oaf_mutex_lock(&pool->mutex))
     {
         return 0;
     }
 
-    *out_task = pool->queue[pool->queue_head];
-    pool->queue[pool->queue_head].proc = NULL;
-    pool->queue[pool->queue_head].state = NULL;
-    pool->queue_head = (pool->queue_head + 1u) % pool->queue_capacity;
-    pool->queue_count--;
-    return 1;
+    if (atomic_load_explicit(&pool->queue_count, memory_order_relaxed) > 0)
+    {
+        *out_task = pool->queue[pool->queue_head];
+        pool->queue[pool->queue_head].proc = NULL;
+        pool->queue[pool->queue_head].state = NULL;
+        pool->queue[pool->queue_head].group = NULL;
+        pool->queue_head = (pool->queue_head + 1u) % pool->queue_capacity;
+        atomic_fetch_sub_explicit(&pool->queue_count, 1u, memory_order_relaxed);
+        oaf_cond_var_signal(&pool->has_space);
+        popped = 1;
+    }
+
+    oaf_mutex_unlock(&pool->mutex);
+    return popped;
 }
 
-static void* worker_main(void* state)
+static uint64_t next_random(OafThreadPoolWorker* worker)
 {
-    OafThreadPool* pool = (OafThreadPool*)state;
+    uint64_t value = worker->rng_state;
 
-    while (1)
+    value ^= value << 13;
+    value ^= value >> 7;
+    value ^= value << 17;
+    worker->rng_state = value;
+    return value;
+}
+
+static int steal_task(OafThreadPool* pool, OafThreadPoolWorker* thief, OafThreadPoolTask* out_task)
+{
+    size_t start;
+    size_t offset;
+
+    if (pool->worker_count < 2)
     {
-        OafThreadPoolTask task;
+        return 0;
+    }
 
-        if (!oaf_mutex_lock(&pool->mutex))
+    start = (size_t)(next_random(thief) % pool->worker_count);
+    for (offset = 0; offset < pool->worker_count; offset++)
+    {
+        OafThreadPoolWorker* victim = &pool->workers[(start + offset) % pool->worker_count];
+
+        if (victim != thief && deque_steal(victim, out_task))
         {
-            break;
+            return 1;
         }
+    }
+
+    return 0;
+}
+
+static int find_task(OafThreadPool* pool, OafThreadPoolWorker* worker, OafThreadPoolTask* out_task)
+{
+    if (deque_pop(worker, out_task))
+    {
+        atomic_fetch_add_explicit(&worker->local_pops, 1u, memory_order_relaxed);
+        return 1;
+    }
+
+    if (queue_pop(pool, out_task))
+    {
+        atomic_fetch_add_explicit(&worker->global_pops, 1u, memory_order_relaxed);
+        return 1;
+    }
+
+    if (steal_task(pool, worker, out_task))
+    {
+        atomic_fetch_add_explicit(&worker->steals, 1u, memory_order_relaxed);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int has_visible_work(OafThreadPool* pool)
+{
+    size_t index;
+
+    if (atomic_load(&pool->queue_count) > 0)
+    {
+        return 1;
+    }
+
+    for (index = 0; index < pool->worker_count; index++)
+    {
+        if (!deque_is_empty(&pool->workers[index]))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void run_task(OafThreadPool* pool, OafThreadPoolWorker* worker, const OafThreadPoolTask* task)
+{
+    if (task->proc != NULL)
+    {
+        task->proc(task->state);
+    }
 
-        while (pool->queue_count == 0 && !pool->shutting_down)
+    atomic_fetch_add_explicit(&worker->executed, 1u, memory_order_relaxed);
+    if (task->group != NULL
+        && atomic_fetch_sub_explicit(&task->group->pending, 1u, memory_order_acq_rel) == 1u)
+    {
+        oaf_event_count_notify(&pool->group_done, 0);
+    }
+
+    if (atomic_fetch_sub_explicit(&pool->pending, 1u, memory_order_acq_rel) == 1u)
+    {
+        oaf_event_count_notify(&pool->idle, 0);
+    }
+}
+
+static void* worker_main(void* state)
+{
+    OafThreadPoolWorker* worker = (OafThreadPoolWorker*)state;
+    OafThreadPool* pool = worker->pool;
+    size_t idle_rounds = 0;
+    int idle = 0;
+
+    g_current_worker = worker;
+
+    while (1)
+    {
+        OafThreadPoolTask task;
+        unsigned int key;
+
+        if (find_task(pool, worker, &task))
         {
-            if (!oaf_cond_var_wait(&pool->has_work, &pool->mutex))
+            if (idle)
             {
-                oaf_mutex_unlock(&pool->mutex);
-                return NULL;
+                atomic_fetch_sub_explicit(&pool->idle_workers, 1u, memory_order_relaxed);
+                idle = 0;
             }
+
+            run_task(pool, worker, &task);
+            idle_rounds = 0;
+            continue;
         }
 
-        if (pool->queue_count == 0 && pool->shutting_down)
+        if (!idle)
         {
-            oaf_mutex_unlock(&pool->mutex);
-            break;
+            atomic_fetch_add_explicit(&pool->idle_workers, 1u, memory_order_relaxed);
+            idle = 1;
         }
 
-        if (!queue_pop(pool, &task))
+        if (idle_rounds < OAF_THREAD_POOL_SPIN_ROUNDS && !atomic_load(&pool->shutting_down))
         {
-            oaf_mutex_unlock(&pool->mutex);
+            idle_rounds++;
+            sched_yield();
             continue;
         }
 
-        pool->active_workers++;
-        oaf_cond_var_signal(&pool->has_space);
-        oaf_mutex_unlock(&pool->mutex);
-
-        if (task.proc != NULL)
+        key = oaf_event_count_prepare_wait(&pool->work_available);
+        if (has_visible_work(pool))
         {
-            task.proc(task.state);
+            oaf_event_count_cancel_wait(&pool->work_available);
+            continue;
         }
 
-        if (!oaf_mutex_lock(&pool->mutex))
+        if (atomic_load(&pool->shutting_down))
         {
+            oaf_event_count_cancel_wait(&pool->work_available);
             break;
         }
 
-        if (pool->active_workers > 0)
+        atomic_fetch_add_explicit(&worker->parks, 1u, memory_order_relaxed);
+        oaf_event_count_wait(&pool->work_available, key);
+        idle_rounds = 0;
+    }
+
+    if (idle)
+    {
+        atomic_fetch_sub_explicit(&pool->idle_workers, 1u, memory_order_relaxed);
+    }
+
+    g_current_worker = NULL;
+    return NULL;
+}
+
+static OafThreadPoolWorker* current_worker_of(const OafThreadPool* pool)
+{
+    OafThreadPoolWorker* worker = g_current_worker;
+
+    return worker != NULL && worker->pool == pool ? worker : NULL;
+}
+
+static int submit_local(OafThreadPool* pool, OafThreadPoolWorker* worker, const OafThreadPoolTask* task)
+{
+    atomic_fetch_add_explicit(&pool->pending, 1u, memory_order_relaxed);
+    if (!deque_push(worker, task))
+    {
+        atomic_fetch_sub_explicit(&pool->pending, 1u, memory_order_relaxed);
+        return 0;
+    }
+
+    atomic_fetch_add_explicit(&worker->submitted, 1u, memory_order_relaxed);
+    oaf_event_count_notify(&pool->work_available, 1);
+    return 1;
+}
+
+static int submit_global(OafThreadPool* pool, const OafThreadPoolTask* task, int blocking)
+{
+    int success = 0;
+
+    if (!oaf_mutex_lock(&pool->mutex))
+    {
+        return 0;
+    }
+
+    while (blocking
+        && !atomic_load(&pool->shutting_down)
+        && atomic_load_explicit(&pool->queue_count, memory_order_relaxed) >= pool->queue_capacity)
+    {
+        if (!oaf_cond_var_wait(&pool->has_space, &pool->mutex))
         {
-            pool->active_workers--;
+            oaf_mutex_unlock(&pool->mutex);
+            return 0;
         }
-        pool->stats.completed++;
+    }
 
-        if (pool->queue_count == 0 && pool->active_workers == 0)
+    if (!atomic_load(&pool->shutting_down))
+    {
+        atomic_fetch_add_explicit(&pool->pending, 1u, memory_order_relaxed);
+        success = queue_push(pool, task);
+        if (success)
+        {
+            atomic_fetch_add_explicit(&pool->submitted, 1u, memory_order_relaxed);
+        }
+        else
         {
-            oaf_cond_var_broadcast(&pool->idle);
+            atomic_fetch_sub_explicit(&pool->pending, 1u, memory_order_relaxed);
         }
+    }
 
-        oaf_mutex_unlock(&pool->mutex);
+    oaf_mutex_unlock(&pool->mutex);
+    if (success)
+    {
+        oaf_event_count_notify(&pool->work_available, 1);
     }
 
-    return NULL;
+    return success;
+}
+
+static int submit_task(OafThreadPool* pool, const OafThreadPoolTask* task, int blocking)
+{
+    OafThreadPoolWorker* worker;
+
+    if (pool == NULL || task->proc == NULL || pool->workers == NULL)
+    {
+        return 0;
+    }
+
+    worker = current_worker_of(pool);
+    if (!atomic_load(&pool->shutting_down)
+        && worker != NULL
+        && submit_local(pool, worker, task))
+    {
+        return 1;
+    }
+
+    if (submit_global(pool, task, blocking && worker == NULL))
+    {
+        return 1;
+    }
+
+    atomic_fetch_add_explicit(&pool->rejected, 1u, memory_order_relaxed);
+    return 0;
 }
 
 static void reset_pool(OafThreadPool* pool)
@@ -103,12 +482,64 @@ static void reset_pool(OafThreadPool* pool)
     pool->queue_capacity = 0;
     pool->queue_head = 0;
     pool->queue_tail = 0;
-    pool->queue_count = 0;
-    pool->active_workers = 0;
-    pool->shutting_down = 0;
+    atomic_init(&pool->queue_count, 0u);
+    atomic_init(&pool->pending, 0u);
+    atomic_init(&pool->idle_workers, 0u);
+    atomic_init(&pool->submitted, 0u);
+    atomic_init(&pool->rejected, 0u);
+    atomic_init(&pool->shutting_down, 0);
+    oaf_event_count_init(&pool->work_available);
+    oaf_event_count_init(&pool->idle);
+    oaf_event_count_init(&pool->group_done);
     pool->stats.submitted = 0;
     pool->stats.completed = 0;
     pool->stats.rejected = 0;
+    pool->stats.local_pops = 0;
+    pool->stats.global_pops = 0;
+    pool->stats.steals = 0;
+    pool->stats.parks = 0;
+    pool->stats.helped = 0;
+    pool->stats.splits = 0;
+    pool->stats.worker_count = 0;
+    pool->stats.workers = NULL;
+}
+
+static void release_pool(OafThreadPool* pool, size_t deque_count)
+{
+    size_t index;
+
+    for (index = 0; index < deque_count; index++)
+    {
+        deque_destroy(&pool->workers[index]);
+    }
+
+    free(pool->stats.workers);
+    free(pool->queue);
+    free(pool->workers);
+    reset_pool(pool);
+}
+
+static int init_worker(OafThreadPool* pool, size_t index)
+{
+    OafThreadPoolWorker* worker = &pool->workers[index];
+
+    if (!deque_init(worker))
+    {
+        return 0;
+    }
+
+    worker->pool = pool;
+    worker->index = index;
+    worker->rng_state = 0x9E3779B97F4A7C15ull ^ ((uint64_t)(index + 1u) * 0xBF58476D1CE4E5B9ull);
+    atomic_init(&worker->submitted, 0u);
+    atomic_init(&worker->executed, 0u);
+    atomic_init(&worker->local_pops, 0u);
+    atomic_init(&worker->global_pops, 0u);
+    atomic_init(&worker->steals, 0u);
+    atomic_init(&worker->parks, 0u);
+    atomic_init(&worker->helped, 0u);
+    atomic_init(&worker->splits, 0u);
+    return 1;
 }
 
 int oaf_thread_pool_init(OafThreadPool* pool, size_t worker_count, size_t queue_capacity)
@@ -122,62 +553,55 @@ int oaf_thread_pool_init(OafThreadPool* pool, size_t worker_count, size_t queue_
 
     reset_pool(pool);
 
-    pool->workers = (pthread_t*)malloc(sizeof(pthread_t) * worker_count);
-    if (pool->workers == NULL)
+    pool->workers = (OafThreadPoolWorker*)aligned_alloc(
+        OAF_CACHE_LINE_SIZE,
+        sizeof(OafThreadPoolWorker) * worker_count);
+    pool->stats.workers = (OafThreadPoolWorkerStats*)calloc(worker_count, sizeof(OafThreadPoolWorkerStats));
+    pool->queue = (OafThreadPoolTask*)malloc(sizeof(OafThreadPoolTask) * queue_capacity);
+    if (pool->workers == NULL || pool->stats.workers == NULL || pool->queue == NULL)
     {
-        reset_pool(pool);
+        release_pool(pool, 0);
         return 0;
     }
 
-    pool->queue = (OafThreadPoolTask*)malloc(sizeof(OafThreadPoolTask) * queue_capacity);
-    if (pool->queue == NULL)
+    for (index = 0; index < worker_count; index++)
     {
-        free(pool->workers);
-        reset_pool(pool);
-        return 0;
+        if (!init_worker(pool, index))
+        {
+            release_pool(pool, index);
+            return 0;
+        }
     }
 
     pool->worker_count = worker_count;
     pool->queue_capacity = queue_capacity;
+    pool->stats.worker_count = worker_count;
 
-    if (!oaf_mutex_init(&pool->mutex)
-        || !oaf_cond_var_init(&pool->has_work)
-        || !oaf_cond_var_init(&pool->has_space)
-        || !oaf_cond_var_init(&pool->idle))
+    if (!oaf_mutex_init(&pool->mutex) || !oaf_cond_var_init(&pool->has_space))
     {
-        oaf_cond_var_destroy(&pool->idle);
         oaf_cond_var_destroy(&pool->has_space);
-        oaf_cond_var_destroy(&pool->has_work);
         oaf_mutex_destroy(&pool->mutex);
-        free(pool->queue);
-        free(pool->workers);
-        reset_pool(pool);
+        release_pool(pool, worker_count);
         return 0;
     }
 
     for (index = 0; index < pool->worker_count; index++)
     {
-        if (pthread_create(&pool->workers[index], NULL, worker_main, pool) != 0)
+        if (pthread_create(&pool->workers[index].thread, NULL, worker_main, &pool->workers[index]) != 0)
         {
             size_t join_index;
 
-            oaf_mutex_lock(&pool->mutex);
-            pool->shutting_down = 1;
-            oaf_cond_var_broadcast(&pool->has_work);
-            oaf_mutex_unlock(&pool->mutex);
+            atomic_store(&pool->shutting_down, 1);
+            oaf_event_count_notify(&pool->work_available, 0);
 
             for (join_index = 0; join_index < index; join_index++)
             {
-                pthread_join(pool->workers[join_index], NULL);
+                pthread_join(pool->workers[join_index].thread, NULL);
             }
 
-            oaf_cond_var_destroy(&pool->idle);
             oaf_cond_var_destroy(&pool->has_space);
-            oaf_cond_var_destroy(&pool->has_work);
             oaf_mutex_destroy(&pool->mutex);
-            free(pool->queue);
-            free(pool->workers);
-            reset_pool(pool);
+            release_pool(pool, worker_count);
             return 0;
         }
     }
@@ -202,144 +626,254 @@ void oaf_thread_pool_shutdown(OafThreadPool* pool)
 
     if (oaf_mutex_lock(&pool->mutex))
     {
-        pool->shutting_down = 1;
-        oaf_cond_var_broadcast(&pool->has_work);
+        atomic_store(&pool->shutting_down, 1);
         oaf_cond_var_broadcast(&pool->has_space);
-        oaf_cond_var_broadcast(&pool->idle);
         oaf_mutex_unlock(&pool->mutex);
     }
 
+    oaf_event_count_notify(&pool->work_available, 0);
     for (index = 0; index < pool->worker_count; index++)
     {
-        pthread_join(pool->workers[index], NULL);
+        pthread_join(pool->workers[index].thread, NULL);
     }
 
-    oaf_cond_var_destroy(&pool->idle);
+    oaf_event_count_notify(&pool->idle, 0);
     oaf_cond_var_destroy(&pool->has_space);
-    oaf_cond_var_destroy(&pool->has_work);
     oaf_mutex_destroy(&pool->mutex);
-
-    free(pool->queue);
-    free(pool->workers);
-    reset_pool(pool);
+    release_pool(pool, pool->worker_count);
 }
 
 int oaf_thread_pool_submit(OafThreadPool* pool, OafThreadPoolTaskProc proc, void* state)
 {
-    int success = 0;
+    OafThreadPoolTask task;
 
-    if (pool == NULL || proc == NULL)
-    {
-        return 0;
-    }
+    task.proc = proc;
+    task.state = state;
+    task.group = NULL;
+    return submit_task(pool, &task, 1);
+}
 
-    if (!oaf_mutex_lock(&pool->mutex))
+int oaf_thread_pool_try_submit(OafThreadPool* pool, OafThreadPoolTaskProc proc, void* state)
+{
+    OafThreadPoolTask task;
+
+    task.proc = proc;
+    task.state = state;
+    task.group = NULL;
+    return submit_task(pool, &task, 0);
+}
+
+int oaf_thread_pool_wait_idle(OafThreadPool* pool)
+{
+    if (pool == NULL || pool->workers == NULL)
     {
         return 0;
     }
 
-    while (!pool->shutting_down && pool->queue_count >= pool->queue_capacity)
+    while (atomic_load(&pool->pending) > 0)
     {
-        if (!oaf_cond_var_wait(&pool->has_space, &pool->mutex))
-        {
-            oaf_mutex_unlock(&pool->mutex);
-            return 0;
-        }
-    }
+        unsigned int key = oaf_event_count_prepare_wait(&pool->idle);
 
-    if (!pool->shutting_down)
-    {
-        success = queue_push(pool, proc, state);
-        if (success)
+        if (atomic_load(&pool->pending) == 0)
         {
-            pool->stats.submitted++;
-            oaf_cond_var_signal(&pool->has_work);
+            oaf_event_count_cancel_wait(&pool->idle);
+            break;
         }
+
+        oaf_event_count_wait(&pool->idle, key);
     }
 
-    if (!success)
+    return 1;
+}
+
+size_t oaf_thread_pool_worker_count(const OafThreadPool* pool)
+{
+    if (pool == NULL)
     {
-        pool->stats.rejected++;
+        return 0;
     }
 
-    oaf_mutex_unlock(&pool->mutex);
-    return success;
+    return pool->worker_count;
 }
 
-int oaf_thread_pool_try_submit(OafThreadPool* pool, OafThreadPoolTaskProc proc, void* state)
+int oaf_thread_pool_current_worker(const OafThreadPool* pool, size_t* out_index)
 {
-    int success = 0;
+    OafThreadPoolWorker* worker;
 
-    if (pool == NULL || proc == NULL)
+    if (pool == NULL)
     {
         return 0;
     }
 
-    if (!oaf_mutex_lock(&pool->mutex))
+    worker = current_worker_of(pool);
+    if (worker == NULL)
     {
         return 0;
     }
 
-    if (!pool->shutting_down)
+    if (out_index != NULL)
     {
-        success = queue_push(pool, proc, state);
-        if (success)
-        {
-            pool->stats.submitted++;
-            oaf_cond_var_signal(&pool->has_work);
-        }
+        *out_index = worker->index;
     }
 
-    if (!success)
+    return 1;
+}
+
+int oaf_thread_pool_wants_split(const OafThreadPool* pool)
+{
+    OafThreadPoolWorker* worker;
+
+    if (pool == NULL)
     {
-        pool->stats.rejected++;
+        return 0;
     }
 
-    oaf_mutex_unlock(&pool->mutex);
-    return success;
+    worker = current_worker_of(pool);
+    return worker != NULL
+        && atomic_load_explicit(&((OafThreadPool*)pool)->idle_workers, memory_order_relaxed) > 0
+        && deque_is_empty(worker);
 }
 
-int oaf_thread_pool_wait_idle(OafThreadPool* pool)
+void oaf_thread_pool_note_split(OafThreadPool* pool)
 {
+    OafThreadPoolWorker* worker;
+
     if (pool == NULL)
     {
-        return 0;
+        return;
     }
 
-    if (!oaf_mutex_lock(&pool->mutex))
+    worker = current_worker_of(pool);
+    if (worker != NULL)
     {
-        return 0;
+        atomic_fetch_add_explicit(&worker->splits, 1u, memory_order_relaxed);
     }
+}
+
+const OafThreadPoolStats* oaf_thread_pool_stats(OafThreadPool* pool)
+{
+    OafThreadPoolStats* stats;
+    size_t index;
 
-    while (pool->queue_count > 0 || pool->active_workers > 0)
+    if (pool == NULL)
     {
-        if (!oaf_cond_var_wait(&pool->idle, &pool->mutex))
-        {
-            oaf_mutex_unlock(&pool->mutex);
-            return 0;
-        }
+        return NULL;
     }
 
-    oaf_mutex_unlock(&pool->mutex);
+    stats = &pool->stats;
+    stats->submitted = atomic_load_explicit(&pool->submitted, memory_order_relaxed);
+    stats->rejected = atomic_load_explicit(&pool->rejected, memory_order_relaxed);
+    stats->completed = 0;
+    stats->local_pops = 0;
+    stats->global_pops = 0;
+    stats->steals = 0;
+    stats->parks = 0;
+    stats->helped = 0;
+    stats->splits = 0;
+
+    for (index = 0; index < pool->worker_count; index++)
+    {
+        OafThreadPoolWorker* worker = &pool->workers[index];
+        OafThreadPoolWorkerStats* entry = &stats->workers[index];
+
+        entry->submitted = atomic_load_explicit(&worker->submitted, memory_order_relaxed);
+        entry->executed = atomic_load_explicit(&worker->executed, memory_order_relaxed);
+        entry->local_pops = atomic_load_explicit(&worker->local_pops, memory_order_relaxed);
+        entry->global_pops = atomic_load_explicit(&worker->global_pops, memory_order_relaxed);
+        entry->steals = atomic_load_explicit(&worker->steals, memory_order_relaxed);
+        entry->parks = atomic_load_explicit(&worker->parks, memory_order_relaxed);
+        entry->helped = atomic_load_explicit(&worker->helped, memory_order_relaxed);
+        entry->splits = atomic_load_explicit(&worker->splits, memory_order_relaxed);
+
+        stats->submitted += entry->submitted;
+        stats->completed += entry->executed;
+        stats->local_pops += entry->local_pops;
+        stats->global_pops += entry->global_pops;
+        stats->steals += entry->steals;
+        stats->parks += entry->parks;
+        stats->helped += entry->helped;
+        stats->splits += entry->splits;
+    }
+
+    return stats;
+}
+
+int oaf_task_group_init(OafTaskGroup* group, OafThreadPool* pool)
+{
+    if (group == NULL || pool == NULL || pool->workers == NULL)
+    {
+        return 0;
+    }
+
+    group->pool = pool;
+    atomic_init(&group->pending, 0u);
     return 1;
 }
 
-size_t oaf_thread_pool_worker_count(const OafThreadPool* pool)
+int oaf_task_group_spawn(OafTaskGroup* group, OafThreadPoolTaskProc proc, void* state)
 {
-    if (pool == NULL)
+    OafThreadPoolTask task;
+
+    if (group == NULL || group->pool == NULL || proc == NULL)
     {
         return 0;
     }
 
-    return pool->worker_count;
+    task.proc = proc;
+    task.state = state;
+    task.group = group;
+    atomic_fetch_add_explicit(&group->pending, 1u, memory_order_relaxed);
+    if (!submit_task(group->pool, &task, 1))
+    {
+        atomic_fetch_sub_explicit(&group->pending, 1u, memory_order_relaxed);
+        return 0;
+    }
+
+    return 1;
 }
 
-const OafThreadPoolStats* oaf_thread_pool_stats(const OafThreadPool* pool)
+int oaf_task_group_wait(OafTaskGroup* group)
 {
-    if (pool == NULL)
+    OafThreadPool* pool;
+    OafThreadPoolWorker* worker;
+    size_t idle_rounds = 0;
+
+    if (group == NULL || group->pool == NULL)
     {
-        return NULL;
+        return 0;
+    }
+
+    pool = group->pool;
+    worker = current_worker_of(pool);
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0)
+    {
+        OafThreadPoolTask task;
+        unsigned int key;
+
+        if (worker != NULL && find_task(pool, worker, &task))
+        {
+            atomic_fetch_add_explicit(&worker->helped, 1u, memory_order_relaxed);
+            run_task(pool, worker, &task);
+            idle_rounds = 0;
+            continue;
+        }
+
+        if (idle_rounds < OAF_THREAD_POOL_SPIN_ROUNDS)
+        {
+            idle_rounds++;
+            sched_yield();
+            continue;
+        }
+
+        key = oaf_event_count_prepare_wait(&pool->group_done);
+        if (atomic_load(&group->pending) == 0 || (worker != NULL && has_visible_work(pool)))
+        {
+            oaf_event_count_cancel_wait(&pool->group_done);
+            continue;
+        }
+
+        oaf_event_count_wait(&pool->group_done, key);
     }
 
-    return &pool->stats;
+    return 1;
 }
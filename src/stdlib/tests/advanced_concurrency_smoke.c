@@ -1,10 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "atomic_ops.h"
+#include "concurrent_dict.h"
 #include "oaf_thread_pool.h"
 #include "oaf_async.h"
 #include "oaf_parallel.h"
+#include "temp_allocator.h"
 
 typedef struct SumTaskState
 {
@@ -66,6 +72,445 @@ static int test_thread_pool(void)
     return 1;
 }
 
+typedef struct NestedSpawnState
+{
+    OafThreadPool* pool;
+    OafAtomicI64 children_done;
+    SumTaskState children[64];
+    int submitted_locally;
+} NestedSpawnState;
+
+static void spawn_children_task(void* state)
+{
+    NestedSpawnState* nested = (NestedSpawnState*)state;
+    size_t index;
+
+    nested->submitted_locally = oaf_thread_pool_current_worker(nested->pool, NULL);
+    for (index = 0; index < 64; index++)
+    {
+        nested->children[index].accumulator = &nested->children_done;
+        nested->children[index].value = 1;
+        if (!oaf_thread_pool_submit(nested->pool, accumulate_task, &nested->children[index]))
+        {
+            nested->submitted_locally = 0;
+            return;
+        }
+    }
+
+    while (oaf_atomic_i64_load(&nested->children_done) < 64)
+    {
+        sched_yield();
+    }
+}
+
+static int test_thread_pool_work_stealing(void)
+{
+    OafThreadPool pool;
+    NestedSpawnState nested;
+    const OafThreadPoolStats* stats;
+    size_t local_submitted = 0;
+    size_t index;
+    int ok = 1;
+
+    if (!oaf_thread_pool_init(&pool, 3, 4))
+    {
+        return 0;
+    }
+
+    nested.pool = &pool;
+    nested.submitted_locally = 0;
+    oaf_atomic_i64_init(&nested.children_done, 0);
+
+    ok = ok && oaf_thread_pool_submit(&pool, spawn_children_task, &nested);
+    ok = ok && oaf_thread_pool_wait_idle(&pool);
+    ok = ok && nested.submitted_locally;
+    ok = ok && !oaf_thread_pool_current_worker(&pool, NULL);
+
+    stats = oaf_thread_pool_stats(&pool);
+    ok = ok && stats != NULL && stats->worker_count == 3;
+    if (ok)
+    {
+        for (index = 0; index < stats->worker_count; index++)
+        {
+            local_submitted += stats->workers[index].submitted;
+        }
+
+        ok = stats->submitted == 65
+            && stats->completed == 65
+            && local_submitted == 64
+            && stats->global_pops == 1
+            && stats->steals == 64
+            && stats->local_pops == 0;
+    }
+
+    oaf_thread_pool_shutdown(&pool);
+    return ok;
+}
+
+typedef struct RangeSumState
+{
+    OafThreadPool* pool;
+    const int64_t* values;
+    size_t start;
+    size_t end;
+    int64_t sum;
+} RangeSumState;
+
+static void range_sum_task(void* state)
+{
+    RangeSumState* range = (RangeSumState*)state;
+    RangeSumState left;
+    RangeSumState right;
+    OafTaskGroup group;
+    size_t index;
+
+    range->sum = 0;
+    if (range->end - range->start <= 64 || !oaf_task_group_init(&group, range->pool))
+    {
+        for (index = range->start; index < range->end; index++)
+        {
+            range->sum += range->values[index];
+        }
+        return;
+    }
+
+    left = *range;
+    right = *range;
+    left.end = range->start + (range->end - range->start) / 2u;
+    right.start = left.end;
+
+    if (!oaf_task_group_spawn(&group, range_sum_task, &left))
+    {
+        range_sum_task(&left);
+    }
+
+    range_sum_task(&right);
+    oaf_task_group_wait(&group);
+    range->sum = left.sum + right.sum;
+}
+
+static int64_t reduce_value(size_t index, void* state)
+{
+    const int64_t* values = (const int64_t*)state;
+    return values[index];
+}
+
+typedef struct NestedReduceState
+{
+    OafThreadPool* pool;
+    int64_t* values;
+    size_t count;
+    int64_t result;
+    int ok;
+} NestedReduceState;
+
+static void nested_reduce_task(void* state)
+{
+    NestedReduceState* nested = (NestedReduceState*)state;
+    nested->ok = oaf_parallel_reduce_i64(nested->pool, nested->count, 16, reduce_value, nested->values, &nested->result);
+}
+
+static int test_task_groups(void)
+{
+    OafThreadPool pool;
+    RangeSumState range;
+    NestedReduceState nested[4];
+    const OafThreadPoolStats* stats;
+    int64_t* values;
+    const size_t count = 20000;
+    const int64_t expected = ((int64_t)count * ((int64_t)count + 1)) / 2;
+    size_t index;
+    int ok = 1;
+
+    values = (int64_t*)malloc(sizeof(int64_t) * count);
+    if (values == NULL)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < count; index++)
+    {
+        values[index] = (int64_t)(index + 1u);
+    }
+
+    if (!oaf_thread_pool_init(&pool, 2, 4))
+    {
+        free(values);
+        return 0;
+    }
+
+    range.pool = &pool;
+    range.values = values;
+    range.start = 0;
+    range.end = count;
+    range.sum = 0;
+    ok = ok && oaf_thread_pool_submit(&pool, range_sum_task, &range);
+    ok = ok && oaf_thread_pool_wait_idle(&pool);
+    ok = ok && range.sum == expected;
+
+    for (index = 0; ok && index < 4; index++)
+    {
+        nested[index].pool = &pool;
+        nested[index].values = values;
+        nested[index].count = count;
+        nested[index].result = 0;
+        nested[index].ok = 0;
+        ok = oaf_thread_pool_submit(&pool, nested_reduce_task, &nested[index]);
+    }
+
+    ok = ok && oaf_thread_pool_wait_idle(&pool);
+    for (index = 0; ok && index < 4; index++)
+    {
+        ok = nested[index].ok && nested[index].result == expected;
+    }
+
+    stats = oaf_thread_pool_stats(&pool);
+    ok = ok && stats != NULL && stats->helped > 0 && stats->completed == stats->submitted;
+
+    oaf_thread_pool_shutdown(&pool);
+    free(values);
+    return ok;
+}
+
+typedef struct SkewedState
+{
+    int64_t* values;
+    size_t heavy_from;
+} SkewedState;
+
+static void skewed_fill(size_t index, void* state)
+{
+    SkewedState* skewed = (SkewedState*)state;
+    volatile int64_t spin = 0;
+    size_t round;
+
+    if (index >= skewed->heavy_from)
+    {
+        for (round = 0; round < 20000; round++)
+        {
+            spin += (int64_t)round;
+        }
+    }
+
+    skewed->values[index] = (int64_t)index * 2 + (spin < 0 ? 1 : 0);
+}
+
+static int test_adaptive_parallel_for(void)
+{
+    OafThreadPool pool;
+    SkewedState skewed;
+    const OafThreadPoolStats* stats;
+    int64_t sum = 0;
+    const size_t count = 4000;
+    size_t index;
+    int ok = 1;
+
+    skewed.values = (int64_t*)malloc(sizeof(int64_t) * count);
+    skewed.heavy_from = count - count / 10u;
+    if (skewed.values == NULL)
+    {
+        return 0;
+    }
+
+    if (!oaf_thread_pool_init(&pool, 4, 16))
+    {
+        free(skewed.values);
+        return 0;
+    }
+
+    ok = ok && oaf_parallel_for(&pool, count, 0, skewed_fill, &skewed);
+    for (index = 0; ok && index < count; index++)
+    {
+        ok = skewed.values[index] == (int64_t)index * 2;
+    }
+
+    ok = ok && oaf_parallel_reduce_i64(&pool, count, 0, reduce_value, skewed.values, &sum);
+    ok = ok && sum == (int64_t)count * ((int64_t)count - 1);
+
+    stats = oaf_thread_pool_stats(&pool);
+    ok = ok && stats != NULL && stats->splits > 0;
+
+    oaf_thread_pool_shutdown(&pool);
+    free(skewed.values);
+    return ok;
+}
+
+typedef struct ScratchState
+{
+    int64_t* results;
+    OafAtomicI64 failures;
+} ScratchState;
+
+static void scratch_sum(size_t index, void* state)
+{
+    ScratchState* scratch = (ScratchState*)state;
+    OafTempAllocatorState* temp = oaf_temp_allocator_thread_local();
+    OafAllocator allocator;
+    size_t count = (index + 1u) * 64u;
+    int64_t* values;
+    int64_t sum = 0;
+    size_t mark;
+    size_t item;
+
+    if (temp == NULL)
+    {
+        oaf_atomic_i64_fetch_add(&scratch->failures, 1);
+        return;
+    }
+
+    oaf_temp_allocator_as_allocator(temp, &allocator);
+    mark = oaf_temp_allocator_mark(temp);
+    values = (int64_t*)oaf_allocator_alloc(&allocator, count * sizeof(int64_t), _Alignof(int64_t));
+    if (mark == (size_t)-1 || values == NULL)
+    {
+        oaf_atomic_i64_fetch_add(&scratch->failures, 1);
+        return;
+    }
+
+    for (item = 0; item < count; item++)
+    {
+        values[item] = (int64_t)index;
+    }
+
+    for (item = 0; item < count; item++)
+    {
+        sum += values[item];
+    }
+
+    scratch->results[index] = sum;
+    if (!oaf_temp_allocator_reset_to_mark(temp, mark) || temp->mark_count != mark)
+    {
+        oaf_atomic_i64_fetch_add(&scratch->failures, 1);
+    }
+}
+
+static int test_parallel_scratch_allocation(void)
+{
+    OafThreadPool pool;
+    ScratchState scratch;
+    const size_t count = 256;
+    size_t index;
+    int ok = 1;
+
+    scratch.results = (int64_t*)calloc(count, sizeof(int64_t));
+    oaf_atomic_i64_init(&scratch.failures, 0);
+    if (scratch.results == NULL)
+    {
+        return 0;
+    }
+
+    if (!oaf_thread_pool_init(&pool, 4, 16))
+    {
+        free(scratch.results);
+        return 0;
+    }
+
+    ok = ok && oaf_parallel_for(&pool, count, 1, scratch_sum, &scratch);
+    ok = ok && oaf_atomic_i64_load(&scratch.failures) == 0;
+    for (index = 0; ok && index < count; index++)
+    {
+        ok = scratch.results[index] == (int64_t)index * (int64_t)((index + 1u) * 64u);
+    }
+
+    oaf_thread_pool_shutdown(&pool);
+    oaf_temp_allocator_thread_release();
+    free(scratch.results);
+    return ok;
+}
+
+typedef struct KahanAccumulator
+{
+    double sum;
+    double compensation;
+    double min;
+    double max;
+} KahanAccumulator;
+
+static void kahan_add(KahanAccumulator* accumulator, double value)
+{
+    double adjusted = value - accumulator->compensation;
+    double total = accumulator->sum + adjusted;
+
+    accumulator->compensation = (total - accumulator->sum) - adjusted;
+    accumulator->sum = total;
+}
+
+static void kahan_map(size_t index, void* accumulator, void* state)
+{
+    KahanAccumulator* acc = (KahanAccumulator*)accumulator;
+    const double* values = (const double*)state;
+
+    kahan_add(acc, values[index]);
+    acc->min = values[index] < acc->min ? values[index] : acc->min;
+    acc->max = values[index] > acc->max ? values[index] : acc->max;
+}
+
+static void kahan_combine(void* accumulator, const void* other, void* state)
+{
+    KahanAccumulator* acc = (KahanAccumulator*)accumulator;
+    const KahanAccumulator* right = (const KahanAccumulator*)other;
+
+    (void)state;
+    kahan_add(acc, right->sum);
+    kahan_add(acc, -right->compensation);
+    acc->min = right->min < acc->min ? right->min : acc->min;
+    acc->max = right->max > acc->max ? right->max : acc->max;
+}
+
+static int test_generic_parallel_reduce(void)
+{
+    OafThreadPool small_pool;
+    OafThreadPool large_pool;
+    KahanAccumulator identity = {0.0, 0.0, 1e300, -1e300};
+    KahanAccumulator first;
+    KahanAccumulator second;
+    KahanAccumulator third;
+    double* values;
+    const size_t count = 100000;
+    size_t index;
+    int ok = 1;
+
+    values = (double*)malloc(sizeof(double) * count);
+    if (values == NULL)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < count; index++)
+    {
+        values[index] = (index % 2u == 0 ? 1.0 : 1e-9) * (double)((index * 7919u) % 1000u);
+    }
+
+    if (!oaf_thread_pool_init(&small_pool, 2, 32))
+    {
+        free(values);
+        return 0;
+    }
+
+    if (!oaf_thread_pool_init(&large_pool, 4, 32))
+    {
+        oaf_thread_pool_shutdown(&small_pool);
+        free(values);
+        return 0;
+    }
+
+    ok = ok && oaf_parallel_reduce(&small_pool, count, 0, sizeof(KahanAccumulator), &identity, kahan_map, kahan_combine, values, &first);
+    ok = ok && oaf_parallel_reduce(&large_pool, count, 0, sizeof(KahanAccumulator), &identity, kahan_map, kahan_combine, values, &second);
+    ok = ok && oaf_parallel_reduce(&large_pool, count, 0, sizeof(KahanAccumulator), &identity, kahan_map, kahan_combine, values, &third);
+    ok = ok && memcmp(&first, &second, sizeof(KahanAccumulator)) == 0;
+    ok = ok && memcmp(&second, &third, sizeof(KahanAccumulator)) == 0;
+    ok = ok && first.min == 0.0 && first.max == 998.0;
+    ok = ok && first.sum > 24000000.0 && first.sum < 26000000.0;
+
+    ok = ok && oaf_parallel_reduce(&large_pool, 0, 0, sizeof(KahanAccumulator), &identity, kahan_map, kahan_combine, values, &first);
+    ok = ok && first.sum == 0.0 && first.max == -1e300;
+
+    oaf_thread_pool_shutdown(&large_pool);
+    oaf_thread_pool_shutdown(&small_pool);
+    free(values);
+    return ok;
+}
+
 typedef struct AddAsyncState
 {
     int left;
@@ -201,13 +646,264 @@ static int test_parallel_algorithms(void)
     return ok;
 }
 
+#define DICT_TEST_THREADS 8
+#define DICT_TEST_KEYS_PER_THREAD 4000
+#define DICT_TEST_SHARED_KEYS 512
+
+typedef struct DictTestWorker
+{
+    OafConcurrentDict* dict;
+    atomic_size_t* computed;
+    int64_t first_key;
+    int ok;
+} DictTestWorker;
+
+static void* counted_alloc(void* state, size_t size, size_t alignment)
+{
+    void* block = malloc(size == 0 ? 1 : size);
+    (void)alignment;
+
+    if (block != NULL)
+    {
+        atomic_fetch_add((atomic_size_t*)state, 1u);
+    }
+
+    return block;
+}
+
+static void* counted_realloc(void* state, void* ptr, size_t old_size, size_t new_size, size_t alignment)
+{
+    (void)state;
+    (void)old_size;
+    (void)alignment;
+    return realloc(ptr, new_size == 0 ? 1 : new_size);
+}
+
+static void counted_free(void* state, void* ptr)
+{
+    if (ptr != NULL)
+    {
+        atomic_fetch_sub((atomic_size_t*)state, 1u);
+        free(ptr);
+    }
+}
+
+typedef struct FlakyAllocatorState
+{
+    atomic_size_t live_blocks;
+    size_t calls;
+    size_t fail_every;
+} FlakyAllocatorState;
+
+/* Fails every fail_every-th allocation (never when 0) to drive the dict through transient out-of-memory. */
+static void* flaky_alloc(void* state, size_t size, size_t alignment)
+{
+    FlakyAllocatorState* flaky = (FlakyAllocatorState*)state;
+
+    flaky->calls++;
+    if (flaky->fail_every != 0 && flaky->calls % flaky->fail_every == 0)
+    {
+        return NULL;
+    }
+
+    return counted_alloc(&flaky->live_blocks, size, alignment);
+}
+
+static void flaky_free(void* state, void* ptr)
+{
+    counted_free(&((FlakyAllocatorState*)state)->live_blocks, ptr);
+}
+
+static int compute_square(const void* key, void* out_value, void* state)
+{
+    int64_t value = *(const int64_t*)key;
+
+    atomic_fetch_add((atomic_size_t*)state, 1u);
+    value *= value;
+    memcpy(out_value, &value, sizeof(value));
+    return 1;
+}
+
+static void* concurrent_dict_worker(void* argument)
+{
+    DictTestWorker* worker = (DictTestWorker*)argument;
+    int64_t index;
+    int64_t key;
+    int64_t value;
+
+    for (index = 0; index < DICT_TEST_KEYS_PER_THREAD && worker->ok; index++)
+    {
+        int inserted = 0;
+
+        key = worker->first_key + index;
+        value = key * 2;
+        worker->ok = oaf_concurrent_dict_set(worker->dict, &key, &value);
+
+        key = index % DICT_TEST_SHARED_KEYS;
+        worker->ok = worker->ok
+            && oaf_concurrent_dict_compute_if_absent(worker->dict, &key, compute_square, worker->computed, &value, &inserted)
+            && value == key * key;
+
+        key = worker->first_key + index / 2;
+        worker->ok = worker->ok && oaf_concurrent_dict_try_get(worker->dict, &key, &value) && value == key * 2;
+    }
+
+    for (index = 0; index < DICT_TEST_KEYS_PER_THREAD && worker->ok; index += 2)
+    {
+        key = worker->first_key + index;
+        worker->ok = oaf_concurrent_dict_remove(worker->dict, &key, &value) && value == key * 2;
+    }
+
+    return NULL;
+}
+
+static int test_concurrent_dict(void)
+{
+    OafAllocator allocator;
+    OafConcurrentDict dict;
+    DictTestWorker workers[DICT_TEST_THREADS];
+    pthread_t threads[DICT_TEST_THREADS];
+    atomic_size_t live_blocks;
+    atomic_size_t computed;
+    size_t index;
+    int64_t key;
+    int64_t value;
+    int inserted = 0;
+    int ok = 1;
+
+    atomic_init(&live_blocks, 0);
+    atomic_init(&computed, 0);
+    allocator.state = &live_blocks;
+    allocator.ops.alloc = counted_alloc;
+    allocator.ops.realloc = counted_realloc;
+    allocator.ops.free = counted_free;
+
+    if (!oaf_concurrent_dict_init(&dict, sizeof(int64_t), sizeof(int64_t), 0, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, &allocator))
+    {
+        return 0;
+    }
+
+    key = -1;
+    value = 10;
+    ok = ok && oaf_concurrent_dict_get_or_insert(&dict, &key, &value, &value, &inserted) && inserted && value == 10;
+    value = 20;
+    ok = ok && oaf_concurrent_dict_get_or_insert(&dict, &key, &value, &value, &inserted) && !inserted && value == 10;
+    value = 30;
+    ok = ok && oaf_concurrent_dict_set(&dict, &key, &value);
+    ok = ok && oaf_concurrent_dict_try_get(&dict, &key, &value) && value == 30;
+    ok = ok && oaf_concurrent_dict_remove(&dict, &key, &value) && value == 30;
+    ok = ok && !oaf_concurrent_dict_contains_key(&dict, &key) && oaf_concurrent_dict_count(&dict) == 0;
+
+    for (index = 0; index < DICT_TEST_THREADS; index++)
+    {
+        workers[index].dict = &dict;
+        workers[index].computed = &computed;
+        workers[index].first_key = 1000000 + (int64_t)index * DICT_TEST_KEYS_PER_THREAD;
+        workers[index].ok = 1;
+        if (ok && pthread_create(&threads[index], NULL, concurrent_dict_worker, &workers[index]) != 0)
+        {
+            ok = 0;
+            workers[index].ok = 0;
+            threads[index] = pthread_self();
+        }
+    }
+
+    for (index = 0; index < DICT_TEST_THREADS; index++)
+    {
+        if (!pthread_equal(threads[index], pthread_self()))
+        {
+            pthread_join(threads[index], NULL);
+        }
+
+        ok = ok && workers[index].ok;
+    }
+
+    ok = ok && atomic_load(&computed) == DICT_TEST_SHARED_KEYS;
+    ok = ok && oaf_concurrent_dict_count(&dict) == DICT_TEST_SHARED_KEYS + DICT_TEST_THREADS * DICT_TEST_KEYS_PER_THREAD / 2;
+    ok = ok && oaf_concurrent_dict_resize_count(&dict) > 0 && oaf_concurrent_dict_bucket_count(&dict) >= 1024;
+
+    for (index = 0; ok && index < DICT_TEST_THREADS * DICT_TEST_KEYS_PER_THREAD; index++)
+    {
+        key = 1000000 + (int64_t)index;
+        ok = oaf_concurrent_dict_contains_key(&dict, &key) == (int)(index & 1u);
+    }
+
+    oaf_concurrent_dict_destroy(&dict);
+    return ok && atomic_load(&live_blocks) == 0;
+}
+
+/* A bucket transfer that runs out of memory is retried later, so the resize still completes and the table grows. */
+static int test_concurrent_dict_resize_after_oom(void)
+{
+    FlakyAllocatorState flaky;
+    OafAllocator allocator;
+    OafConcurrentDict dict;
+    unsigned char* stored;
+    const int64_t key_count = 20000;
+    int64_t key;
+    int64_t value;
+    size_t count = 0;
+    int ok;
+
+    atomic_init(&flaky.live_blocks, 0);
+    flaky.calls = 0;
+    flaky.fail_every = 0;
+    allocator.state = &flaky;
+    allocator.ops.alloc = flaky_alloc;
+    allocator.ops.realloc = counted_realloc;
+    allocator.ops.free = flaky_free;
+
+    stored = (unsigned char*)calloc((size_t)key_count, 1);
+    if (stored == NULL)
+    {
+        return 0;
+    }
+
+    if (!oaf_concurrent_dict_init(&dict, sizeof(int64_t), sizeof(int64_t), 0, oaf_dict_hash_i64, oaf_dict_equals_i64, NULL, &allocator))
+    {
+        free(stored);
+        return 0;
+    }
+
+    ok = 1;
+    flaky.fail_every = 7;
+    for (key = 0; ok && key < key_count; key++)
+    {
+        if (key == key_count / 2)
+        {
+            flaky.fail_every = 0;
+        }
+
+        value = key * 3;
+        stored[key] = (unsigned char)oaf_concurrent_dict_set(&dict, &key, &value);
+        count += stored[key];
+    }
+
+    ok = ok && oaf_concurrent_dict_count(&dict) == count && oaf_concurrent_dict_bucket_count(&dict) >= count;
+    for (key = 0; ok && key < key_count; key++)
+    {
+        ok = oaf_concurrent_dict_try_get(&dict, &key, &value) == stored[key] && (!stored[key] || value == key * 3);
+    }
+
+    oaf_concurrent_dict_destroy(&dict);
+    free(stored);
+    return ok && atomic_load(&flaky.live_blocks) == 0;
+}
+
 int main(void)
 {
     int ok = 1;
 
     ok = ok && test_thread_pool();
+    ok = ok && test_thread_pool_work_stealing();
     ok = ok && test_async_await();
     ok = ok && test_parallel_algorithms();
+    ok = ok && test_task_groups();
+    ok = ok && test_adaptive_parallel_for();
+    ok = ok && test_generic_parallel_reduce();
+    ok = ok && test_parallel_scratch_allocation();
+    ok = ok && test_concurrent_dict();
+    ok = ok && test_concurrent_dict_resize_after_oom();
 
     if (!ok)
     {